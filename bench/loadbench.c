@@ -0,0 +1,1368 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup loadbench loadbench
+ * @brief Variable server contention benchmark for loadconfig
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file loadbench.c
+
+    Contention Benchmark
+
+    The loadbench utility measures loadconfig while other clients are
+    using the same variable server.  It starts the variable server, or
+    a local stand-in, and creates the benchmark variables from a
+    generated vars.json file.  It then starts background reader, writer
+    and notification subscriber clients, and runs several concurrent
+    loadconfig instances against a generated configuration file.
+
+    It reports the completion time of each loadconfig instance, and the
+    latency percentiles and throughput of the other clients, both before
+    and during the loads, so the effect of loader changes such as
+    batching and pacing on the other clients can be quantified.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <varserver/varserver.h>
+#include <varserver/vartemplate.h>
+#include "options.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! maximum number of concurrent loadconfig instances */
+#define MAX_LOADERS         ( 64 )
+
+/*! maximum number of background clients of each kind */
+#define MAX_CLIENTS         ( 64 )
+
+/*! maximum number of arguments passed to loadconfig */
+#define MAX_LOADER_ARGS     ( 32 )
+
+/*! number of variables each subscriber asks to be notified about */
+#define SUBSCRIBED_VARS     ( 16 )
+
+/*! number of attempts to connect to a variable server being started */
+#define CONNECT_RETRIES     ( 50 )
+
+/*! kinds of background client */
+typedef enum _ClientType
+{
+    /*! reads configured variables */
+    CLIENT_READER = 0,
+
+    /*! writes its own variable */
+    CLIENT_WRITER,
+
+    /*! waits for modification notifications */
+    CLIENT_SUBSCRIBER,
+
+    /*! number of kinds of client */
+    CLIENT_NUM_TYPES
+
+} ClientType;
+
+/*! benchmark phases shared with the background clients */
+typedef enum _Phase
+{
+    /*! measuring the clients without a load */
+    PHASE_IDLE = 0,
+
+    /*! measuring the clients while loadconfig is running */
+    PHASE_LOADING,
+
+    /*! the clients report and exit */
+    PHASE_STOP,
+
+    /*! number of measured phases */
+    PHASE_NUM_MEASURED = PHASE_STOP
+
+} Phase;
+
+/*! operations counted by a client in one phase */
+typedef struct _PhaseStats
+{
+    /*! number of operations completed */
+    uint64_t ops;
+
+    /*! number of operations which failed */
+    uint64_t errors;
+
+    /*! duration of the phase in microseconds */
+    uint64_t elapsed;
+
+    /*! number of latency samples which follow */
+    uint64_t nsamples;
+
+} PhaseStats;
+
+/*! latency samples of all the clients of one kind in one phase */
+typedef struct _Samples
+{
+    /*! operation totals */
+    PhaseStats stats;
+
+    /*! latency samples in microseconds */
+    uint32_t *pSamples;
+
+    /*! number of samples allocated */
+    size_t size;
+
+} Samples;
+
+/*! background client */
+typedef struct _Client
+{
+    /*! kind of client */
+    ClientType type;
+
+    /*! process identifier */
+    pid_t pid;
+
+    /*! pipe which the client reports its samples on */
+    int fd;
+
+} Client;
+
+/*! benchmark state */
+typedef struct _BenchState
+{
+    /*! loadconfig executable */
+    char *pLoadconfig;
+
+    /*! additional loadconfig arguments */
+    char *pLoaderArgs[MAX_LOADER_ARGS];
+
+    /*! number of additional loadconfig arguments */
+    int nloaderArgs;
+
+    /*! command which starts the variable server, or NULL */
+    char *pServerCmd;
+
+    /*! command which creates the variables from a vars.json file */
+    char *pCreateCmd;
+
+    /*! directory holding the generated files */
+    char *pDir;
+
+    /*! number of variables in the generated configuration */
+    unsigned int nvars;
+
+    /*! number of concurrent loadconfig instances */
+    unsigned int nloaders;
+
+    /*! number of background clients of each kind */
+    unsigned int nclients[CLIENT_NUM_TYPES];
+
+    /*! delay between the operations of a client in microseconds */
+    unsigned int interval;
+
+    /*! duration of the idle measurement in milliseconds */
+    unsigned int idleMs;
+
+    /*! process identifier of the started variable server, or 0 */
+    pid_t server;
+
+    /*! background clients */
+    Client clients[CLIENT_NUM_TYPES * MAX_CLIENTS];
+
+    /*! number of background clients started */
+    unsigned int nstarted;
+
+    /*! completion time of each loadconfig instance in microseconds */
+    uint64_t loadTimes[MAX_LOADERS];
+
+    /*! number of loadconfig instances which failed */
+    unsigned int loadFailures;
+
+    /*! samples of each kind of client in each phase */
+    Samples samples[CLIENT_NUM_TYPES][PHASE_NUM_MEASURED];
+
+} BenchState;
+
+/*! benchmark phase shared with the background clients */
+static volatile int *pPhase;
+
+/*! set by the signal handler to stop a subscriber */
+static volatile sig_atomic_t stopRequested;
+
+/*! names of the kinds of client */
+static const char *clientNames[CLIENT_NUM_TYPES] =
+{
+    "reader",
+    "writer",
+    "subscriber"
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+int main( int argc, char **argv );
+static void usage( char *cmdname );
+static int ProcessOptions( int argC, char *argV[], BenchState *pState );
+static int GenerateFiles( BenchState *pState );
+static int StartServer( BenchState *pState );
+static int StartClient( BenchState *pState, ClientType type, unsigned int id );
+static void RunClient( ClientType type, unsigned int id, unsigned int nvars,
+                       unsigned int interval, int fd );
+static int RunLoaders( BenchState *pState );
+static int CollectClient( BenchState *pState, Client *pClient );
+static int AddSample( Samples *pSamples, uint32_t sample );
+static void Report( BenchState *pState );
+static uint32_t Percentile( Samples *pSamples, unsigned int percentile );
+static int CompareSamples( const void *p1, const void *p2 );
+static uint64_t Now( void );
+static void HandleSignal( int signum );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  main                                                                    */
+/*!
+    Main entry point for the loadbench utility
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @return 0 if every loadconfig instance completed ok
+    @return 1 otherwise
+
+============================================================================*/
+int main( int argc, char **argv )
+{
+    BenchState state;
+    int result;
+    unsigned int i;
+    unsigned int id;
+    int type;
+
+    memset( &state, 0, sizeof( state ) );
+    state.pLoadconfig = "loadconfig";
+    state.pServerCmd = "varserver";
+    state.pCreateCmd = "varcreate";
+    state.pDir = "/tmp/loadbench";
+    state.nvars = 1000;
+    state.nloaders = 1;
+    state.nclients[CLIENT_READER] = 4;
+    state.nclients[CLIENT_WRITER] = 2;
+    state.nclients[CLIENT_SUBSCRIBER] = 2;
+    state.idleMs = 1000;
+
+    ProcessOptions( argc, argv, &state );
+
+    /* the phase is shared with the background clients */
+    pPhase = mmap( NULL,
+                   sizeof( int ),
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS,
+                   -1,
+                   0 );
+    result = ( pPhase != MAP_FAILED ) ? EOK : errno;
+
+    if ( result == EOK )
+    {
+        *pPhase = PHASE_IDLE;
+        result = GenerateFiles( &state );
+    }
+
+    if ( result == EOK )
+    {
+        result = StartServer( &state );
+    }
+
+    for ( type = 0; ( type < CLIENT_NUM_TYPES ) && ( result == EOK ); type++ )
+    {
+        for ( id = 0;
+              ( id < state.nclients[type] ) && ( result == EOK );
+              id++ )
+        {
+            result = StartClient( &state, (ClientType)type, id );
+        }
+    }
+
+    if ( result == EOK )
+    {
+        /* measure the clients without a load */
+        usleep( state.idleMs * 1000 );
+
+        *pPhase = PHASE_LOADING;
+        result = RunLoaders( &state );
+    }
+
+    /* stop the clients and collect their samples */
+    *pPhase = PHASE_STOP;
+    for ( i = 0; i < state.nstarted; i++ )
+    {
+        kill( state.clients[i].pid, SIGTERM );
+    }
+
+    for ( i = 0; i < state.nstarted; i++ )
+    {
+        CollectClient( &state, &state.clients[i] );
+    }
+
+    if ( state.server != 0 )
+    {
+        kill( state.server, SIGTERM );
+        waitpid( state.server, NULL, 0 );
+    }
+
+    if ( result == EOK )
+    {
+        Report( &state );
+    }
+    else
+    {
+        fprintf( stderr, "Benchmark failed: %s\n", strerror( result ) );
+    }
+
+    return ( ( result == EOK ) && ( state.loadFailures == 0 ) ) ? 0 : 1;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  usage                                                                   */
+/*!
+    Display the loadbench usage
+
+    @param[in]
+        cmdname
+            pointer to the invoked command name
+
+============================================================================*/
+static void usage( char *cmdname )
+{
+    if ( cmdname != NULL )
+    {
+        fprintf( stderr,
+                 "usage: %s [-h] [-L <loadconfig>] [-a <arg>] "
+                 "[-s <cmd>] [-S] [-c <cmd>]\n"
+                 "       [-d <dir>] [-V <n>] [-n <n>] [-r <n>] [-w <n>] "
+                 "[-N <n>] [-i <us>]\n"
+                 "       [-I <ms>]\n"
+                 " [-h] : display this help\n"
+                 " [-L, --loadconfig <path>] : loadconfig executable "
+                 "(default loadconfig)\n"
+                 " [-a, --arg <arg>] : pass an argument to each loadconfig "
+                 "instance\n"
+                 " [-s, --server <cmd>] : command which starts the variable "
+                 "server\n"
+                 "     (default varserver)\n"
+                 " [-S, --no-server] : use the running variable server\n"
+                 " [-c, --create <cmd>] : command which creates the "
+                 "variables from\n"
+                 "     a vars.json file (default varcreate)\n"
+                 " [-d, --dir <dir>] : directory for the generated files "
+                 "(default\n"
+                 "     /tmp/loadbench)\n"
+                 " [-V, --vars <n>] : number of configured variables "
+                 "(default 1000)\n"
+                 " [-n, --loaders <n>] : concurrent loadconfig instances "
+                 "(default 1)\n"
+                 " [-r, --readers <n>] : background reader clients "
+                 "(default 4)\n"
+                 " [-w, --writers <n>] : background writer clients "
+                 "(default 2)\n"
+                 " [-N, --subscribers <n>] : notification subscribers "
+                 "(default 2)\n"
+                 " [-i, --interval <us>] : delay between the operations of "
+                 "a client\n"
+                 "     (default 0)\n"
+                 " [-I, --idle <ms>] : time to measure the clients before "
+                 "the load\n"
+                 "     (default 1000)\n",
+                 cmdname );
+    }
+}
+
+/*==========================================================================*/
+/*  ProcessOptions                                                          */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+            (including the command itself)
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @return 0
+
+============================================================================*/
+static int ProcessOptions( int argC, char *argV[], BenchState *pState )
+{
+    OptionParser parser;
+    int c;
+    const char *options = "hL:a:s:Sc:d:V:n:r:w:N:i:I:";
+    static const struct option longopts[] =
+    {
+        { "help", no_argument, NULL, 'h' },
+        { "loadconfig", required_argument, NULL, 'L' },
+        { "arg", required_argument, NULL, 'a' },
+        { "server", required_argument, NULL, 's' },
+        { "no-server", no_argument, NULL, 'S' },
+        { "create", required_argument, NULL, 'c' },
+        { "dir", required_argument, NULL, 'd' },
+        { "vars", required_argument, NULL, 'V' },
+        { "loaders", required_argument, NULL, 'n' },
+        { "readers", required_argument, NULL, 'r' },
+        { "writers", required_argument, NULL, 'w' },
+        { "subscribers", required_argument, NULL, 'N' },
+        { "interval", required_argument, NULL, 'i' },
+        { "idle", required_argument, NULL, 'I' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    OPTIONS_Init( &parser, argC, argV, options, longopts );
+
+    while ( ( c = OPTIONS_Next( &parser ) ) != -1 )
+    {
+        switch ( c )
+        {
+            case 'h':
+                usage( argV[0] );
+                exit( 0 );
+                break;
+
+            case 'L':
+                pState->pLoadconfig = parser.pArg;
+                break;
+
+            case 'a':
+                if ( pState->nloaderArgs < MAX_LOADER_ARGS )
+                {
+                    pState->pLoaderArgs[pState->nloaderArgs++] = parser.pArg;
+                }
+                break;
+
+            case 's':
+                pState->pServerCmd = parser.pArg;
+                break;
+
+            case 'S':
+                pState->pServerCmd = NULL;
+                break;
+
+            case 'c':
+                pState->pCreateCmd = parser.pArg;
+                break;
+
+            case 'd':
+                pState->pDir = parser.pArg;
+                break;
+
+            case 'V':
+                pState->nvars = strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            case 'n':
+                pState->nloaders = strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            case 'r':
+                pState->nclients[CLIENT_READER] =
+                    strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            case 'w':
+                pState->nclients[CLIENT_WRITER] =
+                    strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            case 'N':
+                pState->nclients[CLIENT_SUBSCRIBER] =
+                    strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            case 'i':
+                pState->interval = strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            case 'I':
+                pState->idleMs = strtoul( parser.pArg, NULL, 0 );
+                break;
+
+            default:
+                usage( argV[0] );
+                exit( 1 );
+                break;
+        }
+    }
+
+    if ( pState->nloaders > MAX_LOADERS )
+    {
+        pState->nloaders = MAX_LOADERS;
+    }
+
+    for ( c = 0; c < CLIENT_NUM_TYPES; c++ )
+    {
+        if ( pState->nclients[c] > MAX_CLIENTS )
+        {
+            pState->nclients[c] = MAX_CLIENTS;
+        }
+    }
+
+    if ( pState->nvars == 0 )
+    {
+        pState->nvars = 1;
+    }
+
+    return 0;
+}
+
+/*==========================================================================*/
+/*  GenerateFiles                                                           */
+/*!
+    Generate the benchmark variables and configuration
+
+    The GenerateFiles function writes vars.json, defining the configured
+    variables /bench/var/<n> and a variable /bench/writer/<n> for each
+    writer client, and bench.cfg, assigning each configured variable.
+    Every tenth assignment references the previous variable so the
+    loads also exercise template expansion.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK the files were generated
+    @retval other error as returned by the file system
+
+============================================================================*/
+static int GenerateFiles( BenchState *pState )
+{
+    int result = EOK;
+    char path[PATH_MAX];
+    FILE *fp;
+    unsigned int i;
+    unsigned int nwriters = pState->nclients[CLIENT_WRITER];
+
+    if ( ( mkdir( pState->pDir, 0755 ) != 0 ) && ( errno != EEXIST ) )
+    {
+        result = errno;
+    }
+
+    snprintf( path, sizeof( path ), "%s/vars.json", pState->pDir );
+    fp = ( result == EOK ) ? fopen( path, "w" ) : NULL;
+    if ( fp != NULL )
+    {
+        fprintf( fp,
+                 "{\n"
+                 "    \"type\":\"loadconfig vars\",\n"
+                 "    \"version\":\"1.0\",\n"
+                 "    \"description\":\"Variables for the loadconfig "
+                 "contention benchmark\",\n"
+                 "    \"vars\":\n"
+                 "    [\n" );
+
+        for ( i = 0; i < pState->nvars + nwriters; i++ )
+        {
+            fprintf( fp,
+                     "        {\n"
+                     "            \"name\":\"/bench/%s/%u\",\n"
+                     "            \"type\":\"str\",\n"
+                     "            \"length\":\"128\"\n"
+                     "        }%s\n",
+                     ( i < pState->nvars ) ? "var" : "writer",
+                     ( i < pState->nvars ) ? i : i - pState->nvars,
+                     ( i + 1 < pState->nvars + nwriters ) ? "," : "" );
+        }
+
+        fprintf( fp, "    ]\n}\n" );
+        result = ( fclose( fp ) == 0 ) ? EOK : errno;
+    }
+    else if ( result == EOK )
+    {
+        result = errno;
+    }
+
+    snprintf( path, sizeof( path ), "%s/bench.cfg", pState->pDir );
+    fp = ( result == EOK ) ? fopen( path, "w" ) : NULL;
+    if ( fp != NULL )
+    {
+        fprintf( fp, "@config Contention Benchmark\n\n" );
+
+        for ( i = 0; i < pState->nvars; i++ )
+        {
+            if ( ( i > 0 ) && ( i % 10 == 0 ) )
+            {
+                fprintf( fp,
+                         "/bench/var/%u ${/bench/var/%u}-%u\n",
+                         i,
+                         i - 1,
+                         i );
+            }
+            else
+            {
+                fprintf( fp, "/bench/var/%u value-%u\n", i, i );
+            }
+        }
+
+        result = ( fclose( fp ) == 0 ) ? EOK : errno;
+    }
+    else if ( result == EOK )
+    {
+        result = errno;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  StartServer                                                             */
+/*!
+    Start the variable server and create the benchmark variables
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK the variable server is running with the variables created
+    @retval ENOTCONN the variable server could not be reached
+    @retval other error starting the variable server or creating the
+            variables
+
+============================================================================*/
+static int StartServer( BenchState *pState )
+{
+    int result = EOK;
+    char cmd[PATH_MAX * 2];
+    VARSERVER_HANDLE hVarServer = NULL;
+    int retries;
+
+    if ( pState->pServerCmd != NULL )
+    {
+        pState->server = fork();
+        if ( pState->server == 0 )
+        {
+            execl( "/bin/sh", "sh", "-c", pState->pServerCmd, (char *)NULL );
+            _exit( 127 );
+        }
+        else if ( pState->server < 0 )
+        {
+            pState->server = 0;
+            result = errno;
+        }
+    }
+
+    for ( retries = 0;
+          ( result == EOK ) &&
+          ( hVarServer == NULL ) &&
+          ( retries < CONNECT_RETRIES );
+          retries++ )
+    {
+        hVarServer = VARSERVER_Open();
+        if ( hVarServer == NULL )
+        {
+            usleep( 100000 );
+        }
+    }
+
+    if ( hVarServer != NULL )
+    {
+        VARSERVER_Close( hVarServer );
+
+        snprintf( cmd,
+                  sizeof( cmd ),
+                  "%s %s/vars.json",
+                  pState->pCreateCmd,
+                  pState->pDir );
+        if ( system( cmd ) != 0 )
+        {
+            fprintf( stderr, "Cannot create variables: %s\n", cmd );
+            result = EIO;
+        }
+    }
+    else if ( result == EOK )
+    {
+        result = ENOTCONN;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  StartClient                                                             */
+/*!
+    Start a background client
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @param[in]
+        type
+            kind of client to start
+
+    @param[in]
+        id
+            index of the client among the clients of its kind
+
+    @retval EOK the client was started
+    @retval other error as returned by pipe or fork
+
+============================================================================*/
+static int StartClient( BenchState *pState, ClientType type, unsigned int id )
+{
+    int result = EOK;
+    Client *pClient = &pState->clients[pState->nstarted];
+    int fds[2];
+
+    if ( pipe( fds ) != 0 )
+    {
+        result = errno;
+    }
+    else
+    {
+        pClient->pid = fork();
+        if ( pClient->pid == 0 )
+        {
+            close( fds[0] );
+            RunClient( type, id, pState->nvars, pState->interval, fds[1] );
+            _exit( 0 );
+        }
+
+        close( fds[1] );
+        if ( pClient->pid > 0 )
+        {
+            pClient->type = type;
+            pClient->fd = fds[0];
+            pState->nstarted++;
+        }
+        else
+        {
+            result = errno;
+            close( fds[0] );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RunClient                                                               */
+/*!
+    Run a background client until the benchmark stops
+
+    A reader expands a random configured variable, a writer sets its own
+    variable, and a subscriber waits for modification notifications on
+    the first configured variables and the writer variables.  Each
+    operation is timed, and the samples of each phase are written to
+    the reporting pipe when the client stops.
+
+    @param[in]
+        type
+            kind of client
+
+    @param[in]
+        id
+            index of the client among the clients of its kind
+
+    @param[in]
+        nvars
+            number of configured variables
+
+    @param[in]
+        interval
+            delay between operations in microseconds
+
+    @param[in]
+        fd
+            reporting pipe
+
+============================================================================*/
+static void RunClient( ClientType type, unsigned int id, unsigned int nvars,
+                       unsigned int interval, int fd )
+{
+    VARSERVER_HANDLE hVarServer;
+    VAR_HANDLE hVar;
+    Samples samples[PHASE_NUM_MEASURED];
+    uint64_t phaseStart[PHASE_NUM_MEASURED];
+    struct sigaction sa;
+    sigset_t mask;
+    char name[64];
+    char value[64];
+    uint64_t start;
+    uint64_t seq = 0;
+    int nullfd;
+    int phase;
+    int sigval;
+    int rc;
+    unsigned int i;
+
+    memset( samples, 0, sizeof( samples ) );
+    srand( getpid() );
+
+    /* notifications are collected by VARSERVER_WaitSignal, and the
+     * benchmark stops a waiting subscriber with SIGTERM */
+    sigemptyset( &mask );
+    sigaddset( &mask, SIG_VAR_MODIFIED );
+    sigprocmask( SIG_BLOCK, &mask, NULL );
+
+    memset( &sa, 0, sizeof( sa ) );
+    sa.sa_handler = HandleSignal;
+    sigemptyset( &sa.sa_mask );
+    sigaction( SIGTERM, &sa, NULL );
+
+    nullfd = open( "/dev/null", O_WRONLY );
+    hVarServer = VARSERVER_Open();
+
+    for ( i = 0;
+          ( type == CLIENT_SUBSCRIBER ) &&
+          ( hVarServer != NULL ) &&
+          ( i < SUBSCRIBED_VARS + MAX_CLIENTS );
+          i++ )
+    {
+        if ( i < SUBSCRIBED_VARS )
+        {
+            snprintf( name, sizeof( name ), "/bench/var/%u", i % nvars );
+        }
+        else
+        {
+            snprintf( name,
+                      sizeof( name ),
+                      "/bench/writer/%u",
+                      i - SUBSCRIBED_VARS );
+        }
+
+        hVar = VAR_FindByName( hVarServer, name );
+        if ( hVar != VAR_INVALID )
+        {
+            VAR_Notify( hVarServer, hVar, NOTIFY_MODIFIED );
+        }
+    }
+
+    phase = *pPhase;
+    phaseStart[PHASE_IDLE] = Now();
+    phaseStart[PHASE_LOADING] = phaseStart[PHASE_IDLE];
+
+    while ( ( hVarServer != NULL ) &&
+            ( stopRequested == 0 ) &&
+            ( *pPhase != PHASE_STOP ) )
+    {
+        if ( *pPhase != phase )
+        {
+            /* the loads have started */
+            phase = *pPhase;
+            phaseStart[phase] = Now();
+            samples[PHASE_IDLE].stats.elapsed =
+                phaseStart[phase] - phaseStart[PHASE_IDLE];
+        }
+
+        start = Now();
+
+        if ( type == CLIENT_READER )
+        {
+            snprintf( name,
+                      sizeof( name ),
+                      "${/bench/var/%u}",
+                      (unsigned int)rand() % nvars );
+            rc = TEMPLATE_StrToFile( hVarServer, name, nullfd );
+        }
+        else if ( type == CLIENT_WRITER )
+        {
+            snprintf( name, sizeof( name ), "/bench/writer/%u", id );
+            snprintf( value, sizeof( value ), "%llu",
+                      (unsigned long long)++seq );
+            rc = VAR_SetNameValue( hVarServer, name, value );
+        }
+        else
+        {
+            rc = ( VARSERVER_WaitSignal( &sigval ) == SIG_VAR_MODIFIED )
+                    ? EOK
+                    : EINTR;
+        }
+
+        if ( ( rc == EINTR ) && ( stopRequested != 0 ) )
+        {
+            /* woken to stop */
+        }
+        else if ( phase < PHASE_NUM_MEASURED )
+        {
+            samples[phase].stats.ops++;
+            if ( rc != EOK )
+            {
+                samples[phase].stats.errors++;
+            }
+
+            AddSample( &samples[phase], (uint32_t)( Now() - start ) );
+        }
+
+        if ( ( interval > 0 ) && ( type != CLIENT_SUBSCRIBER ) )
+        {
+            usleep( interval );
+        }
+    }
+
+    if ( phase < PHASE_NUM_MEASURED )
+    {
+        samples[phase].stats.elapsed = Now() - phaseStart[phase];
+    }
+
+    /* report the samples of each phase */
+    for ( i = 0; i < PHASE_NUM_MEASURED; i++ )
+    {
+        samples[i].stats.nsamples = samples[i].stats.ops;
+        if ( ( write( fd,
+                      &samples[i].stats,
+                      sizeof( PhaseStats ) ) != sizeof( PhaseStats ) ) ||
+             ( ( samples[i].stats.nsamples > 0 ) &&
+               ( write( fd,
+                        samples[i].pSamples,
+                        samples[i].stats.nsamples *
+                            sizeof( uint32_t ) ) < 0 ) ) )
+        {
+            break;
+        }
+    }
+
+    close( fd );
+    close( nullfd );
+
+    if ( hVarServer != NULL )
+    {
+        VARSERVER_Close( hVarServer );
+    }
+}
+
+/*==========================================================================*/
+/*  RunLoaders                                                              */
+/*!
+    Run the concurrent loadconfig instances
+
+    The RunLoaders function starts every loadconfig instance at once
+    and waits for them all to complete, recording the completion time
+    of each.
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @retval EOK the instances were run
+    @retval other error as returned by fork
+
+============================================================================*/
+static int RunLoaders( BenchState *pState )
+{
+    int result = EOK;
+    char cfg[PATH_MAX];
+    char *argv[MAX_LOADER_ARGS + 4];
+    pid_t pids[MAX_LOADERS];
+    uint64_t start;
+    unsigned int nstarted = 0;
+    unsigned int i;
+    int argc = 0;
+    int status;
+    int fd;
+    pid_t pid;
+
+    snprintf( cfg, sizeof( cfg ), "%s/bench.cfg", pState->pDir );
+
+    argv[argc++] = pState->pLoadconfig;
+    for ( i = 0; i < (unsigned int)pState->nloaderArgs; i++ )
+    {
+        argv[argc++] = pState->pLoaderArgs[i];
+    }
+    argv[argc++] = "-f";
+    argv[argc++] = cfg;
+    argv[argc] = NULL;
+
+    start = Now();
+
+    for ( i = 0; ( i < pState->nloaders ) && ( result == EOK ); i++ )
+    {
+        pids[i] = fork();
+        if ( pids[i] == 0 )
+        {
+            /* keep the report readable, errors still go to stderr */
+            fd = open( "/dev/null", O_WRONLY );
+            if ( fd != -1 )
+            {
+                dup2( fd, STDOUT_FILENO );
+            }
+
+            execvp( argv[0], argv );
+            _exit( 127 );
+        }
+        else if ( pids[i] > 0 )
+        {
+            nstarted++;
+        }
+        else
+        {
+            result = errno;
+        }
+    }
+
+    while ( nstarted > 0 )
+    {
+        pid = waitpid( -1, &status, 0 );
+        for ( i = 0; ( pid > 0 ) && ( i < pState->nloaders ); i++ )
+        {
+            if ( pids[i] == pid )
+            {
+                pState->loadTimes[i] = Now() - start;
+                if ( ( WIFEXITED( status ) == false ) ||
+                     ( WEXITSTATUS( status ) != 0 ) )
+                {
+                    pState->loadFailures++;
+                }
+
+                nstarted--;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  CollectClient                                                           */
+/*!
+    Collect the samples reported by a background client
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+    @param[in]
+        pClient
+            pointer to the client
+
+    @retval EOK the samples were collected
+    @retval EIO the client report was incomplete
+
+============================================================================*/
+static int CollectClient( BenchState *pState, Client *pClient )
+{
+    int result = EOK;
+    FILE *fp;
+    PhaseStats stats;
+    Samples *pSamples;
+    uint32_t sample;
+    uint64_t n;
+    int phase;
+
+    fp = fdopen( pClient->fd, "r" );
+    for ( phase = 0;
+          ( fp != NULL ) && ( result == EOK ) && ( phase < PHASE_NUM_MEASURED );
+          phase++ )
+    {
+        pSamples = &pState->samples[pClient->type][phase];
+        if ( fread( &stats, sizeof( stats ), 1, fp ) == 1 )
+        {
+            pSamples->stats.ops += stats.ops;
+            pSamples->stats.errors += stats.errors;
+
+            /* clients of a kind run concurrently */
+            if ( stats.elapsed > pSamples->stats.elapsed )
+            {
+                pSamples->stats.elapsed = stats.elapsed;
+            }
+
+            for ( n = 0; ( n < stats.nsamples ) && ( result == EOK ); n++ )
+            {
+                result = ( fread( &sample, sizeof( sample ), 1, fp ) == 1 )
+                            ? AddSample( pSamples, sample )
+                            : EIO;
+            }
+        }
+        else
+        {
+            result = EIO;
+        }
+    }
+
+    if ( fp != NULL )
+    {
+        fclose( fp );
+    }
+    else
+    {
+        close( pClient->fd );
+    }
+
+    waitpid( pClient->pid, NULL, 0 );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  AddSample                                                               */
+/*!
+    Add a latency sample
+
+    @param[in]
+        pSamples
+            pointer to the samples
+
+    @param[in]
+        sample
+            latency in microseconds
+
+    @retval EOK the sample was added
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int AddSample( Samples *pSamples, uint32_t sample )
+{
+    int result = EOK;
+    size_t size;
+    uint32_t *p;
+
+    if ( pSamples->stats.nsamples == pSamples->size )
+    {
+        size = ( pSamples->size > 0 ) ? pSamples->size * 2 : 1024;
+        p = realloc( pSamples->pSamples, size * sizeof( uint32_t ) );
+        if ( p != NULL )
+        {
+            pSamples->pSamples = p;
+            pSamples->size = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        pSamples->pSamples[pSamples->stats.nsamples++] = sample;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Report                                                                  */
+/*!
+    Report the benchmark results on stdout
+
+    @param[in]
+        pState
+            pointer to the benchmark state
+
+============================================================================*/
+static void Report( BenchState *pState )
+{
+    static const char *phaseNames[PHASE_NUM_MEASURED] = { "idle", "load" };
+    Samples *pSamples;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    uint64_t total = 0;
+    unsigned int i;
+    int type;
+    int phase;
+
+    for ( i = 0; i < pState->nloaders; i++ )
+    {
+        min = ( pState->loadTimes[i] < min ) ? pState->loadTimes[i] : min;
+        max = ( pState->loadTimes[i] > max ) ? pState->loadTimes[i] : max;
+        total += pState->loadTimes[i];
+    }
+
+    printf( "loadconfig: %u instances, %u variables, %u failed\n",
+            pState->nloaders,
+            pState->nvars,
+            pState->loadFailures );
+
+    if ( pState->nloaders > 0 )
+    {
+        printf( "  completion ms: min %.3f mean %.3f max %.3f, "
+                "%.0f assignments/s\n",
+                min / 1e3,
+                total / 1e3 / pState->nloaders,
+                max / 1e3,
+                ( max > 0 )
+                    ? (double)pState->nvars * pState->nloaders * 1e6 / max
+                    : 0.0 );
+    }
+
+    printf( "%-11s %-5s %10s %8s %8s %8s %8s %8s %10s\n",
+            "client", "phase", "ops", "errors",
+            "p50 us", "p90 us", "p99 us", "max us", "ops/s" );
+
+    for ( type = 0; type < CLIENT_NUM_TYPES; type++ )
+    {
+        for ( phase = 0;
+              ( phase < PHASE_NUM_MEASURED ) && ( pState->nclients[type] > 0 );
+              phase++ )
+        {
+            pSamples = &pState->samples[type][phase];
+            qsort( pSamples->pSamples,
+                   pSamples->stats.nsamples,
+                   sizeof( uint32_t ),
+                   CompareSamples );
+
+            printf( "%-11s %-5s %10llu %8llu %8u %8u %8u %8u %10.0f\n",
+                    clientNames[type],
+                    phaseNames[phase],
+                    (unsigned long long)pSamples->stats.ops,
+                    (unsigned long long)pSamples->stats.errors,
+                    Percentile( pSamples, 50 ),
+                    Percentile( pSamples, 90 ),
+                    Percentile( pSamples, 99 ),
+                    Percentile( pSamples, 100 ),
+                    ( pSamples->stats.elapsed > 0 )
+                        ? pSamples->stats.ops * 1e6 / pSamples->stats.elapsed
+                        : 0.0 );
+
+            free( pSamples->pSamples );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  Percentile                                                              */
+/*!
+    Get a percentile of sorted latency samples
+
+    @param[in]
+        pSamples
+            pointer to the sorted samples
+
+    @param[in]
+        percentile
+            percentile to calculate, from 0 to 100
+
+    @retval latency percentile in microseconds
+    @retval 0 if there are no samples
+
+============================================================================*/
+static uint32_t Percentile( Samples *pSamples, unsigned int percentile )
+{
+    size_t n = pSamples->stats.nsamples;
+
+    return ( n > 0 ) ? pSamples->pSamples[( n - 1 ) * percentile / 100] : 0;
+}
+
+/*==========================================================================*/
+/*  CompareSamples                                                          */
+/*!
+    Compare two latency samples for qsort
+
+    @param[in]
+        p1
+            pointer to the first sample
+
+    @param[in]
+        p2
+            pointer to the second sample
+
+    @retval negative, zero or positive as the first sample is less than,
+            equal to or greater than the second
+
+============================================================================*/
+static int CompareSamples( const void *p1, const void *p2 )
+{
+    uint32_t a = *(const uint32_t *)p1;
+    uint32_t b = *(const uint32_t *)p2;
+
+    return ( a > b ) - ( a < b );
+}
+
+/*==========================================================================*/
+/*  Now                                                                     */
+/*!
+    Get the monotonic time in microseconds
+
+    @return monotonic time in microseconds
+
+============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*==========================================================================*/
+/*  HandleSignal                                                            */
+/*!
+    Handle the signal which stops a background client
+
+    @param[in]
+        signum
+            number of the signal received
+
+============================================================================*/
+static void HandleSignal( int signum )
+{
+    (void)signum;
+    stopRequested = 1;
+}
+
+/*! @}
+ * end of loadbench group */
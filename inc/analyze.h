@@ -0,0 +1,106 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! column used to order the analysis report */
+typedef enum _AnalyzeSort
+{
+    /*! time spent in the file, excluding the files it includes */
+    ANALYZE_SORT_TIME = 0,
+
+    /*! size of the file */
+    ANALYZE_SORT_BYTES,
+
+    /*! number of lines in the file */
+    ANALYZE_SORT_LINES,
+
+    /*! number of assignments made by the file */
+    ANALYZE_SORT_ASSIGN,
+
+    /*! number of assignments overridden later */
+    ANALYZE_SORT_DEAD,
+
+    /*! number of optional includes which were missing */
+    ANALYZE_SORT_MISSING,
+
+    /*! number of ${} lookups performed */
+    ANALYZE_SORT_LOOKUPS,
+
+    /*! number of report columns */
+    ANALYZE_NUM_SORTS
+
+} AnalyzeSort;
+
+/*! file context saved by ANALYZE_Enter and restored by ANALYZE_Leave */
+typedef struct _AnalyzeMark
+{
+    /*! index of the file being analyzed */
+    int file;
+
+    /*! time the file was entered */
+    uint64_t start;
+
+    /*! time spent in files included by the file */
+    uint64_t child;
+
+    /*! context of the including file, or NULL */
+    struct _AnalyzeMark *pParent;
+
+} AnalyzeMark;
+
+/*! opaque configuration tree analysis */
+typedef struct _Analysis Analysis;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+Analysis *ANALYZE_Create( void );
+int ANALYZE_ParseSort( char *pName, AnalyzeSort *pSort );
+void ANALYZE_Enter( Analysis *pAnalysis,
+                    char *pFileName,
+                    AnalyzeMark *pMark );
+void ANALYZE_Leave( Analysis *pAnalysis, AnalyzeMark *pMark );
+void ANALYZE_Loaded( Analysis *pAnalysis, size_t bytes, size_t lines );
+void ANALYZE_Missing( Analysis *pAnalysis );
+void ANALYZE_Assign( Analysis *pAnalysis, char *pName );
+void ANALYZE_Lookups( Analysis *pAnalysis, size_t n );
+void ANALYZE_Report( Analysis *pAnalysis, AnalyzeSort sort, FILE *fp );
+void ANALYZE_Free( Analysis *pAnalysis );
+
+#endif
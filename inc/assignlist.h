@@ -0,0 +1,88 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef ASSIGNLIST_H
+#define ASSIGNLIST_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stddef.h>
+#include "vartable.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! expanded variable assignment */
+typedef struct _Assignment
+{
+    /*! name of the variable */
+    char *pName;
+
+    /*! value of the variable */
+    char *pValue;
+
+    /*! name of the configuration file containing the assignment */
+    char *pFileName;
+
+    /*! line number of the assignment within the configuration file */
+    int lineno;
+
+} Assignment;
+
+/*! ordered list of expanded variable assignments */
+typedef struct _AssignList
+{
+    /*! number of assignments in the list */
+    size_t count;
+
+    /*! number of assignments allocated */
+    size_t size;
+
+    /*! array of assignments in the order they were made */
+    Assignment *pAssignments;
+
+    /*! interned configuration file names */
+    VarTable *pFileNames;
+
+    /*! most recent value assigned to each variable */
+    VarTable *pValues;
+
+} AssignList;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+AssignList *ASSIGNLIST_Create( void );
+int ASSIGNLIST_Add( AssignList *pList,
+                    char *pName,
+                    char *pValue,
+                    char *pFileName,
+                    int lineno );
+void ASSIGNLIST_Free( AssignList *pList );
+
+#endif
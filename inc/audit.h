@@ -0,0 +1,70 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef AUDIT_H
+#define AUDIT_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include "assignlist.h"
+#include "varcall.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! totals of a drift audit */
+typedef struct _AuditTotals
+{
+    /*! number of variables audited */
+    size_t variables;
+
+    /*! number of namespaces audited */
+    size_t namespaces;
+
+    /*! number of namespaces whose values all matched */
+    size_t unchanged;
+
+    /*! number of variables whose live value differs */
+    size_t differ;
+
+} AuditTotals;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+int AUDIT_Run( AssignList *pList,
+               VarCall *pVarCall,
+               int fd,
+               char *pBuf,
+               size_t len,
+               FILE *fp,
+               AuditTotals *pTotals );
+
+#endif
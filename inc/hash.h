@@ -0,0 +1,48 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef HASH_H
+#define HASH_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! initial value for a 64-bit FNV-1a hash */
+#define HASH_FNV1A64_INIT   ( 0xcbf29ce484222325ULL )
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+uint64_t HASH_Fnv1a64( void *pData, size_t len, uint64_t hash );
+
+#endif
@@ -0,0 +1,88 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include "metrics.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! maximum length of the root file name stored in a history record */
+#define HISTORY_ROOT_LEN    ( 128 )
+
+/*! fixed size record of a load */
+typedef struct _HistoryRecord
+{
+    /*! time the load started, in seconds since the epoch */
+    int64_t timestamp;
+
+    /*! duration of the load in microseconds */
+    uint64_t durationUs;
+
+    /*! time spent in each load phase in microseconds */
+    uint64_t phaseUs[METRICS_NUM_PHASES];
+
+    /*! number of bytes of configuration read */
+    uint64_t bytes;
+
+    /*! number of configuration files loaded */
+    uint32_t files;
+
+    /*! number of assignments applied */
+    uint32_t applied;
+
+    /*! number of configuration lines which failed */
+    uint32_t errors;
+
+    /*! reserved, zero */
+    uint32_t reserved;
+
+    /*! NUL terminated root configuration file name, truncated */
+    char root[HISTORY_ROOT_LEN];
+
+} HistoryRecord;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+void HISTORY_Fill( HistoryRecord *pRecord,
+                   Metrics *pMetrics,
+                   char *pRootFile );
+int HISTORY_Append( char *pPath, HistoryRecord *pRecord );
+int HISTORY_Report( char *pPath,
+                    double factor,
+                    unsigned int window,
+                    FILE *fp );
+
+#endif
@@ -0,0 +1,55 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef INDEXCACHE_H
+#define INDEXCACHE_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "lineindex.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! opaque in-memory line index cache shared between evaluations */
+typedef struct _IndexCache IndexCache;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+IndexCache *INDEXCACHE_Create( void );
+LineIndex *INDEXCACHE_Get( IndexCache *pCache,
+                           char *pData,
+                           size_t len,
+                           bool *pHit );
+void INDEXCACHE_Release( IndexCache *pCache, LineIndex *pIndex );
+void INDEXCACHE_Free( IndexCache *pCache );
+
+#endif
@@ -0,0 +1,170 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! kind of configuration line */
+typedef enum lineKind
+{
+    /*! blank line */
+    LINE_BLANK = 0,
+
+    /*! comment line starting with # */
+    LINE_COMMENT,
+
+    /*! directive line starting with @ */
+    LINE_DIRECTIVE,
+
+    /*! variable assignment */
+    LINE_ASSIGNMENT
+
+} LineKind;
+
+/*! configuration directive type */
+typedef enum directiveType
+{
+    /*! not a directive */
+    DIRECTIVE_NONE = 0,
+
+    /*! unrecognized directive */
+    DIRECTIVE_UNKNOWN,
+
+    /*! @config directive */
+    DIRECTIVE_CONFIG,
+
+    /*! @include directive */
+    DIRECTIVE_INCLUDE,
+
+    /*! @require directive */
+    DIRECTIVE_REQUIRE,
+
+    /*! @includedir directive */
+    DIRECTIVE_INCLUDEDIR,
+
+    /*! @let directive */
+    DIRECTIVE_LET,
+
+    /*! @foreach directive */
+    DIRECTIVE_FOREACH,
+
+    /*! @end directive */
+    DIRECTIVE_END,
+
+    /*! @barrier directive */
+    DIRECTIVE_BARRIER,
+
+    /*! @ordered directive */
+    DIRECTIVE_ORDERED,
+
+    /*! @lazy directive */
+    DIRECTIVE_LAZY
+
+} DirectiveType;
+
+/*! pre-tokenized configuration line */
+typedef struct lineInfo
+{
+    /*! offset of the start of the line in the configuration data */
+    uint32_t offset;
+
+    /*! length of the line excluding the line break */
+    uint32_t length;
+
+    /*! kind of line (LineKind) */
+    uint8_t kind;
+
+    /*! directive type for directive lines (DirectiveType) */
+    uint8_t directive;
+
+    /*! number of ${} references in the line */
+    uint32_t nrefs;
+
+    /*! index of the first ${} reference in the reference table */
+    uint32_t refidx;
+
+    /*! offset within the line of the variable name or directive */
+    uint32_t nameoff;
+
+    /*! length of the variable name or directive */
+    uint32_t namelen;
+
+    /*! offset within the line of the value or directive argument */
+    uint32_t valoff;
+
+    /*! length of the value or directive argument */
+    uint32_t vallen;
+
+} LineInfo;
+
+/*! ${} reference segment within a configuration line */
+typedef struct refInfo
+{
+    /*! offset within the line of the ${ */
+    uint32_t offset;
+
+    /*! length of the reference including the ${ and } */
+    uint32_t length;
+
+} RefInfo;
+
+/*! pre-tokenized index of a buffer of configuration data */
+typedef struct lineIndex
+{
+    /*! number of lines */
+    uint32_t nlines;
+
+    /*! number of ${} references */
+    uint32_t nrefs;
+
+    /*! array of line information */
+    LineInfo *pLines;
+
+    /*! array of ${} references */
+    RefInfo *pRefs;
+
+} LineIndex;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+LineIndex *LINEINDEX_Build( char *pData, size_t len );
+LineIndex *LINEINDEX_Create( uint32_t nlines, uint32_t nrefs );
+void LINEINDEX_Terminate( LineIndex *pIndex, char *pData );
+void LINEINDEX_Free( LineIndex *pIndex );
+DirectiveType LINEINDEX_DirectiveType( char *pDirective, size_t len );
+
+#endif
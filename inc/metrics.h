@@ -0,0 +1,104 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "varcall.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! default prefix of the published metric variables */
+#define METRICS_DEFAULT_PREFIX  "/sys/loadconfig/"
+
+/*! load phases */
+typedef enum _MetricsPhase
+{
+    /*! reading configuration files */
+    METRICS_PHASE_IO = 0,
+
+    /*! scanning configuration files into line indexes */
+    METRICS_PHASE_PARSE,
+
+    /*! expanding variable references */
+    METRICS_PHASE_EXPAND,
+
+    /*! writing variables to the variable server */
+    METRICS_PHASE_WRITE,
+
+    /*! number of load phases */
+    METRICS_NUM_PHASES
+
+} MetricsPhase;
+
+/*! run metrics */
+typedef struct _Metrics
+{
+    /*! start time of the run */
+    uint64_t start;
+
+    /*! time spent in each phase in nanoseconds */
+    uint64_t phaseNs[METRICS_NUM_PHASES];
+
+    /*! number of configuration files loaded */
+    size_t files;
+
+    /*! number of bytes of configuration read */
+    size_t bytes;
+
+    /*! number of assignments applied */
+    size_t applied;
+
+    /*! number of unchanged assignments skipped */
+    size_t skipped;
+
+    /*! number of configuration lines which failed */
+    size_t errors;
+
+    /*! number of parse cache lookups */
+    size_t cacheLookups;
+
+    /*! number of parse cache hits */
+    size_t cacheHits;
+
+} Metrics;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+void METRICS_Init( Metrics *pMetrics );
+uint64_t METRICS_Now( void );
+void METRICS_AddPhase( Metrics *pMetrics, MetricsPhase phase, uint64_t start );
+int METRICS_Publish( Metrics *pMetrics, VarCall *pVarCall, char *pPrefix );
+
+#endif
@@ -0,0 +1,75 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <getopt.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! reentrant command line option parser state */
+typedef struct _OptionParser
+{
+    /*! number of arguments */
+    int argc;
+
+    /*! array of pointers to the arguments */
+    char **argv;
+
+    /*! short options in getopt format */
+    const char *pShort;
+
+    /*! long options terminated by an all zero entry */
+    const struct option *pLong;
+
+    /*! index of the argument being parsed */
+    int index;
+
+    /*! position of the next short option within the argument, or 0 */
+    int pos;
+
+    /*! argument of the last option, or NULL if it has none */
+    char *pArg;
+
+} OptionParser;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+void OPTIONS_Init( OptionParser *pParser,
+                   int argc,
+                   char **argv,
+                   const char *pShort,
+                   const struct option *pLong );
+int OPTIONS_Next( OptionParser *pParser );
+
+#endif
@@ -0,0 +1,53 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef PACER_H
+#define PACER_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! opaque write pacing controller */
+typedef struct _Pacer Pacer;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+Pacer *PACER_Create( uint32_t targetUs, bool idle );
+uint64_t PACER_Delay( Pacer *pPacer );
+void PACER_Record( Pacer *pPacer, uint64_t latencyNs );
+void PACER_PrintStats( Pacer *pPacer, FILE *fp );
+void PACER_Free( Pacer *pPacer );
+
+#endif
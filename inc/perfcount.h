@@ -0,0 +1,88 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! load phases measured by the performance counters */
+typedef enum _PerfPhase
+{
+    /*! processing configuration lines outside of the other phases */
+    PERF_PHASE_DISPATCH = 0,
+
+    /*! reading configuration files */
+    PERF_PHASE_IO,
+
+    /*! scanning configuration files into line indexes */
+    PERF_PHASE_SCAN,
+
+    /*! expanding variable references */
+    PERF_PHASE_EXPAND,
+
+    /*! writing variables to the variable server */
+    PERF_PHASE_WRITE,
+
+    /*! number of measured phases */
+    PERF_NUM_PHASES
+
+} PerfPhase;
+
+/*! phase context saved by PERFCOUNT_Enter and restored by PERFCOUNT_Leave */
+typedef struct _PerfMark
+{
+    /*! index of the file being measured */
+    int file;
+
+    /*! phase being measured */
+    PerfPhase phase;
+
+} PerfMark;
+
+/*! opaque performance counter set */
+typedef struct _PerfCounters PerfCounters;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+PerfCounters *PERFCOUNT_Create( void );
+void PERFCOUNT_Enter( PerfCounters *pPerf,
+                      char *pFileName,
+                      PerfPhase phase,
+                      PerfMark *pMark );
+void PERFCOUNT_Leave( PerfCounters *pPerf, PerfMark *pMark );
+void PERFCOUNT_Report( PerfCounters *pPerf, FILE *fp );
+void PERFCOUNT_Free( PerfCounters *pPerf );
+
+#endif
@@ -0,0 +1,72 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef PROVENANCE_H
+#define PROVENANCE_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! opaque provenance index under construction */
+typedef struct _Provenance Provenance;
+
+/*! opaque provenance index loaded from a file */
+typedef struct _ProvenanceIndex ProvenanceIndex;
+
+/*! function called with the final assignment of each variable */
+typedef int (*ProvenanceFn)( char *pName,
+                             char *pValue,
+                             char *pFileName,
+                             int lineno,
+                             void *arg );
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+Provenance *PROVENANCE_Create( void );
+int PROVENANCE_Add( Provenance *pProvenance,
+                    char *pName,
+                    char *pValue,
+                    char *pRaw,
+                    char *pFileName,
+                    int lineno );
+int PROVENANCE_Save( Provenance *pProvenance, char *pPath );
+void PROVENANCE_Free( Provenance *pProvenance );
+
+ProvenanceIndex *PROVENANCE_Open( char *pPath );
+int PROVENANCE_Print( ProvenanceIndex *pIndex, char *pName, FILE *fp );
+int PROVENANCE_ForEach( ProvenanceIndex *pIndex,
+                        ProvenanceFn fn,
+                        void *arg );
+void PROVENANCE_Close( ProvenanceIndex *pIndex );
+
+#endif
@@ -0,0 +1,65 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef RESIDENT_H
+#define RESIDENT_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vartable.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! opaque resident value provider */
+typedef struct _Resident Resident;
+
+/*! function called to load a lazy include when one of its variables is
+    first requested */
+typedef int (*ResidentLoadFn)( void *arg, char *pFileName );
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+Resident *RESIDENT_Create( VarTable *pValues );
+int RESIDENT_AddNamespace( Resident *pResident, char *pPrefix );
+int RESIDENT_AddInclude( Resident *pResident,
+                         char *pPrefix,
+                         char *pFileName );
+int RESIDENT_Declare( Resident *pResident, char *pName );
+bool RESIDENT_Match( Resident *pResident, char *pName, size_t len );
+char *RESIDENT_Pending( Resident *pResident, char *pName, size_t len );
+int RESIDENT_Run( Resident *pResident,
+                  ResidentLoadFn fn,
+                  void *arg,
+                  bool verbose );
+void RESIDENT_Free( Resident *pResident );
+
+#endif
@@ -0,0 +1,91 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! load request received by the loader service */
+typedef struct _ServerRequest
+{
+    /*! name of the root configuration file */
+    char *pFileName;
+
+    /*! only apply variables whose names start with this prefix, or NULL */
+    char *pPrefix;
+
+    /*! evaluate the configuration without writing variables */
+    bool dryRun;
+
+} ServerRequest;
+
+/*! reply to a load request */
+typedef struct _ServerReply
+{
+    /*! result of the load */
+    int result;
+
+    /*! number of configuration files loaded */
+    size_t files;
+
+    /*! number of assignments applied */
+    size_t applied;
+
+    /*! number of assignments skipped */
+    size_t skipped;
+
+    /*! number of configuration errors */
+    size_t errors;
+
+    /*! duration of the load in microseconds */
+    uint64_t elapsedUs;
+
+    /*! number of other requests which shared the load */
+    size_t coalesced;
+
+} ServerReply;
+
+/*! function which performs a load request */
+typedef int (*ServerLoadFn)( void *arg,
+                             ServerRequest *pRequest,
+                             ServerReply *pReply );
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+int SERVER_Run( char *pSocketPath, ServerLoadFn fn, void *arg );
+
+#endif
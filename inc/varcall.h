@@ -0,0 +1,108 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef VARCALL_H
+#define VARCALL_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <varserver/varserver.h>
+#include "varlog.h"
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! default base delay between retries in milliseconds */
+#define VARCALL_DEFAULT_BACKOFF_MS  20
+
+/*! function called when a deferred write is confirmed */
+typedef void (*VarCallConfirmFn)( void *arg, char *pName, char *pValue );
+
+/*! variable server call options */
+typedef struct _VarCallOptions
+{
+    /*! maximum time for each call in milliseconds, 0 for no limit */
+    unsigned long callTimeoutMs;
+
+    /*! maximum time for the whole run in milliseconds, 0 for no limit */
+    unsigned long runTimeoutMs;
+
+    /*! number of times a failed or timed out call is retried */
+    unsigned int retries;
+
+    /*! base delay between retries in milliseconds */
+    unsigned long backoffMs;
+
+    /*! queue writes while the variable server is unavailable */
+    bool queue;
+
+    /*! log to record calls into or replay calls from, or NULL for none */
+    VarLog *pLog;
+
+    /*! target write latency in microseconds for pacing, 0 for none */
+    unsigned long paceTargetUs;
+
+    /*! pace writes to back off whenever other clients are active */
+    bool paceIdle;
+
+    /*! function called when a queued write is applied, or NULL */
+    VarCallConfirmFn confirm;
+
+    /*! argument passed to the confirm function */
+    void *pConfirmArg;
+
+} VarCallOptions;
+
+/*! opaque variable server call context */
+typedef struct _VarCall VarCall;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+VarCall *VARCALL_Create( VarCallOptions *pOptions, char *pLabel );
+int VARCALL_Open( VarCall *pVarCall );
+int VARCALL_SetNameValue( VarCall *pVarCall,
+                          char *pName,
+                          char *pValue,
+                          char *pFileName,
+                          int lineno );
+int VARCALL_StrToFile( VarCall *pVarCall,
+                       char *pStr,
+                       int fd,
+                       char *pBuf,
+                       size_t len );
+int VARCALL_Drain( VarCall *pVarCall );
+void VARCALL_PrintStats( VarCall *pVarCall, FILE *fp );
+uint32_t VARCALL_Percentile( VarCall *pVarCall, unsigned int percentile );
+void VARCALL_Close( VarCall *pVarCall );
+
+#endif
@@ -0,0 +1,98 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef VARLOG_H
+#define VARLOG_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! type of recorded interaction */
+typedef enum _VarLogType
+{
+    /*! variable server open */
+    VARLOG_OPEN = 0,
+
+    /*! variable assignment */
+    VARLOG_SET,
+
+    /*! template expansion */
+    VARLOG_EXPAND,
+
+    /*! configuration file read */
+    VARLOG_FILE,
+
+    /*! number of interaction types */
+    VARLOG_NUM_TYPES
+
+} VarLogType;
+
+/*! recorded interaction returned during replay */
+typedef struct _VarLogEntry
+{
+    /*! recorded result */
+    int result;
+
+    /*! pointer to the NUL terminated recorded response data */
+    char *pData;
+
+    /*! length of the response data */
+    size_t len;
+
+} VarLogEntry;
+
+/*! opaque record or replay log */
+typedef struct _VarLog VarLog;
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+VarLog *VARLOG_Create( char *pFileName );
+VarLog *VARLOG_Load( char *pFileName, bool latency );
+bool VARLOG_IsReplay( VarLog *pLog );
+void VARLOG_Add( VarLog *pLog,
+                 VarLogType type,
+                 int result,
+                 uint64_t latencyNs,
+                 char *pKey,
+                 char *pData,
+                 size_t len );
+int VARLOG_Next( VarLog *pLog,
+                 VarLogType type,
+                 char *pKey,
+                 VarLogEntry *pEntry );
+char *VARLOG_GetFile( VarLog *pLog, char *pFileName );
+int VARLOG_Close( VarLog *pLog );
+
+#endif
@@ -0,0 +1,78 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+#ifndef VARTABLE_H
+#define VARTABLE_H
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stddef.h>
+
+/*============================================================================
+        Public definitions
+============================================================================*/
+
+/*! variable table entry */
+typedef struct _VarEntry
+{
+    /*! name of the variable */
+    char *name;
+
+    /*! value of the variable */
+    char *value;
+
+    /*! opaque user data associated with the variable */
+    void *pData;
+
+    /*! user defined flags associated with the variable */
+    int flags;
+
+    /*! pointer to the next entry in the hash bucket */
+    struct _VarEntry *pNext;
+
+} VarEntry;
+
+/*! opaque variable table */
+typedef struct _VarTable VarTable;
+
+/*! function called for each entry in a variable table */
+typedef int (*VarTableFn)( VarEntry *pEntry, void *arg );
+
+/*============================================================================
+        Public function declarations
+============================================================================*/
+
+VarTable *VARTABLE_Create( size_t size );
+void VARTABLE_Destroy( VarTable *pVarTable );
+int VARTABLE_Set( VarTable *pVarTable, char *name, char *value );
+int VARTABLE_Remove( VarTable *pVarTable, char *name );
+char *VARTABLE_Get( VarTable *pVarTable, char *name );
+VarEntry *VARTABLE_Find( VarTable *pVarTable, char *name );
+VarEntry *VARTABLE_FindN( VarTable *pVarTable, char *name, size_t len );
+int VARTABLE_ForEach( VarTable *pVarTable, VarTableFn fn, void *arg );
+size_t VARTABLE_Count( VarTable *pVarTable );
+
+#endif
@@ -0,0 +1,685 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup analyze analyze
+ * @brief Configuration tree cost analysis
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file analyze.c
+
+    Configuration Tree Analysis
+
+    The Configuration Tree Analysis functions gather the cost of each
+    configuration file during a load: its size, the assignments it makes,
+    the assignments which are overridden by a later assignment to the
+    same variable (dead writes), the optional includes it references
+    which do not exist, the ${} lookups it performs, and the time spent
+    processing it.
+
+    The time of each file excludes the time spent in the files it
+    includes, so the times of all files add up to the time of the whole
+    load.  A file which is processed more than once is reported once
+    with the totals of every time it was processed.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include "vartable.h"
+#include "analyze.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! initial number of files in an analysis */
+#define ANALYZE_DEFAULT_SIZE 16
+
+/*! costs of a configuration file */
+typedef struct _FileStats
+{
+    /*! name of the configuration file */
+    char *pFileName;
+
+    /*! number of times the file was processed */
+    uint64_t loads;
+
+    /*! values of the report columns */
+    uint64_t values[ANALYZE_NUM_SORTS];
+
+} FileStats;
+
+/*! row of the analysis report */
+typedef struct _ReportRow
+{
+    /*! value of the sort column */
+    uint64_t key;
+
+    /*! costs of the file */
+    FileStats *pStats;
+
+} ReportRow;
+
+/*! configuration tree analysis */
+struct _Analysis
+{
+    /*! costs of each file */
+    FileStats *pFiles;
+
+    /*! number of files */
+    size_t count;
+
+    /*! number of files allocated */
+    size_t size;
+
+    /*! index of each file, plus one */
+    VarTable *pIndex;
+
+    /*! index of the file which made the latest assignment to each
+        variable, plus one */
+    VarTable *pWriters;
+
+    /*! context of the file being processed, or NULL */
+    AnalyzeMark *pTop;
+};
+
+/*! names of the report columns */
+static char *columns[ANALYZE_NUM_SORTS] =
+{
+    "time",
+    "bytes",
+    "lines",
+    "assign",
+    "dead",
+    "missing",
+    "lookups"
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int FindFile( Analysis *pAnalysis, char *pFileName );
+static FileStats *Current( Analysis *pAnalysis );
+static int CompareRows( const void *p1, const void *p2 );
+static uint64_t Now( void );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  ANALYZE_Create                                                          */
+/*!
+    Create an empty configuration tree analysis
+
+    @retval pointer to the new analysis
+    @retval NULL if the analysis could not be created
+
+============================================================================*/
+Analysis *ANALYZE_Create( void )
+{
+    Analysis *pAnalysis;
+
+    pAnalysis = calloc( 1, sizeof( Analysis ) );
+    if ( pAnalysis != NULL )
+    {
+        pAnalysis->pIndex = VARTABLE_Create( 0 );
+        pAnalysis->pWriters = VARTABLE_Create( 0 );
+        if ( ( pAnalysis->pIndex == NULL ) ||
+             ( pAnalysis->pWriters == NULL ) )
+        {
+            ANALYZE_Free( pAnalysis );
+            pAnalysis = NULL;
+        }
+    }
+
+    return pAnalysis;
+}
+
+/*==========================================================================*/
+/*  ANALYZE_ParseSort                                                       */
+/*!
+    Get the report column with the specified name
+
+    @param[in]
+        pName
+            pointer to the NUL terminated column name, one of time,
+            bytes, lines, assign, dead, missing or lookups
+
+    @param[out]
+        pSort
+            pointer to the location to store the report column
+
+    @retval EOK the column name is valid
+    @retval EINVAL the column name is not valid
+
+============================================================================*/
+int ANALYZE_ParseSort( char *pName, AnalyzeSort *pSort )
+{
+    int result = EINVAL;
+    int i;
+
+    for ( i = 0; ( i < ANALYZE_NUM_SORTS ) && ( pName != NULL ); i++ )
+    {
+        if ( strcmp( pName, columns[i] ) == 0 )
+        {
+            *pSort = (AnalyzeSort)i;
+            result = EOK;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Enter                                                           */
+/*!
+    Start analyzing a configuration file
+
+    The ANALYZE_Enter function makes the specified file the current
+    file, until the matching call to ANALYZE_Leave.
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @param[out]
+        pMark
+            pointer to the context to restore with ANALYZE_Leave
+
+============================================================================*/
+void ANALYZE_Enter( Analysis *pAnalysis,
+                    char *pFileName,
+                    AnalyzeMark *pMark )
+{
+    if ( ( pAnalysis != NULL ) &&
+         ( pMark != NULL ) )
+    {
+        pMark->file = FindFile( pAnalysis, pFileName );
+        pMark->child = 0;
+        pMark->pParent = pAnalysis->pTop;
+        pMark->start = Now();
+        pAnalysis->pTop = pMark;
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Leave                                                           */
+/*!
+    Stop analyzing a configuration file
+
+    The ANALYZE_Leave function adds the time since the matching call
+    to ANALYZE_Enter, less the time spent in included files, to the
+    current file, and makes the including file current again.  The time
+    spent looking for a file which does not exist is left with the
+    including file.
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @param[in]
+        pMark
+            pointer to the context saved by ANALYZE_Enter
+
+============================================================================*/
+void ANALYZE_Leave( Analysis *pAnalysis, AnalyzeMark *pMark )
+{
+    uint64_t elapsed;
+    FileStats *pStats;
+
+    if ( ( pAnalysis != NULL ) &&
+         ( pMark != NULL ) )
+    {
+        elapsed = Now() - pMark->start;
+        if ( pMark->file >= 0 )
+        {
+            pStats = &pAnalysis->pFiles[pMark->file];
+            if ( pStats->loads > 0 )
+            {
+                pStats->values[ANALYZE_SORT_TIME] += elapsed - pMark->child;
+                if ( pMark->pParent != NULL )
+                {
+                    pMark->pParent->child += elapsed;
+                }
+            }
+        }
+
+        pAnalysis->pTop = pMark->pParent;
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Loaded                                                          */
+/*!
+    Record the size of the current configuration file
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @param[in]
+        bytes
+            length of the configuration file
+
+    @param[in]
+        lines
+            number of lines in the configuration file
+
+============================================================================*/
+void ANALYZE_Loaded( Analysis *pAnalysis, size_t bytes, size_t lines )
+{
+    FileStats *pStats = Current( pAnalysis );
+
+    if ( pStats != NULL )
+    {
+        pStats->loads++;
+        pStats->values[ANALYZE_SORT_BYTES] += bytes;
+        pStats->values[ANALYZE_SORT_LINES] += lines;
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Missing                                                         */
+/*!
+    Record that the current configuration file does not exist
+
+    The missing file is counted against the file which included it.
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+============================================================================*/
+void ANALYZE_Missing( Analysis *pAnalysis )
+{
+    AnalyzeMark *pParent;
+
+    if ( ( pAnalysis != NULL ) &&
+         ( pAnalysis->pTop != NULL ) )
+    {
+        pParent = pAnalysis->pTop->pParent;
+        if ( ( pParent != NULL ) &&
+             ( pParent->file >= 0 ) )
+        {
+            pAnalysis->pFiles[pParent->file].values[ANALYZE_SORT_MISSING]++;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Assign                                                          */
+/*!
+    Record an assignment made by the current configuration file
+
+    If the variable was already assigned, the earlier assignment is
+    counted as a dead write against the file which made it.
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+============================================================================*/
+void ANALYZE_Assign( Analysis *pAnalysis, char *pName )
+{
+    FileStats *pStats = Current( pAnalysis );
+    VarEntry *pEntry;
+    uintptr_t prev;
+
+    if ( ( pStats != NULL ) &&
+         ( pName != NULL ) )
+    {
+        pStats->values[ANALYZE_SORT_ASSIGN]++;
+
+        pEntry = VARTABLE_Find( pAnalysis->pWriters, pName );
+        if ( pEntry != NULL )
+        {
+            prev = (uintptr_t)pEntry->pData;
+            if ( prev > 0 )
+            {
+                pAnalysis->pFiles[prev - 1].values[ANALYZE_SORT_DEAD]++;
+            }
+        }
+        else if ( VARTABLE_Set( pAnalysis->pWriters, pName, "" ) == EOK )
+        {
+            pEntry = VARTABLE_Find( pAnalysis->pWriters, pName );
+        }
+
+        if ( pEntry != NULL )
+        {
+            pEntry->pData = (void *)(uintptr_t)( pAnalysis->pTop->file + 1 );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Lookups                                                         */
+/*!
+    Record ${} lookups performed by the current configuration file
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @param[in]
+        n
+            number of lookups performed
+
+============================================================================*/
+void ANALYZE_Lookups( Analysis *pAnalysis, size_t n )
+{
+    FileStats *pStats = Current( pAnalysis );
+
+    if ( pStats != NULL )
+    {
+        pStats->values[ANALYZE_SORT_LOOKUPS] += n;
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Report                                                          */
+/*!
+    Print the analysis report
+
+    The ANALYZE_Report function prints one line per configuration file,
+    ordered by the specified column with the largest value first,
+    followed by the totals.  Times are in microseconds, and the share
+    is the percentage of the total time.
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @param[in]
+        sort
+            column to order the report by
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+============================================================================*/
+void ANALYZE_Report( Analysis *pAnalysis, AnalyzeSort sort, FILE *fp )
+{
+    ReportRow *pRows = NULL;
+    FileStats totals;
+    FileStats *pStats;
+    size_t nrows = 0;
+    size_t i;
+    int j;
+
+    if ( ( pAnalysis != NULL ) &&
+         ( fp != NULL ) &&
+         ( sort < ANALYZE_NUM_SORTS ) )
+    {
+        pRows = calloc( pAnalysis->count + 1, sizeof( ReportRow ) );
+    }
+
+    if ( pRows != NULL )
+    {
+        memset( &totals, 0, sizeof( FileStats ) );
+        totals.pFileName = "total";
+
+        for ( i = 0; i < pAnalysis->count; i++ )
+        {
+            pStats = &pAnalysis->pFiles[i];
+            if ( pStats->loads > 0 )
+            {
+                pRows[nrows].key = pStats->values[sort];
+                pRows[nrows].pStats = pStats;
+                nrows++;
+
+                for ( j = 0; j < ANALYZE_NUM_SORTS; j++ )
+                {
+                    totals.values[j] += pStats->values[j];
+                }
+            }
+        }
+
+        qsort( pRows, nrows, sizeof( ReportRow ), CompareRows );
+        pRows[nrows].pStats = &totals;
+
+        fprintf( fp,
+                 "%9s %7s %7s %7s %7s %7s %9s %6s  %s\n",
+                 "bytes",
+                 "lines",
+                 "assign",
+                 "dead",
+                 "missing",
+                 "lookups",
+                 "time(us)",
+                 "share",
+                 "file" );
+
+        for ( i = 0; i <= nrows; i++ )
+        {
+            pStats = pRows[i].pStats;
+            fprintf( fp,
+                     "%9llu %7llu %7llu %7llu %7llu %7llu %9llu %5.1f%%  %s\n",
+                     (unsigned long long)pStats->values[ANALYZE_SORT_BYTES],
+                     (unsigned long long)pStats->values[ANALYZE_SORT_LINES],
+                     (unsigned long long)pStats->values[ANALYZE_SORT_ASSIGN],
+                     (unsigned long long)pStats->values[ANALYZE_SORT_DEAD],
+                     (unsigned long long)pStats->values[ANALYZE_SORT_MISSING],
+                     (unsigned long long)pStats->values[ANALYZE_SORT_LOOKUPS],
+                     (unsigned long long)
+                        ( pStats->values[ANALYZE_SORT_TIME] / 1000 ),
+                     ( totals.values[ANALYZE_SORT_TIME] > 0 )
+                        ? 100.0 * pStats->values[ANALYZE_SORT_TIME] /
+                                  totals.values[ANALYZE_SORT_TIME]
+                        : 0.0,
+                     pStats->pFileName );
+        }
+
+        free( pRows );
+    }
+}
+
+/*==========================================================================*/
+/*  ANALYZE_Free                                                            */
+/*!
+    Free a configuration tree analysis
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis to free
+
+============================================================================*/
+void ANALYZE_Free( Analysis *pAnalysis )
+{
+    if ( pAnalysis != NULL )
+    {
+        VARTABLE_Destroy( pAnalysis->pIndex );
+        VARTABLE_Destroy( pAnalysis->pWriters );
+        free( pAnalysis->pFiles );
+        free( pAnalysis );
+    }
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FindFile                                                                */
+/*!
+    Find or add the costs of a configuration file
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @retval index of the file's costs
+    @retval -1 memory allocation failure
+
+============================================================================*/
+static int FindFile( Analysis *pAnalysis, char *pFileName )
+{
+    int result = -1;
+    VarEntry *pEntry;
+    FileStats *pFiles;
+    size_t n;
+
+    pEntry = VARTABLE_Find( pAnalysis->pIndex, pFileName );
+    if ( pEntry != NULL )
+    {
+        result = (int)(uintptr_t)pEntry->pData - 1;
+    }
+    else
+    {
+        if ( pAnalysis->count == pAnalysis->size )
+        {
+            n = ( pAnalysis->size == 0 ) ? ANALYZE_DEFAULT_SIZE
+                                         : pAnalysis->size * 2;
+            pFiles = realloc( pAnalysis->pFiles, n * sizeof( FileStats ) );
+            if ( pFiles != NULL )
+            {
+                pAnalysis->pFiles = pFiles;
+                pAnalysis->size = n;
+            }
+        }
+
+        if ( ( pAnalysis->count < pAnalysis->size ) &&
+             ( VARTABLE_Set( pAnalysis->pIndex, pFileName, "" ) == EOK ) )
+        {
+            pEntry = VARTABLE_Find( pAnalysis->pIndex, pFileName );
+        }
+
+        if ( pEntry != NULL )
+        {
+            result = (int)pAnalysis->count++;
+            memset( &pAnalysis->pFiles[result], 0, sizeof( FileStats ) );
+            pAnalysis->pFiles[result].pFileName = pEntry->name;
+            pEntry->pData = (void *)(uintptr_t)( result + 1 );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Current                                                                 */
+/*!
+    Get the costs of the current configuration file
+
+    @param[in]
+        pAnalysis
+            pointer to the analysis, or NULL if not analyzing
+
+    @retval pointer to the costs of the current file
+    @retval NULL if there is no current file
+
+============================================================================*/
+static FileStats *Current( Analysis *pAnalysis )
+{
+    FileStats *pStats = NULL;
+
+    if ( ( pAnalysis != NULL ) &&
+         ( pAnalysis->pTop != NULL ) &&
+         ( pAnalysis->pTop->file >= 0 ) )
+    {
+        pStats = &pAnalysis->pFiles[pAnalysis->pTop->file];
+    }
+
+    return pStats;
+}
+
+/*==========================================================================*/
+/*  CompareRows                                                             */
+/*!
+    Compare two report rows for sorting, largest value first
+
+    @param[in]
+        p1
+            pointer to the first row
+
+    @param[in]
+        p2
+            pointer to the second row
+
+    @retval -1 the first row sorts first
+    @retval 0 the rows have the same value
+    @retval 1 the second row sorts first
+
+============================================================================*/
+static int CompareRows( const void *p1, const void *p2 )
+{
+    const ReportRow *pRow1 = p1;
+    const ReportRow *pRow2 = p2;
+
+    return ( pRow1->key < pRow2->key ) - ( pRow1->key > pRow2->key );
+}
+
+/*==========================================================================*/
+/*  Now                                                                     */
+/*!
+    Get the current monotonic time
+
+    @retval current monotonic time in nanoseconds
+
+============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*! @}
+ * end of analyze group */
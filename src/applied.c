@@ -0,0 +1,291 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup applied applied
+ * @brief Applied assignment state
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file applied.c
+
+    Applied Assignment State
+
+    The Applied Assignment State functions maintain a small sidecar file
+    for each configuration file which records the expanded assignments
+    that were applied from that file during the previous run.
+
+    Each sidecar is named using the hash of the configuration file name.
+    The first line holds the configuration file name, and each following
+    line holds a variable name and its value separated by a TAB.
+
+    The incremental loading mode uses the sidecar to only send
+    assignments which have been added or changed since the previous run.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include "fileutil.h"
+#include "applied.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! sidecar file name suffix */
+#define APPLIED_SUFFIX  ".applied"
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int WriteEntry( VarEntry *pEntry, void *arg );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  APPLIED_Load                                                            */
+/*!
+    Load the applied assignments for a configuration file
+
+    The APPLIED_Load function reads the sidecar file for the specified
+    configuration file into a new variable table.  If there is no
+    sidecar, or it belongs to a different configuration file, an empty
+    table is returned.
+
+    @param[in]
+        pDir
+            pointer to the NUL terminated sidecar directory name
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @retval pointer to a variable table of applied assignments
+    @retval NULL if the table could not be created
+
+============================================================================*/
+VarTable *APPLIED_Load( char *pDir, char *pFileName )
+{
+    VarTable *pApplied;
+    char path[PATH_MAX];
+    char *pLine = NULL;
+    size_t size = 0;
+    ssize_t n;
+    char *pValue;
+    bool valid = false;
+    FILE *fp;
+
+    pApplied = VARTABLE_Create( 0 );
+    if ( ( pApplied != NULL ) &&
+         ( pFileName != NULL ) &&
+         ( FILEUTIL_KeyPath( pDir,
+                             pFileName,
+                             APPLIED_SUFFIX,
+                             path,
+                             sizeof( path ) ) == EOK ) )
+    {
+        fp = fopen( path, "r" );
+        if ( fp != NULL )
+        {
+            while ( ( n = getline( &pLine, &size, fp ) ) > 0 )
+            {
+                if ( pLine[n-1] == '\n' )
+                {
+                    pLine[n-1] = '\0';
+                }
+
+                if ( valid == false )
+                {
+                    /* check the sidecar belongs to this file */
+                    if ( strcmp( pLine, pFileName ) != 0 )
+                    {
+                        break;
+                    }
+
+                    valid = true;
+                }
+                else
+                {
+                    pValue = strchr( pLine, '\t' );
+                    if ( pValue != NULL )
+                    {
+                        *pValue++ = '\0';
+                        VARTABLE_Set( pApplied, pLine, pValue );
+                    }
+                }
+            }
+
+            free( pLine );
+            fclose( fp );
+        }
+    }
+
+    return pApplied;
+}
+
+/*==========================================================================*/
+/*  APPLIED_Save                                                            */
+/*!
+    Save the applied assignments for a configuration file
+
+    The APPLIED_Save function writes the sidecar file for the specified
+    configuration file.  Entries flagged with APPLIED_FLAG_FAILED are
+    not saved so they will be sent again on the next run.  The sidecar
+    is replaced atomically.
+
+    @param[in]
+        pDir
+            pointer to the NUL terminated sidecar directory name
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @param[in]
+        pApplied
+            pointer to the variable table of applied assignments
+
+    @retval EOK the sidecar was saved
+    @retval EINVAL invalid arguments
+    @retval other error as returned by the file system
+
+============================================================================*/
+int APPLIED_Save( char *pDir, char *pFileName, VarTable *pApplied )
+{
+    int result = EINVAL;
+    char path[PATH_MAX];
+    char tmppath[PATH_MAX];
+    FILE *fp;
+
+    if ( ( pDir != NULL ) &&
+         ( pFileName != NULL ) &&
+         ( pApplied != NULL ) )
+    {
+        result = FILEUTIL_MakeDirs( pDir );
+        if ( result == EOK )
+        {
+            result = FILEUTIL_KeyPath( pDir,
+                                       pFileName,
+                                       APPLIED_SUFFIX,
+                                       path,
+                                       sizeof( path ) );
+        }
+
+        if ( ( result == EOK ) &&
+             ( snprintf( tmppath,
+                         sizeof( tmppath ),
+                         "%s.%d",
+                         path,
+                         getpid() ) >= (int)sizeof( tmppath ) ) )
+        {
+            result = ENAMETOOLONG;
+        }
+
+        if ( result == EOK )
+        {
+            fp = fopen( tmppath, "w" );
+            if ( fp != NULL )
+            {
+                fprintf( fp, "%s\n", pFileName );
+                VARTABLE_ForEach( pApplied, WriteEntry, fp );
+
+                result = ( fclose( fp ) == 0 ) ? EOK : errno;
+                if ( result == EOK )
+                {
+                    if ( rename( tmppath, path ) != 0 )
+                    {
+                        result = errno;
+                    }
+                }
+
+                if ( result != EOK )
+                {
+                    unlink( tmppath );
+                }
+            }
+            else
+            {
+                result = errno;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  WriteEntry                                                              */
+/*!
+    Write an applied assignment to a sidecar file
+
+    @param[in]
+        pEntry
+            pointer to the applied assignment
+
+    @param[in]
+        arg
+            pointer to the open sidecar FILE
+
+    @retval EOK the entry was written or skipped
+
+============================================================================*/
+static int WriteEntry( VarEntry *pEntry, void *arg )
+{
+    FILE *fp = (FILE *)arg;
+
+    if ( ( pEntry->flags & APPLIED_FLAG_FAILED ) == 0 )
+    {
+        fprintf( fp, "%s\t%s\n", pEntry->name, pEntry->value );
+    }
+
+    return EOK;
+}
+
+/*! @}
+ * end of applied group */
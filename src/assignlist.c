@@ -0,0 +1,246 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup assignlist assignlist
+ * @brief Expanded assignment list
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file assignlist.c
+
+    Expanded Assignment List
+
+    The Expanded Assignment List functions collect the fully expanded
+    variable assignments of a configuration tree, in the order they
+    were made, so they can be applied to one or more variable servers
+    after the tree has been processed.
+
+    Each assignment records the configuration file and line it came
+    from so errors can be reported against the source.  Configuration
+    file names are interned so each name is only stored once.
+
+    The list also keeps the most recent value of each variable, so
+    later references to a variable within the same configuration tree
+    can be expanded without it having been written to a variable server.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "vartable.h"
+#include "assignlist.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! initial number of entries in an assignment list */
+#define ASSIGNLIST_DEFAULT_SIZE 64
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  ASSIGNLIST_Create                                                       */
+/*!
+    Create an empty assignment list
+
+    @retval pointer to the new assignment list
+    @retval NULL if the list could not be created
+
+============================================================================*/
+AssignList *ASSIGNLIST_Create( void )
+{
+    AssignList *pList;
+
+    pList = calloc( 1, sizeof( AssignList ) );
+    if ( pList != NULL )
+    {
+        pList->pFileNames = VARTABLE_Create( 0 );
+        pList->pValues = VARTABLE_Create( 0 );
+        if ( ( pList->pFileNames == NULL ) ||
+             ( pList->pValues == NULL ) )
+        {
+            ASSIGNLIST_Free( pList );
+            pList = NULL;
+        }
+    }
+
+    return pList;
+}
+
+/*==========================================================================*/
+/*  ASSIGNLIST_Add                                                          */
+/*!
+    Append an assignment to an assignment list
+
+    @param[in]
+        pList
+            pointer to the assignment list
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pValue
+            pointer to the NUL terminated variable value
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @param[in]
+        lineno
+            line number of the assignment within the configuration file
+
+    @retval EOK the assignment was added
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int ASSIGNLIST_Add( AssignList *pList,
+                    char *pName,
+                    char *pValue,
+                    char *pFileName,
+                    int lineno )
+{
+    int result = EINVAL;
+    Assignment *pAssignments;
+    Assignment *pAssignment;
+    VarEntry *pEntry = NULL;
+    size_t n;
+
+    if ( ( pList != NULL ) &&
+         ( pName != NULL ) &&
+         ( pValue != NULL ) &&
+         ( pFileName != NULL ) )
+    {
+        result = EOK;
+
+        if ( pList->count == pList->size )
+        {
+            n = ( pList->size == 0 ) ? ASSIGNLIST_DEFAULT_SIZE
+                                     : pList->size * 2;
+            pAssignments = realloc( pList->pAssignments,
+                                    n * sizeof( Assignment ) );
+            if ( pAssignments != NULL )
+            {
+                pList->pAssignments = pAssignments;
+                pList->size = n;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            /* intern the configuration file name */
+            pEntry = VARTABLE_Find( pList->pFileNames, pFileName );
+            if ( pEntry == NULL )
+            {
+                result = VARTABLE_Set( pList->pFileNames, pFileName, "" );
+                pEntry = VARTABLE_Find( pList->pFileNames, pFileName );
+            }
+        }
+
+        if ( result == EOK )
+        {
+            result = VARTABLE_Set( pList->pValues, pName, pValue );
+        }
+
+        if ( ( result == EOK ) && ( pEntry != NULL ) )
+        {
+            pAssignment = &pList->pAssignments[pList->count];
+            pAssignment->pName = strdup( pName );
+            pAssignment->pValue = strdup( pValue );
+            pAssignment->pFileName = pEntry->name;
+            pAssignment->lineno = lineno;
+
+            if ( ( pAssignment->pName != NULL ) &&
+                 ( pAssignment->pValue != NULL ) )
+            {
+                pList->count++;
+            }
+            else
+            {
+                free( pAssignment->pName );
+                free( pAssignment->pValue );
+                result = ENOMEM;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ASSIGNLIST_Free                                                         */
+/*!
+    Free an assignment list
+
+    @param[in]
+        pList
+            pointer to the assignment list to free
+
+============================================================================*/
+void ASSIGNLIST_Free( AssignList *pList )
+{
+    size_t i;
+
+    if ( pList != NULL )
+    {
+        for ( i = 0; i < pList->count; i++ )
+        {
+            free( pList->pAssignments[i].pName );
+            free( pList->pAssignments[i].pValue );
+        }
+
+        free( pList->pAssignments );
+        VARTABLE_Destroy( pList->pFileNames );
+        VARTABLE_Destroy( pList->pValues );
+        free( pList );
+    }
+}
+
+/*! @}
+ * end of assignlist group */
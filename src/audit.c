@@ -0,0 +1,660 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup audit audit
+ * @brief Detection of variables which drifted from the configuration
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file audit.c
+
+    Drift Audit
+
+    The Drift Audit functions compare the final value of each variable
+    assigned by a configuration with its live value in the variable
+    server, without writing anything.
+
+    The variables are grouped into namespaces by the part of their name
+    before the last '/'.  The live values of each namespace are read in
+    bulk by expanding a single template which references every variable
+    in the namespace, separated by an ASCII record separator, and the
+    separated live values are compared with the expected values.  The
+    variable server has no way to tell that a namespace is unchanged
+    without reading its values, so every value is read and compared.
+    Namespaces too large for the working buffer are audited in several
+    chunks.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "audit.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! separator between the values of a bulk read */
+#define AUDIT_SEPARATOR     '\x1e'
+
+/*! audit context */
+typedef struct _AuditContext
+{
+    /*! variable server call context */
+    VarCall *pVarCall;
+
+    /*! working buffer file descriptor */
+    int fd;
+
+    /*! pointer to the working buffer */
+    char *pBuf;
+
+    /*! size of the working buffer */
+    size_t len;
+
+    /*! template for the bulk read */
+    char *pTemplate;
+
+    /*! size of the template buffer */
+    size_t size;
+
+    /*! output stream for the report */
+    FILE *fp;
+
+    /*! totals of the audit */
+    AuditTotals *pTotals;
+
+} AuditContext;
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static Assignment **FinalAssignments( AssignList *pList, size_t *pCount );
+static int CompareNames( const void *p1, const void *p2 );
+static size_t NamespaceLength( char *pName );
+static size_t ChunkLength( Assignment **ppAssign,
+                           size_t count,
+                           size_t nslen,
+                           size_t len );
+static int AuditChunk( AuditContext *pContext,
+                       Assignment **ppAssign,
+                       size_t count,
+                       bool *pMatched );
+static int AuditVariable( AuditContext *pContext,
+                          Assignment *pAssign,
+                          char *pLive );
+static int ReadValue( AuditContext *pContext, char *pName, char **ppValue );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  AUDIT_Run                                                               */
+/*!
+    Compare the live variable values with the configuration
+
+    The AUDIT_Run function reads the live value of every variable in the
+    assignment list, and reports each variable whose live value differs
+    from its final assigned value, where that value was assigned, and
+    the totals of the audit.
+
+    @param[in]
+        pList
+            pointer to the assignments of the configuration
+
+    @param[in]
+        pVarCall
+            pointer to the variable server call context
+
+    @param[in]
+        fd
+            working buffer file descriptor
+
+    @param[in]
+        pBuf
+            pointer to the working buffer mapped by fd
+
+    @param[in]
+        len
+            size of the working buffer
+
+    @param[in]
+        fp
+            pointer to the output stream for the report
+
+    @param[out]
+        pTotals
+            pointer to the totals of the audit
+
+    @retval EOK the audit was completed
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+    @retval other error as returned by VARCALL_StrToFile
+
+============================================================================*/
+int AUDIT_Run( AssignList *pList,
+               VarCall *pVarCall,
+               int fd,
+               char *pBuf,
+               size_t len,
+               FILE *fp,
+               AuditTotals *pTotals )
+{
+    int result = EINVAL;
+    AuditContext context = { 0 };
+    Assignment **ppAssign = NULL;
+    size_t count = 0;
+    size_t nslen;
+    size_t n;
+    size_t i = 0;
+    size_t j;
+    bool matched;
+    bool unchanged;
+
+    if ( ( pList != NULL ) &&
+         ( pVarCall != NULL ) &&
+         ( pBuf != NULL ) &&
+         ( len > 0 ) &&
+         ( fp != NULL ) &&
+         ( pTotals != NULL ) )
+    {
+        memset( pTotals, 0, sizeof( AuditTotals ) );
+        context.pVarCall = pVarCall;
+        context.fd = fd;
+        context.pBuf = pBuf;
+        context.len = len;
+        context.fp = fp;
+        context.pTotals = pTotals;
+
+        ppAssign = FinalAssignments( pList, &count );
+        result = ( ( ppAssign != NULL ) || ( count == 0 ) ) ? EOK : ENOMEM;
+    }
+
+    if ( result == EOK )
+    {
+        /* group the variables by namespace */
+        qsort( ppAssign, count, sizeof( Assignment * ), CompareNames );
+        pTotals->variables = count;
+    }
+
+    while ( ( result == EOK ) && ( i < count ) )
+    {
+        nslen = NamespaceLength( ppAssign[i]->pName );
+        unchanged = true;
+        j = i;
+
+        do
+        {
+            n = ChunkLength( &ppAssign[j], count - j, nslen, len );
+            result = AuditChunk( &context, &ppAssign[j], n, &matched );
+            unchanged = unchanged && matched;
+            j += n;
+
+        } while ( ( result == EOK ) &&
+                  ( j < count ) &&
+                  ( NamespaceLength( ppAssign[j]->pName ) == nslen ) &&
+                  ( strncmp( ppAssign[i]->pName,
+                             ppAssign[j]->pName,
+                             nslen ) == 0 ) );
+
+        pTotals->namespaces++;
+        if ( unchanged == true )
+        {
+            pTotals->unchanged++;
+        }
+
+        i = j;
+    }
+
+    if ( result == EOK )
+    {
+        fprintf( fp,
+                 "Audit: %zu variables in %zu namespaces, "
+                 "%zu namespaces unchanged, %zu variables differ\n",
+                 pTotals->variables,
+                 pTotals->namespaces,
+                 pTotals->unchanged,
+                 pTotals->differ );
+    }
+
+    free( context.pTemplate );
+    free( ppAssign );
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FinalAssignments                                                        */
+/*!
+    Get the assignment which set the final value of each variable
+
+    @param[in]
+        pList
+            pointer to the assignment list
+
+    @param[out]
+        pCount
+            pointer to a location to store the number of variables
+
+    @retval pointer to an array of the final assignments
+    @retval NULL if there are no variables or memory allocation failed
+
+============================================================================*/
+static Assignment **FinalAssignments( AssignList *pList, size_t *pCount )
+{
+    Assignment **ppAssign;
+    VarEntry *pEntry;
+    size_t count = 0;
+    size_t i;
+
+    ppAssign = calloc( ( pList->count > 0 ) ? pList->count : 1,
+                       sizeof( Assignment * ) );
+    if ( ppAssign != NULL )
+    {
+        /* the last assignment to each variable sets its final value */
+        for ( i = pList->count; i > 0; i-- )
+        {
+            pEntry = VARTABLE_Find( pList->pValues,
+                                    pList->pAssignments[i - 1].pName );
+            if ( ( pEntry != NULL ) && ( pEntry->flags == 0 ) )
+            {
+                pEntry->flags = 1;
+                ppAssign[count++] = &pList->pAssignments[i - 1];
+            }
+        }
+
+        /* leave the list as it was */
+        for ( i = 0; i < count; i++ )
+        {
+            VARTABLE_Find( pList->pValues, ppAssign[i]->pName )->flags = 0;
+        }
+    }
+
+    *pCount = count;
+
+    return ppAssign;
+}
+
+/*==========================================================================*/
+/*  CompareNames                                                            */
+/*!
+    Compare the variable names of two assignments for qsort
+
+    @param[in]
+        p1
+            pointer to the first assignment pointer
+
+    @param[in]
+        p2
+            pointer to the second assignment pointer
+
+    @retval <0, 0 or >0 as the first name sorts before, with or after
+            the second name
+
+============================================================================*/
+static int CompareNames( const void *p1, const void *p2 )
+{
+    const Assignment *pAssign1 = *(Assignment * const *)p1;
+    const Assignment *pAssign2 = *(Assignment * const *)p2;
+
+    return strcmp( pAssign1->pName, pAssign2->pName );
+}
+
+/*==========================================================================*/
+/*  NamespaceLength                                                         */
+/*!
+    Get the length of the namespace of a variable name
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @retval length of the name up to its last '/', or 0 if it has none
+
+============================================================================*/
+static size_t NamespaceLength( char *pName )
+{
+    char *p = strrchr( pName, '/' );
+
+    return ( p != NULL ) ? (size_t)( p - pName ) : 0;
+}
+
+/*==========================================================================*/
+/*  ChunkLength                                                             */
+/*!
+    Get the number of variables to read in the next bulk read
+
+    The ChunkLength function takes variables from the same namespace
+    while the template, and the expected expansion of the template, fit
+    comfortably in the working buffer.  A chunk contains at least one
+    variable.
+
+    @param[in]
+        ppAssign
+            pointer to the assignments starting at the chunk
+
+    @param[in]
+        count
+            number of remaining assignments
+
+    @param[in]
+        nslen
+            length of the namespace of the chunk
+
+    @param[in]
+        len
+            size of the working buffer
+
+    @retval number of variables in the chunk
+
+============================================================================*/
+static size_t ChunkLength( Assignment **ppAssign,
+                           size_t count,
+                           size_t nslen,
+                           size_t len )
+{
+    size_t n = 1;
+    size_t template = strlen( ppAssign[0]->pName ) + 4;
+    size_t expected = strlen( ppAssign[0]->pValue ) + 1;
+    size_t t;
+    size_t e;
+
+    while ( n < count )
+    {
+        t = template + strlen( ppAssign[n]->pName ) + 4;
+        e = expected + strlen( ppAssign[n]->pValue ) + 1;
+
+        /* leave room for live values longer than expected */
+        if ( ( t > len ) ||
+             ( e > len / 2 ) ||
+             ( NamespaceLength( ppAssign[n]->pName ) != nslen ) ||
+             ( strncmp( ppAssign[0]->pName,
+                        ppAssign[n]->pName,
+                        nslen ) != 0 ) )
+        {
+            break;
+        }
+
+        template = t;
+        expected = e;
+        n++;
+    }
+
+    return n;
+}
+
+/*==========================================================================*/
+/*  AuditChunk                                                              */
+/*!
+    Audit a chunk of variables from the same namespace
+
+    The AuditChunk function reads the live values of the chunk in bulk,
+    and compares each live value with its expected value.  If the live
+    values cannot be separated, for example because a live value
+    contains the separator, each variable is read by itself.
+
+    @param[in]
+        pContext
+            pointer to the audit context
+
+    @param[in]
+        ppAssign
+            pointer to the assignments of the chunk
+
+    @param[in]
+        count
+            number of assignments in the chunk
+
+    @param[out]
+        pMatched
+            pointer to a location to store true if every live value
+            matched
+
+    @retval EOK the chunk was audited
+    @retval ENOMEM memory allocation failure
+    @retval other error as returned by VARCALL_StrToFile
+
+============================================================================*/
+static int AuditChunk( AuditContext *pContext,
+                       Assignment **ppAssign,
+                       size_t count,
+                       bool *pMatched )
+{
+    int result = EOK;
+    char separator = AUDIT_SEPARATOR;
+    size_t differ = pContext->pTotals->differ;
+    size_t size = 1;
+    size_t pos = 0;
+    size_t livelen;
+    size_t fields = 0;
+    size_t i;
+    char *pLive;
+    char *p;
+
+    for ( i = 0; i < count; i++ )
+    {
+        size += strlen( ppAssign[i]->pName ) + 4;
+    }
+
+    if ( size > pContext->size )
+    {
+        p = realloc( pContext->pTemplate, size );
+        if ( p != NULL )
+        {
+            pContext->pTemplate = p;
+            pContext->size = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        /* build the template reading every variable of the chunk */
+        for ( i = 0; i < count; i++ )
+        {
+            pos += sprintf( &pContext->pTemplate[pos],
+                            "${%s}%c",
+                            ppAssign[i]->pName,
+                            separator );
+        }
+
+        result = VARCALL_StrToFile( pContext->pVarCall,
+                                    pContext->pTemplate,
+                                    pContext->fd,
+                                    pContext->pBuf,
+                                    pContext->len );
+    }
+
+    if ( result == EOK )
+    {
+        livelen = strnlen( pContext->pBuf, pContext->len );
+        for ( p = pContext->pBuf; p < &pContext->pBuf[livelen]; p++ )
+        {
+            fields += ( *p == separator ) ? 1 : 0;
+        }
+
+        if ( ( livelen < pContext->len ) && ( fields == count ) )
+        {
+            /* compare the separated live values */
+            pLive = pContext->pBuf;
+            for ( i = 0; i < count; i++ )
+            {
+                p = strchr( pLive, separator );
+                *p = '\0';
+                AuditVariable( pContext, ppAssign[i], pLive );
+                pLive = p + 1;
+            }
+        }
+        else
+        {
+            /* read each variable by itself */
+            for ( i = 0; ( i < count ) && ( result == EOK ); i++ )
+            {
+                result = ReadValue( pContext, ppAssign[i]->pName, &pLive );
+                if ( result == EOK )
+                {
+                    AuditVariable( pContext, ppAssign[i], pLive );
+                }
+            }
+        }
+    }
+
+    *pMatched = ( pContext->pTotals->differ == differ );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  AuditVariable                                                           */
+/*!
+    Compare the live value of a variable with its expected value
+
+    @param[in]
+        pContext
+            pointer to the audit context
+
+    @param[in]
+        pAssign
+            pointer to the assignment which set the expected value
+
+    @param[in]
+        pLive
+            pointer to the NUL terminated live value
+
+    @retval EOK the live value matches
+    @retval ESTALE the live value differs and was reported
+
+============================================================================*/
+static int AuditVariable( AuditContext *pContext,
+                          Assignment *pAssign,
+                          char *pLive )
+{
+    int result = EOK;
+
+    if ( strcmp( pAssign->pValue, pLive ) != 0 )
+    {
+        fprintf( pContext->fp,
+                 "%s: expected \"%s\" set at %s:%d, found \"%s\"\n",
+                 pAssign->pName,
+                 pAssign->pValue,
+                 pAssign->pFileName,
+                 pAssign->lineno,
+                 pLive );
+
+        pContext->pTotals->differ++;
+        result = ESTALE;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ReadValue                                                               */
+/*!
+    Read the live value of a single variable
+
+    @param[in]
+        pContext
+            pointer to the audit context
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[out]
+        ppValue
+            pointer to a location to store a pointer to the live value
+            in the working buffer
+
+    @retval EOK the value was read
+    @retval ENOMEM memory allocation failure
+    @retval other error as returned by VARCALL_StrToFile
+
+============================================================================*/
+static int ReadValue( AuditContext *pContext, char *pName, char **ppValue )
+{
+    int result = EOK;
+    size_t size = strlen( pName ) + 4;
+    char *p;
+
+    if ( size > pContext->size )
+    {
+        p = realloc( pContext->pTemplate, size );
+        if ( p != NULL )
+        {
+            pContext->pTemplate = p;
+            pContext->size = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        sprintf( pContext->pTemplate, "${%s}", pName );
+
+        result = VARCALL_StrToFile( pContext->pVarCall,
+                                    pContext->pTemplate,
+                                    pContext->fd,
+                                    pContext->pBuf,
+                                    pContext->len );
+
+        /* the working buffer has room for a NUL terminator */
+        pContext->pBuf[pContext->len] = '\0';
+        *ppValue = pContext->pBuf;
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of audit group */
@@ -0,0 +1,332 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup coalesce coalesce
+ * @brief Coalescing of concurrent loader invocations
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file coalesce.c
+
+    Invocation Coalescing
+
+    The Invocation Coalescing function lets concurrent loader
+    invocations coordinate through an exclusive flock on a lock file,
+    so that any number of triggers collapses into at most one active
+    load plus one follow-up load.
+
+    The first byte of the lock file is the rerun flag, and the second
+    byte is the exit status of the most recent load.  The invocation
+    which holds the lock is the runner.  It clears the rerun flag,
+    performs the load in a child process, records its exit status and
+    releases the lock.  If the rerun flag was set in the meantime, and
+    the lock can be taken again, it performs another load.
+
+    An invocation which cannot take the lock sets the rerun flag and
+    tries once more, in case the runner has just finished.  If it still
+    cannot take the lock it either exits straight away, leaving the
+    follow-up load to the runner, or waits for the lock and then
+    reports the status of the load which ran after it set the flag.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include "coalesce.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! offset of the rerun flag in the lock file */
+#define COALESCE_RERUN_OFFSET   0
+
+/*! offset of the exit status of the most recent load in the lock file */
+#define COALESCE_STATUS_OFFSET  1
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int RunLoads( int fd, int *pStatus );
+static bool TryLock( int fd );
+static void SetByte( int fd, off_t offset, uint8_t value );
+static uint8_t GetByte( int fd, off_t offset );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  COALESCE_Acquire                                                        */
+/*!
+    Coordinate a load with other invocations of the loader
+
+    The COALESCE_Acquire function returns EOK in the process which
+    should perform a load.  In the invocation which holds the lock,
+    this is a child process, and the COALESCE_Acquire function only
+    returns to the invocation itself once there are no more loads to
+    perform.
+
+    @param[in]
+        pLockFile
+            pointer to the NUL terminated name of the lock file
+
+    @param[in]
+        wait
+            true to wait for the follow-up load instead of exiting
+            when another invocation is running
+
+    @param[out]
+        pStatus
+            pointer to the location to store the exit status to use
+            when the caller should not perform a load
+
+    @retval EOK perform a load
+    @retval EALREADY do not perform a load, and exit with *pStatus
+    @retval EINVAL invalid arguments
+    @retval other error as returned by the file system
+
+============================================================================*/
+int COALESCE_Acquire( char *pLockFile, bool wait, int *pStatus )
+{
+    int result = EINVAL;
+    int fd = -1;
+
+    if ( ( pLockFile != NULL ) &&
+         ( pStatus != NULL ) )
+    {
+        *pStatus = 0;
+        fd = open( pLockFile, O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+        result = ( fd != -1 ) ? EOK : errno;
+    }
+
+    if ( result == EOK )
+    {
+        if ( TryLock( fd ) == true )
+        {
+            result = RunLoads( fd, pStatus );
+        }
+        else
+        {
+            /* ask the runner for a follow-up load */
+            SetByte( fd, COALESCE_RERUN_OFFSET, 1 );
+
+            if ( TryLock( fd ) == true )
+            {
+                /* the runner finished in the meantime */
+                result = RunLoads( fd, pStatus );
+            }
+            else if ( wait == false )
+            {
+                result = EALREADY;
+            }
+            else if ( flock( fd, LOCK_EX ) == 0 )
+            {
+                if ( GetByte( fd, COALESCE_RERUN_OFFSET ) != 0 )
+                {
+                    /* no load has started since the flag was set */
+                    result = RunLoads( fd, pStatus );
+                }
+                else
+                {
+                    *pStatus = GetByte( fd, COALESCE_STATUS_OFFSET );
+                    flock( fd, LOCK_UN );
+                    result = EALREADY;
+                }
+            }
+            else
+            {
+                result = errno;
+            }
+        }
+
+        close( fd );
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  RunLoads                                                                */
+/*!
+    Perform loads while the lock is held
+
+    The RunLoads function performs a load in a child process, and
+    repeats it while the rerun flag is set and the lock can be taken
+    again.  The lock must be held by the caller.
+
+    @param[in]
+        fd
+            lock file descriptor
+
+    @param[out]
+        pStatus
+            pointer to the location to store the exit status of the
+            last load
+
+    @retval EOK in the child process, which should perform the load
+    @retval EALREADY in the runner, once the loads are complete
+    @retval other error as returned by fork
+
+============================================================================*/
+static int RunLoads( int fd, int *pStatus )
+{
+    int result = EALREADY;
+    bool again = true;
+    pid_t pid;
+    int status;
+
+    while ( again == true )
+    {
+        /* triggers from now on are covered by this load */
+        SetByte( fd, COALESCE_RERUN_OFFSET, 0 );
+
+        pid = fork();
+        if ( pid == 0 )
+        {
+            result = EOK;
+            break;
+        }
+        else if ( pid == -1 )
+        {
+            result = errno;
+            flock( fd, LOCK_UN );
+            break;
+        }
+
+        while ( ( waitpid( pid, &status, 0 ) == -1 ) && ( errno == EINTR ) );
+
+        *pStatus = WIFEXITED( status ) ? WEXITSTATUS( status ) : 1;
+        SetByte( fd, COALESCE_STATUS_OFFSET, (uint8_t)*pStatus );
+        flock( fd, LOCK_UN );
+
+        /* an invocation which sets the flag after this check takes
+         * the lock itself */
+        again = ( GetByte( fd, COALESCE_RERUN_OFFSET ) != 0 ) &&
+                ( TryLock( fd ) == true );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  TryLock                                                                 */
+/*!
+    Try to take the lock without waiting
+
+    @param[in]
+        fd
+            lock file descriptor
+
+    @retval true the lock was taken
+    @retval false the lock is held by another invocation
+
+============================================================================*/
+static bool TryLock( int fd )
+{
+    return ( flock( fd, LOCK_EX | LOCK_NB ) == 0 );
+}
+
+/*==========================================================================*/
+/*  SetByte                                                                 */
+/*!
+    Write a byte of the lock file
+
+    @param[in]
+        fd
+            lock file descriptor
+
+    @param[in]
+        offset
+            offset of the byte
+
+    @param[in]
+        value
+            value of the byte
+
+============================================================================*/
+static void SetByte( int fd, off_t offset, uint8_t value )
+{
+    if ( pwrite( fd, &value, 1, offset ) != 1 )
+    {
+        /* a flag which cannot be written reads as clear */
+    }
+}
+
+/*==========================================================================*/
+/*  GetByte                                                                 */
+/*!
+    Read a byte of the lock file
+
+    @param[in]
+        fd
+            lock file descriptor
+
+    @param[in]
+        offset
+            offset of the byte
+
+    @retval value of the byte, or 0 if it has not been written
+
+============================================================================*/
+static uint8_t GetByte( int fd, off_t offset )
+{
+    uint8_t value = 0;
+
+    if ( pread( fd, &value, 1, offset ) != 1 )
+    {
+        value = 0;
+    }
+
+    return value;
+}
+
+/*! @}
+ * end of coalesce group */
@@ -0,0 +1,554 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup fanout fanout
+ * @brief Multi-target assignment fan-out
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file fanout.c
+
+    Multi-Target Assignment Fan-out
+
+    The Multi-Target Assignment Fan-out functions apply a list of
+    expanded assignments to several variable server instances
+    concurrently, such as the variable servers running inside
+    a number of containers.
+
+    A target is either "local", a namespace directory such as
+    /proc/<pid>/ns, or the process id of any process running in
+    the target container.
+
+    One worker process is forked per target.  Each worker joins the
+    IPC, mount and PID namespaces of its target, opens its own handle
+    to the variable server found there, and applies every assignment
+    in order.  Processes are used rather than threads because setns()
+    cannot move a multi-threaded process into a new mount namespace.
+
+*/
+/*==========================================================================*/
+
+#define _GNU_SOURCE
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "varcall.h"
+#include "fanout.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! worker exit status: all assignments were applied */
+#define FANOUT_EXIT_OK          0
+
+/*! worker exit status: one or more assignments failed */
+#define FANOUT_EXIT_FAILED      1
+
+/*! worker exit status: the target namespaces could not be joined */
+#define FANOUT_EXIT_NAMESPACE   2
+
+/*! worker exit status: the variable server could not be opened */
+#define FANOUT_EXIT_VARSERVER   3
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int ApplyTarget( AssignList *pList,
+                        char *pTarget,
+                        VarCallOptions *pOptions,
+                        bool verbose );
+static int EnterNamespaces( char *pTarget, bool *pNewPid );
+static int OpenNamespace( char *pDir, char *pName );
+static int WaitWorker( pid_t pid );
+static int PushAssignments( AssignList *pList,
+                            char *pTarget,
+                            VarCallOptions *pOptions,
+                            bool verbose );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FANOUT_Apply                                                            */
+/*!
+    Apply a list of assignments to multiple variable servers
+
+    The FANOUT_Apply function forks one worker per target and waits
+    for all of the workers to complete.  The outcome for each target
+    is reported individually.
+
+    @param[in]
+        pList
+            pointer to the list of expanded assignments
+
+    @param[in]
+        ppTargets
+            array of pointers to the NUL terminated target names
+
+    @param[in]
+        ntargets
+            number of targets
+
+    @param[in]
+        pOptions
+            pointer to the variable server call options for each target
+
+    @param[in]
+        verbose
+            true to report the progress of each target
+
+    @retval EOK the assignments were applied to every target
+    @retval EINVAL invalid arguments
+    @retval EIO one or more targets failed
+
+============================================================================*/
+int FANOUT_Apply( AssignList *pList,
+                  char **ppTargets,
+                  size_t ntargets,
+                  VarCallOptions *pOptions,
+                  bool verbose )
+{
+    int result = EINVAL;
+    pid_t *pPids;
+    size_t i;
+    int rc;
+
+    if ( ( pList != NULL ) &&
+         ( ppTargets != NULL ) &&
+         ( pOptions != NULL ) )
+    {
+        result = ENOMEM;
+        pPids = calloc( ntargets, sizeof( pid_t ) );
+        if ( pPids != NULL )
+        {
+            result = EOK;
+
+            /* don't let the workers inherit pending output */
+            fflush( stdout );
+            fflush( stderr );
+
+            for ( i = 0; i < ntargets; i++ )
+            {
+                pPids[i] = fork();
+                if ( pPids[i] == 0 )
+                {
+                    exit( ApplyTarget( pList,
+                                       ppTargets[i],
+                                       pOptions,
+                                       verbose ) );
+                }
+                else if ( pPids[i] == -1 )
+                {
+                    fprintf( stderr,
+                             "Cannot start worker for target %s: %s\n",
+                             ppTargets[i],
+                             strerror( errno ) );
+                }
+            }
+
+            for ( i = 0; i < ntargets; i++ )
+            {
+                rc = ( pPids[i] != -1 ) ? WaitWorker( pPids[i] )
+                                        : FANOUT_EXIT_FAILED;
+                switch( rc )
+                {
+                    case FANOUT_EXIT_OK:
+                        if ( verbose == true )
+                        {
+                            printf( "Target %s: ok\n", ppTargets[i] );
+                        }
+                        break;
+
+                    case FANOUT_EXIT_NAMESPACE:
+                        fprintf( stderr,
+                                 "Target %s: cannot enter namespaces\n",
+                                 ppTargets[i] );
+                        break;
+
+                    case FANOUT_EXIT_VARSERVER:
+                        fprintf( stderr,
+                                 "Target %s: cannot open variable server\n",
+                                 ppTargets[i] );
+                        break;
+
+                    default:
+                        fprintf( stderr,
+                                 "Target %s: failed\n",
+                                 ppTargets[i] );
+                        break;
+                }
+
+                if ( rc != FANOUT_EXIT_OK )
+                {
+                    result = EIO;
+                }
+            }
+
+            free( pPids );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  ApplyTarget                                                             */
+/*!
+    Apply a list of assignments to a single target
+
+    The ApplyTarget function runs in the worker process for a target.
+    It joins the namespaces of the target, if required, and applies
+    the assignments.  Joining a PID namespace only affects child
+    processes, so in that case the assignments are applied from a
+    further child process.
+
+    @param[in]
+        pList
+            pointer to the list of expanded assignments
+
+    @param[in]
+        pTarget
+            pointer to the NUL terminated target name
+
+    @param[in]
+        pOptions
+            pointer to the variable server call options
+
+    @param[in]
+        verbose
+            true to report the progress of the target
+
+    @retval worker exit status
+
+============================================================================*/
+static int ApplyTarget( AssignList *pList,
+                        char *pTarget,
+                        VarCallOptions *pOptions,
+                        bool verbose )
+{
+    int result;
+    bool newpid = false;
+    pid_t pid;
+
+    if ( strcmp( pTarget, FANOUT_TARGET_LOCAL ) == 0 )
+    {
+        result = PushAssignments( pList, pTarget, pOptions, verbose );
+    }
+    else if ( EnterNamespaces( pTarget, &newpid ) != EOK )
+    {
+        result = FANOUT_EXIT_NAMESPACE;
+    }
+    else if ( newpid == true )
+    {
+        pid = fork();
+        if ( pid == 0 )
+        {
+            exit( PushAssignments( pList, pTarget, pOptions, verbose ) );
+        }
+
+        result = ( pid != -1 ) ? WaitWorker( pid ) : FANOUT_EXIT_FAILED;
+    }
+    else
+    {
+        result = PushAssignments( pList, pTarget, pOptions, verbose );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  EnterNamespaces                                                         */
+/*!
+    Join the namespaces of a target
+
+    The EnterNamespaces function joins the IPC and mount namespaces of
+    the target, so the shared memory and message queues of the target's
+    variable server are visible.  It also joins the PID namespace of the
+    target if it is available, so the server process id recorded by the
+    variable server is valid.
+
+    @param[in]
+        pTarget
+            pointer to the NUL terminated target namespace directory,
+            or process id
+
+    @param[out]
+        pNewPid
+            pointer to a location to store an indication that the
+            PID namespace was joined
+
+    @retval EOK the namespaces were joined
+    @retval other error as returned by open or setns
+
+============================================================================*/
+static int EnterNamespaces( char *pTarget, bool *pNewPid )
+{
+    int result = EOK;
+    char dir[PATH_MAX];
+    char *p;
+    int ipcfd;
+    int mntfd;
+    int pidfd;
+
+    /* a process id refers to the namespaces of that process */
+    for ( p = pTarget; isdigit( (unsigned char)*p ); p++ );
+    if ( ( p != pTarget ) && ( *p == '\0' ) )
+    {
+        snprintf( dir, sizeof( dir ), "/proc/%s/ns", pTarget );
+    }
+    else if ( snprintf( dir, sizeof( dir ), "%s", pTarget ) >=
+                (int)sizeof( dir ) )
+    {
+        result = ENAMETOOLONG;
+    }
+
+    /* open all the namespaces before the mount namespace changes */
+    ipcfd = OpenNamespace( dir, "ipc" );
+    mntfd = OpenNamespace( dir, "mnt" );
+    pidfd = OpenNamespace( dir, "pid" );
+
+    if ( ( result == EOK ) &&
+         ( ( ipcfd == -1 ) || ( mntfd == -1 ) ) )
+    {
+        result = errno;
+        fprintf( stderr, "Cannot open namespaces in %s\n", dir );
+    }
+
+    if ( ( result == EOK ) &&
+         ( ( setns( ipcfd, CLONE_NEWIPC ) != 0 ) ||
+           ( setns( mntfd, CLONE_NEWNS ) != 0 ) ) )
+    {
+        result = errno;
+        fprintf( stderr,
+                 "Cannot enter namespaces in %s: %s\n",
+                 dir,
+                 strerror( result ) );
+    }
+
+    if ( ( result == EOK ) &&
+         ( pidfd != -1 ) &&
+         ( setns( pidfd, CLONE_NEWPID ) == 0 ) )
+    {
+        *pNewPid = true;
+    }
+
+    if ( ipcfd != -1 )
+    {
+        close( ipcfd );
+    }
+
+    if ( mntfd != -1 )
+    {
+        close( mntfd );
+    }
+
+    if ( pidfd != -1 )
+    {
+        close( pidfd );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  OpenNamespace                                                           */
+/*!
+    Open a namespace file
+
+    @param[in]
+        pDir
+            pointer to the NUL terminated namespace directory
+
+    @param[in]
+        pName
+            pointer to the NUL terminated namespace name
+
+    @retval file descriptor of the namespace
+    @retval -1 if the namespace could not be opened
+
+============================================================================*/
+static int OpenNamespace( char *pDir, char *pName )
+{
+    char path[PATH_MAX];
+    int fd = -1;
+
+    if ( snprintf( path, sizeof( path ), "%s/%s", pDir, pName ) <
+            (int)sizeof( path ) )
+    {
+        fd = open( path, O_RDONLY | O_CLOEXEC );
+    }
+
+    return fd;
+}
+
+/*==========================================================================*/
+/*  WaitWorker                                                              */
+/*!
+    Wait for a worker process to exit
+
+    @param[in]
+        pid
+            process id of the worker
+
+    @retval worker exit status
+
+============================================================================*/
+static int WaitWorker( pid_t pid )
+{
+    int status = 0;
+    int result = FANOUT_EXIT_FAILED;
+    pid_t rc;
+
+    do
+    {
+        rc = waitpid( pid, &status, 0 );
+    } while ( ( rc == -1 ) && ( errno == EINTR ) );
+
+    if ( ( rc == pid ) && ( WIFEXITED( status ) ) )
+    {
+        result = WEXITSTATUS( status );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  PushAssignments                                                         */
+/*!
+    Apply a list of assignments to the visible variable server
+
+    The PushAssignments function opens a handle to the variable server
+    and applies every assignment in the list in order, subject to the
+    call deadlines, retries and queueing options.  Each failure is
+    reported against the target and the configuration file and line
+    the assignment came from.
+
+    @param[in]
+        pList
+            pointer to the list of expanded assignments
+
+    @param[in]
+        pTarget
+            pointer to the NUL terminated target name
+
+    @param[in]
+        pOptions
+            pointer to the variable server call options
+
+    @param[in]
+        verbose
+            true to report the progress of the target
+
+    @retval worker exit status
+
+============================================================================*/
+static int PushAssignments( AssignList *pList,
+                            char *pTarget,
+                            VarCallOptions *pOptions,
+                            bool verbose )
+{
+    int result = FANOUT_EXIT_VARSERVER;
+    VarCall *pVarCall;
+    Assignment *pAssignment;
+    size_t failed = 0;
+    size_t i;
+    int rc;
+
+    pVarCall = VARCALL_Create( pOptions, pTarget );
+    if ( VARCALL_Open( pVarCall ) == EOK )
+    {
+        for ( i = 0; i < pList->count; i++ )
+        {
+            pAssignment = &pList->pAssignments[i];
+
+            rc = VARCALL_SetNameValue( pVarCall,
+                                       pAssignment->pName,
+                                       pAssignment->pValue,
+                                       pAssignment->pFileName,
+                                       pAssignment->lineno );
+            if ( ( rc != EOK ) && ( rc != EINPROGRESS ) )
+            {
+                failed++;
+                fprintf( stderr,
+                         "%s: '%s' in %s on line %d [%s]\n",
+                         ( rc == ENOENT ) ? "Variable not found" :
+                         ( rc == ETIMEDOUT ) ? "Variable assignment timed out"
+                                             : "Variable assignment failed",
+                         pAssignment->pName,
+                         pAssignment->pFileName,
+                         pAssignment->lineno,
+                         pTarget );
+            }
+        }
+
+        rc = VARCALL_Drain( pVarCall );
+
+        if ( verbose == true )
+        {
+            printf( "Target %s: %zu of %zu assignments applied\n",
+                    pTarget,
+                    pList->count - failed,
+                    pList->count );
+        }
+
+        result = ( ( failed == 0 ) && ( rc == EOK ) ) ? FANOUT_EXIT_OK
+                                                      : FANOUT_EXIT_FAILED;
+    }
+
+    VARCALL_Close( pVarCall );
+
+    return result;
+}
+
+/*! @}
+ * end of fanout group */
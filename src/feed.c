@@ -0,0 +1,612 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup feed feed
+ * @brief Change feed of applied assignments
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file feed.c
+
+    Change Feed
+
+    The Change Feed functions emit a stream of events describing the
+    assignments applied to the variable server, so downstream consumers
+    can follow configuration changes from a single feed instead of
+    subscribing to individual variables.
+
+    Each event holds the generation of the run, the variable name, its
+    value before and after the assignment, and the file and line which
+    assigned it.  Events are buffered and written to the feed a batch
+    at a time.
+
+    The feed is written to a Unix domain stream socket when its
+    destination is "unix:<path>", to a FIFO when the destination is an
+    existing FIFO, or otherwise appended to a file.
+
+    NDJSON events are one JSON object per line.  Binary events are a
+    32-bit length followed by that many bytes holding the 32-bit
+    generation and line number, and the name, old value, new value and
+    file name, each as a 32-bit length followed by its bytes.  All
+    integers are in network byte order.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "feed.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! prefix of a Unix domain socket destination */
+#define FEED_UNIX_PREFIX    "unix:"
+
+/*! buffered events are written once they exceed this size */
+#define FEED_BATCH_SIZE     ( 64 * 1024 )
+
+/*! change feed */
+struct _Feed
+{
+    /*! feed file descriptor */
+    int fd;
+
+    /*! framing of the events */
+    FeedFormat format;
+
+    /*! generation of this run */
+    uint32_t generation;
+
+    /*! buffered events */
+    char *pBuf;
+
+    /*! number of bytes of buffered events */
+    size_t len;
+
+    /*! size of the event buffer */
+    size_t size;
+
+    /*! a write to the feed failed */
+    int error;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int OpenDestination( char *pDest );
+static int Reserve( Feed *pFeed, size_t len );
+static void Append( Feed *pFeed, const void *pData, size_t len );
+static void AppendU32( Feed *pFeed, uint32_t value );
+static void AppendString( Feed *pFeed, char *pStr );
+static void AppendJSON( Feed *pFeed, char *pStr );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FEED_Open                                                               */
+/*!
+    Open a change feed
+
+    @param[in]
+        pDest
+            pointer to the NUL terminated destination of the feed
+
+    @param[in]
+        format
+            framing of the events
+
+    @param[in]
+        generation
+            generation of this run
+
+    @retval pointer to the open feed
+    @retval NULL the destination could not be opened, for example a
+            FIFO with no reader
+
+============================================================================*/
+Feed *FEED_Open( char *pDest, FeedFormat format, uint32_t generation )
+{
+    Feed *pFeed = NULL;
+    int fd = -1;
+
+    if ( pDest != NULL )
+    {
+        fd = OpenDestination( pDest );
+    }
+
+    if ( fd != -1 )
+    {
+        pFeed = calloc( 1, sizeof( Feed ) );
+        if ( pFeed != NULL )
+        {
+            pFeed->fd = fd;
+            pFeed->format = format;
+            pFeed->generation = generation;
+        }
+        else
+        {
+            close( fd );
+        }
+    }
+
+    return pFeed;
+}
+
+/*==========================================================================*/
+/*  FEED_Event                                                              */
+/*!
+    Add an applied assignment to the change feed
+
+    The event is buffered, and the buffered events are written once they
+    exceed the batch size.
+
+    @param[in]
+        pFeed
+            pointer to the change feed, or NULL if there is no feed
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pOldValue
+            pointer to the NUL terminated value before the assignment
+
+    @param[in]
+        pNewValue
+            pointer to the NUL terminated assigned value
+
+    @param[in]
+        pFileName
+            pointer to the name of the file which made the assignment,
+            or NULL
+
+    @param[in]
+        lineno
+            line number of the assignment within the file
+
+    @retval EOK the event was added, or there is no feed
+    @retval ENOMEM memory allocation failure
+    @retval other error writing a batch of events
+
+============================================================================*/
+int FEED_Event( Feed *pFeed,
+                char *pName,
+                char *pOldValue,
+                char *pNewValue,
+                char *pFileName,
+                int lineno )
+{
+    int result = EOK;
+    char num[32];
+    size_t start;
+    uint32_t len;
+
+    pFileName = ( pFileName != NULL ) ? pFileName : "";
+
+    if ( ( pFeed == NULL ) ||
+         ( pName == NULL ) ||
+         ( pOldValue == NULL ) ||
+         ( pNewValue == NULL ) )
+    {
+        /* nothing to emit */
+    }
+    else if ( pFeed->error != EOK )
+    {
+        result = pFeed->error;
+    }
+    else if ( pFeed->format == FEED_BINARY )
+    {
+        /* the length is filled in once the record is complete */
+        start = pFeed->len;
+        AppendU32( pFeed, 0 );
+        AppendU32( pFeed, pFeed->generation );
+        AppendU32( pFeed, (uint32_t)lineno );
+        AppendString( pFeed, pName );
+        AppendString( pFeed, pOldValue );
+        AppendString( pFeed, pNewValue );
+        AppendString( pFeed, pFileName );
+
+        if ( pFeed->error == EOK )
+        {
+            len = htonl( (uint32_t)( pFeed->len - start - sizeof( len ) ) );
+            memcpy( &pFeed->pBuf[start], &len, sizeof( len ) );
+        }
+    }
+    else
+    {
+        snprintf( num, sizeof( num ), "%u", pFeed->generation );
+        Append( pFeed, "{\"generation\":", 14 );
+        Append( pFeed, num, strlen( num ) );
+        Append( pFeed, ",\"name\":", 8 );
+        AppendJSON( pFeed, pName );
+        Append( pFeed, ",\"old\":", 7 );
+        AppendJSON( pFeed, pOldValue );
+        Append( pFeed, ",\"new\":", 7 );
+        AppendJSON( pFeed, pNewValue );
+        Append( pFeed, ",\"file\":", 8 );
+        AppendJSON( pFeed, pFileName );
+        snprintf( num, sizeof( num ), "%d", lineno );
+        Append( pFeed, ",\"line\":", 8 );
+        Append( pFeed, num, strlen( num ) );
+        Append( pFeed, "}\n", 2 );
+    }
+
+    if ( ( result == EOK ) &&
+         ( pFeed != NULL ) &&
+         ( pFeed->len >= FEED_BATCH_SIZE ) )
+    {
+        result = FEED_Flush( pFeed );
+    }
+
+    if ( ( result == EOK ) && ( pFeed != NULL ) )
+    {
+        result = pFeed->error;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  FEED_Flush                                                              */
+/*!
+    Write the buffered events to the change feed
+
+    @param[in]
+        pFeed
+            pointer to the change feed, or NULL if there is no feed
+
+    @retval EOK the buffered events were written, or there is no feed
+    @retval other error as returned by write
+
+============================================================================*/
+int FEED_Flush( Feed *pFeed )
+{
+    int result = EOK;
+    size_t pos = 0;
+    ssize_t n;
+
+    if ( pFeed != NULL )
+    {
+        while ( ( pFeed->error == EOK ) && ( pos < pFeed->len ) )
+        {
+            n = write( pFeed->fd, &pFeed->pBuf[pos], pFeed->len - pos );
+            if ( n > 0 )
+            {
+                pos += n;
+            }
+            else if ( errno != EINTR )
+            {
+                /* stop emitting events to a broken feed */
+                pFeed->error = ( n == 0 ) ? EIO : errno;
+            }
+        }
+
+        pFeed->len = 0;
+        result = pFeed->error;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  FEED_Close                                                              */
+/*!
+    Write any buffered events and close the change feed
+
+    @param[in]
+        pFeed
+            pointer to the change feed, or NULL if there is no feed
+
+    @retval EOK every event was written, or there is no feed
+    @retval other error writing the events
+
+============================================================================*/
+int FEED_Close( Feed *pFeed )
+{
+    int result = EOK;
+
+    if ( pFeed != NULL )
+    {
+        result = FEED_Flush( pFeed );
+        close( pFeed->fd );
+        free( pFeed->pBuf );
+        free( pFeed );
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  OpenDestination                                                         */
+/*!
+    Open the destination of a change feed for writing
+
+    A FIFO with no reader is not opened, so a load never waits for a
+    consumer.  SIGPIPE is ignored when the feed is a socket or FIFO, so
+    a consumer which goes away ends the feed instead of the load.
+
+    @param[in]
+        pDest
+            pointer to the NUL terminated destination
+
+    @retval file descriptor of the destination
+    @retval -1 the destination could not be opened
+
+============================================================================*/
+static int OpenDestination( char *pDest )
+{
+    int fd = -1;
+    size_t len = strlen( FEED_UNIX_PREFIX );
+    struct sockaddr_un addr;
+    struct stat st;
+    int flags;
+
+    if ( strncmp( pDest, FEED_UNIX_PREFIX, len ) == 0 )
+    {
+        memset( &addr, 0, sizeof( addr ) );
+        addr.sun_family = AF_UNIX;
+        if ( strlen( &pDest[len] ) < sizeof( addr.sun_path ) )
+        {
+            strcpy( addr.sun_path, &pDest[len] );
+            fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        }
+        else
+        {
+            errno = ENAMETOOLONG;
+        }
+
+        if ( ( fd != -1 ) &&
+             ( connect( fd,
+                        (struct sockaddr *)&addr,
+                        sizeof( addr ) ) != 0 ) )
+        {
+            close( fd );
+            fd = -1;
+        }
+
+        if ( fd != -1 )
+        {
+            signal( SIGPIPE, SIG_IGN );
+        }
+    }
+    else if ( ( stat( pDest, &st ) == 0 ) && ( S_ISFIFO( st.st_mode ) ) )
+    {
+        fd = open( pDest, O_WRONLY | O_NONBLOCK | O_CLOEXEC );
+        if ( fd != -1 )
+        {
+            /* write the batches in full once a reader is present */
+            flags = fcntl( fd, F_GETFL );
+            fcntl( fd, F_SETFL, flags & ~O_NONBLOCK );
+            signal( SIGPIPE, SIG_IGN );
+        }
+    }
+    else
+    {
+        fd = open( pDest,
+                   O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+    }
+
+    return fd;
+}
+
+/*==========================================================================*/
+/*  Reserve                                                                 */
+/*!
+    Make space in the event buffer
+
+    @param[in]
+        pFeed
+            pointer to the change feed
+
+    @param[in]
+        len
+            number of bytes to append
+
+    @retval EOK the buffer has space for len more bytes
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int Reserve( Feed *pFeed, size_t len )
+{
+    int result = EOK;
+    size_t size;
+    char *p;
+
+    if ( pFeed->len + len > pFeed->size )
+    {
+        size = ( pFeed->size > 0 ) ? pFeed->size : FEED_BATCH_SIZE;
+        while ( pFeed->len + len > size )
+        {
+            size *= 2;
+        }
+
+        p = realloc( pFeed->pBuf, size );
+        if ( p != NULL )
+        {
+            pFeed->pBuf = p;
+            pFeed->size = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Append                                                                  */
+/*!
+    Append bytes to the event buffer
+
+    A memory allocation failure ends the feed.
+
+    @param[in]
+        pFeed
+            pointer to the change feed
+
+    @param[in]
+        pData
+            pointer to the bytes to append
+
+    @param[in]
+        len
+            number of bytes to append
+
+============================================================================*/
+static void Append( Feed *pFeed, const void *pData, size_t len )
+{
+    if ( pFeed->error == EOK )
+    {
+        pFeed->error = Reserve( pFeed, len );
+        if ( pFeed->error == EOK )
+        {
+            memcpy( &pFeed->pBuf[pFeed->len], pData, len );
+            pFeed->len += len;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  AppendU32                                                               */
+/*!
+    Append a 32-bit integer in network byte order to the event buffer
+
+    @param[in]
+        pFeed
+            pointer to the change feed
+
+    @param[in]
+        value
+            value to append
+
+============================================================================*/
+static void AppendU32( Feed *pFeed, uint32_t value )
+{
+    value = htonl( value );
+    Append( pFeed, &value, sizeof( value ) );
+}
+
+/*==========================================================================*/
+/*  AppendString                                                            */
+/*!
+    Append a length-prefixed string to the event buffer
+
+    @param[in]
+        pFeed
+            pointer to the change feed
+
+    @param[in]
+        pStr
+            pointer to the NUL terminated string to append
+
+============================================================================*/
+static void AppendString( Feed *pFeed, char *pStr )
+{
+    size_t len = strlen( pStr );
+
+    AppendU32( pFeed, (uint32_t)len );
+    Append( pFeed, pStr, len );
+}
+
+/*==========================================================================*/
+/*  AppendJSON                                                              */
+/*!
+    Append a string to the event buffer as a quoted JSON string
+
+    @param[in]
+        pFeed
+            pointer to the change feed
+
+    @param[in]
+        pStr
+            pointer to the NUL terminated string to append
+
+============================================================================*/
+static void AppendJSON( Feed *pFeed, char *pStr )
+{
+    unsigned char *p = (unsigned char *)pStr;
+    char esc[8];
+
+    Append( pFeed, "\"", 1 );
+
+    for ( ; *p != '\0'; p++ )
+    {
+        if ( ( *p == '"' ) || ( *p == '\\' ) )
+        {
+            esc[0] = '\\';
+            esc[1] = *p;
+            Append( pFeed, esc, 2 );
+        }
+        else if ( *p < 0x20 )
+        {
+            snprintf( esc, sizeof( esc ), "\\u%04x", *p );
+            Append( pFeed, esc, 6 );
+        }
+        else
+        {
+            Append( pFeed, p, 1 );
+        }
+    }
+
+    Append( pFeed, "\"", 1 );
+}
+
+/*! @}
+ * end of feed group */
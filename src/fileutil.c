@@ -0,0 +1,200 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup fileutil fileutil
+ * @brief File system utility functions
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file fileutil.c
+
+    File Utilities
+
+    The File Utilities provide helper functions for managing the state
+    and cache files which are maintained by the loadconfig utility
+    between runs.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "hash.h"
+#include "fileutil.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FILEUTIL_MakeDirs                                                       */
+/*!
+    Create a directory and all of its parents
+
+    The FILEUTIL_MakeDirs function creates the specified directory
+    including any missing parent directories.  It is not an error
+    for the directory to already exist.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated directory path
+
+    @retval EOK the directory exists
+    @retval EINVAL invalid arguments
+    @retval ENAMETOOLONG the path is too long
+    @retval other error as returned by mkdir
+
+============================================================================*/
+int FILEUTIL_MakeDirs( char *pPath )
+{
+    int result = EINVAL;
+    char path[PATH_MAX];
+    char *p;
+    size_t len;
+
+    if ( pPath != NULL )
+    {
+        len = strlen( pPath );
+        if ( len < sizeof( path ) )
+        {
+            result = EOK;
+            memcpy( path, pPath, len + 1 );
+
+            for ( p = &path[1]; ( *p != '\0' ) && ( result == EOK ); p++ )
+            {
+                if ( *p == '/' )
+                {
+                    *p = '\0';
+                    if ( ( mkdir( path, 0755 ) != 0 ) && ( errno != EEXIST ) )
+                    {
+                        result = errno;
+                    }
+
+                    *p = '/';
+                }
+            }
+
+            if ( ( result == EOK ) &&
+                 ( mkdir( path, 0755 ) != 0 ) &&
+                 ( errno != EEXIST ) )
+            {
+                result = errno;
+            }
+        }
+        else
+        {
+            result = ENAMETOOLONG;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  FILEUTIL_KeyPath                                                        */
+/*!
+    Build the path of a state file keyed by a string
+
+    The FILEUTIL_KeyPath function builds the path of a file within the
+    specified directory whose name is derived from the hash of a key
+    string such as a configuration file name.
+
+    @param[in]
+        pDir
+            pointer to the NUL terminated directory name
+
+    @param[in]
+        pKey
+            pointer to the NUL terminated key string
+
+    @param[in]
+        pSuffix
+            pointer to the NUL terminated file name suffix
+
+    @param[out]
+        pBuf
+            pointer to a buffer to receive the path
+
+    @param[in]
+        len
+            size of the buffer to receive the path
+
+    @retval EOK the path was generated
+    @retval EINVAL invalid arguments
+    @retval ENAMETOOLONG the path does not fit in the buffer
+
+============================================================================*/
+int FILEUTIL_KeyPath( char *pDir,
+                      char *pKey,
+                      char *pSuffix,
+                      char *pBuf,
+                      size_t len )
+{
+    int result = EINVAL;
+    uint64_t hash;
+    int n;
+
+    if ( ( pDir != NULL ) &&
+         ( pKey != NULL ) &&
+         ( pSuffix != NULL ) &&
+         ( pBuf != NULL ) )
+    {
+        hash = HASH_Fnv1a64( pKey, strlen( pKey ), HASH_FNV1A64_INIT );
+
+        n = snprintf( pBuf,
+                      len,
+                      "%s/%016llx%s",
+                      pDir,
+                      (unsigned long long)hash,
+                      pSuffix );
+
+        result = ( ( n > 0 ) && ( (size_t)n < len ) ) ? EOK : ENAMETOOLONG;
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of fileutil group */
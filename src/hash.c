@@ -0,0 +1,99 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup hash hash
+ * @brief Hashing functions
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file hash.c
+
+    Hash Functions
+
+    The Hash Functions are used to generate compact, stable keys for
+    file names and file content so that state and cache files can be
+    located and validated quickly.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hash.h"
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  HASH_Fnv1a64                                                            */
+/*!
+    Calculate a 64-bit FNV-1a hash
+
+    The HASH_Fnv1a64 function calculates the 64-bit FNV-1a hash of a
+    block of data.  The hash of a large object can be calculated in
+    pieces by passing the result of one call as the initial hash
+    value of the next.
+
+    @param[in]
+        pData
+            pointer to the data to hash
+
+    @param[in]
+        len
+            number of bytes of data to hash
+
+    @param[in]
+        hash
+            initial hash value, normally HASH_FNV1A64_INIT
+
+    @retval the updated hash value
+
+============================================================================*/
+uint64_t HASH_Fnv1a64( void *pData, size_t len, uint64_t hash )
+{
+    unsigned char *p = (unsigned char *)pData;
+    size_t i;
+
+    if ( p != NULL )
+    {
+        for ( i = 0; i < len; i++ )
+        {
+            hash ^= p[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    return hash;
+}
+
+/*! @}
+ * end of hash group */
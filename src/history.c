@@ -0,0 +1,528 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup history history
+ * @brief Load performance history
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file history.c
+
+    Load Performance History
+
+    The Load Performance History functions record a fixed size record
+    of each load in a bounded ring file, and report the trend of the
+    load times, flagging the loads which were slower than a rolling
+    baseline, so that gradual growth in boot time is noticed.
+
+    The ring file consists of a fixed header followed by a fixed number
+    of records.  The header holds the index of the next record to write
+    and the number of records written.  Each load overwrites the oldest
+    record once the ring is full.
+
+    The baseline of a load is the median duration of the preceding
+    loads of the same root configuration file within the baseline
+    window.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include "history.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! history file identifier */
+#define HISTORY_MAGIC       ( 0x4843434cUL )
+
+/*! history file format version */
+#define HISTORY_VERSION     ( 1 )
+
+/*! number of records in the ring */
+#define HISTORY_CAPACITY    ( 256 )
+
+/*! number of nanoseconds in a microsecond */
+#define NS_PER_US           ( 1000 )
+
+/*! history file header */
+typedef struct _HistoryHeader
+{
+    /*! history file identifier */
+    uint32_t magic;
+
+    /*! history file format version */
+    uint32_t version;
+
+    /*! size of each record */
+    uint32_t recordSize;
+
+    /*! number of records in the ring */
+    uint32_t capacity;
+
+    /*! total number of records written */
+    uint64_t count;
+
+} HistoryHeader;
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static bool ValidHeader( HistoryHeader *pHeader );
+static uint64_t Baseline( HistoryRecord *pRecords,
+                          size_t n,
+                          size_t index,
+                          unsigned int window );
+static int CompareDurations( const void *p1, const void *p2 );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  HISTORY_Fill                                                            */
+/*!
+    Fill a history record from the metrics of a load
+
+    @param[out]
+        pRecord
+            pointer to the record to fill
+
+    @param[in]
+        pMetrics
+            pointer to the metrics of the load
+
+    @param[in]
+        pRootFile
+            pointer to the NUL terminated root configuration file name
+
+============================================================================*/
+void HISTORY_Fill( HistoryRecord *pRecord,
+                   Metrics *pMetrics,
+                   char *pRootFile )
+{
+    uint64_t durationNs;
+    int i;
+
+    if ( ( pRecord != NULL ) && ( pMetrics != NULL ) )
+    {
+        durationNs = METRICS_Now() - pMetrics->start;
+
+        memset( pRecord, 0, sizeof( HistoryRecord ) );
+        pRecord->timestamp = (int64_t)time( NULL ) - durationNs / 1000000000;
+        pRecord->durationUs = durationNs / NS_PER_US;
+        for ( i = 0; i < METRICS_NUM_PHASES; i++ )
+        {
+            pRecord->phaseUs[i] = pMetrics->phaseNs[i] / NS_PER_US;
+        }
+
+        pRecord->bytes = pMetrics->bytes;
+        pRecord->files = (uint32_t)pMetrics->files;
+        pRecord->applied = (uint32_t)pMetrics->applied;
+        pRecord->errors = (uint32_t)pMetrics->errors;
+
+        if ( pRootFile != NULL )
+        {
+            strncpy( pRecord->root, pRootFile, HISTORY_ROOT_LEN - 1 );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  HISTORY_Append                                                          */
+/*!
+    Append a load record to the history ring file
+
+    The HISTORY_Append function creates the ring file if it does not
+    exist, or is not a valid ring file of the current format, and then
+    overwrites the oldest record once the ring is full.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated name of the ring file
+
+    @param[in]
+        pRecord
+            pointer to the record to append
+
+    @retval EOK the record was appended
+    @retval EINVAL invalid arguments
+    @retval other error as returned by the file system
+
+============================================================================*/
+int HISTORY_Append( char *pPath, HistoryRecord *pRecord )
+{
+    int result = EINVAL;
+    HistoryHeader header;
+    off_t offset;
+    int fd = -1;
+
+    if ( ( pPath != NULL ) && ( pRecord != NULL ) )
+    {
+        fd = open( pPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+        result = ( fd != -1 ) ? EOK : errno;
+    }
+
+    if ( ( result == EOK ) && ( flock( fd, LOCK_EX ) != 0 ) )
+    {
+        result = errno;
+    }
+
+    if ( result == EOK )
+    {
+        if ( ( pread( fd, &header, sizeof( header ), 0 ) !=
+                    (ssize_t)sizeof( header ) ) ||
+             ( ValidHeader( &header ) == false ) )
+        {
+            /* start a new ring */
+            memset( &header, 0, sizeof( header ) );
+            header.magic = HISTORY_MAGIC;
+            header.version = HISTORY_VERSION;
+            header.recordSize = sizeof( HistoryRecord );
+            header.capacity = HISTORY_CAPACITY;
+
+            if ( ftruncate( fd, 0 ) != 0 )
+            {
+                result = errno;
+            }
+        }
+
+        offset = sizeof( header ) +
+                 ( header.count % header.capacity ) * sizeof( HistoryRecord );
+        header.count++;
+
+        /* the record is written before the header which counts it */
+        if ( ( result == EOK ) &&
+             ( ( pwrite( fd, pRecord, sizeof( HistoryRecord ), offset ) !=
+                    (ssize_t)sizeof( HistoryRecord ) ) ||
+               ( pwrite( fd, &header, sizeof( header ), 0 ) !=
+                    (ssize_t)sizeof( header ) ) ) )
+        {
+            result = EIO;
+        }
+    }
+
+    if ( fd != -1 )
+    {
+        close( fd );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  HISTORY_Report                                                          */
+/*!
+    Report the load history and flag the regressions
+
+    The HISTORY_Report function lists the recorded loads from oldest to
+    newest with their phase times and baselines, marking each load
+    slower than its baseline by more than the factor, followed by a
+    summary of the latest load.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated name of the ring file
+
+    @param[in]
+        factor
+            duration ratio above the baseline which is a regression
+
+    @param[in]
+        window
+            number of preceding loads of the same root file in the baseline
+
+    @param[in]
+        fp
+            output file stream
+
+    @retval EOK the latest load is not a regression
+    @retval ESTALE the latest load is slower than its baseline by more
+            than the factor
+    @retval ENOENT there is no load history
+    @retval other error reading the history
+
+============================================================================*/
+int HISTORY_Report( char *pPath,
+                    double factor,
+                    unsigned int window,
+                    FILE *fp )
+{
+    int result = EINVAL;
+    HistoryHeader header;
+    HistoryRecord *pRecords = NULL;
+    HistoryRecord *pRecord;
+    size_t n = 0;
+    size_t first = 0;
+    size_t i;
+    size_t flagged = 0;
+    uint64_t baseline = 0;
+    bool slow = false;
+    char timestr[32];
+    struct tm tm;
+    time_t t;
+    int fd = -1;
+
+    if ( ( pPath != NULL ) && ( fp != NULL ) )
+    {
+        fd = open( pPath, O_RDONLY | O_CLOEXEC );
+        result = ( fd != -1 ) ? EOK : errno;
+    }
+
+    if ( ( result == EOK ) &&
+         ( ( pread( fd, &header, sizeof( header ), 0 ) !=
+                (ssize_t)sizeof( header ) ) ||
+           ( ValidHeader( &header ) == false ) ) )
+    {
+        result = ENOENT;
+    }
+
+    if ( result == EOK )
+    {
+        n = ( header.count < header.capacity ) ? header.count
+                                               : header.capacity;
+        first = ( header.count < header.capacity )
+                    ? 0
+                    : header.count % header.capacity;
+
+        pRecords = ( n > 0 ) ? malloc( n * sizeof( HistoryRecord ) ) : NULL;
+        result = ( pRecords != NULL ) ? EOK : ( n > 0 ) ? ENOMEM : ENOENT;
+    }
+
+    /* read the records from oldest to newest */
+    for ( i = 0; ( result == EOK ) && ( i < n ); i++ )
+    {
+        if ( pread( fd,
+                    &pRecords[i],
+                    sizeof( HistoryRecord ),
+                    sizeof( header ) +
+                        ( ( first + i ) % header.capacity ) *
+                            sizeof( HistoryRecord ) ) !=
+                (ssize_t)sizeof( HistoryRecord ) )
+        {
+            result = EIO;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        fprintf( fp,
+                 "%-19s %10s %10s %5s %7s %8s %9s %9s %9s %9s  %s\n",
+                 "time", "ms", "base ms", "files", "applied", "KB",
+                 "io ms", "parse ms", "expand ms", "write ms", "root" );
+
+        for ( i = 0; i < n; i++ )
+        {
+            pRecord = &pRecords[i];
+            pRecord->root[HISTORY_ROOT_LEN - 1] = '\0';
+
+            baseline = Baseline( pRecords, n, i, window );
+            slow = ( baseline > 0 ) &&
+                   ( pRecord->durationUs > baseline * factor );
+            flagged += ( slow == true ) ? 1 : 0;
+
+            t = (time_t)pRecord->timestamp;
+            localtime_r( &t, &tm );
+            strftime( timestr, sizeof( timestr ), "%Y-%m-%d %H:%M:%S", &tm );
+
+            fprintf( fp,
+                     "%-19s %10.3f %10.3f %5u %7u %8.1f "
+                     "%9.3f %9.3f %9.3f %9.3f  %s%s\n",
+                     timestr,
+                     pRecord->durationUs / 1e3,
+                     baseline / 1e3,
+                     pRecord->files,
+                     pRecord->applied,
+                     pRecord->bytes / 1024.0,
+                     pRecord->phaseUs[METRICS_PHASE_IO] / 1e3,
+                     pRecord->phaseUs[METRICS_PHASE_PARSE] / 1e3,
+                     pRecord->phaseUs[METRICS_PHASE_EXPAND] / 1e3,
+                     pRecord->phaseUs[METRICS_PHASE_WRITE] / 1e3,
+                     pRecord->root,
+                     ( slow == true ) ? "  SLOW" : "" );
+        }
+
+        fprintf( fp,
+                 "History: %zu loads, %zu slower than %.2fx their baseline",
+                 n,
+                 flagged,
+                 factor );
+
+        if ( baseline > 0 )
+        {
+            fprintf( fp,
+                     ", latest %.3f ms against %.3f ms (%+.1f%%)",
+                     pRecords[n - 1].durationUs / 1e3,
+                     baseline / 1e3,
+                     ( (double)pRecords[n - 1].durationUs / baseline - 1 ) *
+                        100 );
+        }
+
+        fprintf( fp, "\n" );
+
+        /* the last record processed is the latest load */
+        result = ( slow == true ) ? ESTALE : EOK;
+    }
+
+    if ( fd != -1 )
+    {
+        close( fd );
+    }
+
+    free( pRecords );
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  ValidHeader                                                             */
+/*!
+    Check a history file header
+
+    @param[in]
+        pHeader
+            pointer to the header read from the file
+
+    @retval true the header is of a ring file of the current format
+    @retval false the file must be recreated
+
+============================================================================*/
+static bool ValidHeader( HistoryHeader *pHeader )
+{
+    return ( pHeader->magic == HISTORY_MAGIC ) &&
+           ( pHeader->version == HISTORY_VERSION ) &&
+           ( pHeader->recordSize == sizeof( HistoryRecord ) ) &&
+           ( pHeader->capacity == HISTORY_CAPACITY );
+}
+
+/*==========================================================================*/
+/*  Baseline                                                                */
+/*!
+    Get the baseline duration of a load
+
+    The baseline is the median duration of up to window loads of the
+    same root file which precede the load.
+
+    @param[in]
+        pRecords
+            pointer to the records from oldest to newest
+
+    @param[in]
+        n
+            number of records
+
+    @param[in]
+        index
+            index of the load to get the baseline of
+
+    @param[in]
+        window
+            maximum number of preceding loads in the baseline
+
+    @retval baseline duration in microseconds
+    @retval 0 if no load of the same root file precedes the load
+
+============================================================================*/
+static uint64_t Baseline( HistoryRecord *pRecords,
+                          size_t n,
+                          size_t index,
+                          unsigned int window )
+{
+    uint64_t durations[HISTORY_CAPACITY];
+    size_t count = 0;
+    size_t i;
+
+    for ( i = index;
+          ( i > 0 ) && ( i <= n ) && ( count < window ) &&
+          ( count < HISTORY_CAPACITY );
+          i-- )
+    {
+        if ( strcmp( pRecords[i - 1].root, pRecords[index].root ) == 0 )
+        {
+            durations[count++] = pRecords[i - 1].durationUs;
+        }
+    }
+
+    if ( count > 0 )
+    {
+        qsort( durations, count, sizeof( uint64_t ), CompareDurations );
+    }
+
+    return ( count > 0 ) ? durations[count / 2] : 0;
+}
+
+/*==========================================================================*/
+/*  CompareDurations                                                        */
+/*!
+    Compare two load durations for qsort
+
+    @param[in]
+        p1
+            pointer to the first duration
+
+    @param[in]
+        p2
+            pointer to the second duration
+
+    @retval negative, zero or positive as the first duration is less
+            than, equal to or greater than the second
+
+============================================================================*/
+static int CompareDurations( const void *p1, const void *p2 )
+{
+    uint64_t a = *(const uint64_t *)p1;
+    uint64_t b = *(const uint64_t *)p2;
+
+    return ( a > b ) - ( a < b );
+}
+
+/*! @}
+ * end of history group */
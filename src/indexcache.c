@@ -0,0 +1,488 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup indexcache indexcache
+ * @brief Shared in-memory line index cache
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file indexcache.c
+
+    Shared Line Index Cache
+
+    The Shared Line Index Cache holds the line indexes of configuration
+    files keyed by their content, so that a file with the same content
+    in several configuration trees is only scanned once, even when the
+    trees are evaluated by concurrent threads.
+
+    The cached line indexes are owned by the cache and must not be
+    freed by the caller.  Each line index returned by INDEXCACHE_Get is
+    held until it is returned with INDEXCACHE_Release.
+
+    The cache is bounded so that a long running service which loads
+    changing configuration does not grow without limit.  When the number
+    of entries or the size of the cached content exceeds its limit, the
+    least recently used entries which are not held are evicted.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include "hash.h"
+#include "indexcache.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+/*! number of hash buckets */
+#define INDEXCACHE_BUCKETS  64
+
+/*! maximum number of cached line indexes */
+#define INDEXCACHE_MAX_ENTRIES  256
+
+/*! maximum size of the cached content in bytes */
+#define INDEXCACHE_MAX_BYTES    ( 8 * 1024 * 1024 )
+
+/*! cached line index */
+typedef struct _IndexEntry
+{
+    /*! hash of the file content */
+    uint64_t hash;
+
+    /*! copy of the file content */
+    char *pData;
+
+    /*! length of the file content */
+    size_t len;
+
+    /*! line index of the file content */
+    LineIndex *pIndex;
+
+    /*! number of callers holding the line index */
+    int refs;
+
+    /*! cache tick of the most recent use */
+    uint64_t used;
+
+    /*! pointer to the next entry in the hash bucket */
+    struct _IndexEntry *pNext;
+
+} IndexEntry;
+
+/*! shared line index cache */
+struct _IndexCache
+{
+    /*! lock protecting the hash buckets */
+    pthread_mutex_t lock;
+
+    /*! hash buckets */
+    IndexEntry *buckets[INDEXCACHE_BUCKETS];
+
+    /*! number of cached line indexes */
+    size_t count;
+
+    /*! total size of the cached content */
+    size_t bytes;
+
+    /*! cache tick incremented on every lookup */
+    uint64_t tick;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static IndexEntry *Find( IndexCache *pCache,
+                         uint64_t hash,
+                         char *pData,
+                         size_t len );
+static void Evict( IndexCache *pCache );
+static void FreeEntry( IndexEntry *pEntry );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  INDEXCACHE_Create                                                       */
+/*!
+    Create an empty line index cache
+
+    @retval pointer to the line index cache
+    @retval NULL memory allocation failure
+
+============================================================================*/
+IndexCache *INDEXCACHE_Create( void )
+{
+    IndexCache *pCache;
+
+    pCache = calloc( 1, sizeof( IndexCache ) );
+    if ( pCache != NULL )
+    {
+        pthread_mutex_init( &pCache->lock, NULL );
+    }
+
+    return pCache;
+}
+
+/*==========================================================================*/
+/*  INDEXCACHE_Get                                                          */
+/*!
+    Get the line index of a configuration file
+
+    The INDEXCACHE_Get function returns the cached line index of
+    configuration data with the same content, or builds and caches it.
+    The data is scanned without holding the cache lock, so that
+    different files are scanned concurrently.
+
+    The returned line index is held, and is not evicted, until it is
+    returned with INDEXCACHE_Release.
+
+    @param[in]
+        pCache
+            pointer to the line index cache
+
+    @param[in]
+        pData
+            pointer to the configuration data
+
+    @param[in]
+        len
+            length of the configuration data
+
+    @param[out]
+        pHit
+            pointer to a location to store whether the index was cached,
+            or NULL
+
+    @retval pointer to the line index, owned by the cache
+    @retval NULL the line index could not be built
+
+============================================================================*/
+LineIndex *INDEXCACHE_Get( IndexCache *pCache,
+                           char *pData,
+                           size_t len,
+                           bool *pHit )
+{
+    LineIndex *pIndex = NULL;
+    IndexEntry *pEntry = NULL;
+    IndexEntry *pNew = NULL;
+    uint64_t hash = 0;
+    bool hit = false;
+
+    if ( ( pCache != NULL ) &&
+         ( pData != NULL ) )
+    {
+        hash = HASH_Fnv1a64( pData, len, HASH_FNV1A64_INIT );
+
+        pthread_mutex_lock( &pCache->lock );
+        pEntry = Find( pCache, hash, pData, len );
+        if ( pEntry != NULL )
+        {
+            pEntry->refs++;
+            pEntry->used = ++pCache->tick;
+        }
+        pthread_mutex_unlock( &pCache->lock );
+
+        hit = ( pEntry != NULL );
+        if ( pEntry == NULL )
+        {
+            pNew = calloc( 1, sizeof( IndexEntry ) );
+        }
+
+        if ( pNew != NULL )
+        {
+            pNew->hash = hash;
+            pNew->len = len;
+            pNew->pData = malloc( len );
+            pNew->pIndex = LINEINDEX_Build( pData, len );
+            if ( ( pNew->pData != NULL ) &&
+                 ( pNew->pIndex != NULL ) )
+            {
+                memcpy( pNew->pData, pData, len );
+
+                pthread_mutex_lock( &pCache->lock );
+
+                /* another evaluation may have scanned the same content */
+                pEntry = Find( pCache, hash, pData, len );
+                if ( pEntry == NULL )
+                {
+                    pNew->pNext = pCache->buckets[hash % INDEXCACHE_BUCKETS];
+                    pCache->buckets[hash % INDEXCACHE_BUCKETS] = pNew;
+                    pCache->count++;
+                    pCache->bytes += len;
+                    pEntry = pNew;
+                    pNew = NULL;
+                }
+
+                pEntry->refs++;
+                pEntry->used = ++pCache->tick;
+                Evict( pCache );
+
+                pthread_mutex_unlock( &pCache->lock );
+            }
+
+            FreeEntry( pNew );
+        }
+
+        if ( pEntry != NULL )
+        {
+            pIndex = pEntry->pIndex;
+        }
+    }
+
+    if ( pHit != NULL )
+    {
+        *pHit = hit;
+    }
+
+    return pIndex;
+}
+
+/*==========================================================================*/
+/*  INDEXCACHE_Release                                                      */
+/*!
+    Return a line index obtained from INDEXCACHE_Get
+
+    The INDEXCACHE_Release function releases the hold on a cached line
+    index, so that it may be evicted when the cache exceeds its limits.
+
+    @param[in]
+        pCache
+            pointer to the line index cache
+
+    @param[in]
+        pIndex
+            pointer to the line index returned by INDEXCACHE_Get
+
+============================================================================*/
+void INDEXCACHE_Release( IndexCache *pCache, LineIndex *pIndex )
+{
+    IndexEntry *pEntry = NULL;
+    int i;
+
+    if ( ( pCache != NULL ) &&
+         ( pIndex != NULL ) )
+    {
+        pthread_mutex_lock( &pCache->lock );
+
+        for ( i = 0; ( i < INDEXCACHE_BUCKETS ) && ( pEntry == NULL ); i++ )
+        {
+            pEntry = pCache->buckets[i];
+            while ( ( pEntry != NULL ) &&
+                    ( pEntry->pIndex != pIndex ) )
+            {
+                pEntry = pEntry->pNext;
+            }
+        }
+
+        if ( ( pEntry != NULL ) &&
+             ( pEntry->refs > 0 ) )
+        {
+            pEntry->refs--;
+            Evict( pCache );
+        }
+
+        pthread_mutex_unlock( &pCache->lock );
+    }
+}
+
+/*==========================================================================*/
+/*  INDEXCACHE_Free                                                         */
+/*!
+    Free a line index cache and all of its line indexes
+
+    @param[in]
+        pCache
+            pointer to the line index cache to free
+
+============================================================================*/
+void INDEXCACHE_Free( IndexCache *pCache )
+{
+    IndexEntry *pEntry;
+    IndexEntry *pNext;
+    int i;
+
+    if ( pCache != NULL )
+    {
+        for ( i = 0; i < INDEXCACHE_BUCKETS; i++ )
+        {
+            pEntry = pCache->buckets[i];
+            while ( pEntry != NULL )
+            {
+                pNext = pEntry->pNext;
+                FreeEntry( pEntry );
+                pEntry = pNext;
+            }
+        }
+
+        pthread_mutex_destroy( &pCache->lock );
+        free( pCache );
+    }
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  Find                                                                    */
+/*!
+    Find a cached line index with the specified content
+
+    The cache lock must be held by the caller.
+
+    @param[in]
+        pCache
+            pointer to the line index cache
+
+    @param[in]
+        hash
+            hash of the content
+
+    @param[in]
+        pData
+            pointer to the content
+
+    @param[in]
+        len
+            length of the content
+
+    @retval pointer to the cache entry
+    @retval NULL the content is not cached
+
+============================================================================*/
+static IndexEntry *Find( IndexCache *pCache,
+                         uint64_t hash,
+                         char *pData,
+                         size_t len )
+{
+    IndexEntry *pEntry = pCache->buckets[hash % INDEXCACHE_BUCKETS];
+
+    while ( ( pEntry != NULL ) &&
+            ( ( pEntry->hash != hash ) ||
+              ( pEntry->len != len ) ||
+              ( memcmp( pEntry->pData, pData, len ) != 0 ) ) )
+    {
+        pEntry = pEntry->pNext;
+    }
+
+    return pEntry;
+}
+
+/*==========================================================================*/
+/*  Evict                                                                   */
+/*!
+    Evict line indexes until the cache is within its limits
+
+    The Evict function removes the least recently used entries which
+    are not held by a caller, while the number of entries or the size
+    of the cached content exceeds its limit.  Entries which are held
+    are kept, so the cache may exceed its limits while they are in use.
+
+    The cache lock must be held by the caller.
+
+    @param[in]
+        pCache
+            pointer to the line index cache
+
+============================================================================*/
+static void Evict( IndexCache *pCache )
+{
+    IndexEntry **ppEntry;
+    IndexEntry **ppOldest;
+    IndexEntry *pEntry;
+    int i;
+
+    do
+    {
+        ppOldest = NULL;
+
+        if ( ( pCache->count > INDEXCACHE_MAX_ENTRIES ) ||
+             ( pCache->bytes > INDEXCACHE_MAX_BYTES ) )
+        {
+            /* find the least recently used entry which is not held */
+            for ( i = 0; i < INDEXCACHE_BUCKETS; i++ )
+            {
+                ppEntry = &pCache->buckets[i];
+                while ( *ppEntry != NULL )
+                {
+                    if ( ( (*ppEntry)->refs == 0 ) &&
+                         ( ( ppOldest == NULL ) ||
+                           ( (*ppEntry)->used < (*ppOldest)->used ) ) )
+                    {
+                        ppOldest = ppEntry;
+                    }
+
+                    ppEntry = &(*ppEntry)->pNext;
+                }
+            }
+        }
+
+        if ( ppOldest != NULL )
+        {
+            pEntry = *ppOldest;
+            *ppOldest = pEntry->pNext;
+            pCache->count--;
+            pCache->bytes -= pEntry->len;
+            FreeEntry( pEntry );
+        }
+
+    } while ( ppOldest != NULL );
+}
+
+/*==========================================================================*/
+/*  FreeEntry                                                               */
+/*!
+    Free a cache entry and its line index
+
+    @param[in]
+        pEntry
+            pointer to the cache entry to free, or NULL
+
+============================================================================*/
+static void FreeEntry( IndexEntry *pEntry )
+{
+    if ( pEntry != NULL )
+    {
+        LINEINDEX_Free( pEntry->pIndex );
+        free( pEntry->pData );
+        free( pEntry );
+    }
+}
+
+/*! @}
+ * end of indexcache group */
@@ -0,0 +1,673 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup journal journal
+ * @brief Journal of applied variable values
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file journal.c
+
+    Applied-State Journal
+
+    The Applied-State Journal functions append each value written to
+    the variable server to a journal file, so the values can be restored
+    after the variable server restarts without processing any
+    configuration files.
+
+    Each line of the journal holds the generation of the run which wrote
+    the value, the variable name and its value, separated by TABs.  TAB,
+    newline and backslash characters within the name and value are
+    escaped with a backslash.  Each
+    run which opens the journal starts a new generation.  A line which
+    is not terminated, for example after a power failure, is ignored,
+    and is removed before the next run appends to the journal.
+
+    When the journal is opened, it is compacted if most of its records
+    have been superseded.  The compacted journal holds the latest value
+    of each variable with the generation which wrote it, and replaces
+    the journal atomically.  The compacted journal is locked before it
+    replaces the journal, and a run which was waiting for the lock on the
+    replaced journal opens the journal again.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "journal.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! minimum number of records before the journal is compacted */
+#define JOURNAL_COMPACT_MIN     1024
+
+/*! the journal is compacted when it holds more than this many records
+    for each variable */
+#define JOURNAL_COMPACT_RATIO   2
+
+/*! journal open for appending */
+struct _Journal
+{
+    /*! journal file stream */
+    FILE *fp;
+
+    /*! generation of this run */
+    uint32_t generation;
+
+    /*! an append failed */
+    bool failed;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static FILE *OpenLocked( char *pPath );
+static int TrimRecord( FILE *fp );
+static int Compact( char *pPath, VarTable *pValues, FILE **ppFile );
+static int WriteRecord( VarEntry *pEntry, void *arg );
+static int WriteField( FILE *fp, char *pField );
+static void Unescape( char *pField );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JOURNAL_Open                                                            */
+/*!
+    Open the journal to append the values written by this run
+
+    The JOURNAL_Open function starts a new generation, compacting the
+    journal first if most of its records have been superseded.  The
+    journal is locked until it is closed, so concurrent runs append
+    their records in turn.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated name of the journal file
+
+    @retval pointer to the open journal
+    @retval NULL if the journal could not be opened
+
+============================================================================*/
+Journal *JOURNAL_Open( char *pPath )
+{
+    Journal *pJournal = NULL;
+    VarTable *pValues;
+    uint32_t generation = 0;
+    size_t records = 0;
+    FILE *fp = NULL;
+    FILE *fpCompact = NULL;
+
+    if ( pPath != NULL )
+    {
+        fp = OpenLocked( pPath );
+    }
+
+    if ( ( fp != NULL ) &&
+         ( TrimRecord( fp ) == EOK ) )
+    {
+        pValues = JOURNAL_Load( pPath, &generation, &records );
+        if ( ( pValues != NULL ) &&
+             ( records > JOURNAL_COMPACT_MIN ) &&
+             ( records > JOURNAL_COMPACT_RATIO *
+                            VARTABLE_Count( pValues ) ) &&
+             ( Compact( pPath, pValues, &fpCompact ) == EOK ) )
+        {
+            /* append to the compacted journal, which was locked before
+             * it replaced this one */
+            fclose( fp );
+            fp = fpCompact;
+        }
+
+        VARTABLE_Destroy( pValues );
+
+        pJournal = calloc( 1, sizeof( Journal ) );
+    }
+
+    if ( pJournal != NULL )
+    {
+        pJournal->fp = fp;
+        pJournal->generation = generation + 1;
+    }
+    else if ( fp != NULL )
+    {
+        fclose( fp );
+    }
+
+    return pJournal;
+}
+
+/*==========================================================================*/
+/*  JOURNAL_Append                                                          */
+/*!
+    Append a value written to the variable server to the journal
+
+    @param[in]
+        pJournal
+            pointer to the open journal, or NULL if not journaling
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pValue
+            pointer to the NUL terminated value
+
+    @retval EOK the value was appended, or there is no journal
+    @retval EIO the value could not be appended
+
+============================================================================*/
+int JOURNAL_Append( Journal *pJournal, char *pName, char *pValue )
+{
+    int result = EOK;
+
+    if ( ( pJournal != NULL ) &&
+         ( pName != NULL ) &&
+         ( pValue != NULL ) )
+    {
+        if ( ( fprintf( pJournal->fp, "%u\t", pJournal->generation ) < 0 ) ||
+             ( WriteField( pJournal->fp, pName ) != EOK ) ||
+             ( fputc( '\t', pJournal->fp ) == EOF ) ||
+             ( WriteField( pJournal->fp, pValue ) != EOK ) ||
+             ( fputc( '\n', pJournal->fp ) == EOF ) )
+        {
+            pJournal->failed = true;
+            result = EIO;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JOURNAL_Close                                                           */
+/*!
+    Flush the records of this run to storage and close the journal
+
+    @param[in]
+        pJournal
+            pointer to the open journal, or NULL if not journaling
+
+    @retval EOK the journal was closed
+    @retval EIO one or more records could not be written
+
+============================================================================*/
+int JOURNAL_Close( Journal *pJournal )
+{
+    int result = EOK;
+
+    if ( pJournal != NULL )
+    {
+        if ( ( fflush( pJournal->fp ) != 0 ) ||
+             ( fsync( fileno( pJournal->fp ) ) != 0 ) ||
+             ( pJournal->failed == true ) )
+        {
+            result = EIO;
+        }
+
+        fclose( pJournal->fp );
+        free( pJournal );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JOURNAL_Generation                                                      */
+/*!
+    Get the generation of the values appended by this run
+
+    @param[in]
+        pJournal
+            pointer to the open journal
+
+    @retval generation of this run
+    @retval 0 if not journaling
+
+============================================================================*/
+uint32_t JOURNAL_Generation( Journal *pJournal )
+{
+    return ( pJournal != NULL ) ? pJournal->generation : 0;
+}
+
+/*==========================================================================*/
+/*  JOURNAL_Load                                                            */
+/*!
+    Load the latest value of each variable from the journal
+
+    The JOURNAL_Load function reads the journal and returns a table
+    holding the latest value of each variable, with the generation which
+    wrote it in the flags of its entry.  A missing journal is empty.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated name of the journal file
+
+    @param[out]
+        pGeneration
+            pointer to a location to store the latest generation
+
+    @param[out]
+        pRecords
+            pointer to a location to store the number of records, or NULL
+
+    @retval pointer to the table of the latest values
+    @retval NULL if memory allocation failed or the journal is unreadable
+
+============================================================================*/
+VarTable *JOURNAL_Load( char *pPath,
+                        uint32_t *pGeneration,
+                        size_t *pRecords )
+{
+    VarTable *pValues = NULL;
+    VarEntry *pEntry;
+    FILE *fp = NULL;
+    char *pLine = NULL;
+    size_t size = 0;
+    ssize_t len;
+    size_t records = 0;
+    uint32_t generation = 0;
+    unsigned long gen;
+    char *pName;
+    char *pValue;
+
+    if ( ( pPath != NULL ) &&
+         ( pGeneration != NULL ) )
+    {
+        pValues = VARTABLE_Create( 0 );
+        fp = fopen( pPath, "r" );
+        if ( ( fp == NULL ) && ( errno != ENOENT ) )
+        {
+            VARTABLE_Destroy( pValues );
+            pValues = NULL;
+        }
+    }
+
+    while ( ( pValues != NULL ) &&
+            ( fp != NULL ) &&
+            ( ( len = getline( &pLine, &size, fp ) ) > 0 ) )
+    {
+        gen = strtoul( pLine, &pName, 10 );
+        pValue = ( *pName == '\t' ) ? strchr( ++pName, '\t' ) : NULL;
+
+        /* skip malformed and unterminated records */
+        if ( ( pValue != NULL ) &&
+             ( pLine[len - 1] == '\n' ) )
+        {
+            pLine[len - 1] = '\0';
+            *pValue++ = '\0';
+            Unescape( pName );
+            Unescape( pValue );
+
+            if ( VARTABLE_Set( pValues, pName, pValue ) == EOK )
+            {
+                pEntry = VARTABLE_Find( pValues, pName );
+                pEntry->flags = (int)gen;
+                records++;
+            }
+
+            if ( gen > generation )
+            {
+                generation = (uint32_t)gen;
+            }
+        }
+    }
+
+    if ( fp != NULL )
+    {
+        fclose( fp );
+    }
+
+    free( pLine );
+
+    if ( pGeneration != NULL )
+    {
+        *pGeneration = generation;
+    }
+
+    if ( pRecords != NULL )
+    {
+        *pRecords = records;
+    }
+
+    return pValues;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  OpenLocked                                                              */
+/*!
+    Open the journal and lock it for appending
+
+    A run which waited for the lock while another run compacted the
+    journal holds the lock on the replaced journal, so the journal is
+    opened again until the locked file is the current journal.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated name of the journal file
+
+    @retval pointer to the locked journal file stream
+    @retval NULL the journal could not be opened or locked
+
+============================================================================*/
+static FILE *OpenLocked( char *pPath )
+{
+    FILE *fp = NULL;
+    struct stat locked;
+    struct stat current;
+    bool replaced = true;
+
+    while ( replaced == true )
+    {
+        replaced = false;
+        fp = fopen( pPath, "a+" );
+        if ( ( fp != NULL ) &&
+             ( ( flock( fileno( fp ), LOCK_EX ) != 0 ) ||
+               ( fstat( fileno( fp ), &locked ) != 0 ) ) )
+        {
+            fclose( fp );
+            fp = NULL;
+        }
+        else if ( ( fp != NULL ) &&
+                  ( ( stat( pPath, &current ) != 0 ) ||
+                    ( current.st_dev != locked.st_dev ) ||
+                    ( current.st_ino != locked.st_ino ) ) )
+        {
+            /* the journal was replaced while waiting for the lock */
+            fclose( fp );
+            fp = NULL;
+            replaced = true;
+        }
+    }
+
+    return fp;
+}
+
+/*==========================================================================*/
+/*  TrimRecord                                                              */
+/*!
+    Remove a record which was cut short from the end of the journal
+
+    @param[in]
+        fp
+            pointer to the locked journal file stream
+
+    @retval EOK the journal ends with a complete record, or is empty
+    @retval other error as returned by the file system
+
+============================================================================*/
+static int TrimRecord( FILE *fp )
+{
+    int result = EOK;
+    off_t end;
+    off_t pos;
+
+    if ( ( fseeko( fp, 0, SEEK_END ) != 0 ) ||
+         ( ( end = ftello( fp ) ) < 0 ) )
+    {
+        result = errno;
+    }
+    else
+    {
+        /* find the end of the last complete record */
+        for ( pos = end;
+              ( pos > 0 ) &&
+              ( fseeko( fp, pos - 1, SEEK_SET ) == 0 ) &&
+              ( fgetc( fp ) != '\n' );
+              pos-- );
+
+        if ( ( pos < end ) &&
+             ( ftruncate( fileno( fp ), pos ) != 0 ) )
+        {
+            result = errno;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Compact                                                                 */
+/*!
+    Replace the journal with the latest value of each variable
+
+    The compacted journal is written to a temporary file, which is
+    locked before it replaces the journal so that no other run can
+    append to it before this run.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated name of the journal file
+
+    @param[in]
+        pValues
+            pointer to the table of latest values from JOURNAL_Load
+
+    @param[out]
+        ppFile
+            pointer to a location to store the locked file stream of
+            the compacted journal
+
+    @retval EOK the journal was compacted
+    @retval other error as returned by the file system
+
+============================================================================*/
+static int Compact( char *pPath, VarTable *pValues, FILE **ppFile )
+{
+    int result = EOK;
+    char tmppath[PATH_MAX];
+    FILE *fp = NULL;
+
+    if ( snprintf( tmppath,
+                   sizeof( tmppath ),
+                   "%s.%d",
+                   pPath,
+                   getpid() ) >= (int)sizeof( tmppath ) )
+    {
+        result = ENAMETOOLONG;
+    }
+    else if ( ( fp = fopen( tmppath, "w+" ) ) == NULL )
+    {
+        result = errno;
+    }
+    else
+    {
+        if ( ( flock( fileno( fp ), LOCK_EX ) != 0 ) ||
+             ( VARTABLE_ForEach( pValues, WriteRecord, fp ) != EOK ) ||
+             ( fflush( fp ) != 0 ) ||
+             ( fsync( fileno( fp ) ) != 0 ) )
+        {
+            result = ( errno != 0 ) ? errno : EIO;
+        }
+
+        if ( ( result == EOK ) &&
+             ( rename( tmppath, pPath ) != 0 ) )
+        {
+            result = errno;
+        }
+
+        if ( result == EOK )
+        {
+            *ppFile = fp;
+        }
+        else
+        {
+            fclose( fp );
+            unlink( tmppath );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  WriteRecord                                                             */
+/*!
+    Write the latest value of a variable to a compacted journal
+
+    @param[in]
+        pEntry
+            pointer to the variable table entry
+
+    @param[in]
+        arg
+            pointer to the output file stream
+
+    @retval EOK the record was written
+    @retval EIO the record could not be written
+
+============================================================================*/
+static int WriteRecord( VarEntry *pEntry, void *arg )
+{
+    FILE *fp = (FILE *)arg;
+    int result = EIO;
+
+    if ( ( fprintf( fp, "%u\t", (unsigned int)pEntry->flags ) >= 0 ) &&
+         ( WriteField( fp, pEntry->name ) == EOK ) &&
+         ( fputc( '\t', fp ) != EOF ) &&
+         ( WriteField( fp, pEntry->value ) == EOK ) &&
+         ( fputc( '\n', fp ) != EOF ) )
+    {
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  WriteField                                                              */
+/*!
+    Write a name or value to the journal, escaping the record separators
+
+    @param[in]
+        fp
+            pointer to the output file stream
+
+    @param[in]
+        pField
+            pointer to the NUL terminated name or value
+
+    @retval EOK the field was written
+    @retval EIO the field could not be written
+
+============================================================================*/
+static int WriteField( FILE *fp, char *pField )
+{
+    int result = EOK;
+    char *p;
+    int rc;
+
+    for ( p = pField; ( *p != '\0' ) && ( result == EOK ); p++ )
+    {
+        switch ( *p )
+        {
+            case '\t':
+                rc = fputs( "\\t", fp );
+                break;
+
+            case '\n':
+                rc = fputs( "\\n", fp );
+                break;
+
+            case '\\':
+                rc = fputs( "\\\\", fp );
+                break;
+
+            default:
+                rc = fputc( *p, fp );
+                break;
+        }
+
+        result = ( rc != EOF ) ? EOK : EIO;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Unescape                                                                */
+/*!
+    Restore the record separators escaped in a name or value
+
+    @param[in,out]
+        pField
+            pointer to the NUL terminated field, unescaped in place
+
+============================================================================*/
+static void Unescape( char *pField )
+{
+    char *pIn = pField;
+    char *pOut = pField;
+
+    while ( *pIn != '\0' )
+    {
+        if ( ( pIn[0] == '\\' ) && ( pIn[1] != '\0' ) )
+        {
+            pIn++;
+            *pOut++ = ( *pIn == 't' ) ? '\t'
+                    : ( *pIn == 'n' ) ? '\n'
+                    : *pIn;
+            pIn++;
+        }
+        else
+        {
+            *pOut++ = *pIn++;
+        }
+    }
+
+    *pOut = '\0';
+}
+
+/*! @}
+ * end of journal group */
@@ -0,0 +1,465 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup lineindex lineindex
+ * @brief Pre-tokenized configuration line index
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file lineindex.c
+
+    Line Index
+
+    The Line Index functions scan a buffer of configuration data and
+    build a compact index describing each line: its kind, its directive
+    type, the spans of its name and value (or directive and argument),
+    and the offsets of any ${} references it contains.
+
+    Lines without ${} references can be processed directly from the
+    index without being scanned or tokenized again.  The index contains
+    no pointers so it can be cached on disk and reused while the
+    configuration file is unchanged.
+
+    The name and value spans follow the rules used when processing an
+    expanded line: directives are split at the first space, and
+    assignments are split at the first = if there is one, otherwise
+    at the first space.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "lineindex.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+/*! directive name to type mapping */
+typedef struct directiveMap
+{
+    /*! name of the directive */
+    char *name;
+
+    /*! type of the directive */
+    DirectiveType type;
+
+} DirectiveMap;
+
+/*============================================================================
+        Private file scoped variables
+============================================================================*/
+
+/*! supported directives */
+static const DirectiveMap directives[] =
+{
+    { "@config", DIRECTIVE_CONFIG },
+    { "@include", DIRECTIVE_INCLUDE },
+    { "@require", DIRECTIVE_REQUIRE },
+    { "@includedir", DIRECTIVE_INCLUDEDIR },
+    { "@let", DIRECTIVE_LET },
+    { "@foreach", DIRECTIVE_FOREACH },
+    { "@end", DIRECTIVE_END },
+    { "@barrier", DIRECTIVE_BARRIER },
+    { "@ordered", DIRECTIVE_ORDERED },
+    { "@lazy", DIRECTIVE_LAZY }
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static uint32_t FindRefs( char *pLine, size_t len, RefInfo *pRefs );
+static void SplitLine( LineInfo *pInfo, char *pLine, size_t len );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  LINEINDEX_Build                                                         */
+/*!
+    Build the line index for a buffer of configuration data
+
+    The LINEINDEX_Build function scans a buffer of configuration data
+    and builds its line index.  The configuration data is not modified.
+
+    @param[in]
+        pData
+            pointer to the configuration data
+
+    @param[in]
+        len
+            length of the configuration data
+
+    @retval pointer to the line index
+    @retval NULL if the line index could not be created
+
+============================================================================*/
+LineIndex *LINEINDEX_Build( char *pData, size_t len )
+{
+    LineIndex *pIndex = NULL;
+    uint32_t nlines = 1;
+    uint32_t line = 0;
+    uint32_t ref = 0;
+    size_t start = 0;
+    size_t i;
+    LineInfo *pInfo;
+
+    if ( pData != NULL )
+    {
+        /* count the lines and references to size the index */
+        for ( i = 0; i < len; i++ )
+        {
+            if ( pData[i] == '\n' )
+            {
+                nlines++;
+            }
+        }
+
+        pIndex = LINEINDEX_Create( nlines, FindRefs( pData, len, NULL ) );
+        if ( pIndex != NULL )
+        {
+            for ( i = 0; i <= len; i++ )
+            {
+                if ( ( i == len ) || ( pData[i] == '\n' ) )
+                {
+                    pInfo = &pIndex->pLines[line++];
+                    pInfo->offset = start;
+                    pInfo->length = i - start;
+                    pInfo->refidx = ref;
+                    pInfo->nrefs = FindRefs( &pData[start],
+                                             pInfo->length,
+                                             &pIndex->pRefs[ref] );
+                    ref += pInfo->nrefs;
+
+                    SplitLine( pInfo, &pData[start], pInfo->length );
+
+                    start = i + 1;
+                }
+            }
+
+            pIndex->nlines = line;
+            pIndex->nrefs = ref;
+        }
+    }
+
+    return pIndex;
+}
+
+/*==========================================================================*/
+/*  LINEINDEX_Create                                                        */
+/*!
+    Create an empty line index
+
+    The LINEINDEX_Create function allocates a line index with space for
+    the specified number of lines and references.
+
+    @param[in]
+        nlines
+            number of lines
+
+    @param[in]
+        nrefs
+            number of ${} references
+
+    @retval pointer to the line index
+    @retval NULL if the line index could not be created
+
+============================================================================*/
+LineIndex *LINEINDEX_Create( uint32_t nlines, uint32_t nrefs )
+{
+    LineIndex *pIndex;
+
+    pIndex = calloc( 1, sizeof( LineIndex ) );
+    if ( pIndex != NULL )
+    {
+        pIndex->nlines = nlines;
+        pIndex->nrefs = nrefs;
+        pIndex->pLines = calloc( nlines + 1, sizeof( LineInfo ) );
+        pIndex->pRefs = calloc( nrefs + 1, sizeof( RefInfo ) );
+
+        if ( ( pIndex->pLines == NULL ) ||
+             ( pIndex->pRefs == NULL ) )
+        {
+            LINEINDEX_Free( pIndex );
+            pIndex = NULL;
+        }
+    }
+
+    return pIndex;
+}
+
+/*==========================================================================*/
+/*  LINEINDEX_Terminate                                                     */
+/*!
+    NUL terminate the lines of configuration data
+
+    The LINEINDEX_Terminate function replaces the line break at the end
+    of each indexed line with a NUL terminator so each line can be
+    used as a string.
+
+    @param[in]
+        pIndex
+            pointer to the line index
+
+    @param[in]
+        pData
+            pointer to the configuration data which has space for a
+            NUL terminator after the last line
+
+============================================================================*/
+void LINEINDEX_Terminate( LineIndex *pIndex, char *pData )
+{
+    uint32_t i;
+    LineInfo *pInfo;
+
+    if ( ( pIndex != NULL ) &&
+         ( pData != NULL ) )
+    {
+        for ( i = 0; i < pIndex->nlines; i++ )
+        {
+            pInfo = &pIndex->pLines[i];
+            pData[pInfo->offset + pInfo->length] = '\0';
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  LINEINDEX_Free                                                          */
+/*!
+    Free a line index
+
+    @param[in]
+        pIndex
+            pointer to the line index to free
+
+============================================================================*/
+void LINEINDEX_Free( LineIndex *pIndex )
+{
+    if ( pIndex != NULL )
+    {
+        free( pIndex->pLines );
+        free( pIndex->pRefs );
+        free( pIndex );
+    }
+}
+
+/*==========================================================================*/
+/*  LINEINDEX_DirectiveType                                                 */
+/*!
+    Get the type of a directive
+
+    The LINEINDEX_DirectiveType function maps a directive name to its
+    directive type.
+
+    @param[in]
+        pDirective
+            pointer to the directive name, eg "@include"
+
+    @param[in]
+        len
+            length of the directive name
+
+    @retval the directive type
+    @retval DIRECTIVE_UNKNOWN if the directive is not recognized
+
+============================================================================*/
+DirectiveType LINEINDEX_DirectiveType( char *pDirective, size_t len )
+{
+    DirectiveType type = DIRECTIVE_UNKNOWN;
+    size_t i;
+
+    if ( pDirective != NULL )
+    {
+        for ( i = 0; i < sizeof( directives ) / sizeof( directives[0] ); i++ )
+        {
+            if ( ( strncmp( directives[i].name, pDirective, len ) == 0 ) &&
+                 ( directives[i].name[len] == '\0' ) )
+            {
+                type = directives[i].type;
+                break;
+            }
+        }
+    }
+
+    return type;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FindRefs                                                                */
+/*!
+    Find the ${} references in a line
+
+    The FindRefs function finds the ${} references in a block of
+    configuration data, and optionally records their offsets.
+    A reference must be closed on the line it was opened on.
+
+    @param[in]
+        pLine
+            pointer to the configuration data
+
+    @param[in]
+        len
+            length of the configuration data
+
+    @param[out]
+        pRefs
+            pointer to an array to receive the references, or NULL
+            if the references are only to be counted
+
+    @retval number of references found
+
+============================================================================*/
+static uint32_t FindRefs( char *pLine, size_t len, RefInfo *pRefs )
+{
+    uint32_t n = 0;
+    size_t i = 0;
+    size_t j;
+
+    while ( i + 1 < len )
+    {
+        if ( ( pLine[i] == '$' ) && ( pLine[i+1] == '{' ) )
+        {
+            /* find the end of the reference on the same line */
+            for ( j = i + 2;
+                  ( j < len ) && ( pLine[j] != '}' ) && ( pLine[j] != '\n' );
+                  j++ );
+
+            if ( ( j < len ) && ( pLine[j] == '}' ) )
+            {
+                if ( pRefs != NULL )
+                {
+                    pRefs[n].offset = i;
+                    pRefs[n].length = j - i + 1;
+                }
+
+                n++;
+                i = j;
+            }
+        }
+
+        i++;
+    }
+
+    return n;
+}
+
+/*==========================================================================*/
+/*  SplitLine                                                               */
+/*!
+    Classify a line and find its name and value spans
+
+    The SplitLine function determines the kind of a configuration line
+    and locates its name and value spans.
+
+    @param[in,out]
+        pInfo
+            pointer to the line information to populate
+
+    @param[in]
+        pLine
+            pointer to the start of the line
+
+    @param[in]
+        len
+            length of the line
+
+============================================================================*/
+static void SplitLine( LineInfo *pInfo, char *pLine, size_t len )
+{
+    char delim = ' ';
+    size_t i = 0;
+    size_t name;
+
+    pInfo->directive = DIRECTIVE_NONE;
+
+    if ( len == 0 )
+    {
+        pInfo->kind = LINE_BLANK;
+    }
+    else if ( pLine[0] == '#' )
+    {
+        pInfo->kind = LINE_COMMENT;
+    }
+    else
+    {
+        if ( pLine[0] == '@' )
+        {
+            pInfo->kind = LINE_DIRECTIVE;
+        }
+        else
+        {
+            pInfo->kind = LINE_ASSIGNMENT;
+
+            /* assignments use an = delimiter if there is one */
+            if ( memchr( pLine, '=', len ) != NULL )
+            {
+                delim = '=';
+            }
+
+            /* skip leading delimiters */
+            while ( ( i < len ) && ( pLine[i] == delim ) )
+            {
+                i++;
+            }
+        }
+
+        name = i;
+        while ( ( i < len ) && ( pLine[i] != delim ) )
+        {
+            i++;
+        }
+
+        pInfo->nameoff = name;
+        pInfo->namelen = i - name;
+
+        /* the value follows the first delimiter after the name */
+        pInfo->valoff = ( i < len ) ? i + 1 : len;
+        pInfo->vallen = len - pInfo->valoff;
+
+        if ( pInfo->kind == LINE_DIRECTIVE )
+        {
+            pInfo->directive = LINEINDEX_DirectiveType( &pLine[name],
+                                                        pInfo->namelen );
+        }
+    }
+}
+
+/*! @}
+ * end of lineindex group */
@@ -79,6 +79,16 @@ SOFTWARE.
 
     @includedir - specifies a directory of configuration files to process
 
+    @let - defines a loader-local variable which can be referenced using
+           the ${} notation but is never written to the variable server
+
+    @foreach - repeats the lines up to the matching @end once for each
+               value in an integer range or list of values
+
+    @lazy - specifies a namespace and a configuration file which is only
+            processed when a variable in the namespace is first read,
+            when serving values on demand
+
 
 */
 /*==========================================================================*/
@@ -88,18 +98,45 @@ SOFTWARE.
 ============================================================================*/
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <dirent.h>
+#include <pthread.h>
 #include <varserver/vartemplate.h>
 #include <varserver/varserver.h>
+#include "vartable.h"
+#include "applied.h"
+#include "lineindex.h"
+#include "parsecache.h"
+#include "readahead.h"
+#include "fileutil.h"
+#include "assignlist.h"
+#include "fanout.h"
+#include "varcall.h"
+#include "metrics.h"
+#include "perfcount.h"
+#include "varlog.h"
+#include "indexcache.h"
+#include "treediff.h"
+#include "options.h"
+#include "provenance.h"
+#include "analyze.h"
+#include "server.h"
+#include "coalesce.h"
+#include "audit.h"
+#include "resident.h"
+#include "journal.h"
+#include "feed.h"
+#include "history.h"
 
 /*============================================================================
         Private definitions
@@ -114,11 +151,155 @@ SOFTWARE.
 /*! size of the buffer used to store the shared memory client name */
 #define CLIENT_NAME_SIZE ( 128 )
 
+/*! default directory for cached loader state */
+#define DEFAULT_CACHE_DIR   "/var/cache/loadconfig"
+
+/*! sub-directory of the cache directory holding applied assignments */
+#define APPLIED_DIR         "applied"
+
+/*! sub-directory of the cache directory holding parsed line indexes */
+#define PARSE_DIR           "parse"
+
+/*! name of the readahead list within the cache directory */
+#define READAHEAD_FILE      "readahead"
+
+/*! name of the provenance index within the cache directory */
+#define PROVENANCE_FILE     "provenance"
+
+/*! sub-directory of the cache directory holding the coalescing locks */
+#define LOCK_DIR            "locks"
+
+/*! suffix of a coalescing lock file */
+#define LOCK_SUFFIX         ".lock"
+
+/*! name of the applied-state journal within the cache directory */
+#define JOURNAL_FILE        "journal"
+
+/*! name of the run generation counter within the cache directory */
+#define GENERATION_FILE     "generation"
+
+/*! default load performance history ring file */
+#define DEFAULT_HISTORY_FILE    "/var/lib/loadconfig/history"
+
+/*! default duration ratio above the baseline which is a regression */
+#define DEFAULT_HISTORY_FACTOR  ( 1.5 )
+
+/*! number of preceding loads in the regression baseline */
+#define HISTORY_WINDOW          ( 10 )
+
+/*! maximum number of lines in a block of lines expanded in parallel */
+#define EXPAND_BLOCK_LINES  ( 1024 )
+
+/*! minimum number of lines to expand for a block to be expanded in
+    parallel */
+#define EXPAND_MIN_LINES    ( 16 )
+
+/*! maximum number of parallel expansion jobs */
+#define MAX_JOBS            ( 64 )
+
+/*! handling of assignments removed since the previous incremental run */
+typedef enum removedPolicy
+{
+    /*! leave the variable at its current value */
+    REMOVED_KEEP = 0,
+
+    /*! leave the variable at its current value and report it */
+    REMOVED_WARN,
+
+    /*! clear the variable value */
+    REMOVED_CLEAR
+
+} RemovedPolicy;
+
+/*! configuration loop started by a @foreach directive */
+typedef struct configLoop
+{
+    /*! name of the loop variable */
+    char *pVarName;
+
+    /*! range or list of values to iterate over */
+    char *pValues;
+
+    /*! value of the local variable hidden by the loop variable, or NULL */
+    char *pShadowed;
+
+    /*! line number of the @foreach directive */
+    int lineno;
+
+} ConfigLoop;
+
+/*! line expanded by a parallel expansion worker */
+typedef struct _ExpandedLine
+{
+    /*! result of the expansion */
+    int result;
+
+    /*! worker holding the expanded line */
+    unsigned int worker;
+
+    /*! offset of the expanded line in the output buffer of the worker */
+    size_t offset;
+
+} ExpandedLine;
+
+/*! block of independent lines being expanded in parallel */
+typedef struct _ExpandBlock
+{
+    /*! pointer to the buffer of NUL terminated configuration lines */
+    char *pConfigData;
+
+    /*! pointer to the line index of the configuration data */
+    LineIndex *pIndex;
+
+    /*! index of the first line of the block */
+    uint32_t first;
+
+    /*! index one past the last line of the block */
+    uint32_t last;
+
+    /*! number of workers sharing the block */
+    unsigned int nworkers;
+
+    /*! expanded lines of the block */
+    ExpandedLine lines[EXPAND_BLOCK_LINES];
+
+} ExpandBlock;
+
+/*! worker expanding lines in parallel */
+typedef struct _Expander Expander;
+
 /*! Load state */
 typedef struct loadState
 {
-    /*! variable server handle */
-    VARSERVER_HANDLE hVarServer;
+    /*! variable server call context */
+    VarCall *pVarCall;
+
+    /*! variable server call deadlines, retries and queueing */
+    VarCallOptions callOptions;
+
+    /*! report variable server call latency statistics */
+    bool latency;
+
+    /*! run metrics */
+    Metrics metrics;
+
+    /*! prefix of the published metric variables, or NULL if not publishing */
+    char *pMetricsPrefix;
+
+    /*! count hardware events for each file and load phase */
+    bool perfCounters;
+
+    /*! performance counters, or NULL if not counting */
+    PerfCounters *pPerf;
+
+    /*! name of the log to record variable server calls into, or NULL */
+    char *pRecordFile;
+
+    /*! name of the log to replay variable server calls from, or NULL */
+    char *pReplayFile;
+
+    /*! replay variable server calls at their recorded latency */
+    bool replayLatency;
 
     /*! verbose flag */
     bool verbose;
@@ -129,9 +310,6 @@ typedef struct loadState
     /*! current line number of the active configuration file */
     int lineno;
 
-    /*! required flag indicating if the config file is mandatory */
-    bool required;
-
     /*! working buffer file descriptor */
     int fd;
 
@@ -144,8 +322,234 @@ typedef struct loadState
     /*! shared memory client name */
     char clientname[CLIENT_NAME_SIZE];
 
+    /*! pointer to the local variable expansion buffer */
+    char *linebuf;
+
+    /*! loader-local variables defined with the @let directive */
+    VarTable *pLocalVars;
+
+    /*! loop started by the most recent @foreach directive */
+    ConfigLoop *pLoop;
+
+    /*! incremental mode only sends added or changed assignments */
+    bool incremental;
+
+    /*! handling of removed assignments in incremental mode */
+    RemovedPolicy removedPolicy;
+
+    /*! name of the cache directory */
+    char *pCacheDir;
+
+    /*! name of the directory holding the applied assignment sidecars */
+    char *pAppliedDir;
+
+    /*! use the persistent parse cache */
+    bool parseCache;
+
+    /*! name of the parse cache directory, or NULL if not in use */
+    char *pParseDir;
+
+    /*! read ahead the files opened by the previous run */
+    bool readahead;
+
+    /*! name of the readahead list file */
+    char *pReadaheadFile;
+
+    /*! files opened by the previous run */
+    ReadaheadList *pPrevReadahead;
+
+    /*! files opened by this run, or NULL if not recording */
+    ReadaheadList *pReadahead;
+
+    /*! variable server targets to apply the configuration to */
+    char **ppTargets;
+
+    /*! number of variable server targets */
+    size_t ntargets;
+
+    /*! assignments collected for the targets, or NULL if not collecting */
+    AssignList *pAssignList;
+
+    /*! assignments applied from the current file in the previous run */
+    VarTable *pApplied;
+
+    /*! assignments parsed from the current file in this run */
+    VarTable *pParsed;
+
+    /*! final value of every variable assigned in this run */
+    VarTable *pRunVars;
+
+    /*! variables which have been written to the variable server */
+    VarTable *pDirty;
+
+    /*! variables whose assignments were removed since the previous run */
+    VarTable *pRemoved;
+
+    /*! roots of the configuration trees to compare, or NULL */
+    char *pDiffRoots[2];
+
+    /*! name of the seed file for the comparison, or NULL */
+    char *pSeedFile;
+
+    /*! root directory of the configuration tree, or NULL for / */
+    char *pRoot;
+
+    /*! seeded variable store used instead of the variable server, or NULL */
+    VarTable *pSeed;
+
+    /*! line index cache shared between evaluations, or NULL */
+    IndexCache *pIndexCache;
+
+    /*! suppress progress output */
+    bool quiet;
+
+    /*! write a provenance index at the end of the run */
+    bool provenance;
+
+    /*! name of the provenance index file, or NULL for the default */
+    char *pProvenanceFile;
+
+    /*! provenance index of this run, or NULL if not recording */
+    Provenance *pProvenance;
+
+    /*! unexpanded text of the line being processed, or NULL */
+    char *pRawLine;
+
+    /*! variable to report the provenance of, or NULL */
+    char *pWhy;
+
+    /*! report the cost of each configuration file */
+    bool analyze;
+
+    /*! column to order the analysis report by */
+    AnalyzeSort analyzeSort;
+
+    /*! configuration tree analysis, or NULL if not analyzing */
+    Analysis *pAnalysis;
+
+    /*! evaluate the configuration without writing to the variable server */
+    bool dryRun;
+
+    /*! name of the socket to serve load requests on, or NULL */
+    char *pServeSocket;
+
+    /*! only apply variables whose names start with this prefix, or NULL */
+    char *pFilter;
+
+    /*! coalesce concurrent invocations */
+    bool coalesce;
+
+    /*! wait for the follow-up load instead of exiting */
+    bool coalesceWait;
+
+    /*! name of the coalescing lock file, or NULL for the default */
+    char *pLockFile;
+
+    /*! allow writes between barriers to be reordered and coalesced */
+    bool relaxed;
+
+    /*! writes deferred until the next barrier, or NULL if not relaxed */
+    AssignList *pPending;
+
+    /*! the current file requires its writes to be made in order */
+    bool ordered;
+
+    /*! number of threads expanding independent lines */
+    unsigned int jobs;
+
+    /*! parallel expansion workers, or NULL if not created */
+    Expander *pExpanders;
+
+    /*! compare the live variable values with the configuration */
+    bool audit;
+
+    /*! provenance index holding the expected values, or NULL to
+        evaluate the configuration */
+    char *pAuditIndex;
+
+    /*! provider of the values served on demand, or NULL */
+    Resident *pResident;
+
+    /*! values served on demand */
+    VarTable *pLazyValues;
+
+    /*! journal the values written to the variable server */
+    bool journal;
+
+    /*! restore the values from the journal instead of loading */
+    bool restore;
+
+    /*! name of the journal file, or NULL for the default */
+    char *pJournalFile;
+
+    /*! journal open for appending, or NULL if not journaling */
+    Journal *pJournal;
+
+    /*! destination of the change feed, or NULL for no feed */
+    char *pFeedDest;
+
+    /*! framing of the change feed events */
+    FeedFormat feedFormat;
+
+    /*! change feed of the applied assignments, or NULL if not open */
+    Feed *pFeed;
+
+    /*! report the load performance history instead of loading */
+    bool history;
+
+    /*! duration ratio above the baseline which is a regression */
+    double historyFactor;
+
+    /*! load performance history ring file */
+    char *pHistoryFile;
+
 } LoadState;
 
+/*! worker expanding lines in parallel */
+struct _Expander
+{
+    /*! load state holding the working buffers of a worker thread */
+    LoadState state;
+
+    /*! load state used for expansion by the worker */
+    LoadState *pLoad;
+
+    /*! index of the worker */
+    unsigned int worker;
+
+    /*! block of lines being expanded */
+    ExpandBlock *pBlock;
+
+    /*! worker thread */
+    pthread_t thread;
+
+    /*! the worker thread was started */
+    bool started;
+
+    /*! expanded lines of the worker */
+    char *pText;
+
+    /*! length of the expanded lines of the worker */
+    size_t len;
+
+    /*! size of the expanded line buffer */
+    size_t size;
+};
+
+/*! evaluation of a configuration tree for comparison */
+typedef struct _TreeEval
+{
+    /*! load state of the evaluation */
+    LoadState state;
+
+    /*! thread evaluating the tree */
+    pthread_t thread;
+
+    /*! result of the evaluation */
+    int result;
+
+} TreeEval;
+
 /*============================================================================
         Private file scoped variables
 ============================================================================*/
@@ -159,17 +563,132 @@ static int ProcessOptions( int argC, char *argV[], LoadState *pState );
 static void usage( char *cmdname );
 static int CreateWorkingBuffer( LoadState *pState );
 static void DestroyWorkingBuffer( LoadState *pState );
-static int ProcessConfigFile( LoadState *pState, char *filename );
-static int ProcessConfigData( LoadState *pState, char *pConfigData );
+static int ProcessConfigFile( LoadState *pState,
+                              char *filename,
+                              bool required );
+static int ProcessConfigData( LoadState *pState,
+                              char *pConfigData,
+                              LineIndex *pIndex,
+                              uint32_t first,
+                              uint32_t last );
+static int ProcessIndexedLine( LoadState *pState,
+                               char *pConfigData,
+                               LineIndex *pIndex,
+                               uint32_t n );
+static int ExpandConfigLine( LoadState *pState,
+                             char *pConfigLine,
+                             size_t len,
+                             RefInfo *pRefs,
+                             uint32_t nrefs,
+                             char **ppLine );
+static int AppendLine( LoadState *pState,
+                       size_t *pOffset,
+                       char *pText,
+                       size_t len );
+static int ProcessExpandedLine( LoadState *pState,
+                                int result,
+                                char *pExpanded );
+static uint32_t FindExpandBlock( LoadState *pState,
+                                 char *pConfigData,
+                                 LineIndex *pIndex,
+                                 uint32_t first,
+                                 uint32_t last,
+                                 uint32_t *pCount );
+static int ProcessExpandBlock( LoadState *pState,
+                               char *pConfigData,
+                               LineIndex *pIndex,
+                               uint32_t first,
+                               uint32_t last,
+                               uint32_t count );
+static void *ExpandLines( void *arg );
+static int CreateExpanders( LoadState *pState );
+static void DestroyExpanders( LoadState *pState );
 static int ProcessConfigLine( LoadState *pState, char *pConfigLine );
 static int ProcessDirective( LoadState *pState, char *pConfigDirective );
+static int DispatchDirective( LoadState *pState,
+                              DirectiveType type,
+                              char *pArg );
 static int ProcessConfigDirective( LoadState *pState, char *pInfo );
 static int ProcessIncludeDirective( LoadState *pState, char *pFilename );
 static int ProcessRequireDirective( LoadState *pState, char *pFilename );
 static int ProcessIncludeDirDirective( LoadState *pState, char *pDirname );
+static int ProcessLetDirective( LoadState *pState, char *pArgs );
+static int ProcessForeachDirective( LoadState *pState, char *pArgs );
+static int ProcessLazyDirective( LoadState *pState, char *pArgs );
+static int DeclareLazy( LoadState *pState, char *pPrefix, char *pFileName );
+static int LoadLazy( void *arg, char *pFileName );
+static int AddLazyNamespace( LoadState *pState, char *pPrefix );
+static uint32_t FindLoopEnd( LineIndex *pIndex,
+                             uint32_t first,
+                             uint32_t last );
+static int ExecuteLoop( LoadState *pState,
+                        ConfigLoop *pLoop,
+                        char *pConfigData,
+                        LineIndex *pIndex,
+                        uint32_t first,
+                        uint32_t last );
+static int ExecuteLoopBody( LoadState *pState,
+                            ConfigLoop *pLoop,
+                            char *pValue,
+                            char *pConfigData,
+                            LineIndex *pIndex,
+                            uint32_t first,
+                            uint32_t last );
+static void FreeLoop( ConfigLoop *pLoop );
 static int ProcessVariableAssignment( LoadState *pState, char *pConfig );
+static int ApplyAssignment( LoadState *pState, char *pVar, char *pVal );
+static int WriteAssignment( LoadState *pState, char *pVar, char *pVal );
+static int Barrier( LoadState *pState );
+static int InitIncremental( LoadState *pState );
+static int InitReadahead( LoadState *pState );
+static int InitVarLog( LoadState *pState );
+static int RunDiff( LoadState *pState );
+static int InitTreeEval( TreeEval *pEval,
+                         LoadState *pState,
+                         char *pRoot,
+                         VarTable *pSeed,
+                         IndexCache *pIndexCache );
+static void *EvaluateTree( void *arg );
+static void FreeTreeEval( TreeEval *pEval );
+static void Coalesce( LoadState *pState );
+static char *CoalesceLockFile( LoadState *pState );
+static int RunServer( LoadState *pState );
+static int RunAudit( LoadState *pState );
+static int RunRestore( LoadState *pState );
+static int RestoreValue( VarEntry *pEntry, void *arg );
+static char *JournalFile( LoadState *pState );
+static uint32_t NextGeneration( LoadState *pState );
+static char *LiveValue( LoadState *pState, char *pVar );
+static int RecordHistory( LoadState *pState );
+static int AddExpected( char *pName,
+                        char *pValue,
+                        char *pFileName,
+                        int lineno,
+                        void *arg );
+static int ServeLoad( void *arg,
+                      ServerRequest *pRequest,
+                      ServerReply *pReply );
+static int AddTarget( LoadState *pState, char *pTarget );
+static char *ProvenanceFile( LoadState *pState );
+static int Why( LoadState *pState );
+static void CloseReadahead( LoadState *pState );
+static char *CacheSubDir( LoadState *pState, char *pName );
+static int MakeFileDir( char *pPath );
+static void JournalConfirmed( void *arg, char *pName, char *pValue );
+static void CloseIncremental( LoadState *pState );
+static int BeginIncrementalFile( LoadState *pState, char *pFileName );
+static void EndIncrementalFile( LoadState *pState, char *pFileName );
+static int FindRemoved( VarEntry *pEntry, void *arg );
+static int ApplyRemoved( VarEntry *pEntry, void *arg );
+static bool IsUnchanged( LoadState *pState, char *pVar, char *pVal );
+static void TrackAssignment( LoadState *pState,
+                             char *pVar,
+                             char *pVal,
+                             bool sent,
+                             int rc );
 void LogError( LoadState *pState, char *error );
 void LogVarError( LoadState *pState, char *varname, char *error );
+static char *LoadConfigData( LoadState *pState, char *pFileName );
 static char *GetConfigData( char *filename );
 static size_t GetFileSize( char *filename );
 static bool IsConfigFile( FILE *fp );
@@ -202,13 +721,18 @@ int main(int argc, char **argv)
 {
     LoadState state;
     int result = EINVAL;
+    char *pJournalFile;
 
     /* clear the load state object */
     memset( &state, 0, sizeof( state ) );
 
     /* initialize the load state object */
+    METRICS_Init( &state.metrics );
     state.fd = -1;
     state.workbufSize = DEFAULT_WORKBUF_SIZE;
+    state.pCacheDir = DEFAULT_CACHE_DIR;
+    state.pHistoryFile = DEFAULT_HISTORY_FILE;
+    state.historyFactor = DEFAULT_HISTORY_FACTOR;
 
     if( argc < 2 )
     {
@@ -219,268 +743,4799 @@ int main(int argc, char **argv)
     /* process the command line options */
     ProcessOptions( argc, argv, &state );
 
-    /* open a handle to the variable server */
-    state.hVarServer = VARSERVER_Open();
-    if( state.hVarServer != NULL )
+    if ( ( state.coalesce == true ) &&
+         ( state.pWhy == NULL ) &&
+         ( state.pDiffRoots[0] == NULL ) &&
+         ( state.pServeSocket == NULL ) &&
+         ( state.audit == false ) &&
+         ( state.restore == false ) &&
+         ( state.history == false ) )
     {
-        if ( CreateWorkingBuffer(&state) == EOK )
-        {
-            /* indicate that the top level config file is mandatory */
-            state.required = true;
-
-            /* Process the configuration file */
-            result = ProcessConfigFile( &state, state.pFileName );
+        /* only continue in the process which should perform the load */
+        Coalesce( &state );
+    }
 
-            /*! destroy the working buffer */
-            DestroyWorkingBuffer(&state);
-        }
-        else
+    if ( state.perfCounters == true )
+    {
+        /* counting continues without the counters which are unavailable */
+        state.pPerf = PERFCOUNT_Create();
+        if ( state.pPerf == NULL )
         {
-            LogError( &state, "Cannot create working buffer" );
+            fprintf( stderr,
+                     "Performance counters unavailable: %s\n",
+                     strerror( errno ) );
         }
-
-        /* close the handle to the variable server */
-        VARSERVER_Close( state.hVarServer );
     }
 
-    return ( result == EOK ) ? 0 : 1;
-}
-
-/*==========================================================================*/
-/*  usage                                                                   */
-/*!
-    Display the application usage
-
-    The usage function dumps the application usage message
-    to stderr.
-
-    @param[in]
-       cmdname
-            pointer to the invoked command name
-
-    @return none
+    /* create the table of loader-local variables */
+    state.pLocalVars = VARTABLE_Create( 0 );
+    if ( state.pLocalVars == NULL )
+    {
+        LogError( &state, "Cannot create local variable table" );
+        exit( 1 );
+    }
 
-============================================================================*/
-static void usage( char *cmdname )
-{
-    if( cmdname != NULL )
+    if ( ( state.incremental == true ) &&
+         ( state.callOptions.queue == true ) )
     {
-        fprintf(stderr,
-                "usage: %s [-v] [-h]\n"
-                " [-h] : display this help\n"
-                " [-v] : verbose output\n"
-                " [-W <size> ] : working buffer size\n"
-                " -f <filename> : configuration file\n",
-                cmdname );
+        LogError( &state, "Incremental mode cannot be used with queueing" );
+        exit( 1 );
     }
-}
 
-/*==========================================================================*/
-/*  ProcessOptions                                                          */
-/*!
-    Process the command line options
+    if ( state.pWhy != NULL )
+    {
+        /* report the provenance recorded by a previous run */
+        exit( ( Why( &state ) == EOK ) ? 0 : 1 );
+    }
 
-    The ProcessOptions function processes the command line options and
-    populates the ExecVarState object
+    if ( state.history == true )
+    {
+        /* report the loads recorded by previous runs */
+        result = HISTORY_Report( state.pHistoryFile,
+                                 state.historyFactor,
+                                 HISTORY_WINDOW,
+                                 stdout );
+        if ( ( result != EOK ) && ( result != ESTALE ) )
+        {
+            fprintf( stderr,
+                     "No load history in %s\n",
+                     state.pHistoryFile );
+        }
 
-    @param[in]
-        argC
-            number of arguments
-            (including the command itself)
+        exit( ( result == EOK ) ? 0 : 1 );
+    }
 
-    @param[in]
-        argv
-            array of pointers to the command line arguments
+    if ( state.ntargets > 0 )
+    {
+        if ( state.incremental == true )
+        {
+            LogError( &state, "Incremental mode cannot be used with targets" );
+            exit( 1 );
+        }
 
-    @param[in]
-        pState
-            pointer to the loadconfig utility state object
+        /* collect the assignments to apply to each target */
+        state.pAssignList = ASSIGNLIST_Create();
+        if ( state.pAssignList == NULL )
+        {
+            LogError( &state, "Cannot create assignment list" );
+            exit( 1 );
+        }
+    }
 
-    @return 0
+    if ( state.pDiffRoots[0] != NULL )
+    {
+        /* compare two configuration trees without the variable server */
+        exit( ( RunDiff( &state ) == EOK ) ? 0 : 1 );
+    }
 
-============================================================================*/
-static int ProcessOptions( int argC, char *argV[], LoadState *pState )
-{
-    int c;
-    int result = EINVAL;
-    const char *options = "hvf:w:";
+    if ( state.pServeSocket != NULL )
+    {
+        /* serve load requests until stopped */
+        exit( ( RunServer( &state ) == EOK ) ? 0 : 1 );
+    }
 
-    if( ( pState != NULL ) &&
-        ( argV != NULL ) )
+    if ( state.dryRun == true )
     {
-        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        if ( state.incremental == true )
         {
-            switch( c )
-            {
-                case 'v':
-                    pState->verbose = true;
-                    break;
-
-                case 'h':
-                    usage( argV[0] );
-                    break;
-
-                case 'f':
-                    pState->pFileName = strdup(optarg);
-                    break;
+            LogError( &state,
+                      "Incremental mode cannot be used with a dry run" );
+            exit( 1 );
+        }
 
-                case 'w':
-                    pState->workbufSize = atol(optarg);
-                    break;
+        /* collect the assignments instead of applying them */
+        if ( state.pAssignList == NULL )
+        {
+            state.pAssignList = ASSIGNLIST_Create();
+            if ( state.pAssignList == NULL )
+            {
+                LogError( &state, "Cannot create assignment list" );
+                exit( 1 );
+            }
+        }
+    }
 
-                default:
-                    break;
+    if ( state.relaxed == true )
+    {
+        if ( state.incremental == true )
+        {
+            LogError( &state,
+                      "Incremental mode cannot be used with relaxed mode" );
+            exit( 1 );
+        }
 
+        /* collected assignments are already applied out of line */
+        if ( state.pAssignList == NULL )
+        {
+            state.pPending = ASSIGNLIST_Create();
+            if ( state.pPending == NULL )
+            {
+                LogError( &state, "Cannot create pending write list" );
+                exit( 1 );
             }
         }
     }
 
-    return 0;
-}
+    if ( ( state.pResident != NULL ) &&
+         ( ( state.incremental == true ) ||
+           ( state.pAssignList != NULL ) ||
+           ( state.pRecordFile != NULL ) ||
+           ( state.pReplayFile != NULL ) ) )
+    {
+        LogError( &state, "Serving values on demand cannot be used with "
+                          "incremental mode, targets, a dry run, or record "
+                          "and replay" );
+        exit( 1 );
+    }
 
-/*==========================================================================*/
-/*  CreateWorkingBuffer                                                     */
-/*!
-    Create a working buffer
+    if ( ( state.jobs > 1 ) &&
+         ( ( state.pRecordFile != NULL ) ||
+           ( state.pReplayFile != NULL ) ) )
+    {
+        LogError( &state,
+                  "Parallel expansion cannot be used with record and replay" );
+        exit( 1 );
+    }
 
-    The CreateWorkingBuffer function creates a working buffer that can
+    if ( state.analyze == true )
+    {
+        state.pAnalysis = ANALYZE_Create();
+        if ( state.pAnalysis == NULL )
+        {
+            LogError( &state, "Cannot initialize analysis" );
+            exit( 1 );
+        }
+    }
+
+    if ( ( ( state.pRecordFile != NULL ) ||
+           ( state.pReplayFile != NULL ) ) &&
+         ( InitVarLog( &state ) != EOK ) )
+    {
+        LogError( &state, "Cannot initialize record and replay" );
+        exit( 1 );
+    }
+
+    if ( ( state.incremental == true ) &&
+         ( InitIncremental( &state ) != EOK ) )
+    {
+        LogError( &state, "Cannot initialize incremental mode" );
+        exit( 1 );
+    }
+
+    /* start reading the files used by the previous run */
+    if ( ( state.readahead == true ) &&
+         ( InitReadahead( &state ) != EOK ) )
+    {
+        LogError( &state, "Cannot initialize readahead" );
+        exit( 1 );
+    }
+
+    if ( state.provenance == true )
+    {
+        state.pProvenanceFile = ProvenanceFile( &state );
+        state.pProvenance = PROVENANCE_Create();
+        if ( ( state.pProvenanceFile == NULL ) ||
+             ( state.pProvenance == NULL ) )
+        {
+            LogError( &state, "Cannot initialize provenance index" );
+            exit( 1 );
+        }
+    }
+
+    if ( state.parseCache == true )
+    {
+        state.pParseDir = CacheSubDir( &state, PARSE_DIR );
+        if ( state.pParseDir == NULL )
+        {
+            LogError( &state, "Cannot initialize parse cache" );
+            exit( 1 );
+        }
+    }
+
+    if ( state.audit == true )
+    {
+        /* compare the live values without loading anything */
+        exit( ( RunAudit( &state ) == EOK ) ? 0 : 1 );
+    }
+
+    if ( state.restore == true )
+    {
+        /* write back the journaled values without loading anything */
+        exit( ( RunRestore( &state ) == EOK ) ? 0 : 1 );
+    }
+
+    if ( state.journal == true )
+    {
+        if ( ( state.pAssignList != NULL ) ||
+             ( state.pReplayFile != NULL ) )
+        {
+            LogError( &state, "The journal cannot be used with targets, "
+                              "a dry run, or replay" );
+            exit( 1 );
+        }
+
+        /* the configuration is loaded even if it cannot be journaled */
+        pJournalFile = JournalFile( &state );
+        if ( ( pJournalFile != NULL ) &&
+             ( MakeFileDir( pJournalFile ) == EOK ) )
+        {
+            state.pJournal = JOURNAL_Open( pJournalFile );
+        }
+
+        if ( state.pJournal != NULL )
+        {
+            /* queued writes are journaled once they are applied */
+            state.callOptions.confirm = JournalConfirmed;
+            state.callOptions.pConfirmArg = &state;
+        }
+        else
+        {
+            fprintf( stderr,
+                     "Cannot open journal %s, continuing without it\n",
+                     ( pJournalFile != NULL ) ? pJournalFile : "" );
+        }
+
+        free( pJournalFile );
+    }
+
+    if ( state.pFeedDest != NULL )
+    {
+        if ( state.pAssignList != NULL )
+        {
+            LogError( &state, "The change feed cannot be used with targets "
+                              "or a dry run" );
+            exit( 1 );
+        }
+
+        state.pFeed = FEED_Open( state.pFeedDest,
+                                 state.feedFormat,
+                                 NextGeneration( &state ) );
+        if ( state.pFeed == NULL )
+        {
+            fprintf( stderr,
+                     "Cannot open change feed %s: %s\n",
+                     state.pFeedDest,
+                     strerror( errno ) );
+            exit( 1 );
+        }
+    }
+
+    /* open a handle to the variable server */
+    state.pVarCall = VARCALL_Create( &state.callOptions, NULL );
+    if( VARCALL_Open( state.pVarCall ) == EOK )
+    {
+        if ( CreateWorkingBuffer(&state) == EOK )
+        {
+            /* Process the configuration file, which is mandatory */
+            result = ProcessConfigFile( &state, state.pFileName, true );
+
+            /* complete the writes deferred in relaxed mode */
+            if ( ( Barrier( &state ) != EOK ) && ( result == EOK ) )
+            {
+                result = EIO;
+            }
+
+            if ( state.incremental == true )
+            {
+                /* deal with assignments removed since the previous run */
+                VARTABLE_ForEach( state.pRemoved, ApplyRemoved, &state );
+            }
+
+            if ( ( state.pAssignList != NULL ) &&
+                 ( state.dryRun == false ) )
+            {
+                /* apply the expanded assignments to every target */
+                if ( ( FANOUT_Apply( state.pAssignList,
+                                     state.ppTargets,
+                                     state.ntargets,
+                                     &state.callOptions,
+                                     state.verbose ) != EOK ) &&
+                     ( result == EOK ) )
+                {
+                    result = EIO;
+                }
+            }
+
+            if ( ( state.pMetricsPrefix != NULL ) &&
+                 ( state.dryRun == false ) )
+            {
+                /* publish the run metrics */
+                METRICS_Publish( &state.metrics,
+                                 state.pVarCall,
+                                 state.pMetricsPrefix );
+            }
+
+            /* complete any queued or outstanding writes */
+            if ( ( VARCALL_Drain( state.pVarCall ) != EOK ) &&
+                 ( result == EOK ) )
+            {
+                result = EIO;
+            }
+
+            if ( state.dryRun == false )
+            {
+                /* record the load in the performance history */
+                RecordHistory( &state );
+            }
+
+            if ( state.pResident != NULL )
+            {
+                /* serve values on demand until stopped */
+                if ( ( RESIDENT_Run( state.pResident,
+                                     LoadLazy,
+                                     &state,
+                                     state.verbose ) != EOK ) &&
+                     ( result == EOK ) )
+                {
+                    result = EIO;
+                }
+            }
+
+            /*! destroy the working buffer */
+            DestroyWorkingBuffer(&state);
+        }
+        else
+        {
+            LogError( &state, "Cannot create working buffer" );
+        }
+
+        if ( state.latency == true )
+        {
+            VARCALL_PrintStats( state.pVarCall, stdout );
+        }
+
+        if ( state.pPerf != NULL )
+        {
+            PERFCOUNT_Report( state.pPerf, stdout );
+        }
+
+        ANALYZE_Report( state.pAnalysis, state.analyzeSort, stdout );
+    }
+    else
+    {
+        fprintf( stderr, "Cannot open variable server\n" );
+    }
+
+    /* close the handle to the variable server */
+    VARCALL_Close( state.pVarCall );
+
+    if ( FEED_Close( state.pFeed ) != EOK )
+    {
+        LogError( &state, "Cannot write change feed" );
+        result = EIO;
+    }
+
+    if ( JOURNAL_Close( state.pJournal ) != EOK )
+    {
+        fprintf( stderr, "Cannot write journal\n" );
+        result = EIO;
+    }
+
+    if ( VARLOG_Close( state.callOptions.pLog ) == EIO )
+    {
+        LogError( &state, "Cannot write record log" );
+        result = EIO;
+    }
+
+    if ( ( state.pProvenance != NULL ) &&
+         ( ( MakeFileDir( state.pProvenanceFile ) != EOK ) ||
+           ( PROVENANCE_Save( state.pProvenance,
+                              state.pProvenanceFile ) != EOK ) ) )
+    {
+        fprintf( stderr,
+                 "Cannot write provenance index %s\n",
+                 state.pProvenanceFile );
+    }
+
+    VARTABLE_Destroy( state.pLocalVars );
+    CloseIncremental( &state );
+    CloseReadahead( &state );
+    ASSIGNLIST_Free( state.pAssignList );
+    ASSIGNLIST_Free( state.pPending );
+    RESIDENT_Free( state.pResident );
+    VARTABLE_Destroy( state.pLazyValues );
+    free( state.ppTargets );
+    free( state.pParseDir );
+    free( state.pProvenanceFile );
+    PROVENANCE_Free( state.pProvenance );
+    ANALYZE_Free( state.pAnalysis );
+    PERFCOUNT_Free( state.pPerf );
+
+    return ( result == EOK ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  usage                                                                   */
+/*!
+    Display the application usage
+
+    The usage function dumps the application usage message
+    to stderr.
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+    @return none
+
+============================================================================*/
+static void usage( char *cmdname )
+{
+    if( cmdname != NULL )
+    {
+        fprintf(stderr,
+                "usage: %s [-v] [-h] [-i] [-p] [-a] [-r <policy>] "
+                "[-C <dir>] [-t <target>]...\n"
+                "       [-T <ms>] [-D <ms>] [-R <n>] [-B <ms>] [-G <us>] [-I] "
+                "[-Q] [-L]\n"
+                "       [-M[<prefix>]] [-P] [-c <log> | -y <log> [-Y]] "
+                "[-d <rootA> <rootB> [-S <seed>]]\n"
+                "       [-O[<file>]] [-X <var>] [-A[<column>]] [-n] "
+                "[-s <socket>]\n"
+                "       [-k[<lockfile>]] [-K] [-x] [-j <n>] [-u[<index>]] "
+                "[-l <prefix>]\n"
+                "       [-J[<file>]] [-E[<file>]] [-F <dest>] "
+                "[-o ndjson|binary]\n"
+                "       [-H[<factor>]] [-g <file>]\n"
+                " [-h] : display this help\n"
+                " [-v] : verbose output\n"
+                " [-W <size> ] : working buffer size\n"
+                " [-i, --incremental] : only send added or changed "
+                "assignments\n"
+                " [-r, --removed keep|warn|clear] : handling of removed "
+                "assignments\n"
+                " [-p, --parse-cache] : cache the parsed configuration "
+                "files\n"
+                " [-a, --readahead] : read ahead the files used by the "
+                "previous run\n"
+                " [-C, --cache-dir <dir>] : cache directory "
+                "(default " DEFAULT_CACHE_DIR ")\n"
+                " [-t, --target <nsdir|pid|local>] : apply to the variable "
+                "server in\n"
+                "     the specified namespaces (may be repeated)\n"
+                " [-T, --call-timeout <ms>] : deadline for each variable "
+                "server call\n"
+                " [-D, --run-timeout <ms>] : deadline for the whole run\n"
+                " [-R, --retries <n>] : retries for failed or timed out "
+                "calls\n"
+                " [-B, --backoff <ms>] : base delay between retries\n"
+                " [-G, --pace <us>] : pace writes to keep their latency "
+                "below a target\n"
+                " [-I, --idle] : pace writes to back off while other "
+                "clients are active\n"
+                " [-Q, --queue] : queue writes while the variable server "
+                "is unavailable\n"
+                " [-L, --latency] : report call latency statistics\n"
+                " [-M, --metrics[=<prefix>]] : publish run metrics "
+                "(default prefix\n"
+                "     " METRICS_DEFAULT_PREFIX ")\n"
+                " [-P, --perf-counters] : report hardware event counts "
+                "per file and phase\n"
+                " [-c, --record <log>] : record variable server calls and "
+                "configuration\n"
+                "     files to a log\n"
+                " [-y, --replay <log>] : replay a recorded log instead of "
+                "using the\n"
+                "     variable server and configuration files\n"
+                " [-Y, --replay-latency] : replay calls at their recorded "
+                "latency\n"
+                " [-d, --diff <rootA> <rootB>] : compare the variables "
+                "assigned by the\n"
+                "     configuration trees under two root directories\n"
+                " [-S, --seed <file>] : name=value variable store to "
+                "compare against\n"
+                " [-O, --provenance[=<file>]] : write the provenance index "
+                "(default\n"
+                "     <cache-dir>/" PROVENANCE_FILE ")\n"
+                " [-X, --why <var>] : show which file and line set a "
+                "variable in the\n"
+                "     last run written with -O\n"
+                " [-A, --analyze[=<column>]] : report the cost of each "
+                "configuration file,\n"
+                "     largest first by time, bytes, lines, assign, dead, "
+                "missing or lookups\n"
+                " [-n, --dry-run] : evaluate the configuration without "
+                "writing variables\n"
+                " [-s, --serve <socket>] : serve load requests on a Unix "
+                "domain socket\n"
+                " [-k, --coalesce[=<lockfile>]] : request a follow-up load "
+                "and exit if\n"
+                "     another invocation is loading the same configuration\n"
+                "     (default lock file in <cache-dir>/" LOCK_DIR ")\n"
+                " [-K, --coalesce-wait] : coalesce, but wait for the "
+                "follow-up load\n"
+                " [-x, --relaxed] : reorder and coalesce writes between "
+                "barriers\n"
+                " [-j, --jobs <n>] : expand independent lines on <n> "
+                "threads\n"
+                " [-u, --audit[=<index>]] : report variables whose live "
+                "values differ from\n"
+                "     the configuration, or from a provenance index\n"
+                " [-l, --lazy <prefix>] : stay resident and serve the "
+                "variables under\n"
+                "     <prefix> when they are first read\n"
+                " [-J, --journal[=<file>]] : journal the values written "
+                "(default\n"
+                "     <cache-dir>/" JOURNAL_FILE ")\n"
+                " [-E, --restore-journal[=<file>]] : write back the latest "
+                "journaled\n"
+                "     values without loading the configuration\n"
+                " [-F, --feed <dest>] : emit the applied assignments to "
+                "unix:<socket>,\n"
+                "     a FIFO or a file\n"
+                " [-o, --feed-format ndjson|binary] : framing of the change "
+                "feed\n"
+                " [-H, --history[=<factor>]] : report the load history, "
+                "flagging loads\n"
+                "     slower than <factor> times their baseline "
+                "(default 1.5)\n"
+                " [-g, --history-file <file>] : load history file (default\n"
+                "     " DEFAULT_HISTORY_FILE ")\n"
+                " -f <filename> : configuration file\n",
+                cmdname );
+    }
+}
+
+/*==========================================================================*/
+/*  ProcessOptions                                                          */
+/*!
+    Process the command line options
+
+    The ProcessOptions function processes the command line options and
+    populates the ExecVarState object
+
+    @param[in]
+        argC
+            number of arguments
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @param[in]
+        pState
+            pointer to the loadconfig utility state object
+
+    @return 0
+
+============================================================================*/
+static int ProcessOptions( int argC, char *argV[], LoadState *pState )
+{
+    int c;
+    int result = EINVAL;
+    OptionParser parser;
+    const char *options = "hvf:w:ipar:C:t:T:D:R:B:G:IQLM::Pc:y:Yd:S:"
+                          "O::X:A::ns:k::Kxj:u::l:J::E::F:o:H::g:";
+    struct option longopts[] =
+    {
+        { "incremental", no_argument, NULL, 'i' },
+        { "removed", required_argument, NULL, 'r' },
+        { "parse-cache", no_argument, NULL, 'p' },
+        { "readahead", no_argument, NULL, 'a' },
+        { "cache-dir", required_argument, NULL, 'C' },
+        { "target", required_argument, NULL, 't' },
+        { "call-timeout", required_argument, NULL, 'T' },
+        { "run-timeout", required_argument, NULL, 'D' },
+        { "retries", required_argument, NULL, 'R' },
+        { "backoff", required_argument, NULL, 'B' },
+        { "pace", required_argument, NULL, 'G' },
+        { "idle", no_argument, NULL, 'I' },
+        { "queue", no_argument, NULL, 'Q' },
+        { "latency", no_argument, NULL, 'L' },
+        { "metrics", optional_argument, NULL, 'M' },
+        { "perf-counters", no_argument, NULL, 'P' },
+        { "record", required_argument, NULL, 'c' },
+        { "replay", required_argument, NULL, 'y' },
+        { "replay-latency", no_argument, NULL, 'Y' },
+        { "diff", required_argument, NULL, 'd' },
+        { "seed", required_argument, NULL, 'S' },
+        { "provenance", optional_argument, NULL, 'O' },
+        { "why", required_argument, NULL, 'X' },
+        { "analyze", optional_argument, NULL, 'A' },
+        { "dry-run", no_argument, NULL, 'n' },
+        { "serve", required_argument, NULL, 's' },
+        { "coalesce", optional_argument, NULL, 'k' },
+        { "coalesce-wait", no_argument, NULL, 'K' },
+        { "relaxed", no_argument, NULL, 'x' },
+        { "jobs", required_argument, NULL, 'j' },
+        { "audit", optional_argument, NULL, 'u' },
+        { "lazy", required_argument, NULL, 'l' },
+        { "journal", optional_argument, NULL, 'J' },
+        { "restore-journal", optional_argument, NULL, 'E' },
+        { "feed", required_argument, NULL, 'F' },
+        { "feed-format", required_argument, NULL, 'o' },
+        { "history", optional_argument, NULL, 'H' },
+        { "history-file", required_argument, NULL, 'g' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    if( ( pState != NULL ) &&
+        ( argV != NULL ) )
+    {
+        OPTIONS_Init( &parser, argC, argV, options, longopts );
+
+        while( ( c = OPTIONS_Next( &parser ) ) != -1 )
+        {
+            switch( c )
+            {
+                case 'v':
+                    pState->verbose = true;
+                    break;
+
+                case 'h':
+                    usage( argV[0] );
+                    break;
+
+                case 'f':
+                    pState->pFileName = strdup(parser.pArg);
+                    break;
+
+                case 'w':
+                    pState->workbufSize = atol(parser.pArg);
+                    break;
+
+                case 'i':
+                    pState->incremental = true;
+                    break;
+
+                case 'p':
+                    pState->parseCache = true;
+                    break;
+
+                case 'a':
+                    pState->readahead = true;
+                    break;
+
+                case 'r':
+                    if ( strcmp( parser.pArg, "warn" ) == 0 )
+                    {
+                        pState->removedPolicy = REMOVED_WARN;
+                    }
+                    else if ( strcmp( parser.pArg, "clear" ) == 0 )
+                    {
+                        pState->removedPolicy = REMOVED_CLEAR;
+                    }
+                    else
+                    {
+                        pState->removedPolicy = REMOVED_KEEP;
+                    }
+                    break;
+
+                case 'C':
+                    pState->pCacheDir = parser.pArg;
+                    break;
+
+                case 't':
+                    if ( AddTarget( pState, parser.pArg ) != EOK )
+                    {
+                        fprintf( stderr, "Cannot add target %s\n", parser.pArg );
+                    }
+                    break;
+
+                case 'T':
+                    pState->callOptions.callTimeoutMs = strtoul( parser.pArg,
+                                                                 NULL,
+                                                                 0 );
+                    break;
+
+                case 'D':
+                    pState->callOptions.runTimeoutMs = strtoul( parser.pArg,
+                                                                NULL,
+                                                                0 );
+                    break;
+
+                case 'R':
+                    pState->callOptions.retries = strtoul( parser.pArg, NULL, 0 );
+                    break;
+
+                case 'B':
+                    pState->callOptions.backoffMs = strtoul( parser.pArg, NULL, 0 );
+                    break;
+
+                case 'G':
+                    pState->callOptions.paceTargetUs = strtoul( parser.pArg,
+                                                                NULL,
+                                                                0 );
+                    break;
+
+                case 'I':
+                    pState->callOptions.paceIdle = true;
+                    break;
+
+                case 'Q':
+                    pState->callOptions.queue = true;
+                    break;
+
+                case 'L':
+                    pState->latency = true;
+                    break;
+
+                case 'M':
+                    pState->pMetricsPrefix = ( parser.pArg != NULL )
+                                                ? parser.pArg
+                                                : METRICS_DEFAULT_PREFIX;
+                    break;
+
+                case 'P':
+                    pState->perfCounters = true;
+                    break;
+
+                case 'c':
+                    pState->pRecordFile = parser.pArg;
+                    break;
+
+                case 'y':
+                    pState->pReplayFile = parser.pArg;
+                    break;
+
+                case 'Y':
+                    pState->replayLatency = true;
+                    break;
+
+                case 'd':
+                    /* the second root follows the first */
+                    if ( parser.index < argC )
+                    {
+                        pState->pDiffRoots[0] = parser.pArg;
+                        pState->pDiffRoots[1] = argV[parser.index++];
+                    }
+                    else
+                    {
+                        fprintf( stderr, "--diff requires two roots\n" );
+                    }
+                    break;
+
+                case 'S':
+                    pState->pSeedFile = parser.pArg;
+                    break;
+
+                case 'O':
+                    pState->provenance = true;
+                    pState->pProvenanceFile = parser.pArg;
+                    break;
+
+                case 'X':
+                    pState->pWhy = parser.pArg;
+                    break;
+
+                case 'A':
+                    pState->analyze = true;
+                    if ( ( parser.pArg != NULL ) &&
+                         ( ANALYZE_ParseSort( parser.pArg,
+                                              &pState->analyzeSort ) != EOK ) )
+                    {
+                        fprintf( stderr,
+                                 "Unknown analysis column %s\n",
+                                 parser.pArg );
+                    }
+                    break;
+
+                case 'n':
+                    pState->dryRun = true;
+                    break;
+
+                case 's':
+                    pState->pServeSocket = parser.pArg;
+                    break;
+
+                case 'k':
+                    pState->coalesce = true;
+                    pState->pLockFile = parser.pArg;
+                    break;
+
+                case 'K':
+                    pState->coalesce = true;
+                    pState->coalesceWait = true;
+                    break;
+
+                case 'x':
+                    pState->relaxed = true;
+                    break;
+
+                case 'j':
+                    pState->jobs = strtoul( parser.pArg, NULL, 0 );
+                    if ( pState->jobs > MAX_JOBS )
+                    {
+                        pState->jobs = MAX_JOBS;
+                    }
+                    break;
+
+                case 'u':
+                    pState->audit = true;
+                    pState->pAuditIndex = parser.pArg;
+                    break;
+
+                case 'l':
+                    if ( AddLazyNamespace( pState, parser.pArg ) != EOK )
+                    {
+                        fprintf( stderr,
+                                 "Cannot serve %s on demand\n",
+                                 parser.pArg );
+                    }
+                    break;
+
+                case 'J':
+                    pState->journal = true;
+                    pState->pJournalFile = parser.pArg;
+                    break;
+
+                case 'E':
+                    pState->restore = true;
+                    pState->pJournalFile = parser.pArg;
+                    break;
+
+                case 'F':
+                    pState->pFeedDest = parser.pArg;
+                    break;
+
+                case 'o':
+                    pState->feedFormat = ( strcmp( parser.pArg,
+                                                   "binary" ) == 0 )
+                                            ? FEED_BINARY
+                                            : FEED_NDJSON;
+                    break;
+
+                case 'H':
+                    pState->history = true;
+                    if ( parser.pArg != NULL )
+                    {
+                        pState->historyFactor = strtod( parser.pArg, NULL );
+                    }
+                    break;
+
+                case 'g':
+                    pState->pHistoryFile = parser.pArg;
+                    break;
+
+                default:
+                    break;
+
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*==========================================================================*/
+/*  AddTarget                                                               */
+/*!
+    Add a variable server target
+
+    The AddTarget function adds a target to the list of variable servers
+    which the configuration will be applied to.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pTarget
+            pointer to the NUL terminated target name
+
+    @retval EOK the target was added
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int AddTarget( LoadState *pState, char *pTarget )
+{
+    int result = ENOMEM;
+    char **ppTargets;
+
+    ppTargets = realloc( pState->ppTargets,
+                         ( pState->ntargets + 1 ) * sizeof( char * ) );
+    if ( ppTargets != NULL )
+    {
+        ppTargets[pState->ntargets++] = pTarget;
+        pState->ppTargets = ppTargets;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  CreateWorkingBuffer                                                     */
+/*!
+    Create a working buffer
+
+    The CreateWorkingBuffer function creates a working buffer that can
     be used to expand configuration lines which contain system variables
-    to be expanded.
+    to be expanded.  It also allocates a private line buffer of the same
+    size which is used to expand loader-local variables in-process.
+
+    @param[in]
+        pState
+            pointer to the loadconfig utility state object
+
+    @retval EOK working buffer created ok
+    @retval EINVAL invalid arguments
+    @retval other error as returned by shm_open, ftruncate, mmap
+
+============================================================================*/
+static int CreateWorkingBuffer( LoadState *pState )
+{
+    int result = EINVAL;
+	pid_t pid;
+    size_t size;
+    int fd;
+    int rc;
+    char *workbuf;
+
+    if ( ( pState != NULL ) &&
+         ( pState->workbufSize > 0 ) )
+    {
+        /* build a varclient identifier which is unique to this
+         * load context, as a process may run several loads at once */
+        pid = getpid();
+        snprintf( pState->clientname,
+                  sizeof( pState->clientname ),
+                  "/load_%d_%lx",
+                  pid,
+                  (unsigned long)(uintptr_t)pState );
+
+        /* set the working buffer size including space for an
+         * additional NUL terminator */
+        size = pState->workbufSize + 1;
+
+        /* get shared memory file descriptor (NOT a file) */
+        fd = shm_open(pState->clientname, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+        if (fd != -1)
+        {
+            /* extend shared memory object as by default
+               it is initialized with size 0 */
+            rc = ftruncate(fd, size );
+            if (rc != -1)
+            {
+                /* map shared memory to process address space */
+                workbuf = mmap( NULL,
+                                size ,
+                                PROT_WRITE,
+                                MAP_SHARED,
+                                fd,
+                                0);
+
+                if( workbuf != MAP_FAILED )
+                {
+                    /* populate the VarClient object */
+                    pState->workbuf = workbuf;
+                    pState->fd = fd;
+
+                    /* clear the working buffer */
+                    memset( workbuf, 0, size );
+
+                    /* allocate the local variable expansion buffer */
+                    pState->linebuf = calloc( 1, size );
+                    result = ( pState->linebuf != NULL ) ? EOK : ENOMEM;
+                }
+                else
+                {
+                    /* memory map failed */
+                    pState->fd = -1;
+                    pState->workbuf = NULL;
+                    close( fd );
+                    result = errno;
+                }
+            }
+            else
+            {
+                pState->fd = -1;
+                pState->workbuf = NULL;
+                close( fd );
+                result = errno;
+            }
+        }
+        else
+        {
+            pState->fd = -1;
+            pState->workbuf = NULL;
+            result = errno;
+        }
+    }
+
+    if ( result != EOK )
+    {
+        fprintf(stderr, "CreateWorkingBuffer: %s\n", strerror( result ) );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  DestroyWorkingBuffer                                                     */
+/*!
+    Destroy the working buffer
+
+    The DestroyWorkingBuffer function removes the shared memory and file
+    descriptor used for processing lines of configuration data, and the
+    working buffers of the parallel expansion workers.
+
+    @param[in]
+        pState
+            pointer to the loadconfig utility state object
+
+============================================================================*/
+static void DestroyWorkingBuffer( LoadState *pState )
+{
+    if ( pState != NULL )
+    {
+        if ( pState->workbuf != NULL )
+        {
+            /* Unmap the shared memory object from the virtual
+             * address space of the loadconfig application */
+            munmap( pState->workbuf, pState->workbufSize );
+            pState->workbuf = NULL;
+        }
+
+        if ( pState->fd != -1 )
+        {
+            /* close the shared memory file descriptor */
+            close( pState->fd );
+        }
+
+        /* unlink the shared memory object name */
+        shm_unlink( pState->clientname );
+
+        /* release the local variable expansion buffer */
+        free( pState->linebuf );
+        pState->linebuf = NULL;
+
+        /* release the parallel expansion workers */
+        DestroyExpanders( pState );
+    }
+}
+
+/*==========================================================================*/
+/*  ProcessConfigFile                                                       */
+/*!
+    Process the specified configuration file
+
+    The ProcessConfigFile function processes a configuration file
+    consisting of lines of directives and variable assignments.
+
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        filename
+            pointer to the name of the file to load
+
+    @param[in]
+        required
+            true if the file must exist, false if a missing file
+            is not an error
+
+    @retval EINVAL invalid arguments
+    @retval EOK file processed ok
+    @retval other error as returned by ProcessConfigData
+
+============================================================================*/
+static int ProcessConfigFile( LoadState *pState,
+                              char *filename,
+                              bool required )
+{
+    int result = EINVAL;
+    FILE *fp;
+    char *pConfigData;
+    char *saveFileName;
+    int saveLineNumber;
+    VarTable *saveApplied;
+    VarTable *saveParsed;
+    bool saveOrdered;
+    LineIndex *pIndex;
+    bool hit = false;
+    char path[PATH_MAX];
+    uint64_t start;
+    PerfMark fileMark;
+    PerfMark mark;
+    AnalyzeMark analyzeMark;
+    size_t len;
+    char *pFileName = NULL;
+
+    if ( filename != NULL )
+    {
+        pFileName = strdup( filename );
+    }
+
+    if ( ( pState != NULL ) &&
+         ( pFileName != NULL ) )
+    {
+        if ( pState->quiet == false )
+        {
+            printf("ProcessConfigFile: %s\n", pFileName );
+        }
+
+        /* save the file name and the line number within that file */
+        saveFileName = pState->pFileName;
+        saveLineNumber = pState->lineno;
+        saveOrdered = pState->ordered;
+
+        /* initialize the line number */
+        pState->lineno = 1;
+        pState->pFileName = pFileName;
+
+        /* attribute hardware events to this file */
+        PERFCOUNT_Enter( pState->pPerf,
+                         pFileName,
+                         PERF_PHASE_DISPATCH,
+                         &fileMark );
+        ANALYZE_Enter( pState->pAnalysis, pFileName, &analyzeMark );
+
+        /* save the incremental state of the including file */
+        saveApplied = pState->pApplied;
+        saveParsed = pState->pParsed;
+        BeginIncrementalFile( pState, pFileName );
+
+        start = METRICS_Now();
+        PERFCOUNT_Enter( pState->pPerf, NULL, PERF_PHASE_IO, &mark );
+        pConfigData = LoadConfigData( pState, pFileName );
+        PERFCOUNT_Leave( pState->pPerf, &mark );
+        METRICS_AddPhase( &pState->metrics, METRICS_PHASE_IO, start );
+
+        if( pConfigData != NULL )
+        {
+            pState->metrics.files++;
+
+            /* the line index terminates each line in place */
+            len = strlen( pConfigData );
+            pState->metrics.bytes += len;
+
+            if ( pState->pReadahead != NULL )
+            {
+                /* record the file for the next run's readahead */
+                READAHEAD_Add( pState->pReadahead,
+                               ( realpath( pFileName, path ) != NULL )
+                                    ? path
+                                    : pFileName,
+                               strlen( pConfigData ) );
+            }
+
+            /* get the line index from the parse cache, or build it */
+            start = METRICS_Now();
+            PERFCOUNT_Enter( pState->pPerf, NULL, PERF_PHASE_SCAN, &mark );
+            if ( pState->pIndexCache != NULL )
+            {
+                pIndex = INDEXCACHE_Get( pState->pIndexCache,
+                                         pConfigData,
+                                         strlen( pConfigData ),
+                                         &hit );
+            }
+            else
+            {
+                pIndex = PARSECACHE_GetIndex( pState->pParseDir,
+                                              pFileName,
+                                              pConfigData,
+                                              strlen( pConfigData ),
+                                              &hit );
+            }
+
+            if ( pIndex != NULL )
+            {
+                LINEINDEX_Terminate( pIndex, pConfigData );
+                ANALYZE_Loaded( pState->pAnalysis, len, pIndex->nlines );
+            }
+
+            PERFCOUNT_Leave( pState->pPerf, &mark );
+            METRICS_AddPhase( &pState->metrics, METRICS_PHASE_PARSE, start );
+
+            if ( pState->pParseDir != NULL )
+            {
+                pState->metrics.cacheLookups++;
+                pState->metrics.cacheHits += ( hit == true ) ? 1 : 0;
+            }
+
+            if ( pIndex != NULL )
+            {
+                if ( ( pState->verbose == true ) &&
+                     ( ( pState->pParseDir != NULL ) ||
+                       ( pState->pIndexCache != NULL ) ) )
+                {
+                    printf( "Parse cache %s: %s\n",
+                            ( hit == true ) ? "hit" : "miss",
+                            pFileName );
+                }
+
+                result = ProcessConfigData( pState,
+                                            pConfigData,
+                                            pIndex,
+                                            0,
+                                            pIndex->nlines );
+
+                /* shared line indexes are owned by the cache */
+                if ( pState->pIndexCache != NULL )
+                {
+                    INDEXCACHE_Release( pState->pIndexCache, pIndex );
+                }
+                else
+                {
+                    LINEINDEX_Free( pIndex );
+                }
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+
+            free( pConfigData );
+        }
+        else if ( required == false )
+        {
+            /* included file doesn't exist - that's ok */
+            ANALYZE_Missing( pState->pAnalysis );
+            result = EOK;
+        }
+
+        /* record the assignments applied from this file */
+        EndIncrementalFile( pState, pFileName );
+
+        /* emit the changes made by this file as a batch */
+        FEED_Flush( pState->pFeed );
+        pState->pApplied = saveApplied;
+        pState->pParsed = saveParsed;
+
+        /* restore the file name and the line number within that file */
+        pState->pFileName = saveFileName;
+        pState->lineno = saveLineNumber;
+        pState->ordered = saveOrdered;
+        ANALYZE_Leave( pState->pAnalysis, &analyzeMark );
+        PERFCOUNT_Leave( pState->pPerf, &fileMark );
+
+        if ( result != EOK )
+        {
+            fprintf(stderr, "Processing incomplete: %s\n", pFileName );
+        }
+
+        free( pFileName );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessConfigData                                                       */
+/*!
+    Process a range of lines of configuration data
+
+    The ProcessConfigData function processes lines of configuration
+    data which have typically been loaded from a configuration file.
+    The configuration data consists of lines of directives and
+    variable assignments.  Directives start with an @ symbol, and
+    variable assignments consist of name and value strings separated
+    by white space.
+
+    The configuration data has been pre-tokenized into a line index.
+    Lines without ${} references are processed directly from the index,
+    while other lines are expanded and then tokenized.
+
+    Lines following a @foreach directive up to the matching @end
+    directive form the loop body, which is processed once for
+    each loop value.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigData
+            pointer to the buffer of NUL terminated configuration lines
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        first
+            index of the first line to process
+
+    @param[in]
+        last
+            index of the line after the last line to process
+
+    @retval EINVAL invalid arguments
+    @retval EOK file processed ok
+    @retval other last error as returned by ProcessIndexedLine
+
+============================================================================*/
+static int ProcessConfigData( LoadState *pState,
+                              char *pConfigData,
+                              LineIndex *pIndex,
+                              uint32_t first,
+                              uint32_t last )
+{
+    int result = EINVAL;
+    uint32_t n;
+    uint32_t end;
+    uint32_t count;
+    int rc;
+    ConfigLoop *pLoop;
+
+    if ( ( pState != NULL ) &&
+         ( pConfigData != NULL ) &&
+         ( pIndex != NULL ) )
+    {
+        /* assume the result is ok until it is not */
+        result = EOK;
+
+        for ( n = first; n < last; n++ )
+        {
+            end = ( ( pState->jobs > 1 ) && ( pState->pResident == NULL ) )
+                    ? FindExpandBlock( pState, pConfigData, pIndex,
+                                       n, last, &count )
+                    : n;
+            if ( end > n )
+            {
+                /* expand a block of independent lines in parallel */
+                rc = ProcessExpandBlock( pState, pConfigData, pIndex,
+                                         n, end, count );
+                n = end - 1;
+            }
+            else
+            {
+                pState->lineno = n + 1;
+                rc = ProcessIndexedLine( pState, pConfigData, pIndex, n );
+            }
+
+            if ( rc != EOK )
+            {
+                result = rc;
+            }
+
+            pLoop = pState->pLoop;
+            if ( pLoop != NULL )
+            {
+                /* a @foreach directive started a new loop */
+                pState->pLoop = NULL;
+
+                end = FindLoopEnd( pIndex, n + 1, last );
+                if ( end < last )
+                {
+                    rc = ExecuteLoop( pState, pLoop, pConfigData, pIndex,
+                                      n + 1, end );
+                    if ( rc != EOK )
+                    {
+                        result = rc;
+                    }
+                }
+                else
+                {
+                    LogError( pState, "@foreach without @end" );
+                    result = EINVAL;
+                }
+
+                FreeLoop( pLoop );
+                n = end;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessIndexedLine                                                      */
+/*!
+    Process a pre-tokenized line of configuration data
+
+    The ProcessIndexedLine function processes a single line of
+    configuration data using its line index entry.  Blank lines and
+    comments are skipped, and lines without ${} references are
+    dispatched directly using their pre-tokenized name and value spans.
+    Lines containing ${} references are expanded and then processed
+    as a regular configuration line.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigData
+            pointer to the buffer of NUL terminated configuration lines
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        n
+            index of the line to process
+
+    @retval EOK the line was processed ok
+    @retval E2BIG the line does not fit in the working buffer
+    @retval other error as returned by the line processing functions
+
+============================================================================*/
+static int ProcessIndexedLine( LoadState *pState,
+                               char *pConfigData,
+                               LineIndex *pIndex,
+                               uint32_t n )
+{
+    int result = EOK;
+    LineInfo *pInfo = &pIndex->pLines[n];
+    char *pLine = &pConfigData[pInfo->offset];
+    char *pExpanded;
+    char *pName;
+    char *pValue;
+    uint64_t start;
+    PerfMark mark;
+
+    pState->pRawLine = pLine;
+
+    if ( pInfo->nrefs > 0 )
+    {
+        ANALYZE_Lookups( pState->pAnalysis, pInfo->nrefs );
+
+        /* reads must see the writes made before them */
+        if ( Barrier( pState ) != EOK )
+        {
+            pState->metrics.errors++;
+        }
+
+        /* perform expansion of variables within the config line */
+        /* i.e any variables in the form ${varname} will be replaced
+         * with their values */
+        start = METRICS_Now();
+        PERFCOUNT_Enter( pState->pPerf, NULL, PERF_PHASE_EXPAND, &mark );
+        result = ExpandConfigLine( pState,
+                                   pLine,
+                                   pInfo->length,
+                                   &pIndex->pRefs[pInfo->refidx],
+                                   pInfo->nrefs,
+                                   &pExpanded );
+        PERFCOUNT_Leave( pState->pPerf, &mark );
+        METRICS_AddPhase( &pState->metrics, METRICS_PHASE_EXPAND, start );
+
+        result = ProcessExpandedLine( pState, result, pExpanded );
+    }
+    else if ( ( pInfo->kind == LINE_DIRECTIVE ) ||
+              ( pInfo->kind == LINE_ASSIGNMENT ) )
+    {
+        if ( pInfo->namelen + pInfo->vallen + 2 <=
+                (uint32_t)pState->workbufSize + 1 )
+        {
+            /* copy the pre-tokenized name and value so the
+             * configuration data is left untouched */
+            pName = pState->linebuf;
+            memcpy( pName, &pLine[pInfo->nameoff], pInfo->namelen );
+            pName[pInfo->namelen] = '\0';
+
+            pValue = &pName[pInfo->namelen + 1];
+            memcpy( pValue, &pLine[pInfo->valoff], pInfo->vallen );
+            pValue[pInfo->vallen] = '\0';
+
+            if ( pInfo->kind == LINE_DIRECTIVE )
+            {
+                result = DispatchDirective( pState,
+                                            pInfo->directive,
+                                            pValue );
+            }
+            else if ( pInfo->namelen > 0 )
+            {
+                result = ApplyAssignment( pState, pName, pValue );
+            }
+            else
+            {
+                LogError( pState, "Invalid Variable Assignment" );
+                result = EINVAL;
+            }
+        }
+        else
+        {
+            result = E2BIG;
+        }
+
+        if ( result != EOK )
+        {
+            LogError( pState, "Config warning" );
+            pState->metrics.errors++;
+        }
+    }
+
+    pState->pRawLine = NULL;
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ExpandConfigLine                                                        */
+/*!
+    Expand the variable references in a line of configuration data
+
+    The ExpandConfigLine function replaces the ${varname} references
+    in a line of configuration data with their values.
+
+    References to loader-local variables (defined using @let) take
+    precedence and are resolved in-process.  When assignments are being
+    collected for multiple targets, references to variables assigned
+    earlier in the tree are also resolved in-process, as are references
+    to the values served on demand.  The variable
+    server is only consulted if references remain which could not be
+    resolved locally.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigLine
+            pointer to a NUL terminated line of configuration data
+
+    @param[in]
+        len
+            length of the line of configuration data
+
+    @param[in]
+        pRefs
+            pointer to the array of ${} references in the line
+
+    @param[in]
+        nrefs
+            number of ${} references in the line
+
+    @param[out]
+        ppLine
+            pointer to a location to store a pointer to the expanded line
+
+    @retval EINVAL invalid arguments
+    @retval E2BIG the expanded line does not fit in the working buffer
+    @retval EOK the line was expanded ok
+    @retval other error as returned by VARCALL_StrToFile
+
+============================================================================*/
+static int ExpandConfigLine( LoadState *pState,
+                             char *pConfigLine,
+                             size_t len,
+                             RefInfo *pRefs,
+                             uint32_t nrefs,
+                             char **ppLine )
+{
+    int result = EINVAL;
+    size_t n = 0;
+    size_t pos = 0;
+    uint32_t i;
+    VarEntry *pVar;
+    bool remote = false;
+    bool lazy;
+    char *pFileName;
+
+    if ( ( pState != NULL ) &&
+         ( pConfigLine != NULL ) &&
+         ( pRefs != NULL ) &&
+         ( ppLine != NULL ) )
+    {
+        result = EOK;
+
+        /* process the lazy includes which may set the values served on
+         * demand before the expansion buffer is in use */
+        for ( i = 0; ( i < nrefs ) && ( pState->pResident != NULL ); i++ )
+        {
+            while ( ( VARTABLE_FindN( pState->pLazyValues,
+                                      &pConfigLine[pRefs[i].offset + 2],
+                                      pRefs[i].length - 3 ) == NULL ) &&
+                    ( ( pFileName = RESIDENT_Pending(
+                                        pState->pResident,
+                                        &pConfigLine[pRefs[i].offset + 2],
+                                        pRefs[i].length - 3 ) ) != NULL ) )
+            {
+                LoadLazy( pState, pFileName );
+            }
+        }
+
+        for ( i = 0; ( i < nrefs ) && ( result == EOK ); i++ )
+        {
+            /* copy the text preceding the reference */
+            result = AppendLine( pState,
+                                 &n,
+                                 &pConfigLine[pos],
+                                 pRefs[i].offset - pos );
+
+            /* look up the reference in the local variables */
+            pVar = VARTABLE_FindN( pState->pLocalVars,
+                                   &pConfigLine[pRefs[i].offset + 2],
+                                   pRefs[i].length - 3 );
+            if ( ( pVar == NULL ) && ( pState->pAssignList != NULL ) )
+            {
+                /* look up the values collected earlier in the tree */
+                pVar = VARTABLE_FindN( pState->pAssignList->pValues,
+                                       &pConfigLine[pRefs[i].offset + 2],
+                                       pRefs[i].length - 3 );
+            }
+
+            lazy = RESIDENT_Match( pState->pResident,
+                                   &pConfigLine[pRefs[i].offset + 2],
+                                   pRefs[i].length - 3 );
+            if ( ( pVar == NULL ) && ( lazy == true ) )
+            {
+                /* look up the values served on demand */
+                pVar = VARTABLE_FindN( pState->pLazyValues,
+                                       &pConfigLine[pRefs[i].offset + 2],
+                                       pRefs[i].length - 3 );
+            }
+
+            if ( ( pVar == NULL ) && ( pState->pSeed != NULL ) )
+            {
+                /* look up the seeded variable store */
+                pVar = VARTABLE_FindN( pState->pSeed,
+                                       &pConfigLine[pRefs[i].offset + 2],
+                                       pRefs[i].length - 3 );
+            }
+
+            if ( result != EOK )
+            {
+                /* expanded line is too long */
+            }
+            else if ( pVar != NULL )
+            {
+                result = AppendLine( pState,
+                                     &n,
+                                     pVar->value,
+                                     strlen( pVar->value ) );
+            }
+            else if ( ( pState->pSeed != NULL ) || ( lazy == true ) )
+            {
+                /* variables missing from the seeded store, or from the
+                 * values served on demand, are empty */
+            }
+            else
+            {
+                /* leave it for the variable server */
+                remote = true;
+                result = AppendLine( pState,
+                                     &n,
+                                     &pConfigLine[pRefs[i].offset],
+                                     pRefs[i].length );
+            }
+
+            pos = pRefs[i].offset + pRefs[i].length;
+        }
+
+        if ( result == EOK )
+        {
+            /* copy the text following the last reference */
+            result = AppendLine( pState, &n, &pConfigLine[pos], len - pos );
+        }
+
+        pState->linebuf[n] = '\0';
+
+        if ( ( result == EOK ) && ( remote == true ) )
+        {
+            /* expand into the cleared working buffer */
+            result = VARCALL_StrToFile( pState->pVarCall,
+                                        pState->linebuf,
+                                        pState->fd,
+                                        pState->workbuf,
+                                        pState->workbufSize );
+            *ppLine = pState->workbuf;
+        }
+        else
+        {
+            *ppLine = pState->linebuf;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  AppendLine                                                              */
+/*!
+    Append text to the local variable expansion buffer
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in,out]
+        pOffset
+            pointer to the current length of the expanded line
+
+    @param[in]
+        pText
+            pointer to the text to append
+
+    @param[in]
+        len
+            length of the text to append
+
+    @retval EOK the text was appended
+    @retval E2BIG the expanded line does not fit in the working buffer
+
+============================================================================*/
+static int AppendLine( LoadState *pState,
+                       size_t *pOffset,
+                       char *pText,
+                       size_t len )
+{
+    int result = E2BIG;
+
+    if ( *pOffset + len <= (size_t)pState->workbufSize )
+    {
+        memcpy( &pState->linebuf[*pOffset], pText, len );
+        *pOffset += len;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessExpandedLine                                                     */
+/*!
+    Process a line of configuration data after its expansion
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        result
+            result of the expansion of the line
+
+    @param[in]
+        pExpanded
+            pointer to the NUL terminated expanded line
+
+    @retval EOK the line was processed ok
+    @retval other error as returned by the expansion or ProcessConfigLine
+
+============================================================================*/
+static int ProcessExpandedLine( LoadState *pState,
+                                int result,
+                                char *pExpanded )
+{
+    if ( result == EOK )
+    {
+        /* process a configuration line */
+        result = ProcessConfigLine( pState, pExpanded );
+        if ( result != EOK )
+        {
+            LogError( pState, "Config warning" );
+            pState->metrics.errors++;
+        }
+    }
+    else
+    {
+        LogError( pState, "Variable Expansion error" );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  FindExpandBlock                                                         */
+/*!
+    Find a block of lines which can be expanded in parallel
+
+    The FindExpandBlock function finds the block of lines starting at
+    the first line which consists only of blank lines, comments and
+    variable assignments, and in which no line reads a variable
+    written by an earlier line of the block.  Directives end the block
+    as they may change the loader state.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigData
+            pointer to the buffer of NUL terminated configuration lines
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        first
+            index of the first line of the block
+
+    @param[in]
+        last
+            index one past the last line which may be in the block
+
+    @param[out]
+        pCount
+            pointer to a location to store the number of lines in the
+            block which need to be expanded
+
+    @retval index one past the last line of the block, which is first
+            if the first line cannot be part of a block
+
+============================================================================*/
+static uint32_t FindExpandBlock( LoadState *pState,
+                                 char *pConfigData,
+                                 LineIndex *pIndex,
+                                 uint32_t first,
+                                 uint32_t last,
+                                 uint32_t *pCount )
+{
+    uint32_t n = first;
+    uint32_t count = 0;
+    uint32_t i;
+    bool independent = true;
+    VarTable *pWritten = NULL;
+    LineInfo *pInfo;
+    RefInfo *pRefs;
+    char *pLine;
+
+    while ( ( n < last ) &&
+            ( n - first < EXPAND_BLOCK_LINES ) &&
+            ( independent == true ) )
+    {
+        pInfo = &pIndex->pLines[n];
+        pLine = &pConfigData[pInfo->offset];
+        pRefs = &pIndex->pRefs[pInfo->refidx];
+
+        if ( ( pInfo->kind == LINE_BLANK ) ||
+             ( pInfo->kind == LINE_COMMENT ) )
+        {
+            n++;
+        }
+        else if ( ( pInfo->kind == LINE_ASSIGNMENT ) &&
+                  ( pInfo->namelen > 0 ) &&
+                  ( pInfo->namelen <= (uint32_t)pState->workbufSize ) &&
+                  ( ( pInfo->nrefs == 0 ) ||
+                    ( ( pInfo->vallen > 0 ) &&
+                      ( pRefs[0].offset >= pInfo->valoff ) ) ) )
+        {
+            /* the line may not read a variable written earlier */
+            for ( i = 0; ( i < pInfo->nrefs ) && ( independent == true ); i++ )
+            {
+                if ( VARTABLE_FindN( pWritten,
+                                     &pLine[pRefs[i].offset + 2],
+                                     pRefs[i].length - 3 ) != NULL )
+                {
+                    independent = false;
+                }
+            }
+
+            if ( ( independent == true ) && ( pWritten == NULL ) )
+            {
+                pWritten = VARTABLE_Create( 0 );
+            }
+
+            if ( ( independent == true ) && ( pWritten != NULL ) )
+            {
+                /* record the name of the variable written by the line */
+                memcpy( pState->linebuf,
+                        &pLine[pInfo->nameoff],
+                        pInfo->namelen );
+                pState->linebuf[pInfo->namelen] = '\0';
+
+                if ( VARTABLE_Set( pWritten, pState->linebuf, "" ) == EOK )
+                {
+                    count += ( pInfo->nrefs > 0 ) ? 1 : 0;
+                    n++;
+                }
+                else
+                {
+                    independent = false;
+                }
+            }
+            else
+            {
+                independent = false;
+            }
+        }
+        else
+        {
+            independent = false;
+        }
+    }
+
+    VARTABLE_Destroy( pWritten );
+
+    *pCount = count;
+
+    return n;
+}
+
+/*==========================================================================*/
+/*  ProcessExpandBlock                                                      */
+/*!
+    Process a block of independent lines of configuration data
+
+    The ProcessExpandBlock function expands the lines of a block found
+    by FindExpandBlock on the expansion workers, and then processes the
+    expanded lines in their original order.  Blocks with too few lines
+    to expand are processed serially.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigData
+            pointer to the buffer of NUL terminated configuration lines
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        first
+            index of the first line of the block
+
+    @param[in]
+        last
+            index one past the last line of the block
+
+    @param[in]
+        count
+            number of lines in the block which need to be expanded
+
+    @retval EOK the block was processed ok
+    @retval other error as returned by the line processing functions
+
+============================================================================*/
+static int ProcessExpandBlock( LoadState *pState,
+                               char *pConfigData,
+                               LineIndex *pIndex,
+                               uint32_t first,
+                               uint32_t last,
+                               uint32_t count )
+{
+    int result = EOK;
+    ExpandBlock *pBlock;
+    ExpandedLine *pExpanded;
+    LineInfo *pInfo;
+    uint32_t n;
+    unsigned int i;
+    uint64_t start;
+    PerfMark mark;
+    bool parallel;
+    int rc;
+
+    if ( ( count >= EXPAND_MIN_LINES ) &&
+         ( pState->pExpanders == NULL ) &&
+         ( CreateExpanders( pState ) != EOK ) )
+    {
+        LogError( pState, "Cannot create expansion workers" );
+        pState->jobs = 1;
+    }
+
+    parallel = ( count >= EXPAND_MIN_LINES ) &&
+               ( pState->pExpanders != NULL );
+
+    if ( parallel == true )
+    {
+        /* reads must see the writes made before them */
+        if ( Barrier( pState ) != EOK )
+        {
+            pState->metrics.errors++;
+        }
+
+        /* the workers read on their own connections, so the writes
+         * queued on this connection must be applied first.  Serial
+         * expansion drains the queue before each read. */
+        parallel = ( VARCALL_Drain( pState->pVarCall ) == EOK );
+    }
+
+    if ( parallel == true )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout,
+                     "Expanding %u lines on %u threads\n",
+                     count,
+                     pState->jobs );
+        }
+
+        pBlock = pState->pExpanders[0].pBlock;
+        pBlock->pConfigData = pConfigData;
+        pBlock->pIndex = pIndex;
+        pBlock->first = first;
+        pBlock->last = last;
+
+        start = METRICS_Now();
+        PERFCOUNT_Enter( pState->pPerf, NULL, PERF_PHASE_EXPAND, &mark );
+
+        for ( i = 1; i < pState->jobs; i++ )
+        {
+            /* the workers look up the current loader-local variables */
+            pState->pExpanders[i].pLoad->pLocalVars = pState->pLocalVars;
+            pState->pExpanders[i].pLoad->pAssignList = pState->pAssignList;
+            pState->pExpanders[i].pLoad->pSeed = pState->pSeed;
+
+            pState->pExpanders[i].started =
+                ( pthread_create( &pState->pExpanders[i].thread,
+                                  NULL,
+                                  ExpandLines,
+                                  &pState->pExpanders[i] ) == 0 );
+        }
+
+        /* this thread is the first worker */
+        ExpandLines( &pState->pExpanders[0] );
+
+        for ( i = 1; i < pState->jobs; i++ )
+        {
+            if ( pState->pExpanders[i].started == true )
+            {
+                pthread_join( pState->pExpanders[i].thread, NULL );
+            }
+            else
+            {
+                /* expand the share of a worker which could not start */
+                ExpandLines( &pState->pExpanders[i] );
+            }
+        }
+
+        PERFCOUNT_Leave( pState->pPerf, &mark );
+        METRICS_AddPhase( &pState->metrics, METRICS_PHASE_EXPAND, start );
+
+        /* process the lines in their original order */
+        for ( n = first; n < last; n++ )
+        {
+            pState->lineno = n + 1;
+            pInfo = &pIndex->pLines[n];
+
+            if ( pInfo->nrefs > 0 )
+            {
+                pState->pRawLine = &pConfigData[pInfo->offset];
+                ANALYZE_Lookups( pState->pAnalysis, pInfo->nrefs );
+
+                pExpanded = &pBlock->lines[n - first];
+                rc = ProcessExpandedLine(
+                        pState,
+                        pExpanded->result,
+                        &pState->pExpanders[pExpanded->worker].pText[
+                            pExpanded->offset] );
+
+                pState->pRawLine = NULL;
+            }
+            else
+            {
+                rc = ProcessIndexedLine( pState, pConfigData, pIndex, n );
+            }
+
+            if ( rc != EOK )
+            {
+                result = rc;
+            }
+        }
+    }
+    else
+    {
+        for ( n = first; n < last; n++ )
+        {
+            pState->lineno = n + 1;
+
+            rc = ProcessIndexedLine( pState, pConfigData, pIndex, n );
+            if ( rc != EOK )
+            {
+                result = rc;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ExpandLines                                                             */
+/*!
+    Expand a share of the lines of a block
+
+    The ExpandLines function is run by each expansion worker.  The lines
+    of the block which need to be expanded are shared between the
+    workers in turn.  Each worker expands its lines using its own
+    working buffers and copies the expanded lines to its own output
+    buffer.
+
+    @param[in]
+        arg
+            pointer to the Expander of the worker
+
+    @retval NULL always
+
+============================================================================*/
+static void *ExpandLines( void *arg )
+{
+    Expander *pExpander = (Expander *)arg;
+    ExpandBlock *pBlock = pExpander->pBlock;
+    ExpandedLine *pExpanded;
+    LineInfo *pInfo;
+    char *pLine;
+    uint32_t n;
+    uint32_t count = 0;
+    size_t len;
+    char *p;
+
+    pExpander->len = 0;
+
+    for ( n = pBlock->first; n < pBlock->last; n++ )
+    {
+        pInfo = &pBlock->pIndex->pLines[n];
+        if ( ( pInfo->nrefs > 0 ) &&
+             ( ( count++ % pBlock->nworkers ) == pExpander->worker ) )
+        {
+            pExpanded = &pBlock->lines[n - pBlock->first];
+            pExpanded->worker = pExpander->worker;
+            pExpanded->offset = pExpander->len;
+
+            pExpanded->result =
+                ExpandConfigLine( pExpander->pLoad,
+                                  &pBlock->pConfigData[pInfo->offset],
+                                  pInfo->length,
+                                  &pBlock->pIndex->pRefs[pInfo->refidx],
+                                  pInfo->nrefs,
+                                  &pLine );
+
+            if ( pExpanded->result == EOK )
+            {
+                len = strlen( pLine ) + 1;
+                if ( pExpander->len + len > pExpander->size )
+                {
+                    p = realloc( pExpander->pText,
+                                 ( pExpander->len + len ) * 2 );
+                    if ( p != NULL )
+                    {
+                        pExpander->pText = p;
+                        pExpander->size = ( pExpander->len + len ) * 2;
+                    }
+                }
+
+                if ( pExpander->len + len <= pExpander->size )
+                {
+                    memcpy( &pExpander->pText[pExpander->len], pLine, len );
+                    pExpander->len += len;
+                }
+                else
+                {
+                    pExpanded->result = ENOMEM;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  CreateExpanders                                                         */
+/*!
+    Create the workers for parallel expansion
+
+    The CreateExpanders function creates one expansion worker for each
+    job.  The first worker runs on the loading thread and uses its
+    working buffers.  Each other worker has its own variable server
+    connection and working buffers.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @retval EOK the workers were created
+    @retval ENOMEM memory allocation failure
+    @retval other error as returned by VARCALL_Open or CreateWorkingBuffer
+
+============================================================================*/
+static int CreateExpanders( LoadState *pState )
+{
+    int result = ENOMEM;
+    ExpandBlock *pBlock;
+    Expander *pExpanders;
+    LoadState *pLoad;
+    VarCallOptions options = pState->callOptions;
+    unsigned int i;
+
+    pBlock = calloc( 1, sizeof( ExpandBlock ) );
+    pExpanders = calloc( pState->jobs, sizeof( Expander ) );
+    if ( ( pBlock != NULL ) && ( pExpanders != NULL ) )
+    {
+        result = EOK;
+
+        pBlock->nworkers = pState->jobs;
+        pState->pExpanders = pExpanders;
+
+        /* the workers only expand, so they neither record, pace
+         * nor journal */
+        options.pLog = NULL;
+        options.paceTargetUs = 0;
+        options.paceIdle = false;
+        options.confirm = NULL;
+
+        for ( i = 0; ( i < pState->jobs ) && ( result == EOK ); i++ )
+        {
+            pExpanders[i].pBlock = pBlock;
+            pExpanders[i].worker = i;
+
+            if ( i == 0 )
+            {
+                pExpanders[i].pLoad = pState;
+            }
+            else
+            {
+                pLoad = &pExpanders[i].state;
+                pLoad->fd = -1;
+                pLoad->workbufSize = pState->workbufSize;
+                pExpanders[i].pLoad = pLoad;
+
+                pLoad->pVarCall = VARCALL_Create( &options, NULL );
+                result = ( pLoad->pVarCall != NULL )
+                            ? VARCALL_Open( pLoad->pVarCall )
+                            : ENOMEM;
+                if ( result == EOK )
+                {
+                    result = CreateWorkingBuffer( pLoad );
+                }
+            }
+        }
+    }
+    else
+    {
+        free( pBlock );
+        free( pExpanders );
+    }
+
+    if ( result != EOK )
+    {
+        DestroyExpanders( pState );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  DestroyExpanders                                                        */
+/*!
+    Destroy the workers for parallel expansion
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+============================================================================*/
+static void DestroyExpanders( LoadState *pState )
+{
+    Expander *pExpanders = pState->pExpanders;
+    unsigned int i;
+
+    if ( pExpanders != NULL )
+    {
+        for ( i = 0; i < pState->jobs; i++ )
+        {
+            if ( pExpanders[i].pLoad == &pExpanders[i].state )
+            {
+                DestroyWorkingBuffer( &pExpanders[i].state );
+                VARCALL_Close( pExpanders[i].state.pVarCall );
+            }
+
+            free( pExpanders[i].pText );
+        }
+
+        free( pExpanders[0].pBlock );
+        free( pExpanders );
+        pState->pExpanders = NULL;
+    }
+}
+
+/*==========================================================================*/
+/*  ProcessConfigLine                                                       */
+/*!
+    Process a line of configuration data
+
+    The ProcessConfigLine function processes a line of configuration
+    data which has typically been loaded from a configuration file.
+    The configuration data consists of either a directives or a
+    variable assignment.  Directives start with an @ symbol, and
+    a variable assignment consists of a name and value string separated
+    by white space.
+
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigLine
+            pointer to a NUL terminated line of configuration data to load
+
+    @retval EINVAL invalid arguments
+    @retval EOK file processed ok
+    @retval other last error as returned by ProcessConfigLine
+
+============================================================================*/
+static int ProcessConfigLine( LoadState *pState, char *pConfigLine )
+{
+    int result = EINVAL;
+
+    if ( ( pState != NULL ) &&
+         ( pConfigLine != NULL ) )
+    {
+        switch( *pConfigLine )
+        {
+            case '\0':
+            case '#':
+                /* ignore comments and blank lines */
+                result = EOK;
+                break;
+
+            case '@':
+                result = ProcessDirective( pState, pConfigLine );
+                break;
+
+            default:
+                result = ProcessVariableAssignment( pState, pConfigLine );
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessDirective                                                        */
+/*!
+    Process a configuration directive
+
+    The ProcessDirective function splits an expanded configuration
+    directive into the directive and its argument, and dispatches it
+    to the appropriate directive processing function.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfigDirective
+            pointer to a NUL terminated configuration directive
+
+    @retval EINVAL invalid arguments
+    @retval EOK the directive was processed ok
+    @retval other error as returned by the directive processing functions
+
+============================================================================*/
+static int ProcessDirective( LoadState *pState, char *pConfigDirective )
+{
+    int result = EINVAL;
+    char *pArg = NULL;
+    char *pDirective;
+
+    if ( ( pState != NULL ) &&
+         ( pConfigDirective != NULL ) )
+    {
+        /* get the directive and its argument */
+        pDirective = strtok_r( pConfigDirective, " ", &pArg );
+
+        result = DispatchDirective( pState,
+                                    LINEINDEX_DirectiveType(
+                                        pDirective,
+                                        strlen( pDirective ) ),
+                                    pArg );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  DispatchDirective                                                       */
+/*!
+    Dispatch a configuration directive
+
+    The DispatchDirective function processes a configuration directive
+    which could be one of:
+
+    @config
+    @include
+    @require
+    @includedir
+    @let
+    @foreach
+    @barrier
+    @ordered
+    @lazy
+
+    @config gives info about a configuration and outputs all data following
+    the directive to the output log
+
+    @include specifies the name of an (optional) configuration file to
+    include
+
+    @require specifies the name of a configuration file to include.  If
+    the file does not exist, an error is thrown.
+
+    @includedir specifies the name of a directory to scan.  All config
+    files contained in the directory will be loaded.
+
+    @let defines a loader-local variable
+
+    @foreach repeats the following lines up to the matching @end
+
+    @barrier completes the writes deferred in relaxed mode
+
+    @ordered completes the deferred writes, and makes the writes of
+    the rest of the file, and the files it includes, in order
+
+    @lazy specifies a namespace and a configuration file to process
+    when a variable in the namespace is first read
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        type
+            type of the directive
+
+    @param[in]
+        pArg
+            pointer to the NUL terminated directive argument
+
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP unknown directive
+    @retval EOK the directive was processed ok
+    @retval other error as returned by the directive processing functions
+
+============================================================================*/
+static int DispatchDirective( LoadState *pState,
+                              DirectiveType type,
+                              char *pArg )
+{
+    int result = EINVAL;
+
+    switch( type )
+    {
+        case DIRECTIVE_CONFIG:
+            result = ProcessConfigDirective( pState, pArg );
+            break;
+
+        case DIRECTIVE_INCLUDE:
+            result = ProcessIncludeDirective( pState, pArg );
+            break;
+
+        case DIRECTIVE_REQUIRE:
+            result = ProcessRequireDirective( pState, pArg );
+            break;
+
+        case DIRECTIVE_INCLUDEDIR:
+            result = ProcessIncludeDirDirective( pState, pArg );
+            break;
+
+        case DIRECTIVE_LET:
+            result = ProcessLetDirective( pState, pArg );
+            break;
+
+        case DIRECTIVE_FOREACH:
+            result = ProcessForeachDirective( pState, pArg );
+            break;
+
+        case DIRECTIVE_END:
+            LogError( pState, "@end without @foreach" );
+            result = EINVAL;
+            break;
+
+        case DIRECTIVE_BARRIER:
+            result = Barrier( pState );
+            break;
+
+        case DIRECTIVE_ORDERED:
+            result = Barrier( pState );
+            pState->ordered = true;
+            break;
+
+        case DIRECTIVE_LAZY:
+            result = ProcessLazyDirective( pState, pArg );
+            break;
+
+        default:
+            LogError( pState, "unknown directive" );
+            result = ENOTSUP;
+            break;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessConfigDirective                                                  */
+/*!
+    Process a configuration directive
+
+    The ProcessConfigDirective treats everything following the @config
+    directive as a notice, and outputs it to the standard output.
+    It is used to track the loading process of the system configuration.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pInfo
+            pointer to the configuration information to output
+
+    @retval EINVAL invalid arguments
+    @retval EOK the directive was processed ok
+
+============================================================================*/
+static int ProcessConfigDirective( LoadState *pState, char *pInfo )
+{
+    int result = EINVAL;
+
+    if ( ( pState != NULL ) &&
+         ( pInfo != NULL ) )
+    {
+        result = EOK;
+
+        if ( pState->verbose == true )
+        {
+            fprintf( stdout, "Processing %s\n", pInfo );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessIncludeDirective                                                 */
+/*!
+    Process an @include configuration directive
+
+    The ProcessIncludeDirective treats everything following the @include
+    directive as an include file path, and tries to load the include
+    file as a configuration file.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pFilename
+            pointer to the configuration file name
+
+    @retval EINVAL invalid arguments
+    @retval EOK the directive was processed ok
+
+============================================================================*/
+static int ProcessIncludeDirective( LoadState *pState, char *pFilename )
+{
+    int result = EINVAL;
+
+    if ( ( pState != NULL ) &&
+         ( pFilename != NULL ) )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Including %s\n", pFilename );
+        }
+
+        /* recursively process a new configuration file,
+         * included files are not mandatory */
+        result = ProcessConfigFile( pState, pFilename, false );
+
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessRequireDirective                                                 */
+/*!
+    Process a @require configuration directive
+
+    The ProcessRequireDirective treats everything following the @require
+    directive as an include file path, and tries to load the include
+    file as a configuration file.
+
+    The difference between @include and @require is that @require'd
+    configurations must exist and load successfully
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pFilename
+            pointer to the configuration file name
+
+    @retval EINVAL invalid arguments
+    @retval EOK the directive was processed ok
+
+============================================================================*/
+static int ProcessRequireDirective( LoadState *pState, char *pFilename )
+{
+    int result = EINVAL;
+
+    if ( ( pState != NULL ) &&
+         ( pFilename != NULL ) )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Including %s\n", pFilename );
+        }
+
+        /* recursively process a new configuration file,
+         * required files are mandatory */
+        result = ProcessConfigFile( pState, pFilename, true );
+
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessIncludeDirDirective                                              */
+/*!
+    Process an @includedir configuration directive
+
+    The ProcessIncludeDirDirective treats everything following the @require
+    directive as an include directory path, and tries to load all of the
+    files in that directory as config files.
+
+    Failed configuration files are ignored and do not affect the error
+    return of this function
+
+    When a configuration tree root is set, an absolute directory is
+    read from within the root.  Each file is loaded by its directory
+    qualified name so LoadConfigData applies the root in the same way.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pDirname
+            pointer to the configuration directory name
+
+    @retval EINVAL invalid arguments
+    @retval EOK the directive was processed ok
+
+============================================================================*/
+static int ProcessIncludeDirDirective( LoadState *pState, char *pDirname )
+{
+    int result = EINVAL;
+    DIR *configdir = NULL;
+    struct dirent *entry;
+    char dirname[PATH_MAX];
+    char dirpath[PATH_MAX];
+    char filename[PATH_MAX];
+    int n;
+
+    if ( ( pState != NULL ) &&
+         ( pDirname != NULL ) )
+    {
+        result = EOK;
+
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Processing directory: %s\n", pDirname );
+        }
+
+        /* the directive argument is overwritten by the included files */
+        snprintf( dirname, sizeof( dirname ), "%s", pDirname );
+
+        /* read absolute directories from within the tree root */
+        if ( ( pState->pRoot != NULL ) && ( dirname[0] == '/' ) )
+        {
+            n = snprintf( dirpath,
+                          sizeof( dirpath ),
+                          "%s%s",
+                          pState->pRoot,
+                          dirname );
+        }
+        else
+        {
+            n = snprintf( dirpath, sizeof( dirpath ), "%s", dirname );
+        }
+
+        configdir = ( n < (int)sizeof( dirpath ) ) ? opendir( dirpath )
+                                                   : NULL;
+        if( configdir != NULL )
+        {
+            while( entry = readdir( configdir ) )
+            {
+                /* process configuration file, included
+                 * directories are not mandatory */
+                n = snprintf( filename,
+                              sizeof( filename ),
+                              "%s/%s",
+                              dirname,
+                              entry->d_name );
+                if ( ( strcmp( entry->d_name, "." ) != 0 ) &&
+                     ( strcmp( entry->d_name, ".." ) != 0 ) &&
+                     ( n < (int)sizeof( filename ) ) )
+                {
+                    ProcessConfigFile( pState, filename, false );
+                }
+            }
+
+            closedir( configdir );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessLetDirective                                                     */
+/*!
+    Process a @let configuration directive
+
+    The ProcessLetDirective function defines a loader-local variable.
+    The first token following the @let directive is the variable name,
+    and the remainder of the line is its value.
+
+    Local variables are visible to all lines processed after their
+    definition, including those in included files.  They take precedence
+    over variable server variables during ${} expansion and are never
+    written to the variable server.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pArgs
+            pointer to the variable name and value
+
+    @retval EINVAL invalid arguments or invalid @let directive
+    @retval EOK the directive was processed ok
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int ProcessLetDirective( LoadState *pState, char *pArgs )
+{
+    int result = EINVAL;
+    char *pName;
+    char *pValue = NULL;
+
+    if ( ( pState != NULL ) &&
+         ( pArgs != NULL ) )
+    {
+        pName = strtok_r( pArgs, " ", &pValue );
+        if ( pName != NULL )
+        {
+            if ( pValue == NULL )
+            {
+                pValue = "";
+            }
+
+            if( pState->verbose == true )
+            {
+                fprintf( stdout, "Defining %s as %s\n", pName, pValue );
+            }
+
+            result = VARTABLE_Set( pState->pLocalVars, pName, pValue );
+        }
+        else
+        {
+            LogError( pState, "Invalid @let directive" );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessForeachDirective                                                 */
+/*!
+    Process a @foreach configuration directive
+
+    The ProcessForeachDirective function starts a loop.  The first token
+    following the @foreach directive is the name of the loop variable,
+    and the remainder of the line is either an inclusive integer range
+    in the form <first>..<last>, or a list of white space separated values.
+
+    The lines following the directive up to the matching @end directive
+    are processed once for each value with the loop variable defined as
+    a loader-local variable.  The value of any local variable with the
+    same name is saved so that it can be restored after the loop.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pArgs
+            pointer to the loop variable name and values
+
+    @retval EINVAL invalid arguments or invalid @foreach directive
+    @retval EOK the directive was processed ok
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int ProcessForeachDirective( LoadState *pState, char *pArgs )
+{
+    int result = EINVAL;
+    char *pName;
+    char *pValues = NULL;
+    char *pShadowed;
+    ConfigLoop *pLoop;
+
+    if ( ( pState != NULL ) &&
+         ( pArgs != NULL ) )
+    {
+        pName = strtok_r( pArgs, " ", &pValues );
+        if ( ( pName != NULL ) &&
+             ( pValues != NULL ) &&
+             ( *pValues != '\0' ) )
+        {
+            result = ENOMEM;
+
+            pLoop = calloc( 1, sizeof( ConfigLoop ) );
+            if ( pLoop != NULL )
+            {
+                pLoop->pVarName = strdup( pName );
+                pLoop->pValues = strdup( pValues );
+                pLoop->lineno = pState->lineno;
+
+                /* save the local variable hidden by the loop variable */
+                pShadowed = VARTABLE_Get( pState->pLocalVars, pName );
+                if ( pShadowed != NULL )
+                {
+                    pLoop->pShadowed = strdup( pShadowed );
+                }
+
+                if ( ( pLoop->pVarName != NULL ) &&
+                     ( pLoop->pValues != NULL ) &&
+                     ( ( pShadowed == NULL ) ||
+                       ( pLoop->pShadowed != NULL ) ) )
+                {
+                    pState->pLoop = pLoop;
+                    result = EOK;
+                }
+                else
+                {
+                    FreeLoop( pLoop );
+                }
+            }
+        }
+        else
+        {
+            LogError( pState, "Invalid @foreach directive" );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ProcessLazyDirective                                                    */
+/*!
+    Process a @lazy directive
+
+    The ProcessLazyDirective function processes a directive of the form
+    @lazy <namespace> <filename>.  When values are served on demand, the
+    namespace is served on demand, and the file is only processed when
+    one of the variables it assigns in the namespace is first read.
+    Otherwise the file is included straight away.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pArgs
+            pointer to the namespace and file name
+
+    @retval EINVAL invalid arguments or invalid @lazy directive
+    @retval EOK the directive was processed ok
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int ProcessLazyDirective( LoadState *pState, char *pArgs )
+{
+    int result = EINVAL;
+    char *pPrefix;
+    char *pFileName = NULL;
+
+    if ( ( pState != NULL ) &&
+         ( pArgs != NULL ) )
+    {
+        pPrefix = strtok_r( pArgs, " ", &pFileName );
+        if ( pFileName != NULL )
+        {
+            pFileName += strspn( pFileName, " " );
+        }
+
+        if ( ( pPrefix == NULL ) ||
+             ( pFileName == NULL ) ||
+             ( pFileName[0] == '\0' ) )
+        {
+            LogError( pState, "Invalid @lazy directive" );
+        }
+        else if ( pState->pResident == NULL )
+        {
+            result = ProcessIncludeDirective( pState, pFileName );
+        }
+        else
+        {
+            if( pState->verbose == true )
+            {
+                fprintf( stdout,
+                         "Deferring %s until %s is read\n",
+                         pFileName,
+                         pPrefix );
+            }
+
+            result = RESIDENT_AddInclude( pState->pResident,
+                                          pPrefix,
+                                          pFileName );
+            if ( result == EOK )
+            {
+                result = DeclareLazy( pState, pPrefix, pFileName );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  DeclareLazy                                                             */
+/*!
+    Declare the variables assigned by a lazy include
+
+    The DeclareLazy function tokenizes the file of a lazy include, without
+    processing it, to declare the variables it assigns in its namespace
+    so they can be served when first read.  Assignments whose variable
+    name contains a ${} reference cannot be declared.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pPrefix
+            pointer to the namespace of the lazy include
+
+    @param[in]
+        pFileName
+            pointer to the name of the configuration file
+
+    @retval EOK the variables were declared, or the file does not exist
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int DeclareLazy( LoadState *pState, char *pPrefix, char *pFileName )
+{
+    int result = EOK;
+    char *pConfigData;
+    LineIndex *pIndex = NULL;
+    LineInfo *pInfo;
+    char *pLine;
+    size_t len = strlen( pPrefix );
+    uint32_t n;
+
+    pConfigData = LoadConfigData( pState, pFileName );
+    if ( pConfigData != NULL )
+    {
+        pIndex = LINEINDEX_Build( pConfigData, strlen( pConfigData ) );
+        result = ( pIndex != NULL ) ? EOK : ENOMEM;
+    }
+
+    for ( n = 0; ( pIndex != NULL ) && ( n < pIndex->nlines ); n++ )
+    {
+        pInfo = &pIndex->pLines[n];
+        pLine = &pConfigData[pInfo->offset];
+
+        if ( ( pInfo->kind == LINE_ASSIGNMENT ) &&
+             ( pInfo->namelen >= len ) &&
+             ( pInfo->namelen <= (uint32_t)pState->workbufSize ) &&
+             ( ( pInfo->nrefs == 0 ) ||
+               ( pIndex->pRefs[pInfo->refidx].offset >=
+                    pInfo->nameoff + pInfo->namelen ) ) &&
+             ( strncmp( &pLine[pInfo->nameoff], pPrefix, len ) == 0 ) )
+        {
+            memcpy( pState->linebuf, &pLine[pInfo->nameoff], pInfo->namelen );
+            pState->linebuf[pInfo->namelen] = '\0';
+
+            if ( RESIDENT_Declare( pState->pResident,
+                                   pState->linebuf ) != EOK )
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+
+    LINEINDEX_Free( pIndex );
+    free( pConfigData );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  LoadLazy                                                                */
+/*!
+    Process a lazy include
+
+    The LoadLazy function processes the configuration file of a lazy
+    include, when one of the variables in its namespace is first read
+    or referenced.
+
+    @param[in]
+        arg
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pFileName
+            pointer to the name of the configuration file
+
+    @retval EOK the file was processed
+    @retval other error as returned by ProcessConfigFile
+
+============================================================================*/
+static int LoadLazy( void *arg, char *pFileName )
+{
+    LoadState *pState = (LoadState *)arg;
+    char *pRawLine = pState->pRawLine;
+    int result;
+
+    result = ProcessConfigFile( pState, pFileName, false );
+
+    /* complete the writes deferred in relaxed mode */
+    if ( ( Barrier( pState ) != EOK ) && ( result == EOK ) )
+    {
+        result = EIO;
+    }
+
+    FEED_Flush( pState->pFeed );
+
+    pState->pRawLine = pRawLine;
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  AddLazyNamespace                                                        */
+/*!
+    Serve the variables of a namespace on demand
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pPrefix
+            pointer to the variable name prefix of the namespace
+
+    @retval EOK the namespace will be served on demand
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int AddLazyNamespace( LoadState *pState, char *pPrefix )
+{
+    int result = ENOMEM;
+
+    if ( pState->pLazyValues == NULL )
+    {
+        pState->pLazyValues = VARTABLE_Create( 0 );
+    }
+
+    if ( ( pState->pResident == NULL ) &&
+         ( pState->pLazyValues != NULL ) )
+    {
+        pState->pResident = RESIDENT_Create( pState->pLazyValues );
+    }
+
+    if ( pState->pResident != NULL )
+    {
+        result = RESIDENT_AddNamespace( pState->pResident, pPrefix );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  FindLoopEnd                                                             */
+/*!
+    Find the end of a loop body
+
+    The FindLoopEnd function searches the line index for the @end
+    directive which closes a loop, taking nested loops into account.
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        first
+            index of the first line of the loop body
+
+    @param[in]
+        last
+            index of the line after the last line to search
+
+    @retval index of the closing @end directive
+    @retval last if the loop is not closed
+
+============================================================================*/
+static uint32_t FindLoopEnd( LineIndex *pIndex, uint32_t first, uint32_t last )
+{
+    uint32_t n;
+    int depth = 1;
+
+    for ( n = first; n < last; n++ )
+    {
+        if ( pIndex->pLines[n].directive == DIRECTIVE_FOREACH )
+        {
+            depth++;
+        }
+        else if ( pIndex->pLines[n].directive == DIRECTIVE_END )
+        {
+            if ( --depth == 0 )
+            {
+                break;
+            }
+        }
+    }
+
+    return n;
+}
+
+/*==========================================================================*/
+/*  ExecuteLoop                                                             */
+/*!
+    Execute a @foreach loop
+
+    The ExecuteLoop function processes the loop body once for each
+    value of the loop.  The loop body lines are processed directly
+    from the configuration data already in memory without any
+    further file I/O.
+
+    After the last iteration the local variable hidden by the loop
+    variable is restored, or the loop variable is removed if it did
+    not hide one, so the loop variable is not visible after the @end.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pLoop
+            pointer to the loop
+
+    @param[in]
+        pConfigData
+            pointer to the buffer of NUL terminated configuration lines
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        first
+            index of the first line of the loop body
+
+    @param[in]
+        last
+            index of the @end directive which closes the loop
+
+    @retval EINVAL invalid loop range
+    @retval EOK the loop was processed ok
+    @retval other last error as returned by ExecuteLoopBody
+
+============================================================================*/
+static int ExecuteLoop( LoadState *pState,
+                        ConfigLoop *pLoop,
+                        char *pConfigData,
+                        LineIndex *pIndex,
+                        uint32_t first,
+                        uint32_t last )
+{
+    int result = EOK;
+    int rc;
+    char *pValue;
+    char *pSave = NULL;
+    char *pEnd;
+    char value[32];
+    long start;
+    long end;
+    long n;
+    long step;
+
+    start = strtol( pLoop->pValues, &pEnd, 0 );
+    if ( ( pEnd != pLoop->pValues ) &&
+         ( strncmp( pEnd, "..", 2 ) == 0 ) )
+    {
+        /* integer range */
+        pValue = pEnd + 2;
+        end = strtol( pValue, &pEnd, 0 );
+        if ( ( pEnd != pValue ) && ( *pEnd == '\0' ) )
+        {
+            step = ( end >= start ) ? 1 : -1;
+            for ( n = start; ; n += step )
+            {
+                snprintf( value, sizeof( value ), "%ld", n );
+                rc = ExecuteLoopBody( pState, pLoop, value, pConfigData,
+                                      pIndex, first, last );
+                if ( rc != EOK )
+                {
+                    result = rc;
+                }
+
+                if ( n == end )
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            pState->lineno = pLoop->lineno;
+            LogError( pState, "Invalid @foreach range" );
+            result = EINVAL;
+        }
+    }
+    else
+    {
+        /* list of values */
+        pValue = strtok_r( pLoop->pValues, " ", &pSave );
+        while ( pValue != NULL )
+        {
+            rc = ExecuteLoopBody( pState, pLoop, pValue, pConfigData,
+                                  pIndex, first, last );
+            if ( rc != EOK )
+            {
+                result = rc;
+            }
+
+            pValue = strtok_r( NULL, " ", &pSave );
+        }
+    }
+
+    /* restore the local variable hidden by the loop variable */
+    if ( pLoop->pShadowed != NULL )
+    {
+        rc = VARTABLE_Set( pState->pLocalVars,
+                           pLoop->pVarName,
+                           pLoop->pShadowed );
+        if ( rc != EOK )
+        {
+            result = rc;
+        }
+    }
+    else
+    {
+        VARTABLE_Remove( pState->pLocalVars, pLoop->pVarName );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ExecuteLoopBody                                                         */
+/*!
+    Execute one iteration of a @foreach loop
+
+    The ExecuteLoopBody function assigns the loop variable and processes
+    the loop body.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pLoop
+            pointer to the loop
+
+    @param[in]
+        pValue
+            pointer to the value of the loop variable for this iteration
+
+    @param[in]
+        pConfigData
+            pointer to the buffer of NUL terminated configuration lines
+
+    @param[in]
+        pIndex
+            pointer to the line index of the configuration data
+
+    @param[in]
+        first
+            index of the first line of the loop body
+
+    @param[in]
+        last
+            index of the @end directive which closes the loop
+
+    @retval EOK the loop body was processed ok
+    @retval other error as returned by VARTABLE_Set or ProcessConfigData
+
+============================================================================*/
+static int ExecuteLoopBody( LoadState *pState,
+                            ConfigLoop *pLoop,
+                            char *pValue,
+                            char *pConfigData,
+                            LineIndex *pIndex,
+                            uint32_t first,
+                            uint32_t last )
+{
+    int result;
+
+    result = VARTABLE_Set( pState->pLocalVars, pLoop->pVarName, pValue );
+    if ( result == EOK )
+    {
+        result = ProcessConfigData( pState, pConfigData, pIndex, first, last );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  FreeLoop                                                                */
+/*!
+    Free a captured @foreach loop
+
+    The FreeLoop function releases the memory used by a captured loop
+
+    @param[in]
+        pLoop
+            pointer to the captured loop
+
+============================================================================*/
+static void FreeLoop( ConfigLoop *pLoop )
+{
+    if ( pLoop != NULL )
+    {
+        free( pLoop->pVarName );
+        free( pLoop->pValues );
+        free( pLoop->pShadowed );
+        free( pLoop );
+    }
+}
+
+/*==========================================================================*/
+/*  ProcessVariableAssignment                                               */
+/*!
+    Process a configuration variable assignment
+
+    The ProcessVariableAssignment function assumes that the configuration
+    line consistes of a variable name and variable value separatted by
+    a space.
+
+    It sets the variable to the specified value.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pConfig
+            pointer to the configuration var/value to process
+
+    @retval EINVAL invalid arguments or invalid variable assignment
+    @retval EOK the variable assignment was processed ok
+    @retval other error as returned by ApplyAssignment
+
+============================================================================*/
+static int ProcessVariableAssignment( LoadState *pState, char *pConfig )
+{
+    int result = EINVAL;
+    char *pVar = NULL;
+    char *pVal = NULL;
+    char *ch = " ";
+
+    if ( ( pState != NULL ) &&
+         ( pConfig != NULL ) )
+    {
+        /* check if we have an = delimeter */
+        if ( strchr( pConfig, '=' ) != NULL )
+        {
+            ch = "=";
+        }
+
+        /* get the variable and its value */
+        pVar = strtok_r( pConfig, ch, &pVal );
+
+        if ( ( pVar != NULL ) &&
+             ( pVal != NULL ) )
+        {
+            result = ApplyAssignment( pState, pVar, pVal );
+        }
+        else
+        {
+            LogError( pState, "Invalid Variable Assignment" );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ApplyAssignment                                                         */
+/*!
+    Apply a variable assignment
+
+    The ApplyAssignment function sets the variable to the specified
+    value.  In incremental mode the assignment is skipped if it is
+    unchanged since the previous run.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pVar
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pVal
+            pointer to the NUL terminated variable value
+
+    @retval EOK the variable assignment was processed ok
+    @retval other error as returned by VARCALL_SetNameValue
+
+============================================================================*/
+static int ApplyAssignment( LoadState *pState, char *pVar, char *pVal )
+{
+    int result = EOK;
+
+    ANALYZE_Assign( pState->pAnalysis, pVar );
+
+    if ( ( pState->pProvenance != NULL ) &&
+         ( PROVENANCE_Add( pState->pProvenance,
+                           pVar,
+                           pVal,
+                           pState->pRawLine,
+                           pState->pFileName,
+                           pState->lineno ) != EOK ) )
+    {
+        LogVarError( pState, pVar, "Cannot record provenance" );
+    }
+
+    if ( ( pState->pFilter != NULL ) &&
+         ( strncmp( pVar, pState->pFilter, strlen( pState->pFilter ) ) != 0 ) )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Filtered %s\n", pVar );
+        }
+
+        pState->metrics.skipped++;
+    }
+    else if ( pState->pAssignList != NULL )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Collecting %s as %s\n", pVar, pVal );
+        }
+
+        /* the assignment is applied to each target later */
+        result = ASSIGNLIST_Add( pState->pAssignList,
+                                 pVar,
+                                 pVal,
+                                 pState->pFileName,
+                                 pState->lineno );
+        if ( result == EOK )
+        {
+            pState->metrics.applied++;
+        }
+    }
+    else if ( RESIDENT_Match( pState->pResident,
+                              pVar,
+                              strlen( pVar ) ) == true )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Holding %s as %s\n", pVar, pVal );
+        }
+
+        /* the value is served when it is first read */
+        result = VARTABLE_Set( pState->pLazyValues, pVar, pVal );
+        pState->metrics.skipped++;
+    }
+    else if ( IsUnchanged( pState, pVar, pVal ) == true )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Unchanged %s\n", pVar );
+        }
+
+        pState->metrics.skipped++;
+
+        TrackAssignment( pState, pVar, pVal, false, EOK );
+    }
+    else if ( ( pState->pPending != NULL ) &&
+              ( pState->ordered == false ) )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Deferring %s as %s\n", pVar, pVal );
+        }
+
+        /* the write is made at the next barrier */
+        result = ASSIGNLIST_Add( pState->pPending,
+                                 pVar,
+                                 pVal,
+                                 pState->pFileName,
+                                 pState->lineno );
+    }
+    else
+    {
+        result = WriteAssignment( pState, pVar, pVal );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  WriteAssignment                                                         */
+/*!
+    Write a variable assignment to the variable server
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pVar
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pVal
+            pointer to the NUL terminated variable value
+
+    @retval EOK the variable was written, or queued
+    @retval other error as returned by VARCALL_SetNameValue
+
+============================================================================*/
+static int WriteAssignment( LoadState *pState, char *pVar, char *pVal )
+{
+    int result;
+    uint64_t start;
+    PerfMark mark;
+    char *pName = NULL;
+    char *pValue = NULL;
+    char *pOldValue = NULL;
+    bool queued;
+
+    if ( pState->pFeed != NULL )
+    {
+        /* the assignment may be held in the buffers used to read the
+         * value it replaces */
+        pVar = pName = strdup( pVar );
+        pVal = pValue = strdup( pVal );
+        pOldValue = LiveValue( pState, pVar );
+    }
+
+    if( pState->verbose == true )
+    {
+        fprintf( stdout, "Setting %s to %s\n", pVar, pVal );
+    }
+
+    start = METRICS_Now();
+    PERFCOUNT_Enter( pState->pPerf, NULL, PERF_PHASE_WRITE, &mark );
+    result = VARCALL_SetNameValue( pState->pVarCall,
+                                   pVar,
+                                   pVal,
+                                   pState->pFileName,
+                                   pState->lineno );
+    PERFCOUNT_Leave( pState->pPerf, &mark );
+    METRICS_AddPhase( &pState->metrics, METRICS_PHASE_WRITE, start );
+
+    if ( ( result == EOK ) || ( result == EINPROGRESS ) )
+    {
+        pState->metrics.applied++;
+    }
+
+    queued = ( result == EINPROGRESS );
+    if ( queued == true )
+    {
+        if( pState->verbose == true )
+        {
+            fprintf( stdout, "Queued %s\n", pVar );
+        }
+
+        /* failures are reported when the write is applied */
+        result = EOK;
+    }
+    else if( result != EOK )
+    {
+        if ( result == ENOENT )
+        {
+            LogVarError( pState, pVar, "Variable not found" );
+        }
+        else if ( result == ETIMEDOUT )
+        {
+            LogVarError( pState, pVar, "Variable assignment timed out" );
+        }
+        else
+        {
+            LogVarError( pState, pVar, "Variable assignment failed" );
+        }
+    }
+
+    /* queued writes are journaled by JournalConfirmed when applied */
+    if ( ( result == EOK ) &&
+         ( queued == false ) &&
+         ( JOURNAL_Append( pState->pJournal, pVar, pVal ) != EOK ) )
+    {
+        LogVarError( pState, pVar, "Cannot journal assignment" );
+    }
+
+    if ( ( result == EOK ) &&
+         ( pState->pFeed != NULL ) &&
+         ( FEED_Event( pState->pFeed,
+                       pVar,
+                       ( pOldValue != NULL ) ? pOldValue : "",
+                       pVal,
+                       pState->pFileName,
+                       pState->lineno ) != EOK ) )
+    {
+        LogVarError( pState, pVar, "Cannot emit change feed event" );
+    }
+
+    TrackAssignment( pState, pVar, pVal, true, result );
+
+    free( pName );
+    free( pValue );
+    free( pOldValue );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Barrier                                                                 */
+/*!
+    Complete the writes deferred in relaxed mode
+
+    The Barrier function writes the final value of each variable
+    assigned since the previous barrier, once, and in no particular
+    order.  Errors are reported against the assignment which set the
+    final value.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @retval EOK the deferred writes were completed, or there were none
+    @retval ENOMEM memory allocation failure
+    @retval other error as returned by WriteAssignment
+
+============================================================================*/
+static int Barrier( LoadState *pState )
+{
+    int result = EOK;
+    AssignList *pPending = pState->pPending;
+    Assignment *pAssignment;
+    VarEntry *pEntry;
+    char *saveFileName = pState->pFileName;
+    int saveLineNumber = pState->lineno;
+    size_t writes = 0;
+    size_t i;
+    int rc;
+
+    if ( ( pPending != NULL ) &&
+         ( pPending->count > 0 ) )
+    {
+        /* the last assignment to each variable is the one to write */
+        for ( i = pPending->count; i > 0; i-- )
+        {
+            pAssignment = &pPending->pAssignments[i - 1];
+            pEntry = VARTABLE_Find( pPending->pValues, pAssignment->pName );
+            if ( ( pEntry != NULL ) && ( pEntry->flags == 0 ) )
+            {
+                pEntry->flags = 1;
+                writes++;
+
+                pState->pFileName = pAssignment->pFileName;
+                pState->lineno = pAssignment->lineno;
+                rc = WriteAssignment( pState,
+                                      pAssignment->pName,
+                                      pAssignment->pValue );
+                if ( rc != EOK )
+                {
+                    result = rc;
+                }
+            }
+        }
+
+        pState->pFileName = saveFileName;
+        pState->lineno = saveLineNumber;
+
+        if( pState->verbose == true )
+        {
+            fprintf( stdout,
+                     "Barrier: %zu writes, %zu coalesced\n",
+                     writes,
+                     pPending->count - writes );
+        }
+
+        ASSIGNLIST_Free( pPending );
+        pState->pPending = ASSIGNLIST_Create();
+        if ( pState->pPending == NULL )
+        {
+            LogError( pState, "Cannot create pending write list" );
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  InitReadahead                                                           */
+/*!
+    Initialize the boot readahead
+
+    The InitReadahead function loads the list of configuration files
+    which were opened by the previous run and advises the kernel to
+    start reading them into the page cache, so they are already in
+    memory by the time the include recursion reaches them.  It also
+    creates the list used to record the files opened by this run.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @retval EOK readahead was initialized
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int InitReadahead( LoadState *pState )
+{
+    int result = ENOMEM;
+    size_t n;
+
+    pState->pReadaheadFile = CacheSubDir( pState, READAHEAD_FILE );
+    if ( pState->pReadaheadFile != NULL )
+    {
+        pState->pPrevReadahead = READAHEAD_Load( pState->pReadaheadFile );
+        pState->pReadahead = READAHEAD_Create();
+    }
+
+    if ( ( pState->pPrevReadahead != NULL ) &&
+         ( pState->pReadahead != NULL ) )
+    {
+        n = READAHEAD_Prefetch( pState->pPrevReadahead );
+        if ( pState->verbose == true )
+        {
+            printf( "Readahead %zu files\n", n );
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  InitVarLog                                                              */
+/*!
+    Initialize recording or replay of the variable server calls
+
+    The InitVarLog function creates the log to record the variable server
+    calls and configuration files into, or loads the log to replay them
+    from.  A replay does not touch the variable server, the configuration
+    files, or the cache directory, so it cannot be combined with the
+    options which use them.
+
+    @param[in]
+        pState
+            pointer to the load state
+
+    @retval EOK the log is ready
+    @retval EINVAL the options cannot be combined
+    @retval ENOENT the log could not be created or loaded
+
+============================================================================*/
+static int InitVarLog( LoadState *pState )
+{
+    int result = EINVAL;
+
+    if ( ( pState->pRecordFile != NULL ) &&
+         ( pState->pReplayFile != NULL ) )
+    {
+        LogError( pState, "Cannot record and replay at the same time" );
+    }
+    else if ( pState->ntargets > 0 )
+    {
+        LogError( pState, "Record and replay cannot be used with targets" );
+    }
+    else if ( ( pState->pReplayFile != NULL ) &&
+              ( ( pState->incremental == true ) ||
+                ( pState->parseCache == true ) ||
+                ( pState->readahead == true ) ) )
+    {
+        LogError( pState, "Replay cannot be used with the cache directory" );
+    }
+    else if ( pState->pRecordFile != NULL )
+    {
+        pState->callOptions.pLog = VARLOG_Create( pState->pRecordFile );
+        result = ( pState->callOptions.pLog != NULL ) ? EOK : ENOENT;
+    }
+    else
+    {
+        pState->callOptions.pLog = VARLOG_Load( pState->pReplayFile,
+                                                pState->replayLatency );
+        result = ( pState->callOptions.pLog != NULL ) ? EOK : ENOENT;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RunDiff                                                                 */
+/*!
+    Compare the variables assigned by two configuration trees
+
+    The RunDiff function evaluates the configuration file in the
+    configuration trees under each of the two diff roots, concurrently
+    and without the variable server.  References to variables which are
+    not assigned by the tree are expanded from the seeded variable store.
+    Files with the same content in both trees are only scanned once.
+    The added, removed and changed variables are printed on stdout.
+
+    @param[in]
+        pState
+            pointer to the load state holding the options
+
+    @retval EOK the trees were compared
+    @retval EINVAL the options cannot be combined with a comparison
+    @retval other error evaluating or comparing the trees
+
+============================================================================*/
+static int RunDiff( LoadState *pState )
+{
+    int result = EINVAL;
+    TreeEval eval[2];
+    VarTable *pSeed = NULL;
+    IndexCache *pIndexCache = NULL;
+    size_t count = 0;
+    int started = 0;
+    int i;
+
+    memset( eval, 0, sizeof( eval ) );
+
+    if ( ( pState->incremental == true ) ||
+         ( pState->ntargets > 0 ) ||
+         ( pState->pRecordFile != NULL ) ||
+         ( pState->pReplayFile != NULL ) )
+    {
+        LogError( pState, "Diff cannot be used with incremental mode, "
+                          "targets, or record and replay" );
+    }
+    else if ( ( pSeed = TREEDIFF_LoadSeed( pState->pSeedFile ) ) == NULL )
+    {
+        fprintf( stderr, "Cannot load seed file %s\n", pState->pSeedFile );
+    }
+    else if ( ( pIndexCache = INDEXCACHE_Create() ) != NULL )
+    {
+        result = EOK;
+    }
+
+    for ( i = 0; ( i < 2 ) && ( result == EOK ); i++ )
+    {
+        result = InitTreeEval( &eval[i],
+                               pState,
+                               pState->pDiffRoots[i],
+                               pSeed,
+                               pIndexCache );
+        if ( ( result == EOK ) &&
+             ( pthread_create( &eval[i].thread,
+                               NULL,
+                               EvaluateTree,
+                               &eval[i] ) == 0 ) )
+        {
+            started++;
+        }
+        else if ( result == EOK )
+        {
+            result = EAGAIN;
+        }
+    }
+
+    for ( i = 0; i < started; i++ )
+    {
+        pthread_join( eval[i].thread, NULL );
+        if ( ( eval[i].result != EOK ) &&
+             ( result == EOK ) )
+        {
+            fprintf( stderr,
+                     "Cannot evaluate tree %s\n",
+                     pState->pDiffRoots[i] );
+            result = eval[i].result;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        result = TREEDIFF_Print( eval[0].state.pAssignList,
+                                 eval[1].state.pAssignList,
+                                 stdout,
+                                 &count );
+        if ( pState->verbose == true )
+        {
+            printf( "%zu differences\n", count );
+        }
+    }
+
+    for ( i = 0; i < 2; i++ )
+    {
+        FreeTreeEval( &eval[i] );
+    }
+
+    INDEXCACHE_Free( pIndexCache );
+    VARTABLE_Destroy( pSeed );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RunAudit                                                                */
+/*!
+    Report the variables whose live values drifted from the configuration
+
+    The RunAudit function gets the expected final value of each variable
+    from a provenance index written by an earlier run, or by evaluating
+    the configuration without writing to the variable server.  It then
+    reads the live values in bulk and reports the variables whose live
+    value differs, and the totals, on stdout.
+
+    @param[in]
+        pState
+            pointer to the load state holding the options
+
+    @retval EOK every live value matches the configuration
+    @retval ESTALE one or more live values differ from the configuration
+    @retval EINVAL the options cannot be combined with an audit
+    @retval other error evaluating the configuration or reading the
+            live values
+
+============================================================================*/
+static int RunAudit( LoadState *pState )
+{
+    int result = EINVAL;
+    ProvenanceIndex *pIndex = NULL;
+    AuditTotals totals;
+
+    if ( ( pState->incremental == true ) ||
+         ( pState->ntargets > 0 ) ||
+         ( pState->pRecordFile != NULL ) ||
+         ( pState->pReplayFile != NULL ) )
+    {
+        LogError( pState, "Audit cannot be used with incremental mode, "
+                          "targets, or record and replay" );
+    }
+    else if ( ( pState->pAssignList == NULL ) &&
+              ( ( pState->pAssignList = ASSIGNLIST_Create() ) == NULL ) )
+    {
+        result = ENOMEM;
+    }
+    else
+    {
+        pState->quiet = ( pState->verbose == false );
+        pState->pVarCall = VARCALL_Create( &pState->callOptions, NULL );
+        result = VARCALL_Open( pState->pVarCall );
+        if ( result != EOK )
+        {
+            fprintf( stderr, "Cannot open variable server\n" );
+        }
+    }
+
+    if ( result == EOK )
+    {
+        result = CreateWorkingBuffer( pState );
+        if ( result == EOK )
+        {
+            if ( pState->pAuditIndex != NULL )
+            {
+                /* use the values of the run which wrote the index */
+                pIndex = PROVENANCE_Open( pState->pAuditIndex );
+                result = PROVENANCE_ForEach( pIndex,
+                                             AddExpected,
+                                             pState->pAssignList );
+                if ( result != EOK )
+                {
+                    fprintf( stderr,
+                             "Cannot read provenance index %s\n",
+                             pState->pAuditIndex );
+                }
+            }
+            else
+            {
+                /* evaluate the configuration without writing it */
+                result = ProcessConfigFile( pState, pState->pFileName, true );
+            }
+
+            if ( result == EOK )
+            {
+                result = AUDIT_Run( pState->pAssignList,
+                                    pState->pVarCall,
+                                    pState->fd,
+                                    pState->workbuf,
+                                    pState->workbufSize,
+                                    stdout,
+                                    &totals );
+            }
+
+            if ( ( result == EOK ) && ( totals.differ > 0 ) )
+            {
+                result = ESTALE;
+            }
+
+            DestroyWorkingBuffer( pState );
+        }
+        else
+        {
+            LogError( pState, "Cannot create working buffer" );
+        }
+    }
+
+    PROVENANCE_Close( pIndex );
+    VARCALL_Close( pState->pVarCall );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RunRestore                                                              */
+/*!
+    Write back the latest journaled values after a variable server restart
+
+    The RunRestore function loads the latest value of each variable from
+    the applied-state journal and writes them back to back over a single
+    variable server connection, without reading any configuration file,
+    so recovery time depends only on the number of variables.
+
+    @param[in]
+        pState
+            pointer to the load state holding the options
+
+    @retval EOK every journaled value was restored
+    @retval EIO one or more values could not be restored
+    @retval other error reading the journal or opening the variable server
+
+============================================================================*/
+static int RunRestore( LoadState *pState )
+{
+    int result = ENOMEM;
+    char *pPath;
+    VarTable *pValues = NULL;
+    uint32_t generation = 0;
+    uint64_t start;
+
+    start = METRICS_Now();
+
+    pPath = JournalFile( pState );
+    if ( pPath != NULL )
+    {
+        pValues = JOURNAL_Load( pPath, &generation, NULL );
+        if ( pValues == NULL )
+        {
+            fprintf( stderr, "Cannot read journal %s\n", pPath );
+            result = EIO;
+        }
+    }
+
+    if ( pValues != NULL )
+    {
+        pState->pFileName = pPath;
+        pState->pVarCall = VARCALL_Create( &pState->callOptions, NULL );
+        result = VARCALL_Open( pState->pVarCall );
+        if ( result == EOK )
+        {
+            if ( VARTABLE_ForEach( pValues, RestoreValue, pState ) != EOK )
+            {
+                result = EIO;
+            }
+
+            /* complete any queued or outstanding writes */
+            if ( ( VARCALL_Drain( pState->pVarCall ) != EOK ) &&
+                 ( result == EOK ) )
+            {
+                result = EIO;
+            }
+
+            printf( "Restored %zu variables from generation %u in %.3f ms\n",
+                    pState->metrics.applied,
+                    generation,
+                    ( METRICS_Now() - start ) / 1e6 );
+        }
+        else
+        {
+            fprintf( stderr, "Cannot open variable server\n" );
+        }
+
+        VARCALL_Close( pState->pVarCall );
+        VARTABLE_Destroy( pValues );
+    }
+
+    free( pPath );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RestoreValue                                                            */
+/*!
+    Write back a journaled value
+
+    @param[in]
+        pEntry
+            pointer to the latest journaled value of a variable
+
+    @param[in]
+        arg
+            pointer to the Load state
+
+    @retval EOK the value was written, or queued
+    @retval other error as returned by VARCALL_SetNameValue
+
+============================================================================*/
+static int RestoreValue( VarEntry *pEntry, void *arg )
+{
+    LoadState *pState = (LoadState *)arg;
+    int result;
+
+    if ( pState->verbose == true )
+    {
+        fprintf( stdout, "Restoring %s to %s\n", pEntry->name, pEntry->value );
+    }
+
+    result = VARCALL_SetNameValue( pState->pVarCall,
+                                   pEntry->name,
+                                   pEntry->value,
+                                   pState->pFileName,
+                                   0 );
+    if ( ( result == EOK ) || ( result == EINPROGRESS ) )
+    {
+        pState->metrics.applied++;
+        result = EOK;
+    }
+    else
+    {
+        fprintf( stderr, "Cannot restore '%s'\n", pEntry->name );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JournalFile                                                             */
+/*!
+    Construct the name of the applied-state journal file
+
+    The JournalFile function allocates the name of the journal file
+    specified with the journal options, or of the default file in the
+    cache directory.  The caller must free the returned name.
 
     @param[in]
         pState
-            pointer to the loadconfig utility state object
+            pointer to the Load state which manages the current
+            loading context
 
-    @retval EOK working buffer created ok
-    @retval EINVAL invalid arguments
-    @retval other error as returned by shm_open, ftruncate, mmap
+    @retval pointer to the allocated file name
+    @retval NULL memory allocation failure
 
 ============================================================================*/
-static int CreateWorkingBuffer( LoadState *pState )
+static char *JournalFile( LoadState *pState )
 {
-    int result = EINVAL;
-	pid_t pid;
-    size_t size;
-    int fd;
-    int rc;
-    char *workbuf;
+    return ( pState->pJournalFile != NULL )
+                ? strdup( pState->pJournalFile )
+                : CacheSubDir( pState, JOURNAL_FILE );
+}
 
-    if ( ( pState != NULL ) &&
-         ( pState->workbufSize > 0 ) )
+/*==========================================================================*/
+/*  JournalConfirmed                                                        */
+/*!
+    Journal a queued write once it has been applied
+
+    The JournalConfirmed function is called by the variable server call
+    context when a write which was queued, or which completed after its
+    call deadline, is applied, so that the journal only records values
+    which reached the variable server.
+
+    @param[in]
+        arg
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pValue
+            pointer to the NUL terminated variable value
+
+============================================================================*/
+static void JournalConfirmed( void *arg, char *pName, char *pValue )
+{
+    LoadState *pState = (LoadState *)arg;
+
+    if ( JOURNAL_Append( pState->pJournal, pName, pValue ) != EOK )
     {
-        /* build the varclient identifier */
-        pid = getpid();
-        sprintf(pState->clientname, "/load_%d", pid);
+        fprintf( stderr, "Cannot journal assignment of %s\n", pName );
+    }
+}
 
-        /* set the working buffer size including space for an
-         * additional NUL terminator */
-        size = pState->workbufSize + 1;
+/*==========================================================================*/
+/*  NextGeneration                                                          */
+/*!
+    Get the generation of this run
 
-        /* get shared memory file descriptor (NOT a file) */
-        fd = shm_open(pState->clientname, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
-        if (fd != -1)
+    The NextGeneration function returns the journal generation when
+    journaling.  Otherwise it increments the generation counter kept in
+    the cache directory.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @retval generation of this run
+
+============================================================================*/
+static uint32_t NextGeneration( LoadState *pState )
+{
+    uint32_t generation = JOURNAL_Generation( pState->pJournal );
+    unsigned int last = 0;
+    char *pPath = NULL;
+    FILE *fp;
+
+    if ( generation == 0 )
+    {
+        pPath = CacheSubDir( pState, GENERATION_FILE );
+    }
+
+    if ( pPath != NULL )
+    {
+        fp = fopen( pPath, "r" );
+        if ( fp != NULL )
         {
-            /* extend shared memory object as by default
-               it is initialized with size 0 */
-            rc = ftruncate(fd, size );
-            if (rc != -1)
+            if ( fscanf( fp, "%u", &last ) != 1 )
             {
-                /* map shared memory to process address space */
-                workbuf = mmap( NULL,
-                                size ,
-                                PROT_WRITE,
-                                MAP_SHARED,
-                                fd,
-                                0);
+                last = 0;
+            }
 
-                if( workbuf != MAP_FAILED )
-                {
-                    /* populate the VarClient object */
-                    pState->workbuf = workbuf;
-                    pState->fd = fd;
+            fclose( fp );
+        }
 
-                    /* clear the working buffer */
-                    memset( workbuf, 0, size );
+        generation = last + 1;
 
-                    result = EOK;
-                }
-                else
-                {
-                    /* memory map failed */
-                    pState->fd = -1;
-                    pState->workbuf = NULL;
-                    close( fd );
-                    result = errno;
-                }
-            }
-            else
+        FILEUTIL_MakeDirs( pState->pCacheDir );
+        fp = fopen( pPath, "w" );
+        if ( fp != NULL )
+        {
+            fprintf( fp, "%u\n", generation );
+            fclose( fp );
+        }
+
+        free( pPath );
+    }
+
+    return generation;
+}
+
+/*==========================================================================*/
+/*  LiveValue                                                               */
+/*!
+    Read the current value of a variable from the variable server
+
+    The LiveValue function reads the value a change feed event reports
+    as replaced.  It uses the working buffers, so any assignment held in
+    them must be copied first.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @param[in]
+        pVar
+            pointer to the NUL terminated variable name
+
+    @retval pointer to the allocated value, which the caller must free
+    @retval NULL the value could not be read
+
+============================================================================*/
+static char *LiveValue( LoadState *pState, char *pVar )
+{
+    char *pValue = NULL;
+
+    if ( ( snprintf( pState->linebuf,
+                     pState->workbufSize,
+                     "${%s}",
+                     pVar ) < (int)pState->workbufSize ) &&
+         ( VARCALL_StrToFile( pState->pVarCall,
+                              pState->linebuf,
+                              pState->fd,
+                              pState->workbuf,
+                              pState->workbufSize ) == EOK ) )
+    {
+        pValue = strdup( pState->workbuf );
+    }
+
+    return pValue;
+}
+
+/*==========================================================================*/
+/*  RecordHistory                                                           */
+/*!
+    Record the load in the performance history
+
+    A history file which cannot be written, for example on a read-only
+    file system, does not fail the load.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @retval EOK the load was recorded
+    @retval other error as returned by HISTORY_Append
+
+============================================================================*/
+static int RecordHistory( LoadState *pState )
+{
+    int result = ENOMEM;
+    HistoryRecord record;
+    char *pDir;
+    char *p;
+
+    HISTORY_Fill( &record, &pState->metrics, pState->pFileName );
+
+    /* create the directory holding the history file */
+    pDir = strdup( pState->pHistoryFile );
+    if ( pDir != NULL )
+    {
+        p = strrchr( pDir, '/' );
+        if ( ( p != NULL ) && ( p != pDir ) )
+        {
+            *p = '\0';
+            FILEUTIL_MakeDirs( pDir );
+        }
+
+        free( pDir );
+        result = HISTORY_Append( pState->pHistoryFile, &record );
+    }
+
+    if ( ( result != EOK ) && ( pState->verbose == true ) )
+    {
+        fprintf( stderr,
+                 "Cannot record load history: %s\n",
+                 strerror( result ) );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  AddExpected                                                             */
+/*!
+    Add a value from a provenance index to the expected values
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pValue
+            pointer to the NUL terminated final value
+
+    @param[in]
+        pFileName
+            pointer to the name of the file which set the value
+
+    @param[in]
+        lineno
+            line number of the assignment which set the value
+
+    @param[in]
+        arg
+            pointer to the AssignList of expected values
+
+    @retval EOK the value was added
+    @retval other error as returned by ASSIGNLIST_Add
+
+============================================================================*/
+static int AddExpected( char *pName,
+                        char *pValue,
+                        char *pFileName,
+                        int lineno,
+                        void *arg )
+{
+    return ASSIGNLIST_Add( (AssignList *)arg,
+                           pName,
+                           pValue,
+                           pFileName,
+                           lineno );
+}
+
+/*==========================================================================*/
+/*  RunServer                                                               */
+/*!
+    Serve load requests over a Unix domain socket
+
+    The RunServer function opens the variable server and the working
+    buffer once, and then serves load requests until it receives SIGINT
+    or SIGTERM.  The line indexes of the configuration files are kept
+    in memory between loads, so only files whose content has changed
+    are scanned again.
+
+    @param[in]
+        pState
+            pointer to the load state holding the options
+
+    @retval EOK the service stopped
+    @retval EINVAL the options cannot be combined with the service
+    @retval other error starting the service
+
+============================================================================*/
+static int RunServer( LoadState *pState )
+{
+    int result = EINVAL;
+
+    if ( ( pState->incremental == true ) ||
+         ( pState->ntargets > 0 ) ||
+         ( pState->pRecordFile != NULL ) ||
+         ( pState->pReplayFile != NULL ) ||
+         ( pState->readahead == true ) ||
+         ( pState->provenance == true ) ||
+         ( pState->analyze == true ) ||
+         ( pState->dryRun == true ) )
+    {
+        LogError( pState, "Serve cannot be used with incremental mode, "
+                          "targets, record and replay, readahead, "
+                          "provenance, analysis or a dry run" );
+    }
+    else if ( ( pState->pIndexCache = INDEXCACHE_Create() ) == NULL )
+    {
+        result = ENOMEM;
+    }
+    else
+    {
+        pState->quiet = ( pState->verbose == false );
+        pState->pVarCall = VARCALL_Create( &pState->callOptions, NULL );
+        result = VARCALL_Open( pState->pVarCall );
+        if ( result != EOK )
+        {
+            fprintf( stderr, "Cannot open variable server\n" );
+        }
+    }
+
+    if ( result == EOK )
+    {
+        result = CreateWorkingBuffer( pState );
+        if ( result == EOK )
+        {
+            result = SERVER_Run( pState->pServeSocket, ServeLoad, pState );
+            if ( result != EOK )
             {
-                pState->fd = -1;
-                pState->workbuf = NULL;
-                close( fd );
-                result = errno;
+                fprintf( stderr,
+                         "Cannot serve on %s: %s\n",
+                         pState->pServeSocket,
+                         strerror( result ) );
             }
+
+            DestroyWorkingBuffer( pState );
+        }
+        else
+        {
+            LogError( pState, "Cannot create working buffer" );
+        }
+    }
+
+    VARCALL_Close( pState->pVarCall );
+    INDEXCACHE_Free( pState->pIndexCache );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ServeLoad                                                               */
+/*!
+    Perform a load request received by the loader service
+
+    The ServeLoad function loads the requested configuration file using
+    the variable server connection and caches of the service.  Loader
+    local variables do not carry over from one load to the next.
+
+    @param[in]
+        arg
+            pointer to the load state of the service
+
+    @param[in]
+        pRequest
+            pointer to the load request
+
+    @param[out]
+        pReply
+            pointer to the reply to populate with the load statistics
+
+    @retval EOK the configuration was loaded
+    @retval ENOMEM memory allocation failure
+    @retval EIO queued or outstanding writes could not be completed
+    @retval other error as returned by ProcessConfigFile
+
+============================================================================*/
+static int ServeLoad( void *arg,
+                      ServerRequest *pRequest,
+                      ServerReply *pReply )
+{
+    LoadState *pState = arg;
+    int result = ENOMEM;
+
+    METRICS_Init( &pState->metrics );
+    pState->pFilter = pRequest->pPrefix;
+
+    VARTABLE_Destroy( pState->pLocalVars );
+    pState->pLocalVars = VARTABLE_Create( 0 );
+
+    if ( pRequest->dryRun == true )
+    {
+        pState->pAssignList = ASSIGNLIST_Create();
+    }
+
+    if ( ( pState->pLocalVars != NULL ) &&
+         ( ( pRequest->dryRun == false ) ||
+           ( pState->pAssignList != NULL ) ) )
+    {
+        result = ProcessConfigFile( pState, pRequest->pFileName, true );
+
+        if ( ( Barrier( pState ) != EOK ) && ( result == EOK ) )
+        {
+            result = EIO;
         }
-        else
+
+        if ( ( VARCALL_Drain( pState->pVarCall ) != EOK ) &&
+             ( result == EOK ) )
         {
-            pState->fd = -1;
-            pState->workbuf = NULL;
-            result = errno;
+            result = EIO;
         }
     }
 
-    if ( result != EOK )
+    pReply->files = pState->metrics.files;
+    pReply->applied = pState->metrics.applied;
+    pReply->skipped = pState->metrics.skipped;
+    pReply->errors = pState->metrics.errors;
+    pReply->elapsedUs = ( METRICS_Now() - pState->metrics.start ) / 1000;
+
+    if ( pState->verbose == true )
     {
-        fprintf(stderr, "CreateWorkingBuffer: %s\n", strerror( result ) );
+        printf( "Served %s: %s\n", pRequest->pFileName, strerror( result ) );
     }
 
+    ASSIGNLIST_Free( pState->pAssignList );
+    pState->pAssignList = NULL;
+    pState->pFilter = NULL;
+
     return result;
 }
 
 /*==========================================================================*/
-/*  DestroyWorkingBuffer                                                     */
+/*  InitTreeEval                                                            */
 /*!
-    Destroy the working buffer
+    Initialize the evaluation of a configuration tree for comparison
 
-    The DestroyWorkingBuffer function removes the shared memory and file
-    descriptor used for processing lines of configuration data.
+    @param[in]
+        pEval
+            pointer to the evaluation to initialize
 
     @param[in]
         pState
-            pointer to the loadconfig utility state object
+            pointer to the load state holding the options
+
+    @param[in]
+        pRoot
+            pointer to the NUL terminated root directory of the tree
+
+    @param[in]
+        pSeed
+            pointer to the seeded variable store
+
+    @param[in]
+        pIndexCache
+            pointer to the line index cache shared by the evaluations
+
+    @retval EOK the evaluation was initialized
+    @retval ENOMEM memory allocation failure
 
 ============================================================================*/
-static void DestroyWorkingBuffer( LoadState *pState )
+static int InitTreeEval( TreeEval *pEval,
+                         LoadState *pState,
+                         char *pRoot,
+                         VarTable *pSeed,
+                         IndexCache *pIndexCache )
 {
-    if ( pState != NULL )
+    LoadState *pTree = &pEval->state;
+
+    METRICS_Init( &pTree->metrics );
+    pTree->fd = -1;
+    pTree->verbose = pState->verbose;
+    pTree->quiet = true;
+    pTree->workbufSize = pState->workbufSize;
+    pTree->pFileName = pState->pFileName;
+    pTree->pRoot = pRoot;
+    pTree->pSeed = pSeed;
+    pTree->pIndexCache = pIndexCache;
+
+    pTree->pLocalVars = VARTABLE_Create( 0 );
+    pTree->pAssignList = ASSIGNLIST_Create();
+    pTree->linebuf = calloc( 1, pTree->workbufSize + 1 );
+
+    return ( ( pTree->pLocalVars != NULL ) &&
+             ( pTree->pAssignList != NULL ) &&
+             ( pTree->linebuf != NULL ) ) ? EOK : ENOMEM;
+}
+
+/*==========================================================================*/
+/*  EvaluateTree                                                            */
+/*!
+    Thread which evaluates a configuration tree for comparison
+
+    @param[in]
+        arg
+            pointer to the evaluation
+
+    @retval NULL
+
+============================================================================*/
+static void *EvaluateTree( void *arg )
+{
+    TreeEval *pEval = (TreeEval *)arg;
+
+    /* the top level configuration file is mandatory */
+    pEval->result = ProcessConfigFile( &pEval->state,
+                                       pEval->state.pFileName,
+                                       true );
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  FreeTreeEval                                                            */
+/*!
+    Release the resources of a configuration tree evaluation
+
+    @param[in]
+        pEval
+            pointer to the evaluation
+
+============================================================================*/
+static void FreeTreeEval( TreeEval *pEval )
+{
+    VARTABLE_Destroy( pEval->state.pLocalVars );
+    ASSIGNLIST_Free( pEval->state.pAssignList );
+    free( pEval->state.linebuf );
+}
+
+/*==========================================================================*/
+/*  CloseReadahead                                                          */
+/*!
+    Save the readahead list and release the readahead resources
+
+    The CloseReadahead function saves the list of files opened by this
+    run for the next run's readahead.  The list file is only written
+    if it has changed, to avoid unnecessary writes to flash storage.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+============================================================================*/
+static void CloseReadahead( LoadState *pState )
+{
+    int rc;
+
+    if ( ( pState->pReadahead != NULL ) &&
+         ( READAHEAD_Equal( pState->pReadahead,
+                            pState->pPrevReadahead ) == false ) )
     {
-        if ( pState->workbuf != NULL )
+        rc = FILEUTIL_MakeDirs( pState->pCacheDir );
+        if ( rc == EOK )
         {
-            /* Unmap the shared memory object from the virtual
-             * address space of the loadconfig application */
-            munmap( pState->workbuf, pState->workbufSize );
-            pState->workbuf = NULL;
+            rc = READAHEAD_Save( pState->pReadahead,
+                                 pState->pReadaheadFile );
         }
 
-        if ( pState->fd != -1 )
+        if ( rc != EOK )
         {
-            /* close the shared memory file descriptor */
-            close( pState->fd );
+            fprintf( stderr,
+                     "Cannot save readahead list %s: %s\n",
+                     pState->pReadaheadFile,
+                     strerror( rc ) );
         }
-
-        /* unlink the shared memory object name */
-        shm_unlink( pState->clientname );
     }
+
+    READAHEAD_Free( pState->pReadahead );
+    READAHEAD_Free( pState->pPrevReadahead );
+    free( pState->pReadaheadFile );
+
+    pState->pReadahead = NULL;
+    pState->pPrevReadahead = NULL;
+    pState->pReadaheadFile = NULL;
 }
 
 /*==========================================================================*/
-/*  ProcessConfigFile                                                       */
+/*  InitIncremental                                                         */
 /*!
-    Process the specified configuration file
+    Initialize incremental loading
 
-    The ProcessConfigFile function processes a configuration file
-    consisting of lines of directives and variable assignments.
+    The InitIncremental function sets up the tables used to track the
+    assignments made during an incremental run.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
+
+    @retval EOK incremental loading was initialized
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int InitIncremental( LoadState *pState )
+{
+    int result = ENOMEM;
+
+    pState->pAppliedDir = CacheSubDir( pState, APPLIED_DIR );
+    pState->pRunVars = VARTABLE_Create( 0 );
+    pState->pDirty = VARTABLE_Create( 0 );
+    pState->pRemoved = VARTABLE_Create( 0 );
+
+    if ( ( pState->pAppliedDir != NULL ) &&
+         ( pState->pRunVars != NULL ) &&
+         ( pState->pDirty != NULL ) &&
+         ( pState->pRemoved != NULL ) )
+    {
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  CacheSubDir                                                             */
+/*!
+    Construct the name of a subdirectory of the cache directory
 
+    The CacheSubDir function allocates the name of a subdirectory
+    of the cache directory.  The caller must free the returned name.
 
     @param[in]
         pState
@@ -488,245 +5543,309 @@ static void DestroyWorkingBuffer( LoadState *pState )
             loading context
 
     @param[in]
-        filename
-            pointer to the name of the file to load
+        pName
+            pointer to the name of the subdirectory
 
-    @retval EINVAL invalid arguments
-    @retval EOK file processed ok
-    @retval other error as returned by ProcessConfigData
+    @retval pointer to the allocated subdirectory name
+    @retval NULL memory allocation failure
 
 ============================================================================*/
-static int ProcessConfigFile( LoadState *pState, char *filename )
+static char *CacheSubDir( LoadState *pState, char *pName )
 {
-    int result = EINVAL;
-    FILE *fp;
-    char *pConfigData;
-    char *saveFileName;
-    int saveLineNumber;
-    char *pFileName = NULL;
+    size_t len;
+    char *pDir;
 
-    if ( filename != NULL )
+    len = strlen( pState->pCacheDir ) + strlen( pName ) + 2;
+    pDir = malloc( len );
+    if ( pDir != NULL )
     {
-        pFileName = strdup( filename );
+        snprintf( pDir, len, "%s/%s", pState->pCacheDir, pName );
     }
 
-    if ( ( pState != NULL ) &&
-         ( pFileName != NULL ) )
-    {
-        printf("ProcessConfigFile: %s\n", pFileName );
+    return pDir;
+}
 
-        /* save the file name and the line number within that file */
-        saveFileName = pState->pFileName;
-        saveLineNumber = pState->lineno;
+/*==========================================================================*/
+/*  MakeFileDir                                                             */
+/*!
+    Create the directory containing a file
 
-        /* initialize the line number */
-        pState->lineno = 1;
-        pState->pFileName = pFileName;
+    The MakeFileDir function creates the directory which will contain
+    the specified file, including any missing parent directories.
 
-        pConfigData = GetConfigData( pFileName );
-        if( pConfigData != NULL )
-        {
-            result = ProcessConfigData( pState, pConfigData );
-            free( pConfigData );
-        }
-        else if ( pState->required == false )
-        {
-            /* included file doesn't exist - that's ok */
-            result = EOK;
-        }
+    @param[in]
+        pPath
+            pointer to the NUL terminated file name
 
-        /* restore the file name and the line number within that file */
-        pState->pFileName = saveFileName;
-        pState->lineno = saveLineNumber;
+    @retval EOK the directory exists
+    @retval ENOMEM memory allocation failure
+    @retval other error as returned by FILEUTIL_MakeDirs
 
-        if ( result != EOK )
+============================================================================*/
+static int MakeFileDir( char *pPath )
+{
+    int result = ENOMEM;
+    char *pDir;
+    char *p;
+
+    pDir = strdup( pPath );
+    if ( pDir != NULL )
+    {
+        result = EOK;
+
+        p = strrchr( pDir, '/' );
+        if ( ( p != NULL ) && ( p != pDir ) )
         {
-            fprintf(stderr, "Processing incomplete: %s\n", pFileName );
+            *p = '\0';
+            result = FILEUTIL_MakeDirs( pDir );
         }
 
-        free( pFileName );
+        free( pDir );
     }
 
     return result;
 }
 
 /*==========================================================================*/
-/*  ProcessConfigData                                                       */
+/*  ProvenanceFile                                                          */
 /*!
-    Process a buffer of configuration data
-
-    The ProcessConfigData function processes a buffer of configuration
-    data which has typically been loaded from a configuration file.
-    The configuration data consists of lines of directives and
-    variable assignments.  Directives start with an @ symbol, and
-    variable assignments consist of name and value strings separated
-    by white space.
+    Construct the name of the provenance index file
 
+    The ProvenanceFile function allocates the name of the provenance
+    index file specified with the provenance option, or of the default
+    file in the cache directory.  The caller must free the returned name.
 
     @param[in]
         pState
             pointer to the Load state which manages the current
             loading context
 
-    @param[in]
-        pConfigData
-            pointer to the buffer of configuration data to load
+    @retval pointer to the allocated file name
+    @retval NULL memory allocation failure
 
-    @retval EINVAL invalid arguments
-    @retval EOK file processed ok
-    @retval other last error as returned by ProcessConfigLine
+============================================================================*/
+static char *ProvenanceFile( LoadState *pState )
+{
+    return ( pState->pProvenanceFile != NULL )
+                ? strdup( pState->pProvenanceFile )
+                : CacheSubDir( pState, PROVENANCE_FILE );
+}
+
+/*==========================================================================*/
+/*  Coalesce                                                                */
+/*!
+    Coordinate the load with other invocations of the loader
+
+    The Coalesce function returns in the process which should perform
+    the load.  When another invocation is already loading the same
+    configuration, a follow-up load is requested and the process exits,
+    either immediately or, in wait mode, with the status of the
+    follow-up load.  If the lock file cannot be used, the load is
+    performed without coordination.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
 
 ============================================================================*/
-static int ProcessConfigData( LoadState *pState, char *pConfigData )
+static void Coalesce( LoadState *pState )
 {
-    int result = EINVAL;
-    int i = 0;
-    int lineidx = 0;
-    char *pConfigLine;
-    int rc;
-    bool done = false;
+    char *pPath;
+    int status = 0;
+    int rc = ENOMEM;
 
-    if ( ( pState != NULL ) &&
-         ( pConfigData != NULL ) )
+    pPath = ( pState->pLockFile != NULL ) ? strdup( pState->pLockFile )
+                                          : CoalesceLockFile( pState );
+    if ( pPath != NULL )
     {
-        /* assume the result is ok until it is not */
-        result = EOK;
+        rc = COALESCE_Acquire( pPath, pState->coalesceWait, &status );
+        free( pPath );
+    }
 
-        /* process configuration data one line at a time
-         * until we hit a NUL character */
-        while( !done )
+    if ( rc == EALREADY )
+    {
+        if ( pState->verbose == true )
         {
-            if( pConfigData[i] == '\0' )
-            {
-                done = true;
-            }
+            printf( "Load coalesced, exit status %d\n", status );
+        }
 
-            if( ( pConfigData[i] == '\n' ) ||
-                ( pConfigData[i] == '\0' ) )
-            {
-                /* replace the line break with a NUL terminator*/
-                pConfigData[i] = 0;
+        exit( status );
+    }
+    else if ( rc != EOK )
+    {
+        fprintf( stderr,
+                 "Cannot coalesce with other invocations: %s\n",
+                 strerror( rc ) );
+    }
+}
 
-                /* clear the working buffer and reposition
-                 * the write point to the start of the buffer */
-                lseek( pState->fd, 0, SEEK_SET );
-                memset( pState->workbuf, 0, pState->workbufSize );
+/*==========================================================================*/
+/*  CoalesceLockFile                                                        */
+/*!
+    Get the default coalescing lock file of the load
 
-                /* perform expansion of variables within the config line */
-                /* i.e any variables in the form ${varname} will be replaced
-                 * with their values */
-                rc = TEMPLATE_StrToFile( pState->hVarServer,
-                                         &pConfigData[lineidx],
-                                         pState->fd);
-                if ( rc == EOK )
-                {
-                    /* process a configuration line */
-                    rc = ProcessConfigLine( pState, pState->workbuf );
-                    if ( rc != EOK )
-                    {
-                        LogError( pState, "Config warning" );
-                        result = rc;
-                    }
-                }
-                else
-                {
-                    LogError( pState, "Variable Expansion error" );
-                    result = rc;
-                }
+    The CoalesceLockFile function derives the name of the lock file
+    from the root configuration file and the options which change the
+    result of the load, so that only invocations performing the same
+    load coalesce with each other.  The lock directory is created if
+    it does not exist.
+
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
 
-                /* update the line index */
-                lineidx = i + 1;
+    @retval pointer to the allocated lock file name
+    @retval NULL the lock file name could not be created
 
-                /* increment the line number */
-                pState->lineno++;
-            }
+============================================================================*/
+static char *CoalesceLockFile( LoadState *pState )
+{
+    char *pPath = NULL;
+    char *pDir;
+    char key[BUFSIZ];
+    char path[PATH_MAX];
+    char *pFileName;
+    size_t len;
+    size_t i;
 
-            i++;
-        }
+    if ( pState->pFileName == NULL )
+    {
+        pFileName = "";
+    }
+    else if ( realpath( pState->pFileName, path ) != NULL )
+    {
+        pFileName = path;
+    }
+    else
+    {
+        pFileName = pState->pFileName;
     }
 
-    return result;
+    len = snprintf( key,
+                    sizeof( key ),
+                    "%s\nprefix=%s\ndry-run=%d\nincremental=%d,%d",
+                    pFileName,
+                    ( pState->pFilter != NULL ) ? pState->pFilter : "",
+                    pState->dryRun,
+                    pState->incremental,
+                    (int)pState->removedPolicy );
+
+    for ( i = 0; ( i < pState->ntargets ) && ( len < sizeof( key ) ); i++ )
+    {
+        len += snprintf( &key[len],
+                         sizeof( key ) - len,
+                         "\ntarget=%s",
+                         pState->ppTargets[i] );
+    }
+
+    pDir = CacheSubDir( pState, LOCK_DIR );
+    if ( ( pDir != NULL ) &&
+         ( len < sizeof( key ) ) &&
+         ( FILEUTIL_MakeDirs( pDir ) == EOK ) &&
+         ( FILEUTIL_KeyPath( pDir,
+                             key,
+                             LOCK_SUFFIX,
+                             path,
+                             sizeof( path ) ) == EOK ) )
+    {
+        pPath = strdup( path );
+    }
+
+    free( pDir );
+
+    return pPath;
 }
 
 /*==========================================================================*/
-/*  ProcessConfigLine                                                       */
+/*  Why                                                                     */
 /*!
-    Process a line of configuration data
-
-    The ProcessConfigLine function processes a line of configuration
-    data which has typically been loaded from a configuration file.
-    The configuration data consists of either a directives or a
-    variable assignment.  Directives start with an @ symbol, and
-    a variable assignment consists of a name and value string separated
-    by white space.
+    Report which file and line set a variable
 
+    The Why function looks up a variable in the provenance index written
+    by a previous run, and prints the assignment which set its final
+    value and the earlier assignments it overrode.  The configuration
+    is not loaded.
 
     @param[in]
         pState
-            pointer to the Load state which manages the current
-            loading context
-
-    @param[in]
-        pConfigLine
-            pointer to a NUL terminated line of configuration data to load
+            pointer to the load state holding the options
 
-    @retval EINVAL invalid arguments
-    @retval EOK file processed ok
-    @retval other last error as returned by ProcessConfigLine
+    @retval EOK the provenance of the variable was printed
+    @retval ENOENT the variable was not assigned by the previous run
+    @retval ENOMEM memory allocation failure
+    @retval EIO the provenance index could not be opened
 
 ============================================================================*/
-static int ProcessConfigLine( LoadState *pState, char *pConfigLine )
+static int Why( LoadState *pState )
 {
-    int result = EINVAL;
+    int result = ENOMEM;
+    ProvenanceIndex *pIndex = NULL;
+    char *pPath;
 
-    if ( ( pState != NULL ) &&
-         ( pConfigLine != NULL ) )
+    pPath = ProvenanceFile( pState );
+    if ( pPath != NULL )
     {
-        switch( *pConfigLine )
+        pIndex = PROVENANCE_Open( pPath );
+        if ( pIndex == NULL )
         {
-            case '\0':
-            case '#':
-                /* ignore comments and blank lines */
-                result = EOK;
-                break;
-
-            case '@':
-                result = ProcessDirective( pState, pConfigLine );
-                break;
+            fprintf( stderr, "Cannot open provenance index %s\n", pPath );
+            result = EIO;
+        }
+    }
 
-            default:
-                result = ProcessVariableAssignment( pState, pConfigLine );
-                break;
+    if ( pIndex != NULL )
+    {
+        result = PROVENANCE_Print( pIndex, pState->pWhy, stdout );
+        if ( result == ENOENT )
+        {
+            fprintf( stderr,
+                     "%s was not assigned by the last run\n",
+                     pState->pWhy );
         }
+
+        PROVENANCE_Close( pIndex );
     }
 
+    free( pPath );
+
     return result;
 }
 
 /*==========================================================================*/
-/*  ProcessDirective                                                        */
+/*  CloseIncremental                                                        */
 /*!
-    Process a configuration directive
+    Release the incremental loading resources
 
-    The ProcessDirective function processes a configuration directive
-    which could be one of:
+    @param[in]
+        pState
+            pointer to the Load state which manages the current
+            loading context
 
-    @config
-    @include
-    @require
-    @includedir
+============================================================================*/
+static void CloseIncremental( LoadState *pState )
+{
+    free( pState->pAppliedDir );
+    pState->pAppliedDir = NULL;
 
-    @config gives info about a configuration and outputs all data following
-    the directive to the output log
+    VARTABLE_Destroy( pState->pRunVars );
+    VARTABLE_Destroy( pState->pDirty );
+    VARTABLE_Destroy( pState->pRemoved );
 
-    @include specifies the name of an (optional) configuration file to
-    include
+    pState->pRunVars = NULL;
+    pState->pDirty = NULL;
+    pState->pRemoved = NULL;
+}
 
-    @require specifies the name of a configuration file to include.  If
-    the file does not exist, an error is thrown.
+/*==========================================================================*/
+/*  BeginIncrementalFile                                                    */
+/*!
+    Begin incremental processing of a configuration file
 
-    @includedir specifies the name of a directory to scan.  All config
-    files contained in the directory will be loaded.
+    The BeginIncrementalFile function loads the assignments which were
+    applied from the configuration file during the previous run, and
+    prepares to track the assignments parsed from it during this run.
 
     @param[in]
         pState
@@ -734,47 +5853,33 @@ static int ProcessConfigLine( LoadState *pState, char *pConfigLine )
             loading context
 
     @param[in]
-        pConfigDirective
-            pointer to a NUL terminated configuration directive
+        pFileName
+            pointer to the name of the configuration file
 
-    @retval EINVAL invalid arguments
-    @retval EOK the directive was processed ok
-    @retval other error as returned by the directive processing functions
+    @retval EOK incremental processing has started
+    @retval ENOMEM memory allocation failure
 
 ============================================================================*/
-static int ProcessDirective( LoadState *pState, char *pConfigDirective )
+static int BeginIncrementalFile( LoadState *pState, char *pFileName )
 {
-    int result = EINVAL;
-    char *pArg = NULL;
-    char *pDirective;
+    int result = EOK;
 
-    if ( ( pState != NULL ) &&
-         ( pConfigDirective != NULL ) )
+    pState->pApplied = NULL;
+    pState->pParsed = NULL;
+
+    if ( pState->incremental == true )
     {
-        /* get the directive and its argument */
-        pDirective = strtok_r( pConfigDirective, " ", &pArg );
+        pState->pApplied = APPLIED_Load( pState->pAppliedDir, pFileName );
+        pState->pParsed = VARTABLE_Create( 0 );
 
-        /* act on the directive */
-        if ( strcmp( pConfigDirective, "@config") == 0 )
-        {
-            result = ProcessConfigDirective( pState, pArg );
-        }
-        else if ( strcmp( pConfigDirective, "@include" ) == 0 )
+        if ( ( pState->pApplied == NULL ) ||
+             ( pState->pParsed == NULL ) )
         {
-            result = ProcessIncludeDirective( pState, pArg );
-        }
-        else if ( strcmp( pConfigDirective, "@require" ) == 0 )
-        {
-            result = ProcessRequireDirective( pState, pArg );
-        }
-        else if ( strcmp( pConfigDirective, "@includedir" ) == 0 )
-        {
-            result = ProcessIncludeDirDirective( pState, pArg );
-        }
-        else
-        {
-            LogError( pState, "unknown directive" );
-            result = ENOTSUP;
+            VARTABLE_Destroy( pState->pApplied );
+            VARTABLE_Destroy( pState->pParsed );
+            pState->pApplied = NULL;
+            pState->pParsed = NULL;
+            result = ENOMEM;
         }
     }
 
@@ -782,13 +5887,13 @@ static int ProcessDirective( LoadState *pState, char *pConfigDirective )
 }
 
 /*==========================================================================*/
-/*  ProcessConfigDirective                                                  */
+/*  EndIncrementalFile                                                      */
 /*!
-    Process a configuration directive
+    End incremental processing of a configuration file
 
-    The ProcessConfigDirective treats everything following the @config
-    directive as a notice, and outputs it to the standard output.
-    It is used to track the loading process of the system configuration.
+    The EndIncrementalFile function records the variables whose
+    assignments have been removed from the configuration file since
+    the previous run, and saves the assignments applied during this run.
 
     @param[in]
         pState
@@ -796,135 +5901,180 @@ static int ProcessDirective( LoadState *pState, char *pConfigDirective )
             loading context
 
     @param[in]
-        pInfo
-            pointer to the configuration information to output
-
-    @retval EINVAL invalid arguments
-    @retval EOK the directive was processed ok
+        pFileName
+            pointer to the name of the configuration file
 
 ============================================================================*/
-static int ProcessConfigDirective( LoadState *pState, char *pInfo )
+static void EndIncrementalFile( LoadState *pState, char *pFileName )
 {
-    int result = EINVAL;
+    int rc;
 
-    if ( ( pState != NULL ) &&
-         ( pInfo != NULL ) )
+    if ( ( pState->pApplied != NULL ) &&
+         ( pState->pParsed != NULL ) )
     {
-        result = EOK;
+        VARTABLE_ForEach( pState->pApplied, FindRemoved, pState );
 
-        if ( pState->verbose == true )
+        rc = APPLIED_Save( pState->pAppliedDir, pFileName, pState->pParsed );
+        if ( ( rc != EOK ) && ( pState->verbose == true ) )
         {
-            fprintf( stdout, "Processing %s\n", pInfo );
+            fprintf( stderr,
+                     "Cannot save applied state for %s: %s\n",
+                     pFileName,
+                     strerror( rc ) );
         }
     }
 
-    return result;
+    VARTABLE_Destroy( pState->pApplied );
+    VARTABLE_Destroy( pState->pParsed );
+    pState->pApplied = NULL;
+    pState->pParsed = NULL;
 }
 
 /*==========================================================================*/
-/*  ProcessIncludeDirective                                                 */
+/*  FindRemoved                                                             */
 /*!
-    Process an @include configuration directive
+    Check if a previously applied assignment has been removed
 
-    The ProcessIncludeDirective treats everything following the @include
-    directive as an include file path, and tries to load the include
-    file as a configuration file.
+    The FindRemoved function is called for each assignment applied from
+    a configuration file during the previous run.  Assignments which were
+    not parsed from the file during this run are added to the table of
+    removed variables.
 
     @param[in]
-        pState
-            pointer to the Load state which manages the current
-            loading context
+        pEntry
+            pointer to the previously applied assignment
 
     @param[in]
-        pFilename
-            pointer to the configuration file name
+        arg
+            pointer to the Load state
 
-    @retval EINVAL invalid arguments
-    @retval EOK the directive was processed ok
+    @retval EOK always
 
 ============================================================================*/
-static int ProcessIncludeDirective( LoadState *pState, char *pFilename )
+static int FindRemoved( VarEntry *pEntry, void *arg )
 {
-    int result = EINVAL;
+    LoadState *pState = (LoadState *)arg;
 
-    if ( ( pState != NULL ) &&
-         ( pFilename != NULL ) )
+    if ( VARTABLE_Find( pState->pParsed, pEntry->name ) == NULL )
     {
-        /* included files are not mandatory */
-        pState->required = false;
-
-        if( pState->verbose == true )
-        {
-            fprintf( stdout, "Including %s\n", pFilename );
-        }
-
-        /* recursively process a new configuration file */
-        result = ProcessConfigFile( pState, pFilename );
-
+        VARTABLE_Set( pState->pRemoved, pEntry->name, "" );
     }
 
-    return result;
+    return EOK;
 }
 
 /*==========================================================================*/
-/*  ProcessRequireDirective                                                 */
+/*  ApplyRemoved                                                            */
 /*!
-    Process a @require configuration directive
+    Handle a variable whose assignment was removed
 
-    The ProcessRequireDirective treats everything following the @require
-    directive as an include file path, and tries to load the include
-    file as a configuration file.
+    The ApplyRemoved function is called at the end of an incremental run
+    for each variable whose assignment was removed from a configuration
+    file since the previous run.
 
-    The difference between @include and @require is that @require'd
-    configurations must exist and load successfully
+    If the variable is still assigned elsewhere in the configuration
+    tree, and was not written during this run, its final value is sent
+    again since the removed assignment may have overridden it.
+    Otherwise the removed policy is applied.
 
     @param[in]
-        pState
-            pointer to the Load state which manages the current
-            loading context
+        pEntry
+            pointer to the removed variable
 
     @param[in]
-        pFilename
-            pointer to the configuration file name
+        arg
+            pointer to the Load state
 
-    @retval EINVAL invalid arguments
-    @retval EOK the directive was processed ok
+    @retval EOK the removed variable was handled ok
+    @retval other error as returned by VARCALL_SetNameValue
 
 ============================================================================*/
-static int ProcessRequireDirective( LoadState *pState, char *pFilename )
+static int ApplyRemoved( VarEntry *pEntry, void *arg )
 {
-    int result = EINVAL;
-
-    if ( ( pState != NULL ) &&
-         ( pFilename != NULL ) )
+    LoadState *pState = (LoadState *)arg;
+    int result = EOK;
+    char *pValue = NULL;
+    char *pOldValue = NULL;
+    uint64_t start;
+    PerfMark mark;
+
+    if ( VARTABLE_Find( pState->pDirty, pEntry->name ) != NULL )
     {
-        /* included files are not mandatory */
-        pState->required = true;
-
-        if( pState->verbose == true )
+        /* the variable already has its final value */
+    }
+    else if ( ( pValue = VARTABLE_Get( pState->pRunVars,
+                                       pEntry->name ) ) != NULL )
+    {
+        if ( pState->verbose == true )
         {
-            fprintf( stdout, "Including %s\n", pFilename );
+            fprintf( stdout, "Restoring %s to %s\n", pEntry->name, pValue );
         }
+    }
+    else if ( pState->removedPolicy == REMOVED_WARN )
+    {
+        fprintf( stderr, "Assignment removed: '%s'\n", pEntry->name );
+    }
+    else if ( pState->removedPolicy == REMOVED_CLEAR )
+    {
+        if ( pState->verbose == true )
+        {
+            fprintf( stdout, "Clearing %s\n", pEntry->name );
+        }
+
+        pValue = "";
+    }
 
-        /* recursively process a new configuration file */
-        result = ProcessConfigFile( pState, pFilename );
+    if ( ( pValue != NULL ) && ( pState->pFeed != NULL ) )
+    {
+        pOldValue = LiveValue( pState, pEntry->name );
+    }
 
+    if ( pValue != NULL )
+    {
+        start = METRICS_Now();
+        PERFCOUNT_Enter( pState->pPerf, NULL, PERF_PHASE_WRITE, &mark );
+        result = VARCALL_SetNameValue( pState->pVarCall,
+                                       pEntry->name,
+                                       pValue,
+                                       pState->pFileName,
+                                       0 );
+        PERFCOUNT_Leave( pState->pPerf, &mark );
+        METRICS_AddPhase( &pState->metrics, METRICS_PHASE_WRITE, start );
+
+        if ( result == EOK )
+        {
+            pState->metrics.applied++;
+            JOURNAL_Append( pState->pJournal, pEntry->name, pValue );
+            FEED_Event( pState->pFeed,
+                        pEntry->name,
+                        ( pOldValue != NULL ) ? pOldValue : "",
+                        pValue,
+                        pState->pFileName,
+                        0 );
+        }
+        else
+        {
+            fprintf( stderr,
+                     "Variable assignment failed: '%s'\n",
+                     pEntry->name );
+        }
     }
 
+    free( pOldValue );
+
     return result;
 }
 
 /*==========================================================================*/
-/*  ProcessIncludeDirDirective                                              */
+/*  IsUnchanged                                                             */
 /*!
-    Process an @includedir configuration directive
-
-    The ProcessIncludeDirDirective treats everything following the @require
-    directive as an include directory path, and tries to load all of the
-    files in that directory as config files.
+    Check if an assignment is unchanged since the previous run
 
-    Failed configuration files are ignored and do not affect the error
-    return of this function
+    The IsUnchanged function determines if an assignment can be skipped
+    in incremental mode.  An assignment is skipped if it was applied with
+    the same value from the same file during the previous run, and the
+    variable has not already been written during this run (in which case
+    this assignment is needed to restore its final value).
 
     @param[in]
         pState
@@ -932,42 +6082,30 @@ static int ProcessRequireDirective( LoadState *pState, char *pFilename )
             loading context
 
     @param[in]
-        pDirname
-            pointer to the configuration directory name
+        pVar
+            pointer to the variable name
 
-    @retval EINVAL invalid arguments
-    @retval EOK the directive was processed ok
+    @param[in]
+        pVal
+            pointer to the expanded variable value
+
+    @retval true the assignment is unchanged and can be skipped
+    @retval false the assignment must be sent
 
 ============================================================================*/
-static int ProcessIncludeDirDirective( LoadState *pState, char *pDirname )
+static bool IsUnchanged( LoadState *pState, char *pVar, char *pVal )
 {
-    int result = EINVAL;
-    DIR *configdir = NULL;
-    struct dirent *entry;
+    bool result = false;
+    char *pPrevious;
 
-    if ( ( pState != NULL ) &&
-         ( pDirname != NULL ) )
+    if ( pState->pApplied != NULL )
     {
-        result = EOK;
-
-        if( pState->verbose == true )
-        {
-            fprintf( stdout, "Processing directory: %s\n", pDirname );
-        }
-
-        configdir = opendir( pDirname );
-        if( configdir != NULL )
+        pPrevious = VARTABLE_Get( pState->pApplied, pVar );
+        if ( ( pPrevious != NULL ) &&
+             ( strcmp( pPrevious, pVal ) == 0 ) &&
+             ( VARTABLE_Find( pState->pDirty, pVar ) == NULL ) )
         {
-            while( entry = readdir( configdir ) )
-            {
-                /* included directories are not mandatory */
-                pState->required = false;
-
-                /* process configuration file */
-                ProcessConfigFile( pState, entry->d_name );
-            }
-
-            closedir( configdir );
+            result = true;
         }
     }
 
@@ -975,15 +6113,13 @@ static int ProcessIncludeDirDirective( LoadState *pState, char *pDirname )
 }
 
 /*==========================================================================*/
-/*  ProcessVariableAssignment                                               */
+/*  TrackAssignment                                                         */
 /*!
-    Process a configuration variable assignment
+    Track an assignment in incremental mode
 
-    The ProcessVariableAssignment function assumes that the configuration
-    line consistes of a variable name and variable value separatted by
-    a space.
-
-    It sets the variable to the specified value.
+    The TrackAssignment function records an assignment parsed from the
+    current configuration file so it can be compared against on the
+    next run.
 
     @param[in]
         pState
@@ -991,61 +6127,46 @@ static int ProcessIncludeDirDirective( LoadState *pState, char *pDirname )
             loading context
 
     @param[in]
-        pConfig
-            pointer to the configuration var/value to process
+        pVar
+            pointer to the variable name
 
-    @retval EINVAL invalid arguments or invalid variable assignment
-    @retval EOK the variable assignment was processed ok
-    @retval other error as returned by VAR_SetNameValue
+    @param[in]
+        pVal
+            pointer to the expanded variable value
+
+    @param[in]
+        sent
+            true if the assignment was sent to the variable server
+
+    @param[in]
+        rc
+            result of sending the assignment
 
 ============================================================================*/
-static int ProcessVariableAssignment( LoadState *pState, char *pConfig )
+static void TrackAssignment( LoadState *pState,
+                             char *pVar,
+                             char *pVal,
+                             bool sent,
+                             int rc )
 {
-    int result = EINVAL;
-    char *pVar = NULL;
-    char *pVal = NULL;
-    char *ch = " ";
+    VarEntry *pEntry;
 
-    if ( ( pState != NULL ) &&
-         ( pConfig != NULL ) )
+    if ( pState->pParsed != NULL )
     {
-        /* check if we have an = delimeter */
-        if ( strchr( pConfig, '=' ) != NULL )
-        {
-            ch = "=";
-        }
-
-        /* get the variable and its value */
-        pVar = strtok_r( pConfig, ch, &pVal );
+        VARTABLE_Set( pState->pRunVars, pVar, pVal );
+        VARTABLE_Set( pState->pParsed, pVar, pVal );
 
-        if ( ( pVar != NULL ) &&
-             ( pVal != NULL ) )
+        pEntry = VARTABLE_Find( pState->pParsed, pVar );
+        if ( pEntry != NULL )
         {
-            if( pState->verbose == true )
-            {
-                fprintf( stdout, "Setting %s to %s\n", pVar, pVal );
-            }
-
-            result = VAR_SetNameValue( pState->hVarServer, pVar, pVal );
-            if( result != EOK )
-            {
-                if ( result == ENOENT )
-                {
-                    LogVarError( pState, pVar, "Variable not found" );
-                }
-                else
-                {
-                    LogVarError( pState, pVar, "Variable assignment failed" );
-                }
-            }
+            pEntry->flags = ( rc == EOK ) ? 0 : APPLIED_FLAG_FAILED;
         }
-        else
+
+        if ( ( sent == true ) && ( rc == EOK ) )
         {
-            LogError( pState, "Invalid Variable Assignment" );
+            VARTABLE_Set( pState->pDirty, pVar, "" );
         }
     }
-
-    return result;
 }
 
 /*==========================================================================*/
@@ -1132,6 +6253,67 @@ void LogVarError( LoadState *pState, char *varname, char *error )
     }
 }
 
+/*==========================================================================*/
+/*  LoadConfigData                                                          */
+/*!
+    Load the content of a configuration file
+
+    The LoadConfigData function reads a configuration file, recording
+    its contents if variable server calls are being recorded.  When a log
+    is being replayed, the contents are taken from the log instead.
+    When a configuration tree root is set, absolute file names are read
+    from within the root.
+
+    @param[in]
+        pState
+            pointer to the load state
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the configuration file
+
+    @retval pointer to the configuration data
+    @retval NULL the file is not a configuration file or does not exist
+
+============================================================================*/
+static char *LoadConfigData( LoadState *pState, char *pFileName )
+{
+    char *pConfigData;
+    VarLog *pLog = pState->callOptions.pLog;
+    uint64_t start = METRICS_Now();
+    char path[PATH_MAX];
+
+    if ( VARLOG_IsReplay( pLog ) == true )
+    {
+        pConfigData = VARLOG_GetFile( pLog, pFileName );
+    }
+    else if ( ( pState->pRoot != NULL ) &&
+              ( pFileName[0] == '/' ) )
+    {
+        /* read absolute file names from within the tree root */
+        pConfigData = ( snprintf( path,
+                                  sizeof( path ),
+                                  "%s%s",
+                                  pState->pRoot,
+                                  pFileName ) < (int)sizeof( path ) )
+                        ? GetConfigData( path )
+                        : NULL;
+    }
+    else
+    {
+        pConfigData = GetConfigData( pFileName );
+        VARLOG_Add( pLog,
+                    VARLOG_FILE,
+                    ( pConfigData != NULL ) ? EOK : ENOENT,
+                    METRICS_Now() - start,
+                    pFileName,
+                    pConfigData,
+                    ( pConfigData != NULL ) ? strlen( pConfigData ) : 0 );
+    }
+
+    return pConfigData;
+}
+
 /*==========================================================================*/
 /*  GetConfigData                                                           */
 /*!
@@ -0,0 +1,300 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup metrics metrics
+ * @brief Run metrics
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file metrics.c
+
+    Run Metrics
+
+    The Run Metrics functions measure the time spent in each phase of
+    a configuration load and count the work done, and publish the
+    results as variables on the variable server at the end of the run
+    so they are visible to fleet monitoring.
+
+    All of the metrics are written together once the configuration
+    has been loaded, so publishing them does not affect the phase
+    timings.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include "metrics.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! nanoseconds per microsecond */
+#define NS_PER_US   1000ULL
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static void Publish( VarCall *pVarCall,
+                     char *pPrefix,
+                     char *pName,
+                     unsigned long long value,
+                     int *pResult );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  METRICS_Init                                                            */
+/*!
+    Initialize the run metrics
+
+    The METRICS_Init function clears the run metrics and records
+    the start time of the run.
+
+    @param[in]
+        pMetrics
+            pointer to the run metrics
+
+============================================================================*/
+void METRICS_Init( Metrics *pMetrics )
+{
+    if ( pMetrics != NULL )
+    {
+        memset( pMetrics, 0, sizeof( Metrics ) );
+        pMetrics->start = METRICS_Now();
+    }
+}
+
+/*==========================================================================*/
+/*  METRICS_Now                                                             */
+/*!
+    Get the current monotonic time
+
+    @retval current monotonic time in nanoseconds
+
+============================================================================*/
+uint64_t METRICS_Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*==========================================================================*/
+/*  METRICS_AddPhase                                                        */
+/*!
+    Add the time since the specified start time to a phase
+
+    @param[in]
+        pMetrics
+            pointer to the run metrics
+
+    @param[in]
+        phase
+            phase to add the time to
+
+    @param[in]
+        start
+            start time as returned by METRICS_Now
+
+============================================================================*/
+void METRICS_AddPhase( Metrics *pMetrics, MetricsPhase phase, uint64_t start )
+{
+    if ( ( pMetrics != NULL ) &&
+         ( phase < METRICS_NUM_PHASES ) )
+    {
+        pMetrics->phaseNs[phase] += METRICS_Now() - start;
+    }
+}
+
+/*==========================================================================*/
+/*  METRICS_Publish                                                         */
+/*!
+    Publish the run metrics
+
+    The METRICS_Publish function writes the run metrics to variables
+    on the variable server whose names start with the specified prefix:
+
+    duration_us : total run duration
+    io_us : time spent reading configuration files
+    parse_us : time spent scanning configuration files
+    expand_us : time spent expanding variable references
+    write_us : time spent writing variables
+    files : number of configuration files loaded
+    applied : number of assignments applied
+    skipped : number of unchanged assignments skipped
+    errors : number of configuration lines which failed
+    cache_hit_rate : parse cache hit rate in percent
+    call_p50_us : median variable server call latency
+    call_p99_us : 99th percentile variable server call latency
+
+    @param[in]
+        pMetrics
+            pointer to the run metrics
+
+    @param[in]
+        pVarCall
+            pointer to the variable server call context
+
+    @param[in]
+        pPrefix
+            pointer to the NUL terminated metric variable name prefix
+
+    @retval EOK the metrics were published
+    @retval EINVAL invalid arguments
+    @retval other error as returned by VARCALL_SetNameValue
+
+============================================================================*/
+int METRICS_Publish( Metrics *pMetrics, VarCall *pVarCall, char *pPrefix )
+{
+    int result = EINVAL;
+    uint64_t durationNs;
+    unsigned long long hitrate;
+    unsigned long long p50;
+    unsigned long long p99;
+
+    if ( ( pMetrics != NULL ) &&
+         ( pVarCall != NULL ) &&
+         ( pPrefix != NULL ) )
+    {
+        result = EOK;
+
+        /* capture every value before any of them are written */
+        durationNs = METRICS_Now() - pMetrics->start;
+        hitrate = ( pMetrics->cacheLookups > 0 )
+                    ? pMetrics->cacheHits * 100 / pMetrics->cacheLookups
+                    : 0;
+        p50 = VARCALL_Percentile( pVarCall, 50 );
+        p99 = VARCALL_Percentile( pVarCall, 99 );
+
+        Publish( pVarCall, pPrefix, "duration_us",
+                 durationNs / NS_PER_US, &result );
+        Publish( pVarCall, pPrefix, "io_us",
+                 pMetrics->phaseNs[METRICS_PHASE_IO] / NS_PER_US, &result );
+        Publish( pVarCall, pPrefix, "parse_us",
+                 pMetrics->phaseNs[METRICS_PHASE_PARSE] / NS_PER_US, &result );
+        Publish( pVarCall, pPrefix, "expand_us",
+                 pMetrics->phaseNs[METRICS_PHASE_EXPAND] / NS_PER_US, &result );
+        Publish( pVarCall, pPrefix, "write_us",
+                 pMetrics->phaseNs[METRICS_PHASE_WRITE] / NS_PER_US, &result );
+        Publish( pVarCall, pPrefix, "files", pMetrics->files, &result );
+        Publish( pVarCall, pPrefix, "applied", pMetrics->applied, &result );
+        Publish( pVarCall, pPrefix, "skipped", pMetrics->skipped, &result );
+        Publish( pVarCall, pPrefix, "errors", pMetrics->errors, &result );
+        Publish( pVarCall, pPrefix, "cache_hit_rate", hitrate, &result );
+        Publish( pVarCall, pPrefix, "call_p50_us", p50, &result );
+        Publish( pVarCall, pPrefix, "call_p99_us", p99, &result );
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  Publish                                                                 */
+/*!
+    Publish a single metric
+
+    @param[in]
+        pVarCall
+            pointer to the variable server call context
+
+    @param[in]
+        pPrefix
+            pointer to the NUL terminated metric variable name prefix
+
+    @param[in]
+        pName
+            pointer to the NUL terminated metric name
+
+    @param[in]
+        value
+            value of the metric
+
+    @param[in,out]
+        pResult
+            pointer to the publish result, which is updated if the
+            metric cannot be published
+
+============================================================================*/
+static void Publish( VarCall *pVarCall,
+                     char *pPrefix,
+                     char *pName,
+                     unsigned long long value,
+                     int *pResult )
+{
+    int rc = ENAMETOOLONG;
+    char name[PATH_MAX];
+    char buf[32];
+
+    if ( snprintf( name, sizeof( name ), "%s%s", pPrefix, pName ) <
+            (int)sizeof( name ) )
+    {
+        snprintf( buf, sizeof( buf ), "%llu", value );
+
+        rc = VARCALL_SetNameValue( pVarCall, name, buf, NULL, 0 );
+        if ( rc == EINPROGRESS )
+        {
+            rc = EOK;
+        }
+    }
+
+    if ( rc != EOK )
+    {
+        fprintf( stderr,
+                 "Cannot publish metric %s%s: %s\n",
+                 pPrefix,
+                 pName,
+                 strerror( rc ) );
+        *pResult = rc;
+    }
+}
+
+/*! @}
+ * end of metrics group */
@@ -0,0 +1,373 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup options options
+ * @brief Reentrant command line option parser
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file options.c
+
+    Reentrant Command Line Option Parser
+
+    The Command Line Option Parser functions parse short and long options
+    in the same format as getopt_long, but keep all of their state in
+    the caller's parser object instead of the getopt globals, so that
+    options can be parsed by several threads at once.
+
+    Arguments which are not options are skipped.  Parsing stops at
+    the end of the arguments or at "--".
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "options.h"
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int NextLong( OptionParser *pParser );
+static int NextShort( OptionParser *pParser );
+static const struct option *FindLong( const struct option *pLong,
+                                      char *pName,
+                                      size_t len );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  OPTIONS_Init                                                            */
+/*!
+    Initialize a command line option parser
+
+    @param[in]
+        pParser
+            pointer to the parser to initialize
+
+    @param[in]
+        argc
+            number of arguments (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the arguments
+
+    @param[in]
+        pShort
+            pointer to the short options in getopt format
+
+    @param[in]
+        pLong
+            pointer to the long options, or NULL for none
+
+============================================================================*/
+void OPTIONS_Init( OptionParser *pParser,
+                   int argc,
+                   char **argv,
+                   const char *pShort,
+                   const struct option *pLong )
+{
+    if ( pParser != NULL )
+    {
+        pParser->argc = argc;
+        pParser->argv = argv;
+        pParser->pShort = ( pShort != NULL ) ? pShort : "";
+        pParser->pLong = pLong;
+        pParser->index = 1;
+        pParser->pos = 0;
+        pParser->pArg = NULL;
+    }
+}
+
+/*==========================================================================*/
+/*  OPTIONS_Next                                                            */
+/*!
+    Get the next command line option
+
+    The OPTIONS_Next function gets the next option and stores its
+    argument, if any, in the parser's pArg member.  On return the
+    parser's index member refers to the argument following the option,
+    so a caller may consume additional arguments by advancing it.
+
+    @param[in]
+        pParser
+            pointer to the parser
+
+    @retval option character, or the value of the long option
+    @retval '?' unknown option or missing option argument
+    @retval -1 there are no more options
+
+============================================================================*/
+int OPTIONS_Next( OptionParser *pParser )
+{
+    int c = -1;
+    char *pArg;
+    bool found = false;
+
+    while ( ( pParser != NULL ) &&
+            ( found == false ) &&
+            ( pParser->index < pParser->argc ) )
+    {
+        pArg = pParser->argv[pParser->index];
+        pParser->pArg = NULL;
+
+        if ( pParser->pos > 0 )
+        {
+            c = NextShort( pParser );
+            found = true;
+        }
+        else if ( strcmp( pArg, "--" ) == 0 )
+        {
+            /* end of the options */
+            pParser->index++;
+            break;
+        }
+        else if ( strncmp( pArg, "--", 2 ) == 0 )
+        {
+            c = NextLong( pParser );
+            found = true;
+        }
+        else if ( ( pArg[0] == '-' ) &&
+                  ( pArg[1] != '\0' ) )
+        {
+            pParser->pos = 1;
+            c = NextShort( pParser );
+            found = true;
+        }
+        else
+        {
+            /* skip arguments which are not options */
+            pParser->index++;
+        }
+    }
+
+    return ( found == true ) ? c : -1;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  NextLong                                                                */
+/*!
+    Parse a long option
+
+    A long option may be abbreviated to any unique prefix.  A required
+    argument follows an '=' or is the next argument.  An optional
+    argument must follow an '='.
+
+    @param[in]
+        pParser
+            pointer to the parser, whose current argument is a long option
+
+    @retval value of the long option
+    @retval '?' unknown option or invalid option argument
+
+============================================================================*/
+static int NextLong( OptionParser *pParser )
+{
+    int c = '?';
+    char *pName = &pParser->argv[pParser->index++][2];
+    char *pValue = strchr( pName, '=' );
+    size_t len = ( pValue != NULL ) ? (size_t)( pValue - pName )
+                                    : strlen( pName );
+    const struct option *pOption;
+
+    pOption = FindLong( pParser->pLong, pName, len );
+    if ( pOption == NULL )
+    {
+        fprintf( stderr,
+                 "%s: unrecognized option '--%.*s'\n",
+                 pParser->argv[0],
+                 (int)len,
+                 pName );
+    }
+    else if ( ( pOption->has_arg == no_argument ) &&
+              ( pValue != NULL ) )
+    {
+        fprintf( stderr,
+                 "%s: option '--%s' doesn't allow an argument\n",
+                 pParser->argv[0],
+                 pOption->name );
+    }
+    else if ( pValue != NULL )
+    {
+        pParser->pArg = pValue + 1;
+        c = pOption->val;
+    }
+    else if ( pOption->has_arg != required_argument )
+    {
+        c = pOption->val;
+    }
+    else if ( pParser->index < pParser->argc )
+    {
+        pParser->pArg = pParser->argv[pParser->index++];
+        c = pOption->val;
+    }
+    else
+    {
+        fprintf( stderr,
+                 "%s: option '--%s' requires an argument\n",
+                 pParser->argv[0],
+                 pOption->name );
+    }
+
+    return c;
+}
+
+/*==========================================================================*/
+/*  NextShort                                                               */
+/*!
+    Parse a short option
+
+    Short options may be grouped in a single argument.  A required
+    argument is the rest of the argument or the next argument.
+    An optional argument must be the rest of the argument.
+
+    @param[in]
+        pParser
+            pointer to the parser, whose current position is a short option
+
+    @retval option character
+    @retval '?' unknown option or missing option argument
+
+============================================================================*/
+static int NextShort( OptionParser *pParser )
+{
+    char *pArg = pParser->argv[pParser->index];
+    int c = (unsigned char)pArg[pParser->pos++];
+    char *pSpec = ( c != ':' ) ? strchr( pParser->pShort, c ) : NULL;
+    bool last = ( pArg[pParser->pos] == '\0' );
+
+    if ( pSpec == NULL )
+    {
+        fprintf( stderr,
+                 "%s: invalid option -- '%c'\n",
+                 pParser->argv[0],
+                 c );
+        c = '?';
+    }
+    else if ( pSpec[1] != ':' )
+    {
+        /* option without an argument */
+    }
+    else if ( last == false )
+    {
+        /* the argument is the rest of this argument */
+        pParser->pArg = &pArg[pParser->pos];
+        last = true;
+    }
+    else if ( pSpec[2] == ':' )
+    {
+        /* the optional argument was not specified */
+    }
+    else if ( pParser->index + 1 < pParser->argc )
+    {
+        pParser->pArg = pParser->argv[++pParser->index];
+    }
+    else
+    {
+        fprintf( stderr,
+                 "%s: option requires an argument -- '%c'\n",
+                 pParser->argv[0],
+                 c );
+        c = '?';
+    }
+
+    if ( last == true )
+    {
+        /* move on to the next argument */
+        pParser->index++;
+        pParser->pos = 0;
+    }
+
+    return c;
+}
+
+/*==========================================================================*/
+/*  FindLong                                                                */
+/*!
+    Find a long option by name or unique prefix
+
+    @param[in]
+        pLong
+            pointer to the long options, or NULL
+
+    @param[in]
+        pName
+            pointer to the option name
+
+    @param[in]
+        len
+            length of the option name
+
+    @retval pointer to the matching long option
+    @retval NULL there is no matching option, or the prefix is ambiguous
+
+============================================================================*/
+static const struct option *FindLong( const struct option *pLong,
+                                      char *pName,
+                                      size_t len )
+{
+    const struct option *pMatch = NULL;
+    int matches = 0;
+
+    while ( ( pLong != NULL ) &&
+            ( pLong->name != NULL ) )
+    {
+        if ( strncmp( pLong->name, pName, len ) == 0 )
+        {
+            if ( pLong->name[len] == '\0' )
+            {
+                /* exact match */
+                pMatch = pLong;
+                matches = 1;
+                break;
+            }
+
+            pMatch = pLong;
+            matches++;
+        }
+
+        pLong++;
+    }
+
+    return ( matches == 1 ) ? pMatch : NULL;
+}
+
+/*! @}
+ * end of options group */
@@ -0,0 +1,421 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup pacer pacer
+ * @brief Adaptive write pacing
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file pacer.c
+
+    Adaptive Write Pacing
+
+    The Adaptive Write Pacing functions spread variable writes out into
+    batches separated by gaps, so that a large load does not monopolize
+    the variable server while other clients are using it.
+
+    The controller tracks the 90th percentile latency of the most recent
+    writes.  At the end of each batch, if that latency is above the
+    target, the batch size is halved and the gap is doubled.  Otherwise
+    the batch size grows by one write and the gap shrinks by a quarter.
+    A target below twice the fastest write seen is treated as that
+    value, since pacing cannot make the server faster than it is idle.
+
+    In idle priority mode, the controller also treats any write which
+    takes much longer than the fastest write seen so far as a sign that
+    other clients are being served, and backs off to single writes with
+    a rapidly growing gap until the latency recovers.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "pacer.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+/*! number of recent write latencies tracked */
+#define PACER_WINDOW            32
+
+/*! percentile of the recent write latencies compared to the target */
+#define PACER_PERCENTILE        90
+
+/*! maximum number of writes in a batch */
+#define PACER_MAX_BATCH         64
+
+/*! smallest non-zero gap between batches in microseconds */
+#define PACER_MIN_GAP_US        1000
+
+/*! largest gap between batches in microseconds */
+#define PACER_MAX_GAP_US        200000
+
+/*! largest gap between batches in idle priority mode in microseconds */
+#define PACER_IDLE_MAX_GAP_US   1000000
+
+/*! latency increase over the fastest write which indicates other
+    clients are active, as a multiple of the fastest write */
+#define PACER_IDLE_FACTOR       2
+
+/*! latency increase over the fastest write which is ignored in
+    idle priority mode in microseconds */
+#define PACER_IDLE_SLACK_US     50
+
+/*! nanoseconds per microsecond */
+#define NS_PER_US               1000ULL
+
+/*! write pacing controller */
+struct _Pacer
+{
+    /*! target write latency in microseconds, or 0 for none */
+    uint32_t targetUs;
+
+    /*! back off whenever other clients are active */
+    bool idle;
+
+    /*! most recent write latencies in microseconds */
+    uint32_t window[PACER_WINDOW];
+
+    /*! number of latencies recorded */
+    uint64_t samples;
+
+    /*! fastest write latency seen in microseconds */
+    uint32_t fastestUs;
+
+    /*! number of writes per batch */
+    uint32_t batch;
+
+    /*! number of writes made in the current batch */
+    uint32_t count;
+
+    /*! gap between batches in microseconds */
+    uint32_t gapUs;
+
+    /*! number of completed batches */
+    uint64_t batches;
+
+    /*! number of times the controller backed off */
+    uint64_t backoffs;
+
+    /*! total time spent in gaps in microseconds */
+    uint64_t pausedUs;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static void Adjust( Pacer *pPacer );
+static uint32_t Percentile( Pacer *pPacer, unsigned int percentile );
+static int CompareLatency( const void *p1, const void *p2 );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  PACER_Create                                                            */
+/*!
+    Create a write pacing controller
+
+    @param[in]
+        targetUs
+            target write latency in microseconds, or 0 for none
+
+    @param[in]
+        idle
+            true to back off whenever other clients are active
+
+    @retval pointer to the write pacing controller
+    @retval NULL memory allocation failure
+
+============================================================================*/
+Pacer *PACER_Create( uint32_t targetUs, bool idle )
+{
+    Pacer *pPacer;
+
+    pPacer = calloc( 1, sizeof( Pacer ) );
+    if ( pPacer != NULL )
+    {
+        pPacer->targetUs = targetUs;
+        pPacer->idle = idle;
+        pPacer->fastestUs = UINT32_MAX;
+        pPacer->batch = 1;
+    }
+
+    return pPacer;
+}
+
+/*==========================================================================*/
+/*  PACER_Delay                                                             */
+/*!
+    Get the time to wait before the next write
+
+    The PACER_Delay function counts the next write against the current
+    batch.  When the batch is complete, the batch size and gap are
+    adjusted and the gap is returned.
+
+    @param[in]
+        pPacer
+            pointer to the write pacing controller
+
+    @retval time to wait before the next write in nanoseconds
+
+============================================================================*/
+uint64_t PACER_Delay( Pacer *pPacer )
+{
+    uint64_t delay = 0;
+
+    if ( pPacer != NULL )
+    {
+        if ( pPacer->count >= pPacer->batch )
+        {
+            Adjust( pPacer );
+
+            pPacer->count = 0;
+            pPacer->batches++;
+            pPacer->pausedUs += pPacer->gapUs;
+            delay = pPacer->gapUs * NS_PER_US;
+        }
+
+        pPacer->count++;
+    }
+
+    return delay;
+}
+
+/*==========================================================================*/
+/*  PACER_Record                                                            */
+/*!
+    Record the latency of a write
+
+    @param[in]
+        pPacer
+            pointer to the write pacing controller
+
+    @param[in]
+        latencyNs
+            latency of the write in nanoseconds
+
+============================================================================*/
+void PACER_Record( Pacer *pPacer, uint64_t latencyNs )
+{
+    uint64_t us = latencyNs / NS_PER_US;
+    uint32_t latencyUs = ( us > UINT32_MAX ) ? UINT32_MAX : (uint32_t)us;
+
+    if ( pPacer != NULL )
+    {
+        pPacer->window[pPacer->samples++ % PACER_WINDOW] = latencyUs;
+        if ( latencyUs < pPacer->fastestUs )
+        {
+            pPacer->fastestUs = latencyUs;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  PACER_PrintStats                                                        */
+/*!
+    Print the write pacing statistics
+
+    @param[in]
+        pPacer
+            pointer to the write pacing controller
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+============================================================================*/
+void PACER_PrintStats( Pacer *pPacer, FILE *fp )
+{
+    if ( ( pPacer != NULL ) &&
+         ( fp != NULL ) )
+    {
+        fprintf( fp,
+                 "paced batches: %llu backoffs: %llu paused: %llums "
+                 "batch: %u gap: %uus\n",
+                 (unsigned long long)pPacer->batches,
+                 (unsigned long long)pPacer->backoffs,
+                 (unsigned long long)( pPacer->pausedUs / 1000 ),
+                 pPacer->batch,
+                 pPacer->gapUs );
+    }
+}
+
+/*==========================================================================*/
+/*  PACER_Free                                                              */
+/*!
+    Free a write pacing controller
+
+    @param[in]
+        pPacer
+            pointer to the write pacing controller to free
+
+============================================================================*/
+void PACER_Free( Pacer *pPacer )
+{
+    free( pPacer );
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  Adjust                                                                  */
+/*!
+    Adjust the batch size and gap at the end of a batch
+
+    @param[in]
+        pPacer
+            pointer to the write pacing controller
+
+============================================================================*/
+static void Adjust( Pacer *pPacer )
+{
+    uint32_t latencyUs = Percentile( pPacer, PACER_PERCENTILE );
+    uint32_t recentUs = Percentile( pPacer, 50 );
+    uint64_t floorUs = (uint64_t)pPacer->fastestUs * PACER_IDLE_FACTOR;
+    bool contended;
+    uint64_t gap;
+
+    contended = ( pPacer->idle == true ) &&
+                ( pPacer->samples > 0 ) &&
+                ( recentUs > floorUs + PACER_IDLE_SLACK_US );
+
+    if ( contended == true )
+    {
+        /* other clients are active, back off hard */
+        pPacer->batch = 1;
+        gap = ( pPacer->gapUs > 0 ) ? (uint64_t)pPacer->gapUs * 4
+                                    : PACER_MIN_GAP_US * 4;
+        pPacer->gapUs = ( gap > PACER_IDLE_MAX_GAP_US ) ? PACER_IDLE_MAX_GAP_US
+                                                        : (uint32_t)gap;
+        pPacer->backoffs++;
+    }
+    else if ( ( pPacer->targetUs > 0 ) &&
+              ( latencyUs > pPacer->targetUs ) &&
+              ( latencyUs > floorUs ) )
+    {
+        /* above the target latency, and not just the cost of a write
+           on an otherwise idle server, which no gap can reduce */
+        pPacer->batch = ( pPacer->batch > 1 ) ? pPacer->batch / 2 : 1;
+        gap = ( pPacer->gapUs > 0 ) ? (uint64_t)pPacer->gapUs * 2
+                                    : PACER_MIN_GAP_US;
+        pPacer->gapUs = ( gap > PACER_MAX_GAP_US ) ? PACER_MAX_GAP_US
+                                                   : (uint32_t)gap;
+        pPacer->backoffs++;
+    }
+    else
+    {
+        /* below the target latency */
+        if ( pPacer->batch < PACER_MAX_BATCH )
+        {
+            pPacer->batch++;
+        }
+
+        pPacer->gapUs = pPacer->gapUs * 3 / 4;
+        if ( pPacer->gapUs < PACER_MIN_GAP_US )
+        {
+            pPacer->gapUs = 0;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  Percentile                                                              */
+/*!
+    Get a percentile of the recent write latencies
+
+    @param[in]
+        pPacer
+            pointer to the write pacing controller
+
+    @param[in]
+        percentile
+            percentile to get, from 0 to 100
+
+    @retval latency at the percentile in microseconds, or 0 if there
+            are no samples
+
+============================================================================*/
+static uint32_t Percentile( Pacer *pPacer, unsigned int percentile )
+{
+    uint32_t sorted[PACER_WINDOW];
+    size_t n;
+    uint32_t result = 0;
+
+    n = ( pPacer->samples < PACER_WINDOW ) ? (size_t)pPacer->samples
+                                           : PACER_WINDOW;
+    if ( n > 0 )
+    {
+        memcpy( sorted, pPacer->window, n * sizeof( uint32_t ) );
+        qsort( sorted, n, sizeof( uint32_t ), CompareLatency );
+        result = sorted[( n - 1 ) * percentile / 100];
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  CompareLatency                                                          */
+/*!
+    Compare two latencies for sorting
+
+    @param[in]
+        p1
+            pointer to the first latency
+
+    @param[in]
+        p2
+            pointer to the second latency
+
+    @retval -1 the first latency is smaller
+    @retval 0 the latencies are equal
+    @retval 1 the first latency is larger
+
+============================================================================*/
+static int CompareLatency( const void *p1, const void *p2 )
+{
+    uint32_t a = *(const uint32_t *)p1;
+    uint32_t b = *(const uint32_t *)p2;
+
+    return ( a > b ) - ( a < b );
+}
+
+/*! @}
+ * end of pacer group */
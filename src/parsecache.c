@@ -0,0 +1,564 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup parsecache parsecache
+ * @brief Persistent per-file parse cache
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file parsecache.c
+
+    Parse Cache
+
+    The Parse Cache stores the pre-tokenized line index of each
+    configuration file on disk so that unchanged files do not need
+    to be scanned and tokenized again on the next run.
+
+    Each cache file is named using the hash of the configuration file
+    name, and is keyed by the device, inode, modification time and size
+    of the configuration file.  If the key does not match (for example
+    the file was rewritten with identical content) the 64-bit FNV-1a
+    hash of the file content is compared instead, and the cache key is
+    refreshed if the content is unchanged.
+
+    The cache file consists of a fixed header followed by the array
+    of line information and the array of ${} references.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "hash.h"
+#include "fileutil.h"
+#include "parsecache.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! parse cache file identifier */
+#define PARSECACHE_MAGIC    ( 0x4350434cUL )
+
+/*! parse cache file format version */
+#define PARSECACHE_VERSION  ( 4 )
+
+/*! parse cache file name suffix */
+#define PARSECACHE_SUFFIX   ".idx"
+
+/*! parse cache file header */
+typedef struct parseCacheHeader
+{
+    /*! parse cache file identifier */
+    uint32_t magic;
+
+    /*! parse cache file format version */
+    uint32_t version;
+
+    /*! device containing the configuration file */
+    uint64_t dev;
+
+    /*! inode of the configuration file */
+    uint64_t ino;
+
+    /*! modification time of the configuration file (seconds) */
+    int64_t mtime_sec;
+
+    /*! modification time of the configuration file (nanoseconds) */
+    int64_t mtime_nsec;
+
+    /*! size of the configuration file */
+    uint64_t size;
+
+    /*! length of the indexed configuration data */
+    uint64_t datalen;
+
+    /*! hash of the indexed configuration data */
+    uint64_t hash;
+
+    /*! number of lines in the index */
+    uint32_t nlines;
+
+    /*! number of ${} references in the index */
+    uint32_t nrefs;
+
+} ParseCacheHeader;
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static void SetKey( ParseCacheHeader *pHeader, struct stat *pStat );
+static bool MatchKey( ParseCacheHeader *pHeader, struct stat *pStat );
+static LineIndex *ReadIndex( int fd, ParseCacheHeader *pHeader, size_t len );
+static bool ValidLine( LineIndex *pIndex, LineInfo *pInfo, size_t len );
+static bool ValidSpan( size_t offset, size_t length, size_t limit );
+static int WriteIndex( char *pPath,
+                       ParseCacheHeader *pHeader,
+                       LineIndex *pIndex );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  PARSECACHE_GetIndex                                                     */
+/*!
+    Get the line index for a configuration file
+
+    The PARSECACHE_GetIndex function retrieves the line index for a
+    configuration file from the parse cache.  Cache entries are named
+    by the device and inode of the file so the same file is found
+    regardless of the path used to include it.  If there is no valid
+    cached index, the configuration data is indexed and the result
+    is stored in the cache.  Failure to access the cache is not an
+    error, the index is simply built from the configuration data.
+
+    @param[in]
+        pDir
+            pointer to the NUL terminated parse cache directory, or NULL
+            to bypass the cache
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @param[in]
+        pData
+            pointer to the configuration data read from the file
+
+    @param[in]
+        len
+            length of the configuration data
+
+    @param[out]
+        pHit
+            pointer to a location to store the cache hit indication
+
+    @retval pointer to the line index
+    @retval NULL if the line index could not be created
+
+============================================================================*/
+LineIndex *PARSECACHE_GetIndex( char *pDir,
+                                char *pFileName,
+                                char *pData,
+                                size_t len,
+                                bool *pHit )
+{
+    LineIndex *pIndex = NULL;
+    ParseCacheHeader header;
+    struct stat st;
+    char path[PATH_MAX];
+    char key[64];
+    uint64_t hash = 0;
+    bool hashed = false;
+    bool valid;
+    int fd;
+
+    if ( pHit != NULL )
+    {
+        *pHit = false;
+    }
+
+    if ( ( pDir != NULL ) &&
+         ( pFileName != NULL ) &&
+         ( pData != NULL ) &&
+         ( stat( pFileName, &st ) == 0 ) &&
+         ( snprintf( key,
+                     sizeof( key ),
+                     "%ju:%ju",
+                     (uintmax_t)st.st_dev,
+                     (uintmax_t)st.st_ino ) < (int)sizeof( key ) ) &&
+         ( FILEUTIL_KeyPath( pDir,
+                             key,
+                             PARSECACHE_SUFFIX,
+                             path,
+                             sizeof( path ) ) == EOK ) )
+    {
+        fd = open( path, O_RDWR );
+        if ( fd != -1 )
+        {
+            valid = ( read( fd, &header, sizeof( header ) ) ==
+                        sizeof( header ) ) &&
+                    ( header.magic == PARSECACHE_MAGIC ) &&
+                    ( header.version == PARSECACHE_VERSION ) &&
+                    ( header.datalen == len );
+
+            if ( ( valid == true ) &&
+                 ( MatchKey( &header, &st ) == false ) )
+            {
+                /* fall back to comparing the file content */
+                hash = HASH_Fnv1a64( pData, len, HASH_FNV1A64_INIT );
+                hashed = true;
+
+                valid = ( hash == header.hash );
+                if ( valid == true )
+                {
+                    /* refresh the key of the unchanged file */
+                    SetKey( &header, &st );
+                    pwrite( fd, &header, sizeof( header ), 0 );
+                }
+            }
+
+            if ( valid == true )
+            {
+                pIndex = ReadIndex( fd, &header, len );
+            }
+
+            close( fd );
+        }
+
+        if ( pIndex != NULL )
+        {
+            if ( pHit != NULL )
+            {
+                *pHit = true;
+            }
+        }
+        else
+        {
+            pIndex = LINEINDEX_Build( pData, len );
+            if ( ( pIndex != NULL ) &&
+                 ( FILEUTIL_MakeDirs( pDir ) == EOK ) )
+            {
+                memset( &header, 0, sizeof( header ) );
+                header.magic = PARSECACHE_MAGIC;
+                header.version = PARSECACHE_VERSION;
+                header.datalen = len;
+                header.hash = ( hashed == true )
+                                ? hash
+                                : HASH_Fnv1a64( pData,
+                                                len,
+                                                HASH_FNV1A64_INIT );
+                header.nlines = pIndex->nlines;
+                header.nrefs = pIndex->nrefs;
+                SetKey( &header, &st );
+
+                WriteIndex( path, &header, pIndex );
+            }
+        }
+    }
+    else if ( pData != NULL )
+    {
+        pIndex = LINEINDEX_Build( pData, len );
+    }
+
+    return pIndex;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  SetKey                                                                  */
+/*!
+    Set the cache key in a parse cache header
+
+    @param[in,out]
+        pHeader
+            pointer to the parse cache header
+
+    @param[in]
+        pStat
+            pointer to the status of the configuration file
+
+============================================================================*/
+static void SetKey( ParseCacheHeader *pHeader, struct stat *pStat )
+{
+    pHeader->dev = pStat->st_dev;
+    pHeader->ino = pStat->st_ino;
+    pHeader->mtime_sec = pStat->st_mtim.tv_sec;
+    pHeader->mtime_nsec = pStat->st_mtim.tv_nsec;
+    pHeader->size = pStat->st_size;
+}
+
+/*==========================================================================*/
+/*  MatchKey                                                                */
+/*!
+    Compare the cache key in a parse cache header
+
+    @param[in]
+        pHeader
+            pointer to the parse cache header
+
+    @param[in]
+        pStat
+            pointer to the status of the configuration file
+
+    @retval true the configuration file matches the cache key
+    @retval false the configuration file does not match the cache key
+
+============================================================================*/
+static bool MatchKey( ParseCacheHeader *pHeader, struct stat *pStat )
+{
+    return ( pHeader->dev == (uint64_t)pStat->st_dev ) &&
+           ( pHeader->ino == (uint64_t)pStat->st_ino ) &&
+           ( pHeader->mtime_sec == (int64_t)pStat->st_mtim.tv_sec ) &&
+           ( pHeader->mtime_nsec == (int64_t)pStat->st_mtim.tv_nsec ) &&
+           ( pHeader->size == (uint64_t)pStat->st_size );
+}
+
+/*==========================================================================*/
+/*  ReadIndex                                                               */
+/*!
+    Read a line index from a parse cache file
+
+    The ReadIndex function reads the line index which follows the
+    parse cache header, and validates it against the length of the
+    configuration data.  An index which fails validation is discarded,
+    so that the caller rebuilds it and replaces the cache file.
+
+    @param[in]
+        fd
+            file descriptor of the parse cache file positioned after
+            the header
+
+    @param[in]
+        pHeader
+            pointer to the parse cache header
+
+    @param[in]
+        len
+            length of the configuration data
+
+    @retval pointer to the line index
+    @retval NULL if the line index could not be read
+
+============================================================================*/
+static LineIndex *ReadIndex( int fd, ParseCacheHeader *pHeader, size_t len )
+{
+    LineIndex *pIndex;
+    size_t linesize;
+    size_t refsize;
+    uint32_t i;
+    bool valid;
+
+    pIndex = LINEINDEX_Create( pHeader->nlines, pHeader->nrefs );
+    if ( pIndex != NULL )
+    {
+        linesize = pHeader->nlines * sizeof( LineInfo );
+        refsize = pHeader->nrefs * sizeof( RefInfo );
+
+        valid = ( read( fd, pIndex->pLines, linesize ) == (ssize_t)linesize ) &&
+                ( read( fd, pIndex->pRefs, refsize ) == (ssize_t)refsize );
+
+        /* make sure the index cannot reference outside the data */
+        for ( i = 0; ( i < pIndex->nlines ) && ( valid == true ); i++ )
+        {
+            valid = ValidLine( pIndex, &pIndex->pLines[i], len );
+        }
+
+        if ( valid == false )
+        {
+            LINEINDEX_Free( pIndex );
+            pIndex = NULL;
+        }
+    }
+
+    return pIndex;
+}
+
+/*==========================================================================*/
+/*  ValidLine                                                               */
+/*!
+    Validate a line of a cached line index
+
+    The ValidLine function checks that a line lies within the
+    configuration data, that its name, value and ${} reference spans
+    lie within the line, and that its kind and directive are known.
+
+    @param[in]
+        pIndex
+            pointer to the line index containing the line
+
+    @param[in]
+        pInfo
+            pointer to the line information to validate
+
+    @param[in]
+        len
+            length of the configuration data
+
+    @retval true the line is valid
+    @retval false the line references outside the data or the line
+
+============================================================================*/
+static bool ValidLine( LineIndex *pIndex, LineInfo *pInfo, size_t len )
+{
+    bool valid;
+    uint32_t i;
+
+    valid = ( ValidSpan( pInfo->offset, pInfo->length, len ) == true ) &&
+            ( ValidSpan( pInfo->refidx,
+                         pInfo->nrefs,
+                         pIndex->nrefs ) == true ) &&
+            ( ValidSpan( pInfo->nameoff,
+                         pInfo->namelen,
+                         pInfo->length ) == true ) &&
+            ( ValidSpan( pInfo->valoff,
+                         pInfo->vallen,
+                         pInfo->length ) == true ) &&
+            ( pInfo->kind <= LINE_ASSIGNMENT ) &&
+            ( pInfo->directive <= DIRECTIVE_LAZY );
+
+    for ( i = 0; ( i < pInfo->nrefs ) && ( valid == true ); i++ )
+    {
+        valid = ValidSpan( pIndex->pRefs[pInfo->refidx + i].offset,
+                           pIndex->pRefs[pInfo->refidx + i].length,
+                           pInfo->length );
+    }
+
+    return valid;
+}
+
+/*==========================================================================*/
+/*  ValidSpan                                                               */
+/*!
+    Check that a span lies within a limit
+
+    The comparison cannot overflow for any offset and length.
+
+    @param[in]
+        offset
+            offset of the start of the span
+
+    @param[in]
+        length
+            length of the span
+
+    @param[in]
+        limit
+            length of the enclosing region
+
+    @retval true the span lies within the region
+    @retval false the span extends beyond the region
+
+============================================================================*/
+static bool ValidSpan( size_t offset, size_t length, size_t limit )
+{
+    return ( offset <= limit ) && ( length <= limit - offset );
+}
+
+/*==========================================================================*/
+/*  WriteIndex                                                              */
+/*!
+    Write a line index to a parse cache file
+
+    The WriteIndex function atomically replaces the parse cache file
+    with the specified header and line index.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated parse cache file name
+
+    @param[in]
+        pHeader
+            pointer to the parse cache header
+
+    @param[in]
+        pIndex
+            pointer to the line index
+
+    @retval EOK the parse cache file was written
+    @retval other error as returned by the file system
+
+============================================================================*/
+static int WriteIndex( char *pPath,
+                       ParseCacheHeader *pHeader,
+                       LineIndex *pIndex )
+{
+    int result = EOK;
+    char tmppath[PATH_MAX];
+    size_t linesize = pIndex->nlines * sizeof( LineInfo );
+    size_t refsize = pIndex->nrefs * sizeof( RefInfo );
+    int fd;
+
+    if ( snprintf( tmppath,
+                   sizeof( tmppath ),
+                   "%s.%d",
+                   pPath,
+                   getpid() ) >= (int)sizeof( tmppath ) )
+    {
+        result = ENAMETOOLONG;
+    }
+    else
+    {
+        fd = open( tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+        if ( fd != -1 )
+        {
+            if ( ( write( fd, pHeader, sizeof( ParseCacheHeader ) ) !=
+                    sizeof( ParseCacheHeader ) ) ||
+                 ( write( fd, pIndex->pLines, linesize ) !=
+                    (ssize_t)linesize ) ||
+                 ( write( fd, pIndex->pRefs, refsize ) !=
+                    (ssize_t)refsize ) )
+            {
+                result = EIO;
+            }
+
+            close( fd );
+
+            if ( ( result == EOK ) &&
+                 ( rename( tmppath, pPath ) != 0 ) )
+            {
+                result = errno;
+            }
+
+            if ( result != EOK )
+            {
+                unlink( tmppath );
+            }
+        }
+        else
+        {
+            result = errno;
+        }
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of parsecache group */
@@ -0,0 +1,643 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup perfcount perfcount
+ * @brief Hardware performance counters
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file perfcount.c
+
+    Performance Counters
+
+    The Performance Counter functions count CPU cycles, instructions,
+    cache misses, page faults and context switches for the loader
+    thread using perf_event_open, and attribute them to the configuration
+    file and load phase which was active when they occurred.
+
+    The counters are opened as a single group so that every phase
+    transition costs a single read.  Counters which the kernel or the
+    hardware does not provide are omitted from the report.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perfcount.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+/*! number of counted events */
+#define PERFCOUNT_NUM_EVENTS    5
+
+/*! name of the entry which collects counts outside any configuration file */
+#define PERFCOUNT_OTHER         "(outside files)"
+
+/*! counted event */
+typedef struct _PerfEvent
+{
+    /*! name of the event in the report */
+    char *pName;
+
+    /*! perf event type */
+    uint32_t type;
+
+    /*! perf event configuration */
+    uint64_t config;
+
+} PerfEvent;
+
+/*! counts attributed to a configuration file */
+typedef struct _PerfFile
+{
+    /*! name of the configuration file */
+    char *pName;
+
+    /*! event counts for each phase */
+    uint64_t counts[PERF_NUM_PHASES][PERFCOUNT_NUM_EVENTS];
+
+} PerfFile;
+
+/*! performance counter set */
+struct _PerfCounters
+{
+    /*! group leader file descriptor */
+    int leader;
+
+    /*! file descriptor of each event, or -1 if it is not available */
+    int fds[PERFCOUNT_NUM_EVENTS];
+
+    /*! position of each event in the group read, or -1 */
+    int slot[PERFCOUNT_NUM_EVENTS];
+
+    /*! number of events in the group */
+    int nopen;
+
+    /*! event values at the last phase transition */
+    uint64_t last[PERFCOUNT_NUM_EVENTS];
+
+    /*! index of the file being measured */
+    int file;
+
+    /*! phase being measured */
+    PerfPhase phase;
+
+    /*! files which counts are attributed to */
+    PerfFile *pFiles;
+
+    /*! number of files */
+    int nfiles;
+
+    /*! number of allocated file entries */
+    int size;
+};
+
+/*! counted events */
+static const PerfEvent events[PERFCOUNT_NUM_EVENTS] =
+{
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    { "ctx-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES }
+};
+
+/*! phase names */
+static const char *phaseNames[PERF_NUM_PHASES] =
+{
+    "dispatch",
+    "io",
+    "scan",
+    "expand",
+    "write"
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int OpenEvent( const PerfEvent *pEvent, int group );
+static void Sample( PerfCounters *pPerf );
+static int FindFile( PerfCounters *pPerf, char *pFileName );
+static void ReportRow( PerfCounters *pPerf,
+                       FILE *fp,
+                       const char *pLabel,
+                       uint64_t *pCounts );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  PERFCOUNT_Create                                                        */
+/*!
+    Open the performance counters
+
+    The PERFCOUNT_Create function opens as many of the counted events
+    as are available and starts counting for the calling thread.
+
+    @retval pointer to the performance counter set
+    @retval NULL no counters are available, errno indicates the reason
+
+============================================================================*/
+PerfCounters *PERFCOUNT_Create( void )
+{
+    PerfCounters *pPerf;
+    int err = ENOENT;
+    int fd;
+    int i;
+
+    pPerf = calloc( 1, sizeof( PerfCounters ) );
+    if ( pPerf != NULL )
+    {
+        pPerf->leader = -1;
+
+        for ( i = 0; i < PERFCOUNT_NUM_EVENTS; i++ )
+        {
+            pPerf->slot[i] = -1;
+            pPerf->fds[i] = -1;
+
+            fd = OpenEvent( &events[i], pPerf->leader );
+            if ( fd != -1 )
+            {
+                if ( pPerf->leader == -1 )
+                {
+                    pPerf->leader = fd;
+                }
+
+                pPerf->fds[i] = fd;
+                pPerf->slot[i] = pPerf->nopen++;
+            }
+            else
+            {
+                err = errno;
+            }
+        }
+
+        /* counts outside any configuration file go to the first entry */
+        if ( pPerf->leader != -1 )
+        {
+            FindFile( pPerf, PERFCOUNT_OTHER );
+        }
+
+        if ( pPerf->nfiles == 0 )
+        {
+            PERFCOUNT_Free( pPerf );
+            pPerf = NULL;
+            errno = err;
+        }
+        else
+        {
+            pPerf->phase = PERF_PHASE_DISPATCH;
+            Sample( pPerf );
+        }
+    }
+
+    return pPerf;
+}
+
+/*==========================================================================*/
+/*  PERFCOUNT_Enter                                                         */
+/*!
+    Enter a load phase
+
+    The PERFCOUNT_Enter function attributes the events counted since
+    the last transition to the current file and phase, and then makes
+    the specified file and phase current.
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set.  If NULL the
+            function does nothing.
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the file to attribute
+            counts to, or NULL to keep the current file
+
+    @param[in]
+        phase
+            phase to attribute counts to
+
+    @param[out]
+        pMark
+            pointer to a location to store the current file and phase,
+            to be passed to PERFCOUNT_Leave
+
+============================================================================*/
+void PERFCOUNT_Enter( PerfCounters *pPerf,
+                      char *pFileName,
+                      PerfPhase phase,
+                      PerfMark *pMark )
+{
+    if ( ( pPerf != NULL ) &&
+         ( pMark != NULL ) &&
+         ( phase < PERF_NUM_PHASES ) )
+    {
+        Sample( pPerf );
+
+        pMark->file = pPerf->file;
+        pMark->phase = pPerf->phase;
+
+        if ( pFileName != NULL )
+        {
+            pPerf->file = FindFile( pPerf, pFileName );
+        }
+
+        pPerf->phase = phase;
+    }
+}
+
+/*==========================================================================*/
+/*  PERFCOUNT_Leave                                                         */
+/*!
+    Leave a load phase
+
+    The PERFCOUNT_Leave function attributes the events counted since
+    the last transition to the current file and phase, and then restores
+    the file and phase which were current when the phase was entered.
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set.  If NULL the
+            function does nothing.
+
+    @param[in]
+        pMark
+            pointer to the mark stored by PERFCOUNT_Enter
+
+============================================================================*/
+void PERFCOUNT_Leave( PerfCounters *pPerf, PerfMark *pMark )
+{
+    if ( ( pPerf != NULL ) &&
+         ( pMark != NULL ) )
+    {
+        Sample( pPerf );
+
+        pPerf->file = pMark->file;
+        pPerf->phase = pMark->phase;
+    }
+}
+
+/*==========================================================================*/
+/*  PERFCOUNT_Report                                                        */
+/*!
+    Report the performance counts
+
+    The PERFCOUNT_Report function writes the event counts for each
+    phase of each file which had any events, followed by the totals
+    for each phase and the overall total.  Events which are not
+    available are shown as '-'.
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set
+
+    @param[in]
+        fp
+            output stream to write the report to
+
+============================================================================*/
+void PERFCOUNT_Report( PerfCounters *pPerf, FILE *fp )
+{
+    uint64_t total[PERF_NUM_PHASES][PERFCOUNT_NUM_EVENTS];
+    uint64_t all[PERFCOUNT_NUM_EVENTS];
+    uint64_t *pCounts;
+    int i;
+    int j;
+    int k;
+
+    if ( ( pPerf != NULL ) &&
+         ( fp != NULL ) )
+    {
+        Sample( pPerf );
+
+        memset( total, 0, sizeof( total ) );
+        memset( all, 0, sizeof( all ) );
+
+        fprintf( fp, "%-10s", "phase" );
+        for ( k = 0; k < PERFCOUNT_NUM_EVENTS; k++ )
+        {
+            fprintf( fp, " %13s", events[k].pName );
+        }
+
+        fprintf( fp, "\n" );
+
+        for ( i = 0; i < pPerf->nfiles; i++ )
+        {
+            for ( j = 0; j < PERF_NUM_PHASES; j++ )
+            {
+                pCounts = pPerf->pFiles[i].counts[j];
+                for ( k = 0; k < PERFCOUNT_NUM_EVENTS; k++ )
+                {
+                    total[j][k] += pCounts[k];
+                    all[k] += pCounts[k];
+                }
+            }
+        }
+
+        for ( i = 0; i < pPerf->nfiles; i++ )
+        {
+            fprintf( fp, "%s\n", pPerf->pFiles[i].pName );
+            for ( j = 0; j < PERF_NUM_PHASES; j++ )
+            {
+                ReportRow( pPerf,
+                           fp,
+                           phaseNames[j],
+                           pPerf->pFiles[i].counts[j] );
+            }
+        }
+
+        fprintf( fp, "total\n" );
+        for ( j = 0; j < PERF_NUM_PHASES; j++ )
+        {
+            ReportRow( pPerf, fp, phaseNames[j], total[j] );
+        }
+
+        ReportRow( pPerf, fp, "all", all );
+    }
+}
+
+/*==========================================================================*/
+/*  PERFCOUNT_Free                                                          */
+/*!
+    Close the performance counters
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set to free
+
+============================================================================*/
+void PERFCOUNT_Free( PerfCounters *pPerf )
+{
+    int i;
+
+    if ( pPerf != NULL )
+    {
+        for ( i = 0; i < PERFCOUNT_NUM_EVENTS; i++ )
+        {
+            if ( pPerf->fds[i] != -1 )
+            {
+                close( pPerf->fds[i] );
+            }
+        }
+
+        for ( i = 0; i < pPerf->nfiles; i++ )
+        {
+            free( pPerf->pFiles[i].pName );
+        }
+
+        free( pPerf->pFiles );
+        free( pPerf );
+    }
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  OpenEvent                                                               */
+/*!
+    Open a counted event for the calling thread
+
+    The OpenEvent function opens the event with kernel activity included
+    and, if that is not permitted, retries counting user space only.
+
+    @param[in]
+        pEvent
+            pointer to the event to open
+
+    @param[in]
+        group
+            file descriptor of the group leader, or -1 to open a new group
+
+    @retval file descriptor of the event
+    @retval -1 the event is not available
+
+============================================================================*/
+static int OpenEvent( const PerfEvent *pEvent, int group )
+{
+    struct perf_event_attr attr;
+    int fd;
+
+    memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.type = pEvent->type;
+    attr.config = pEvent->config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_hv = 1;
+
+    fd = syscall( SYS_perf_event_open,
+                  &attr,
+                  0,
+                  -1,
+                  group,
+                  PERF_FLAG_FD_CLOEXEC );
+    if ( ( fd == -1 ) &&
+         ( ( errno == EACCES ) || ( errno == EPERM ) ) )
+    {
+        attr.exclude_kernel = 1;
+        fd = syscall( SYS_perf_event_open,
+                      &attr,
+                      0,
+                      -1,
+                      group,
+                      PERF_FLAG_FD_CLOEXEC );
+    }
+
+    return fd;
+}
+
+/*==========================================================================*/
+/*  Sample                                                                  */
+/*!
+    Attribute the events counted since the last transition
+
+    The Sample function reads the counter group and adds the change in
+    each counter to the current file and phase.
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set
+
+============================================================================*/
+static void Sample( PerfCounters *pPerf )
+{
+    uint64_t values[1 + PERFCOUNT_NUM_EVENTS];
+    uint64_t *pCounts;
+    int slot;
+    int i;
+
+    if ( read( pPerf->leader, values, sizeof( values ) ) > 0 )
+    {
+        pCounts = pPerf->pFiles[pPerf->file].counts[pPerf->phase];
+
+        for ( i = 0; i < PERFCOUNT_NUM_EVENTS; i++ )
+        {
+            slot = pPerf->slot[i];
+            if ( ( slot >= 0 ) &&
+                 ( (uint64_t)slot < values[0] ) )
+            {
+                pCounts[i] += values[1 + slot] - pPerf->last[i];
+                pPerf->last[i] = values[1 + slot];
+            }
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  FindFile                                                                */
+/*!
+    Find or add the entry for a configuration file
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @retval index of the file entry.  If an entry cannot be added
+            the index of the entry for counts outside any file is
+            returned.
+
+============================================================================*/
+static int FindFile( PerfCounters *pPerf, char *pFileName )
+{
+    int idx = -1;
+    int i;
+    int size;
+    PerfFile *pFiles;
+
+    for ( i = 0; ( i < pPerf->nfiles ) && ( idx == -1 ); i++ )
+    {
+        if ( strcmp( pPerf->pFiles[i].pName, pFileName ) == 0 )
+        {
+            idx = i;
+        }
+    }
+
+    if ( idx == -1 )
+    {
+        if ( pPerf->nfiles == pPerf->size )
+        {
+            size = ( pPerf->size > 0 ) ? pPerf->size * 2 : 16;
+            pFiles = realloc( pPerf->pFiles, size * sizeof( PerfFile ) );
+            if ( pFiles != NULL )
+            {
+                pPerf->pFiles = pFiles;
+                pPerf->size = size;
+            }
+        }
+
+        if ( pPerf->nfiles < pPerf->size )
+        {
+            memset( &pPerf->pFiles[pPerf->nfiles], 0, sizeof( PerfFile ) );
+            pPerf->pFiles[pPerf->nfiles].pName = strdup( pFileName );
+            if ( pPerf->pFiles[pPerf->nfiles].pName != NULL )
+            {
+                idx = pPerf->nfiles++;
+            }
+        }
+    }
+
+    return ( idx != -1 ) ? idx : 0;
+}
+
+/*==========================================================================*/
+/*  ReportRow                                                               */
+/*!
+    Report the event counts of a single phase
+
+    Rows without any events are omitted.
+
+    @param[in]
+        pPerf
+            pointer to the performance counter set
+
+    @param[in]
+        fp
+            output stream to write the row to
+
+    @param[in]
+        pLabel
+            pointer to the NUL terminated row label
+
+    @param[in]
+        pCounts
+            pointer to the event counts
+
+============================================================================*/
+static void ReportRow( PerfCounters *pPerf,
+                       FILE *fp,
+                       const char *pLabel,
+                       uint64_t *pCounts )
+{
+    uint64_t any = 0;
+    int k;
+
+    for ( k = 0; k < PERFCOUNT_NUM_EVENTS; k++ )
+    {
+        any |= pCounts[k];
+    }
+
+    if ( any != 0 )
+    {
+        fprintf( fp, "  %-8s", pLabel );
+        for ( k = 0; k < PERFCOUNT_NUM_EVENTS; k++ )
+        {
+            if ( pPerf->slot[k] >= 0 )
+            {
+                fprintf( fp, " %13llu", (unsigned long long)pCounts[k] );
+            }
+            else
+            {
+                fprintf( fp, " %13s", "-" );
+            }
+        }
+
+        fprintf( fp, "\n" );
+    }
+}
+
+/*! @}
+ * end of perfcount group */
@@ -0,0 +1,1050 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup provenance provenance
+ * @brief Variable assignment provenance index
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file provenance.c
+
+    Provenance Index
+
+    The Provenance Index records, for every variable assigned during a
+    load, the configuration file and line of the assignment which set
+    its final value, the unexpanded text of that line, and the earlier
+    assignments which it overrode.
+
+    The index is written at the end of the load as a single file which
+    can be mapped into memory and searched in place, so that a query
+    does not need to parse the file or repeat the load.  The file
+    consists of a fixed header, an array of variables sorted by name,
+    an array of assignments, and a pool of NUL terminated strings.
+    Each variable refers to a contiguous run of assignments, most
+    recent first, and all names, values, lines and file names are
+    stored as offsets into the string pool.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "vartable.h"
+#include "provenance.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! provenance index file identifier */
+#define PROVENANCE_MAGIC    ( 0x5650434cUL )
+
+/*! provenance index file format version */
+#define PROVENANCE_VERSION  ( 1 )
+
+/*! initial number of assignment records */
+#define PROVENANCE_DEFAULT_SIZE 64
+
+/*! provenance index file header */
+typedef struct _ProvHeader
+{
+    /*! provenance index file identifier */
+    uint32_t magic;
+
+    /*! provenance index file format version */
+    uint32_t version;
+
+    /*! number of variables */
+    uint32_t nvars;
+
+    /*! number of assignments */
+    uint32_t nassigns;
+
+    /*! size of the string pool */
+    uint64_t strsize;
+
+} ProvHeader;
+
+/*! variable in the provenance index file */
+typedef struct _ProvVar
+{
+    /*! offset of the variable name in the string pool */
+    uint32_t name;
+
+    /*! index of the assignment which set the final value */
+    uint32_t first;
+
+    /*! number of assignments to the variable */
+    uint32_t count;
+
+} ProvVar;
+
+/*! assignment in the provenance index file */
+typedef struct _ProvAssign
+{
+    /*! offset of the configuration file name in the string pool */
+    uint32_t file;
+
+    /*! line number within the configuration file */
+    uint32_t lineno;
+
+    /*! offset of the expanded value in the string pool */
+    uint32_t value;
+
+    /*! offset of the unexpanded configuration line in the string pool */
+    uint32_t raw;
+
+} ProvAssign;
+
+/*! assignment recorded during the load */
+typedef struct _ProvRecord
+{
+    /*! name of the variable */
+    char *pName;
+
+    /*! expanded value of the variable */
+    char *pValue;
+
+    /*! unexpanded configuration line */
+    char *pRaw;
+
+    /*! interned configuration file name */
+    char *pFileName;
+
+    /*! line number within the configuration file */
+    uint32_t lineno;
+
+    /*! order in which the assignment was made */
+    uint32_t seq;
+
+} ProvRecord;
+
+/*! provenance index under construction */
+struct _Provenance
+{
+    /*! assignments in the order they were made */
+    ProvRecord *pRecords;
+
+    /*! number of assignments */
+    size_t count;
+
+    /*! number of assignments allocated */
+    size_t size;
+
+    /*! interned configuration file names */
+    VarTable *pFileNames;
+};
+
+/*! string pool under construction */
+typedef struct _StringPool
+{
+    /*! pool data */
+    char *pData;
+
+    /*! number of bytes used */
+    size_t len;
+
+    /*! number of bytes allocated */
+    size_t size;
+
+    /*! offset of each string already in the pool */
+    VarTable *pOffsets;
+
+} StringPool;
+
+/*! provenance index loaded from a file */
+struct _ProvenanceIndex
+{
+    /*! mapping of the index file */
+    void *pMap;
+
+    /*! length of the mapping */
+    size_t len;
+
+    /*! index file header */
+    ProvHeader *pHeader;
+
+    /*! variables sorted by name */
+    ProvVar *pVars;
+
+    /*! assignments */
+    ProvAssign *pAssigns;
+
+    /*! string pool */
+    char *pStrings;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int CompareRecords( const void *p1, const void *p2 );
+static int AddString( StringPool *pPool, char *pStr, uint32_t *pOffset );
+static int WriteIndex( char *pPath,
+                       ProvHeader *pHeader,
+                       ProvVar *pVars,
+                       ProvAssign *pAssigns,
+                       StringPool *pPool );
+static char *GetString( ProvenanceIndex *pIndex, uint32_t offset );
+static void PrintAssign( ProvenanceIndex *pIndex,
+                         ProvAssign *pAssign,
+                         char *pLabel,
+                         FILE *fp );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  PROVENANCE_Create                                                       */
+/*!
+    Create an empty provenance index
+
+    @retval pointer to the new provenance index
+    @retval NULL if the provenance index could not be created
+
+============================================================================*/
+Provenance *PROVENANCE_Create( void )
+{
+    Provenance *pProvenance;
+
+    pProvenance = calloc( 1, sizeof( Provenance ) );
+    if ( pProvenance != NULL )
+    {
+        pProvenance->pFileNames = VARTABLE_Create( 0 );
+        if ( pProvenance->pFileNames == NULL )
+        {
+            free( pProvenance );
+            pProvenance = NULL;
+        }
+    }
+
+    return pProvenance;
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_Add                                                          */
+/*!
+    Record an assignment in the provenance index
+
+    @param[in]
+        pProvenance
+            pointer to the provenance index
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pValue
+            pointer to the NUL terminated expanded variable value
+
+    @param[in]
+        pRaw
+            pointer to the NUL terminated unexpanded configuration line,
+            or NULL if it is not known
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated configuration file name
+
+    @param[in]
+        lineno
+            line number of the assignment within the configuration file
+
+    @retval EOK the assignment was recorded
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int PROVENANCE_Add( Provenance *pProvenance,
+                    char *pName,
+                    char *pValue,
+                    char *pRaw,
+                    char *pFileName,
+                    int lineno )
+{
+    int result = EINVAL;
+    ProvRecord *pRecords;
+    ProvRecord *pRecord;
+    VarEntry *pEntry = NULL;
+    size_t n;
+
+    if ( ( pProvenance != NULL ) &&
+         ( pName != NULL ) &&
+         ( pValue != NULL ) &&
+         ( pFileName != NULL ) )
+    {
+        result = EOK;
+
+        if ( pProvenance->count == pProvenance->size )
+        {
+            n = ( pProvenance->size == 0 ) ? PROVENANCE_DEFAULT_SIZE
+                                           : pProvenance->size * 2;
+            pRecords = realloc( pProvenance->pRecords,
+                                n * sizeof( ProvRecord ) );
+            if ( pRecords != NULL )
+            {
+                pProvenance->pRecords = pRecords;
+                pProvenance->size = n;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            /* intern the configuration file name */
+            pEntry = VARTABLE_Find( pProvenance->pFileNames, pFileName );
+            if ( pEntry == NULL )
+            {
+                result = VARTABLE_Set( pProvenance->pFileNames,
+                                       pFileName,
+                                       "" );
+                pEntry = VARTABLE_Find( pProvenance->pFileNames, pFileName );
+            }
+        }
+
+        if ( ( result == EOK ) && ( pEntry != NULL ) )
+        {
+            pRecord = &pProvenance->pRecords[pProvenance->count];
+            pRecord->pName = strdup( pName );
+            pRecord->pValue = strdup( pValue );
+            pRecord->pRaw = strdup( ( pRaw != NULL ) ? pRaw : "" );
+            pRecord->pFileName = pEntry->name;
+            pRecord->lineno = ( lineno > 0 ) ? (uint32_t)lineno : 0;
+            pRecord->seq = (uint32_t)pProvenance->count;
+
+            if ( ( pRecord->pName != NULL ) &&
+                 ( pRecord->pValue != NULL ) &&
+                 ( pRecord->pRaw != NULL ) )
+            {
+                pProvenance->count++;
+            }
+            else
+            {
+                free( pRecord->pName );
+                free( pRecord->pValue );
+                free( pRecord->pRaw );
+                result = ENOMEM;
+            }
+        }
+        else if ( result == EOK )
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_Save                                                         */
+/*!
+    Write the provenance index to a file
+
+    The PROVENANCE_Save function groups the recorded assignments by
+    variable, and atomically replaces the index file.  The recorded
+    assignments are reordered, so no further assignments should be
+    recorded afterwards.
+
+    @param[in]
+        pProvenance
+            pointer to the provenance index
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated index file name
+
+    @retval EOK the index file was written
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+    @retval EFBIG the index is too large
+    @retval other error as returned by the file system
+
+============================================================================*/
+int PROVENANCE_Save( Provenance *pProvenance, char *pPath )
+{
+    int result = EINVAL;
+    ProvHeader header;
+    ProvVar *pVars = NULL;
+    ProvAssign *pAssigns = NULL;
+    ProvRecord *pRecord;
+    StringPool pool;
+    size_t nvars = 0;
+    size_t i;
+
+    memset( &pool, 0, sizeof( StringPool ) );
+
+    if ( ( pProvenance != NULL ) &&
+         ( pPath != NULL ) )
+    {
+        result = ( pProvenance->count < UINT32_MAX ) ? EOK : EFBIG;
+    }
+
+    if ( result == EOK )
+    {
+        pVars = malloc( ( pProvenance->count + 1 ) * sizeof( ProvVar ) );
+        pAssigns = malloc( ( pProvenance->count + 1 ) * sizeof( ProvAssign ) );
+        pool.pOffsets = VARTABLE_Create( 0 );
+        if ( ( pVars == NULL ) ||
+             ( pAssigns == NULL ) ||
+             ( pool.pOffsets == NULL ) )
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        /* group the assignments by variable, most recent first */
+        qsort( pProvenance->pRecords,
+               pProvenance->count,
+               sizeof( ProvRecord ),
+               CompareRecords );
+
+        for ( i = 0; ( i < pProvenance->count ) && ( result == EOK ); i++ )
+        {
+            pRecord = &pProvenance->pRecords[i];
+
+            if ( ( i == 0 ) ||
+                 ( strcmp( pRecord->pName,
+                           pProvenance->pRecords[i - 1].pName ) != 0 ) )
+            {
+                pVars[nvars].first = (uint32_t)i;
+                pVars[nvars].count = 0;
+                result = AddString( &pool, pRecord->pName, &pVars[nvars].name );
+                nvars++;
+            }
+
+            pVars[nvars - 1].count++;
+            pAssigns[i].lineno = pRecord->lineno;
+
+            if ( result == EOK )
+            {
+                result = AddString( &pool,
+                                    pRecord->pFileName,
+                                    &pAssigns[i].file );
+            }
+
+            if ( result == EOK )
+            {
+                result = AddString( &pool,
+                                    pRecord->pValue,
+                                    &pAssigns[i].value );
+            }
+
+            if ( result == EOK )
+            {
+                result = AddString( &pool, pRecord->pRaw, &pAssigns[i].raw );
+            }
+        }
+    }
+
+    if ( result == EOK )
+    {
+        memset( &header, 0, sizeof( ProvHeader ) );
+        header.magic = PROVENANCE_MAGIC;
+        header.version = PROVENANCE_VERSION;
+        header.nvars = (uint32_t)nvars;
+        header.nassigns = (uint32_t)pProvenance->count;
+        header.strsize = pool.len;
+
+        result = WriteIndex( pPath, &header, pVars, pAssigns, &pool );
+    }
+
+    VARTABLE_Destroy( pool.pOffsets );
+    free( pool.pData );
+    free( pAssigns );
+    free( pVars );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_Free                                                         */
+/*!
+    Free a provenance index under construction
+
+    @param[in]
+        pProvenance
+            pointer to the provenance index to free
+
+============================================================================*/
+void PROVENANCE_Free( Provenance *pProvenance )
+{
+    size_t i;
+
+    if ( pProvenance != NULL )
+    {
+        for ( i = 0; i < pProvenance->count; i++ )
+        {
+            free( pProvenance->pRecords[i].pName );
+            free( pProvenance->pRecords[i].pValue );
+            free( pProvenance->pRecords[i].pRaw );
+        }
+
+        VARTABLE_Destroy( pProvenance->pFileNames );
+        free( pProvenance->pRecords );
+        free( pProvenance );
+    }
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_Open                                                         */
+/*!
+    Map a provenance index file into memory
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated index file name
+
+    @retval pointer to the loaded provenance index
+    @retval NULL the index file could not be mapped or is invalid
+
+============================================================================*/
+ProvenanceIndex *PROVENANCE_Open( char *pPath )
+{
+    ProvenanceIndex *pIndex = NULL;
+    ProvHeader *pHeader;
+    struct stat sb;
+    uint64_t expected;
+    void *pMap = MAP_FAILED;
+    int fd = -1;
+
+    if ( pPath != NULL )
+    {
+        fd = open( pPath, O_RDONLY );
+    }
+
+    if ( ( fd != -1 ) &&
+         ( fstat( fd, &sb ) == 0 ) &&
+         ( (size_t)sb.st_size >= sizeof( ProvHeader ) ) )
+    {
+        pMap = mmap( NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    }
+
+    if ( pMap != MAP_FAILED )
+    {
+        pHeader = pMap;
+        expected = sizeof( ProvHeader ) +
+                   (uint64_t)pHeader->nvars * sizeof( ProvVar ) +
+                   (uint64_t)pHeader->nassigns * sizeof( ProvAssign ) +
+                   pHeader->strsize;
+
+        if ( ( pHeader->magic == PROVENANCE_MAGIC ) &&
+             ( pHeader->version == PROVENANCE_VERSION ) &&
+             ( expected == (uint64_t)sb.st_size ) &&
+             ( ( pHeader->strsize == 0 ) ||
+               ( ((char *)pMap)[sb.st_size - 1] == '\0' ) ) )
+        {
+            pIndex = calloc( 1, sizeof( ProvenanceIndex ) );
+        }
+
+        if ( pIndex != NULL )
+        {
+            pIndex->pMap = pMap;
+            pIndex->len = sb.st_size;
+            pIndex->pHeader = pHeader;
+            pIndex->pVars = (ProvVar *)&pHeader[1];
+            pIndex->pAssigns = (ProvAssign *)&pIndex->pVars[pHeader->nvars];
+            pIndex->pStrings = (char *)&pIndex->pAssigns[pHeader->nassigns];
+        }
+        else
+        {
+            munmap( pMap, sb.st_size );
+        }
+    }
+
+    if ( fd != -1 )
+    {
+        close( fd );
+    }
+
+    return pIndex;
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_Print                                                        */
+/*!
+    Print the provenance of a variable
+
+    The PROVENANCE_Print function finds the variable using a binary
+    search of the mapped index, and prints its final value, the
+    assignment which set it and the earlier assignments it overrode.
+
+    @param[in]
+        pIndex
+            pointer to the loaded provenance index
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+    @retval EOK the provenance was printed
+    @retval ENOENT the variable was not assigned
+    @retval EINVAL invalid arguments
+
+============================================================================*/
+int PROVENANCE_Print( ProvenanceIndex *pIndex, char *pName, FILE *fp )
+{
+    int result = EINVAL;
+    ProvVar *pVar = NULL;
+    ProvAssign *pAssign;
+    size_t lo = 0;
+    size_t hi;
+    size_t mid;
+    uint32_t i;
+    int cmp;
+
+    if ( ( pIndex != NULL ) &&
+         ( pName != NULL ) &&
+         ( fp != NULL ) )
+    {
+        result = ENOENT;
+        hi = pIndex->pHeader->nvars;
+
+        while ( ( lo < hi ) && ( pVar == NULL ) )
+        {
+            mid = lo + ( hi - lo ) / 2;
+            cmp = strcmp( pName, GetString( pIndex, pIndex->pVars[mid].name ) );
+            if ( cmp == 0 )
+            {
+                pVar = &pIndex->pVars[mid];
+            }
+            else if ( cmp < 0 )
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+
+        if ( ( pVar != NULL ) &&
+             ( pVar->count > 0 ) &&
+             ( (uint64_t)pVar->first + pVar->count <=
+                    pIndex->pHeader->nassigns ) )
+        {
+            pAssign = &pIndex->pAssigns[pVar->first];
+            fprintf( fp,
+                     "%s=%s\n",
+                     pName,
+                     GetString( pIndex, pAssign->value ) );
+
+            PrintAssign( pIndex, pAssign, "set", fp );
+            for ( i = 1; i < pVar->count; i++ )
+            {
+                PrintAssign( pIndex, &pAssign[i], "overrides", fp );
+            }
+
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_ForEach                                                      */
+/*!
+    Visit the final assignment of each variable
+
+    The PROVENANCE_ForEach function calls the specified function with
+    the final value of each variable in the index, in name order, and
+    the location of the assignment which set it.  The iteration stops
+    at the first error returned by the function.
+
+    @param[in]
+        pIndex
+            pointer to the loaded provenance index
+
+    @param[in]
+        fn
+            function to call for each variable
+
+    @param[in]
+        arg
+            argument to pass to the function
+
+    @retval EOK every variable was visited
+    @retval EINVAL invalid arguments
+    @retval other error as returned by the function
+
+============================================================================*/
+int PROVENANCE_ForEach( ProvenanceIndex *pIndex,
+                        ProvenanceFn fn,
+                        void *arg )
+{
+    int result = EINVAL;
+    ProvVar *pVar;
+    ProvAssign *pAssign;
+    uint32_t i;
+
+    if ( ( pIndex != NULL ) &&
+         ( fn != NULL ) )
+    {
+        result = EOK;
+
+        for ( i = 0; ( i < pIndex->pHeader->nvars ) && ( result == EOK ); i++ )
+        {
+            pVar = &pIndex->pVars[i];
+            if ( ( pVar->count > 0 ) &&
+                 ( pVar->first < pIndex->pHeader->nassigns ) )
+            {
+                pAssign = &pIndex->pAssigns[pVar->first];
+                result = fn( GetString( pIndex, pVar->name ),
+                             GetString( pIndex, pAssign->value ),
+                             GetString( pIndex, pAssign->file ),
+                             (int)pAssign->lineno,
+                             arg );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  PROVENANCE_Close                                                        */
+/*!
+    Unmap a provenance index file
+
+    @param[in]
+        pIndex
+            pointer to the loaded provenance index to close
+
+============================================================================*/
+void PROVENANCE_Close( ProvenanceIndex *pIndex )
+{
+    if ( pIndex != NULL )
+    {
+        munmap( pIndex->pMap, pIndex->len );
+        free( pIndex );
+    }
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  CompareRecords                                                          */
+/*!
+    Compare two assignment records for sorting
+
+    Records are ordered by variable name, and then with the most
+    recent assignment first.
+
+    @param[in]
+        p1
+            pointer to the first record
+
+    @param[in]
+        p2
+            pointer to the second record
+
+    @retval <0 the first record sorts first
+    @retval >0 the second record sorts first
+
+============================================================================*/
+static int CompareRecords( const void *p1, const void *p2 )
+{
+    const ProvRecord *pRecord1 = p1;
+    const ProvRecord *pRecord2 = p2;
+    int result;
+
+    result = strcmp( pRecord1->pName, pRecord2->pName );
+    if ( result == 0 )
+    {
+        result = ( pRecord1->seq < pRecord2->seq ) ? 1 : -1;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  AddString                                                               */
+/*!
+    Add a string to the string pool
+
+    Each distinct string is stored in the pool only once.
+
+    @param[in]
+        pPool
+            pointer to the string pool
+
+    @param[in]
+        pStr
+            pointer to the NUL terminated string to add
+
+    @param[out]
+        pOffset
+            pointer to the location to store the offset of the string
+
+    @retval EOK the string was added
+    @retval ENOMEM memory allocation failure
+    @retval EFBIG the string pool is too large
+
+============================================================================*/
+static int AddString( StringPool *pPool, char *pStr, uint32_t *pOffset )
+{
+    int result = EOK;
+    VarEntry *pEntry;
+    size_t len = strlen( pStr ) + 1;
+    size_t size;
+    char *pData;
+
+    pEntry = VARTABLE_Find( pPool->pOffsets, pStr );
+    if ( pEntry != NULL )
+    {
+        *pOffset = (uint32_t)(uintptr_t)pEntry->pData;
+    }
+    else if ( pPool->len + len > UINT32_MAX )
+    {
+        result = EFBIG;
+    }
+    else
+    {
+        if ( pPool->len + len > pPool->size )
+        {
+            size = ( pPool->size == 0 ) ? BUFSIZ : pPool->size;
+            while ( size < pPool->len + len )
+            {
+                size *= 2;
+            }
+
+            pData = realloc( pPool->pData, size );
+            if ( pData != NULL )
+            {
+                pPool->pData = pData;
+                pPool->size = size;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            result = VARTABLE_Set( pPool->pOffsets, pStr, "" );
+            pEntry = VARTABLE_Find( pPool->pOffsets, pStr );
+        }
+
+        if ( ( result == EOK ) && ( pEntry != NULL ) )
+        {
+            memcpy( &pPool->pData[pPool->len], pStr, len );
+            pEntry->pData = (void *)(uintptr_t)pPool->len;
+            *pOffset = (uint32_t)pPool->len;
+            pPool->len += len;
+        }
+        else if ( result == EOK )
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  WriteIndex                                                              */
+/*!
+    Write a provenance index file
+
+    The WriteIndex function atomically replaces the provenance index
+    file with the specified header, variables, assignments and strings.
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated index file name
+
+    @param[in]
+        pHeader
+            pointer to the index file header
+
+    @param[in]
+        pVars
+            pointer to the array of variables
+
+    @param[in]
+        pAssigns
+            pointer to the array of assignments
+
+    @param[in]
+        pPool
+            pointer to the string pool
+
+    @retval EOK the index file was written
+    @retval other error as returned by the file system
+
+============================================================================*/
+static int WriteIndex( char *pPath,
+                       ProvHeader *pHeader,
+                       ProvVar *pVars,
+                       ProvAssign *pAssigns,
+                       StringPool *pPool )
+{
+    int result = EOK;
+    char tmppath[PATH_MAX];
+    size_t varsize = pHeader->nvars * sizeof( ProvVar );
+    size_t assignsize = pHeader->nassigns * sizeof( ProvAssign );
+    int fd;
+
+    if ( snprintf( tmppath,
+                   sizeof( tmppath ),
+                   "%s.%d",
+                   pPath,
+                   getpid() ) >= (int)sizeof( tmppath ) )
+    {
+        result = ENAMETOOLONG;
+    }
+    else
+    {
+        fd = open( tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+        if ( fd != -1 )
+        {
+            if ( ( write( fd, pHeader, sizeof( ProvHeader ) ) !=
+                    sizeof( ProvHeader ) ) ||
+                 ( write( fd, pVars, varsize ) != (ssize_t)varsize ) ||
+                 ( write( fd, pAssigns, assignsize ) !=
+                    (ssize_t)assignsize ) ||
+                 ( write( fd, pPool->pData, pPool->len ) !=
+                    (ssize_t)pPool->len ) )
+            {
+                result = EIO;
+            }
+
+            close( fd );
+
+            if ( ( result == EOK ) &&
+                 ( rename( tmppath, pPath ) != 0 ) )
+            {
+                result = errno;
+            }
+
+            if ( result != EOK )
+            {
+                unlink( tmppath );
+            }
+        }
+        else
+        {
+            result = errno;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  GetString                                                               */
+/*!
+    Get a string from the string pool of a loaded index
+
+    @param[in]
+        pIndex
+            pointer to the loaded provenance index
+
+    @param[in]
+        offset
+            offset of the string in the string pool
+
+    @retval pointer to the NUL terminated string, or an empty string
+            if the offset is outside the string pool
+
+============================================================================*/
+static char *GetString( ProvenanceIndex *pIndex, uint32_t offset )
+{
+    return ( offset < pIndex->pHeader->strsize ) ? &pIndex->pStrings[offset]
+                                                  : "";
+}
+
+/*==========================================================================*/
+/*  PrintAssign                                                             */
+/*!
+    Print an assignment from a loaded index
+
+    @param[in]
+        pIndex
+            pointer to the loaded provenance index
+
+    @param[in]
+        pAssign
+            pointer to the assignment to print
+
+    @param[in]
+        pLabel
+            pointer to the NUL terminated label of the assignment
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+============================================================================*/
+static void PrintAssign( ProvenanceIndex *pIndex,
+                         ProvAssign *pAssign,
+                         char *pLabel,
+                         FILE *fp )
+{
+    fprintf( fp,
+             "    %s %s at %s:%u: %s\n",
+             pLabel,
+             GetString( pIndex, pAssign->value ),
+             GetString( pIndex, pAssign->file ),
+             pAssign->lineno,
+             GetString( pIndex, pAssign->raw ) );
+}
+
+/*! @}
+ * end of provenance group */
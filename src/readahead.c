@@ -0,0 +1,451 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup readahead readahead
+ * @brief Boot readahead list
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file readahead.c
+
+    Boot Readahead List
+
+    The Boot Readahead List functions record the configuration files
+    which were opened during a run, in the order they were opened,
+    together with their sizes.
+
+    At the start of the next run the recorded files are handed to the
+    kernel using posix_fadvise( POSIX_FADV_WILLNEED ) so they are read
+    into the page cache asynchronously before they are needed.
+
+    The list file holds one file per line consisting of the file size
+    and the file name separated by a TAB.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "vartable.h"
+#include "readahead.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! initial number of entries in a readahead list */
+#define READAHEAD_DEFAULT_SIZE  16
+
+/*! file to read ahead */
+typedef struct _ReadaheadEntry
+{
+    /*! name of the file */
+    char *pPath;
+
+    /*! size of the file */
+    size_t size;
+
+} ReadaheadEntry;
+
+/*! list of files to read ahead */
+struct _ReadaheadList
+{
+    /*! number of entries in the list */
+    size_t count;
+
+    /*! number of entries allocated */
+    size_t size;
+
+    /*! array of entries in the order they were added */
+    ReadaheadEntry *pEntries;
+
+    /*! table of the file names in the list */
+    VarTable *pNames;
+};
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  READAHEAD_Create                                                        */
+/*!
+    Create an empty readahead list
+
+    @retval pointer to the new readahead list
+    @retval NULL if the list could not be created
+
+============================================================================*/
+ReadaheadList *READAHEAD_Create( void )
+{
+    ReadaheadList *pList;
+
+    pList = calloc( 1, sizeof( ReadaheadList ) );
+    if ( pList != NULL )
+    {
+        pList->pNames = VARTABLE_Create( 0 );
+        if ( pList->pNames == NULL )
+        {
+            free( pList );
+            pList = NULL;
+        }
+    }
+
+    return pList;
+}
+
+/*==========================================================================*/
+/*  READAHEAD_Load                                                          */
+/*!
+    Load a readahead list
+
+    The READAHEAD_Load function reads a readahead list file which was
+    saved by a previous run.  If the list file does not exist, an empty
+    list is returned.
+
+    @param[in]
+        pListFile
+            pointer to the NUL terminated readahead list file name
+
+    @retval pointer to the readahead list
+    @retval NULL if the list could not be created
+
+============================================================================*/
+ReadaheadList *READAHEAD_Load( char *pListFile )
+{
+    ReadaheadList *pList;
+    char *pLine = NULL;
+    size_t len = 0;
+    ssize_t n;
+    char *pPath;
+    unsigned long long size;
+    FILE *fp;
+
+    pList = READAHEAD_Create();
+    if ( ( pList != NULL ) &&
+         ( pListFile != NULL ) )
+    {
+        fp = fopen( pListFile, "r" );
+        if ( fp != NULL )
+        {
+            while ( ( n = getline( &pLine, &len, fp ) ) > 0 )
+            {
+                if ( pLine[n-1] == '\n' )
+                {
+                    pLine[n-1] = '\0';
+                }
+
+                size = strtoull( pLine, &pPath, 10 );
+                if ( *pPath == '\t' )
+                {
+                    READAHEAD_Add( pList, pPath + 1, (size_t)size );
+                }
+            }
+
+            free( pLine );
+            fclose( fp );
+        }
+    }
+
+    return pList;
+}
+
+/*==========================================================================*/
+/*  READAHEAD_Add                                                           */
+/*!
+    Add a file to a readahead list
+
+    The READAHEAD_Add function appends a file to the readahead list.
+    Files which are already in the list are not added again.
+
+    @param[in]
+        pList
+            pointer to the readahead list
+
+    @param[in]
+        pPath
+            pointer to the NUL terminated file name
+
+    @param[in]
+        size
+            size of the file
+
+    @retval EOK the file was added, or was already in the list
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int READAHEAD_Add( ReadaheadList *pList, char *pPath, size_t size )
+{
+    int result = EINVAL;
+    ReadaheadEntry *pEntries;
+    size_t n;
+
+    if ( ( pList != NULL ) &&
+         ( pPath != NULL ) )
+    {
+        result = EOK;
+
+        if ( VARTABLE_Find( pList->pNames, pPath ) == NULL )
+        {
+            if ( pList->count == pList->size )
+            {
+                n = ( pList->size == 0 ) ? READAHEAD_DEFAULT_SIZE
+                                         : pList->size * 2;
+                pEntries = realloc( pList->pEntries,
+                                    n * sizeof( ReadaheadEntry ) );
+                if ( pEntries != NULL )
+                {
+                    pList->pEntries = pEntries;
+                    pList->size = n;
+                }
+                else
+                {
+                    result = ENOMEM;
+                }
+            }
+
+            if ( result == EOK )
+            {
+                result = VARTABLE_Set( pList->pNames, pPath, "" );
+            }
+
+            if ( result == EOK )
+            {
+                pEntries = &pList->pEntries[pList->count];
+                pEntries->pPath = VARTABLE_Find( pList->pNames, pPath )->name;
+                pEntries->size = size;
+                pList->count++;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  READAHEAD_Prefetch                                                      */
+/*!
+    Start reading the files in a readahead list
+
+    The READAHEAD_Prefetch function advises the kernel that each file
+    in the readahead list will be needed soon.  The kernel starts
+    reading the files into the page cache asynchronously, so this
+    function does not wait for the file data.
+
+    @param[in]
+        pList
+            pointer to the readahead list
+
+    @retval number of files which were prefetched
+
+============================================================================*/
+size_t READAHEAD_Prefetch( ReadaheadList *pList )
+{
+    size_t count = 0;
+    size_t i;
+    int fd;
+
+    if ( pList != NULL )
+    {
+        for ( i = 0; i < pList->count; i++ )
+        {
+            fd = open( pList->pEntries[i].pPath, O_RDONLY );
+            if ( fd != -1 )
+            {
+                if ( posix_fadvise( fd,
+                                    0,
+                                    pList->pEntries[i].size,
+                                    POSIX_FADV_WILLNEED ) == 0 )
+                {
+                    count++;
+                }
+
+                close( fd );
+            }
+        }
+    }
+
+    return count;
+}
+
+/*==========================================================================*/
+/*  READAHEAD_Equal                                                         */
+/*!
+    Compare two readahead lists
+
+    @param[in]
+        pList1
+            pointer to the first readahead list
+
+    @param[in]
+        pList2
+            pointer to the second readahead list
+
+    @retval true the lists hold the same files in the same order
+    @retval false the lists are different
+
+============================================================================*/
+bool READAHEAD_Equal( ReadaheadList *pList1, ReadaheadList *pList2 )
+{
+    bool result = false;
+    size_t i;
+
+    if ( ( pList1 != NULL ) &&
+         ( pList2 != NULL ) &&
+         ( pList1->count == pList2->count ) )
+    {
+        result = true;
+
+        for ( i = 0; ( i < pList1->count ) && ( result == true ); i++ )
+        {
+            result = ( pList1->pEntries[i].size ==
+                        pList2->pEntries[i].size ) &&
+                     ( strcmp( pList1->pEntries[i].pPath,
+                               pList2->pEntries[i].pPath ) == 0 );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  READAHEAD_Save                                                          */
+/*!
+    Save a readahead list
+
+    The READAHEAD_Save function writes the readahead list file.
+    The list file is replaced atomically.
+
+    @param[in]
+        pList
+            pointer to the readahead list
+
+    @param[in]
+        pListFile
+            pointer to the NUL terminated readahead list file name
+
+    @retval EOK the readahead list was saved
+    @retval EINVAL invalid arguments
+    @retval other error as returned by the file system
+
+============================================================================*/
+int READAHEAD_Save( ReadaheadList *pList, char *pListFile )
+{
+    int result = EINVAL;
+    char tmppath[PATH_MAX];
+    size_t i;
+    FILE *fp;
+
+    if ( ( pList != NULL ) &&
+         ( pListFile != NULL ) )
+    {
+        result = EOK;
+
+        if ( snprintf( tmppath,
+                       sizeof( tmppath ),
+                       "%s.%d",
+                       pListFile,
+                       getpid() ) >= (int)sizeof( tmppath ) )
+        {
+            result = ENAMETOOLONG;
+        }
+
+        if ( result == EOK )
+        {
+            fp = fopen( tmppath, "w" );
+            if ( fp != NULL )
+            {
+                for ( i = 0; i < pList->count; i++ )
+                {
+                    fprintf( fp,
+                             "%zu\t%s\n",
+                             pList->pEntries[i].size,
+                             pList->pEntries[i].pPath );
+                }
+
+                result = ( fclose( fp ) == 0 ) ? EOK : errno;
+                if ( result == EOK )
+                {
+                    if ( rename( tmppath, pListFile ) != 0 )
+                    {
+                        result = errno;
+                    }
+                }
+
+                if ( result != EOK )
+                {
+                    unlink( tmppath );
+                }
+            }
+            else
+            {
+                result = errno;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  READAHEAD_Free                                                          */
+/*!
+    Free a readahead list
+
+    @param[in]
+        pList
+            pointer to the readahead list to free
+
+============================================================================*/
+void READAHEAD_Free( ReadaheadList *pList )
+{
+    if ( pList != NULL )
+    {
+        free( pList->pEntries );
+        VARTABLE_Destroy( pList->pNames );
+        free( pList );
+    }
+}
+
+/*! @}
+ * end of readahead group */
@@ -0,0 +1,952 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup resident resident
+ * @brief Resident on-demand provider of configured values
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file resident.c
+
+    Resident Value Provider
+
+    The Resident Value Provider serves the values of selected namespaces
+    from memory instead of writing them to the variable server at load
+    time.  Once the load completes, it registers for print (render) and
+    calc notifications on every variable it holds a value for, and then
+    waits for the variable server to ask for the values which are
+    actually read.
+
+    Once a variable has been written, either in response to a calc
+    request or by another client, its notifications are cancelled so
+    that the variable server serves the stored value from then on.
+
+    A lazy include names a namespace and a configuration file.  The
+    file is only tokenized at load time, to declare the variables it
+    assigns in the namespace.  It is processed when one of those
+    variables is first requested.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <varserver/varserver.h>
+#include "resident.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! initial number of namespaces and served variables */
+#define RESIDENT_DEFAULT_SIZE   16
+
+/*! namespace served on demand */
+typedef struct _ResidentNamespace
+{
+    /*! variable name prefix of the namespace */
+    char *pPrefix;
+
+    /*! length of the prefix */
+    size_t len;
+
+    /*! configuration file of a lazy include, or NULL */
+    char *pFileName;
+
+    /*! the lazy include has been processed */
+    bool loaded;
+
+} ResidentNamespace;
+
+/*! variable served on demand */
+typedef struct _ResidentVar
+{
+    /*! variable server handle of the variable */
+    VAR_HANDLE hVar;
+
+    /*! name of the variable */
+    char *pName;
+
+    /*! the variable has been written and is no longer served */
+    bool written;
+
+} ResidentVar;
+
+/*! resident value provider */
+struct _Resident
+{
+    /*! resolved values, owned by the caller */
+    VarTable *pValues;
+
+    /*! variables declared by lazy includes which are not yet loaded */
+    VarTable *pDeclared;
+
+    /*! namespaces served on demand */
+    ResidentNamespace *pNamespaces;
+
+    /*! number of namespaces */
+    size_t count;
+
+    /*! number of namespaces allocated */
+    size_t size;
+
+    /*! variables registered with the variable server, sorted by handle */
+    ResidentVar *pVars;
+
+    /*! number of registered variables */
+    size_t nvars;
+
+    /*! number of registered variables allocated */
+    size_t varsize;
+
+    /*! variable server handle */
+    VARSERVER_HANDLE hVarServer;
+
+    /*! function to load a lazy include */
+    ResidentLoadFn fn;
+
+    /*! argument of the load function */
+    void *arg;
+
+    /*! report each request */
+    bool verbose;
+};
+
+/*============================================================================
+        Private file scoped variables
+============================================================================*/
+
+/*! set by the signal handler to stop the provider */
+static volatile sig_atomic_t stopRequested;
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static int AddNamespace( Resident *pResident,
+                         char *pPrefix,
+                         char *pFileName );
+static int Register( VarEntry *pEntry, void *arg );
+static int CompareHandles( const void *p1, const void *p2 );
+static ResidentVar *FindVar( Resident *pResident, VAR_HANDLE hVar );
+static char *GetValue( Resident *pResident, ResidentVar *pVar );
+static void Print( Resident *pResident, int32_t hPrintSession );
+static void Calc( Resident *pResident, VAR_HANDLE hVar );
+static void Written( Resident *pResident, ResidentVar *pVar );
+static void HandleSignal( int signum );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  RESIDENT_Create                                                         */
+/*!
+    Create a resident value provider
+
+    @param[in]
+        pValues
+            pointer to the table of resolved values to serve, which
+            remains owned by the caller
+
+    @retval pointer to the new provider
+    @retval NULL if the provider could not be created
+
+============================================================================*/
+Resident *RESIDENT_Create( VarTable *pValues )
+{
+    Resident *pResident = NULL;
+
+    if ( pValues != NULL )
+    {
+        pResident = calloc( 1, sizeof( Resident ) );
+    }
+
+    if ( pResident != NULL )
+    {
+        pResident->pValues = pValues;
+        pResident->pDeclared = VARTABLE_Create( 0 );
+        if ( pResident->pDeclared == NULL )
+        {
+            free( pResident );
+            pResident = NULL;
+        }
+    }
+
+    return pResident;
+}
+
+/*==========================================================================*/
+/*  RESIDENT_AddNamespace                                                   */
+/*!
+    Serve the variables of a namespace on demand
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        pPrefix
+            pointer to the NUL terminated variable name prefix
+
+    @retval EOK the namespace was added
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int RESIDENT_AddNamespace( Resident *pResident, char *pPrefix )
+{
+    return AddNamespace( pResident, pPrefix, NULL );
+}
+
+/*==========================================================================*/
+/*  RESIDENT_AddInclude                                                     */
+/*!
+    Add a lazy include
+
+    The RESIDENT_AddInclude function serves the variables of a namespace
+    on demand, and records the configuration file to process when one
+    of them is first requested.
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        pPrefix
+            pointer to the NUL terminated variable name prefix
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the configuration file
+
+    @retval EOK the lazy include was added
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int RESIDENT_AddInclude( Resident *pResident,
+                         char *pPrefix,
+                         char *pFileName )
+{
+    return ( pFileName != NULL ) ? AddNamespace( pResident,
+                                                 pPrefix,
+                                                 pFileName )
+                                 : EINVAL;
+}
+
+/*==========================================================================*/
+/*  RESIDENT_Declare                                                        */
+/*!
+    Declare a variable assigned by a lazy include
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @retval EOK the variable was declared
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int RESIDENT_Declare( Resident *pResident, char *pName )
+{
+    return ( pResident != NULL ) ? VARTABLE_Set( pResident->pDeclared,
+                                                 pName,
+                                                 "" )
+                                 : EINVAL;
+}
+
+/*==========================================================================*/
+/*  RESIDENT_Match                                                          */
+/*!
+    Check if a variable is served on demand
+
+    @param[in]
+        pResident
+            pointer to the resident provider, or NULL
+
+    @param[in]
+        pName
+            pointer to the start of the variable name
+
+    @param[in]
+        len
+            length of the variable name
+
+    @retval true the variable is in a namespace served on demand
+    @retval false the variable is written to the variable server
+
+============================================================================*/
+bool RESIDENT_Match( Resident *pResident, char *pName, size_t len )
+{
+    bool result = false;
+    ResidentNamespace *pNamespace;
+    size_t i;
+
+    if ( ( pResident != NULL ) &&
+         ( pName != NULL ) )
+    {
+        for ( i = 0; ( i < pResident->count ) && ( result == false ); i++ )
+        {
+            pNamespace = &pResident->pNamespaces[i];
+            result = ( pNamespace->len <= len ) &&
+                     ( strncmp( pName,
+                                pNamespace->pPrefix,
+                                pNamespace->len ) == 0 );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RESIDENT_Pending                                                        */
+/*!
+    Get a lazy include which may assign a variable
+
+    The RESIDENT_Pending function returns the configuration file of the
+    first lazy include whose namespace contains the variable, and which
+    has not been processed.  The include is marked as processed, so
+    each lazy include is returned once.
+
+    @param[in]
+        pResident
+            pointer to the resident provider, or NULL
+
+    @param[in]
+        pName
+            pointer to the start of the variable name
+
+    @param[in]
+        len
+            length of the variable name
+
+    @retval pointer to the name of the configuration file to process
+    @retval NULL if there is no such lazy include
+
+============================================================================*/
+char *RESIDENT_Pending( Resident *pResident, char *pName, size_t len )
+{
+    char *pFileName = NULL;
+    ResidentNamespace *pNamespace;
+    size_t i;
+
+    if ( ( pResident != NULL ) &&
+         ( pName != NULL ) )
+    {
+        for ( i = 0; ( i < pResident->count ) && ( pFileName == NULL ); i++ )
+        {
+            pNamespace = &pResident->pNamespaces[i];
+            if ( ( pNamespace->pFileName != NULL ) &&
+                 ( pNamespace->loaded == false ) &&
+                 ( pNamespace->len <= len ) &&
+                 ( strncmp( pName,
+                            pNamespace->pPrefix,
+                            pNamespace->len ) == 0 ) )
+            {
+                pNamespace->loaded = true;
+                pFileName = pNamespace->pFileName;
+            }
+        }
+    }
+
+    return pFileName;
+}
+
+/*==========================================================================*/
+/*  RESIDENT_Run                                                            */
+/*!
+    Serve values on demand
+
+    The RESIDENT_Run function registers for print and calc notifications
+    on every variable with a resolved value or declared by a lazy
+    include, and serves the requests made by the variable server until
+    SIGINT or SIGTERM is received.  A print request is answered with the
+    value, and the first calc request for a variable writes its value.
+    A variable is no longer served once it has been written.
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        fn
+            function to call to process a lazy include
+
+    @param[in]
+        arg
+            argument to pass to the load function
+
+    @param[in]
+        verbose
+            true to report each request on stdout
+
+    @retval EOK the provider stopped
+    @retval EINVAL invalid arguments
+    @retval ENOTCONN the variable server is not available
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int RESIDENT_Run( Resident *pResident,
+                  ResidentLoadFn fn,
+                  void *arg,
+                  bool verbose )
+{
+    int result = EINVAL;
+    struct sigaction sa;
+    sigset_t mask;
+    int sigval;
+    int sig;
+
+    if ( ( pResident != NULL ) &&
+         ( fn != NULL ) )
+    {
+        pResident->fn = fn;
+        pResident->arg = arg;
+        pResident->verbose = verbose;
+
+        /* the notifications are collected by VARSERVER_WaitSignal */
+        sigemptyset( &mask );
+        sigaddset( &mask, SIG_VAR_PRINT );
+        sigaddset( &mask, SIG_VAR_CALC );
+        sigaddset( &mask, SIG_VAR_MODIFIED );
+        pthread_sigmask( SIG_BLOCK, &mask, NULL );
+
+        memset( &sa, 0, sizeof( sa ) );
+        sa.sa_handler = HandleSignal;
+        sigemptyset( &sa.sa_mask );
+        sigaction( SIGINT, &sa, NULL );
+        sigaction( SIGTERM, &sa, NULL );
+
+        pResident->hVarServer = VARSERVER_Open();
+        result = ( pResident->hVarServer != NULL ) ? EOK : ENOTCONN;
+    }
+
+    if ( result == EOK )
+    {
+        result = VARTABLE_ForEach( pResident->pValues, Register, pResident );
+    }
+
+    if ( result == EOK )
+    {
+        result = VARTABLE_ForEach( pResident->pDeclared, Register, pResident );
+    }
+
+    if ( result == EOK )
+    {
+        qsort( pResident->pVars,
+               pResident->nvars,
+               sizeof( ResidentVar ),
+               CompareHandles );
+
+        if ( verbose == true )
+        {
+            fprintf( stdout,
+                     "Serving %zu variables on demand\n",
+                     pResident->nvars );
+        }
+
+        while ( stopRequested == 0 )
+        {
+            sig = VARSERVER_WaitSignal( &sigval );
+            if ( sig == SIG_VAR_PRINT )
+            {
+                Print( pResident, sigval );
+            }
+            else if ( sig == SIG_VAR_CALC )
+            {
+                Calc( pResident, (VAR_HANDLE)sigval );
+            }
+            else if ( sig == SIG_VAR_MODIFIED )
+            {
+                /* another client has written the variable */
+                Written( pResident, FindVar( pResident, (VAR_HANDLE)sigval ) );
+            }
+        }
+    }
+
+    if ( pResident != NULL )
+    {
+        VARSERVER_Close( pResident->hVarServer );
+        pResident->hVarServer = NULL;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  RESIDENT_Free                                                           */
+/*!
+    Free a resident value provider
+
+    @param[in]
+        pResident
+            pointer to the resident provider to free
+
+============================================================================*/
+void RESIDENT_Free( Resident *pResident )
+{
+    size_t i;
+
+    if ( pResident != NULL )
+    {
+        for ( i = 0; i < pResident->count; i++ )
+        {
+            free( pResident->pNamespaces[i].pPrefix );
+            free( pResident->pNamespaces[i].pFileName );
+        }
+
+        for ( i = 0; i < pResident->nvars; i++ )
+        {
+            free( pResident->pVars[i].pName );
+        }
+
+        VARTABLE_Destroy( pResident->pDeclared );
+        free( pResident->pNamespaces );
+        free( pResident->pVars );
+        free( pResident );
+    }
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  AddNamespace                                                            */
+/*!
+    Add a namespace served on demand
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        pPrefix
+            pointer to the NUL terminated variable name prefix
+
+    @param[in]
+        pFileName
+            pointer to the configuration file of a lazy include, or NULL
+
+    @retval EOK the namespace was added
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int AddNamespace( Resident *pResident,
+                         char *pPrefix,
+                         char *pFileName )
+{
+    int result = EINVAL;
+    ResidentNamespace *pNamespaces;
+    ResidentNamespace *pNamespace;
+    size_t n;
+
+    if ( ( pResident != NULL ) &&
+         ( pPrefix != NULL ) &&
+         ( pPrefix[0] != '\0' ) )
+    {
+        result = EOK;
+
+        if ( pResident->count == pResident->size )
+        {
+            n = ( pResident->size == 0 ) ? RESIDENT_DEFAULT_SIZE
+                                         : pResident->size * 2;
+            pNamespaces = realloc( pResident->pNamespaces,
+                                   n * sizeof( ResidentNamespace ) );
+            if ( pNamespaces != NULL )
+            {
+                pResident->pNamespaces = pNamespaces;
+                pResident->size = n;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if ( result == EOK )
+        {
+            pNamespace = &pResident->pNamespaces[pResident->count];
+            memset( pNamespace, 0, sizeof( ResidentNamespace ) );
+            pNamespace->pPrefix = strdup( pPrefix );
+            pNamespace->len = strlen( pPrefix );
+            pNamespace->pFileName = ( pFileName != NULL ) ? strdup( pFileName )
+                                                          : NULL;
+
+            if ( ( pNamespace->pPrefix != NULL ) &&
+                 ( ( pFileName == NULL ) ||
+                   ( pNamespace->pFileName != NULL ) ) )
+            {
+                pResident->count++;
+            }
+            else
+            {
+                free( pNamespace->pPrefix );
+                free( pNamespace->pFileName );
+                result = ENOMEM;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Register                                                                */
+/*!
+    Register for the notifications of a variable served on demand
+
+    The Register function is called for each resolved and declared
+    variable.  Variables which are unknown to the variable server are
+    skipped, as are declared variables which already have a value.
+
+    @param[in]
+        pEntry
+            pointer to the variable table entry
+
+    @param[in]
+        arg
+            pointer to the resident provider
+
+    @retval EOK the variable was registered or skipped
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int Register( VarEntry *pEntry, void *arg )
+{
+    int result = EOK;
+    Resident *pResident = (Resident *)arg;
+    ResidentVar *pVars;
+    ResidentVar *pVar;
+    VAR_HANDLE hVar = VAR_INVALID;
+    size_t n;
+
+    /* declared variables which have a value are already registered */
+    if ( ( VARTABLE_Find( pResident->pDeclared, pEntry->name ) != pEntry ) ||
+         ( VARTABLE_Find( pResident->pValues, pEntry->name ) == NULL ) )
+    {
+        hVar = VAR_FindByName( pResident->hVarServer, pEntry->name );
+    }
+
+    if ( ( hVar != VAR_INVALID ) &&
+         ( pResident->nvars == pResident->varsize ) )
+    {
+        n = ( pResident->varsize == 0 ) ? RESIDENT_DEFAULT_SIZE
+                                        : pResident->varsize * 2;
+        pVars = realloc( pResident->pVars, n * sizeof( ResidentVar ) );
+        if ( pVars != NULL )
+        {
+            pResident->pVars = pVars;
+            pResident->varsize = n;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if ( ( hVar != VAR_INVALID ) && ( result == EOK ) )
+    {
+        pVar = &pResident->pVars[pResident->nvars];
+        pVar->hVar = hVar;
+        pVar->written = false;
+        pVar->pName = strdup( pEntry->name );
+        if ( pVar->pName != NULL )
+        {
+            VAR_Notify( pResident->hVarServer, hVar, NOTIFY_PRINT );
+            VAR_Notify( pResident->hVarServer, hVar, NOTIFY_CALC );
+            VAR_Notify( pResident->hVarServer, hVar, NOTIFY_MODIFIED );
+            pResident->nvars++;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  CompareHandles                                                          */
+/*!
+    Compare the handles of two served variables for qsort and bsearch
+
+    @param[in]
+        p1
+            pointer to the first served variable
+
+    @param[in]
+        p2
+            pointer to the second served variable
+
+    @retval <0, 0 or >0 as the first handle is less than, equal to or
+            greater than the second handle
+
+============================================================================*/
+static int CompareHandles( const void *p1, const void *p2 )
+{
+    const ResidentVar *pVar1 = (const ResidentVar *)p1;
+    const ResidentVar *pVar2 = (const ResidentVar *)p2;
+
+    return ( pVar1->hVar > pVar2->hVar ) - ( pVar1->hVar < pVar2->hVar );
+}
+
+/*==========================================================================*/
+/*  FindVar                                                                 */
+/*!
+    Find a served variable by its handle
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        hVar
+            variable server handle of the variable
+
+    @retval pointer to the served variable
+    @retval NULL if the variable is not served
+
+============================================================================*/
+static ResidentVar *FindVar( Resident *pResident, VAR_HANDLE hVar )
+{
+    ResidentVar key;
+
+    key.hVar = hVar;
+
+    return bsearch( &key,
+                    pResident->pVars,
+                    pResident->nvars,
+                    sizeof( ResidentVar ),
+                    CompareHandles );
+}
+
+/*==========================================================================*/
+/*  GetValue                                                                */
+/*!
+    Get the value of a served variable
+
+    The GetValue function processes the pending lazy includes for the
+    variable until it has a value.  A variable which has no value once
+    they have been processed is served as an empty string.
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        pVar
+            pointer to the served variable
+
+    @retval pointer to the NUL terminated value
+
+============================================================================*/
+static char *GetValue( Resident *pResident, ResidentVar *pVar )
+{
+    char *pValue;
+    char *pFileName;
+    size_t len = strlen( pVar->pName );
+
+    pValue = VARTABLE_Get( pResident->pValues, pVar->pName );
+    while ( ( pValue == NULL ) &&
+            ( ( pFileName = RESIDENT_Pending( pResident,
+                                              pVar->pName,
+                                              len ) ) != NULL ) )
+    {
+        if ( pResident->verbose == true )
+        {
+            fprintf( stdout, "Loading %s for %s\n", pFileName, pVar->pName );
+        }
+
+        pResident->fn( pResident->arg, pFileName );
+        pValue = VARTABLE_Get( pResident->pValues, pVar->pName );
+    }
+
+    return ( pValue != NULL ) ? pValue : "";
+}
+
+/*==========================================================================*/
+/*  Print                                                                   */
+/*!
+    Answer a print request
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        hPrintSession
+            print session handle received with the notification
+
+============================================================================*/
+static void Print( Resident *pResident, int32_t hPrintSession )
+{
+    VAR_HANDLE hVar;
+    ResidentVar *pVar;
+    char *pValue = "";
+    int fd;
+
+    if ( VAR_OpenPrintSession( pResident->hVarServer,
+                               hPrintSession,
+                               &hVar,
+                               &fd ) == EOK )
+    {
+        pVar = FindVar( pResident, hVar );
+        if ( pVar != NULL )
+        {
+            pValue = GetValue( pResident, pVar );
+
+            if ( pResident->verbose == true )
+            {
+                fprintf( stdout, "Serving %s\n", pVar->pName );
+            }
+        }
+
+        if ( write( fd, pValue, strlen( pValue ) ) < 0 )
+        {
+            fprintf( stderr, "Cannot serve value: %s\n", strerror( errno ) );
+        }
+
+        VAR_ClosePrintSession( pResident->hVarServer, hPrintSession, fd );
+    }
+}
+
+/*==========================================================================*/
+/*  Calc                                                                    */
+/*!
+    Answer a calc request
+
+    The Calc function writes the value of the variable the first time
+    it is requested, and stops serving the variable.  Later requests
+    find the value already written.
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        hVar
+            handle of the variable received with the notification
+
+============================================================================*/
+static void Calc( Resident *pResident, VAR_HANDLE hVar )
+{
+    ResidentVar *pVar = FindVar( pResident, hVar );
+
+    if ( ( pVar != NULL ) &&
+         ( pVar->written == false ) )
+    {
+        if ( pResident->verbose == true )
+        {
+            fprintf( stdout, "Writing %s\n", pVar->pName );
+        }
+
+        if ( VAR_SetNameValue( pResident->hVarServer,
+                               pVar->pName,
+                               GetValue( pResident, pVar ) ) == EOK )
+        {
+            Written( pResident, pVar );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  Written                                                                 */
+/*!
+    Stop serving a variable which has been written
+
+    The Written function cancels the notifications of a variable whose
+    value is now stored by the variable server, so that later reads
+    see the stored value, including any value written by another
+    client, instead of the value held in memory.
+
+    @param[in]
+        pResident
+            pointer to the resident provider
+
+    @param[in]
+        pVar
+            pointer to the served variable, or NULL
+
+============================================================================*/
+static void Written( Resident *pResident, ResidentVar *pVar )
+{
+    if ( ( pVar != NULL ) &&
+         ( pVar->written == false ) )
+    {
+        pVar->written = true;
+
+        VAR_NotifyCancel( pResident->hVarServer, pVar->hVar, NOTIFY_PRINT );
+        VAR_NotifyCancel( pResident->hVarServer, pVar->hVar, NOTIFY_CALC );
+        VAR_NotifyCancel( pResident->hVarServer,
+                          pVar->hVar,
+                          NOTIFY_MODIFIED );
+    }
+}
+
+/*==========================================================================*/
+/*  HandleSignal                                                            */
+/*!
+    Request the resident provider to stop
+
+    @param[in]
+        signum
+            number of the signal received
+
+============================================================================*/
+static void HandleSignal( int signum )
+{
+    (void)signum;
+    stopRequested = 1;
+}
+
+/*! @}
+ * end of resident group */
@@ -0,0 +1,908 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup server server
+ * @brief Loader service over a Unix domain socket
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file server.c
+
+    Loader Service
+
+    The Loader Service accepts load requests over a Unix domain stream
+    socket, so that a single long lived loader can keep its variable
+    server connection and caches warm between loads.
+
+    Each connection carries a single request line consisting of the
+    root configuration file name followed by optional space separated
+    options:
+
+        <file> [prefix=<prefix>] [dry-run]
+
+    and receives a single reply line:
+
+        result=<n> files=<n> applied=<n> skipped=<n> errors=<n>
+        time_us=<n> coalesced=<n>
+
+    Loads are performed one at a time by a worker thread.  A request
+    which matches a load which is waiting to start joins that load and
+    receives its reply, so any number of identical requests which
+    arrive while a load is in progress are served by a single
+    follow-up load.
+
+    Each connection is served by its own thread.  A client which does
+    not send its request, or read its reply, within SERVER_TIMEOUT_MS
+    is disconnected.  When the service stops, it waits for the
+    connection threads to finish before returning.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "server.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! maximum length of a request line */
+#define SERVER_MAX_REQUEST  4096
+
+/*! maximum number of connections waiting to be accepted */
+#define SERVER_BACKLOG      16
+
+/*! interval at which the accept loop checks for a stop request */
+#define SERVER_POLL_MS      500
+
+/*! maximum time to wait for a client to send or receive, in milliseconds */
+#define SERVER_TIMEOUT_MS   5000
+
+/*! state of a load */
+typedef enum _JobState
+{
+    /*! waiting for the worker thread */
+    JOB_PENDING = 0,
+
+    /*! being performed by the worker thread */
+    JOB_RUNNING,
+
+    /*! complete, and the reply is available */
+    JOB_DONE
+
+} JobState;
+
+/*! load shared by one or more identical requests */
+typedef struct _Job
+{
+    /*! load request */
+    ServerRequest request;
+
+    /*! state of the load */
+    JobState state;
+
+    /*! number of requests which joined the load */
+    size_t requests;
+
+    /*! number of requests still waiting for the reply */
+    size_t waiters;
+
+    /*! reply to the load */
+    ServerReply reply;
+
+    /*! next load waiting for the worker thread */
+    struct _Job *pNext;
+
+} Job;
+
+/*! loader service */
+typedef struct _Server
+{
+    /*! function which performs a load */
+    ServerLoadFn fn;
+
+    /*! argument passed to the load function */
+    void *arg;
+
+    /*! lock protecting the load queue */
+    pthread_mutex_t lock;
+
+    /*! condition signalled when a load is queued or the service stops */
+    pthread_cond_t queued;
+
+    /*! condition signalled when a load completes */
+    pthread_cond_t done;
+
+    /*! condition signalled when the last connection thread finishes */
+    pthread_cond_t idle;
+
+    /*! number of running connection threads */
+    size_t connections;
+
+    /*! first load waiting for the worker thread */
+    Job *pHead;
+
+    /*! last load waiting for the worker thread */
+    Job *pTail;
+
+    /*! the service is stopping */
+    bool stop;
+
+} Server;
+
+/*! client connection */
+typedef struct _Connection
+{
+    /*! loader service */
+    Server *pServer;
+
+    /*! connected socket */
+    int fd;
+
+} Connection;
+
+/*! set by the signal handler to stop the service */
+static volatile sig_atomic_t stopRequested;
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static void HandleSignal( int signum );
+static int Listen( char *pSocketPath );
+static void *Worker( void *arg );
+static void *Serve( void *arg );
+static int ReadRequest( int fd, char *pBuf, size_t len );
+static int ParseRequest( char *pLine, ServerRequest *pRequest );
+static void Submit( Server *pServer,
+                    ServerRequest *pRequest,
+                    ServerReply *pReply );
+static Job *FindPending( Server *pServer, ServerRequest *pRequest );
+static Job *CreateJob( ServerRequest *pRequest );
+static void FreeJob( Job *pJob );
+static void CancelPending( Server *pServer );
+static void SetTimeout( int fd );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  SERVER_Run                                                              */
+/*!
+    Run the loader service
+
+    The SERVER_Run function listens for load requests on the specified
+    Unix domain socket, and performs them using the specified load
+    function until it receives SIGINT or SIGTERM.  Any existing socket
+    with the same name is replaced, and the socket is removed when
+    the service stops.  The function returns once the current load and
+    all connection threads have finished.
+
+    @param[in]
+        pSocketPath
+            pointer to the NUL terminated name of the socket
+
+    @param[in]
+        fn
+            function which performs a load request
+
+    @param[in]
+        arg
+            argument to pass to the load function
+
+    @retval EOK the service stopped
+    @retval EINVAL invalid arguments
+    @retval ENAMETOOLONG the socket name is too long
+    @retval other error as returned by the socket functions
+
+============================================================================*/
+int SERVER_Run( char *pSocketPath, ServerLoadFn fn, void *arg )
+{
+    int result = EINVAL;
+    Server server;
+    Connection *pConnection;
+    struct sigaction sa;
+    struct pollfd pfd;
+    pthread_t worker;
+    pthread_t thread;
+    int sock = -1;
+    int fd;
+
+    memset( &server, 0, sizeof( Server ) );
+    server.fn = fn;
+    server.arg = arg;
+
+    if ( ( pSocketPath != NULL ) &&
+         ( fn != NULL ) )
+    {
+        sock = Listen( pSocketPath );
+        result = ( sock >= 0 ) ? EOK : -sock;
+    }
+
+    if ( result == EOK )
+    {
+        memset( &sa, 0, sizeof( sa ) );
+        sa.sa_handler = HandleSignal;
+        sigemptyset( &sa.sa_mask );
+        sigaction( SIGINT, &sa, NULL );
+        sigaction( SIGTERM, &sa, NULL );
+        signal( SIGPIPE, SIG_IGN );
+
+        pthread_mutex_init( &server.lock, NULL );
+        pthread_cond_init( &server.queued, NULL );
+        pthread_cond_init( &server.done, NULL );
+        pthread_cond_init( &server.idle, NULL );
+
+        result = pthread_create( &worker, NULL, Worker, &server );
+    }
+
+    if ( result == EOK )
+    {
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+
+        while ( stopRequested == 0 )
+        {
+            if ( poll( &pfd, 1, SERVER_POLL_MS ) <= 0 )
+            {
+                continue;
+            }
+
+            fd = accept( sock, NULL, NULL );
+            if ( fd == -1 )
+            {
+                continue;
+            }
+
+            SetTimeout( fd );
+
+            pConnection = malloc( sizeof( Connection ) );
+            if ( pConnection != NULL )
+            {
+                pConnection->pServer = &server;
+                pConnection->fd = fd;
+
+                pthread_mutex_lock( &server.lock );
+                server.connections++;
+                pthread_mutex_unlock( &server.lock );
+
+                if ( pthread_create( &thread,
+                                     NULL,
+                                     Serve,
+                                     pConnection ) == 0 )
+                {
+                    pthread_detach( thread );
+                }
+                else
+                {
+                    pthread_mutex_lock( &server.lock );
+                    server.connections--;
+                    pthread_mutex_unlock( &server.lock );
+
+                    free( pConnection );
+                    close( fd );
+                }
+            }
+            else
+            {
+                close( fd );
+            }
+        }
+
+        /* stop the worker thread once the current load completes */
+        pthread_mutex_lock( &server.lock );
+        server.stop = true;
+        CancelPending( &server );
+        pthread_cond_broadcast( &server.queued );
+        pthread_mutex_unlock( &server.lock );
+
+        pthread_join( worker, NULL );
+
+        /* the connection threads use the service state on this stack */
+        pthread_mutex_lock( &server.lock );
+        while ( server.connections > 0 )
+        {
+            pthread_cond_wait( &server.idle, &server.lock );
+        }
+        pthread_mutex_unlock( &server.lock );
+
+        pthread_cond_destroy( &server.idle );
+        pthread_cond_destroy( &server.done );
+        pthread_cond_destroy( &server.queued );
+        pthread_mutex_destroy( &server.lock );
+    }
+
+    if ( sock >= 0 )
+    {
+        close( sock );
+        unlink( pSocketPath );
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  HandleSignal                                                            */
+/*!
+    Request the loader service to stop
+
+    @param[in]
+        signum
+            number of the signal received
+
+============================================================================*/
+static void HandleSignal( int signum )
+{
+    (void)signum;
+    stopRequested = 1;
+}
+
+/*==========================================================================*/
+/*  Listen                                                                  */
+/*!
+    Create the listening socket
+
+    @param[in]
+        pSocketPath
+            pointer to the NUL terminated name of the socket
+
+    @retval listening socket descriptor
+    @retval negative error number if the socket could not be created
+
+============================================================================*/
+static int Listen( char *pSocketPath )
+{
+    int result = -ENAMETOOLONG;
+    struct sockaddr_un addr;
+    int sock;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+
+    if ( strlen( pSocketPath ) < sizeof( addr.sun_path ) )
+    {
+        strcpy( addr.sun_path, pSocketPath );
+
+        sock = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        if ( sock == -1 )
+        {
+            result = -errno;
+        }
+        else
+        {
+            /* replace a socket left by a previous instance */
+            unlink( pSocketPath );
+
+            if ( ( bind( sock,
+                         (struct sockaddr *)&addr,
+                         sizeof( addr ) ) == 0 ) &&
+                 ( listen( sock, SERVER_BACKLOG ) == 0 ) )
+            {
+                result = sock;
+            }
+            else
+            {
+                result = -errno;
+                close( sock );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Worker                                                                  */
+/*!
+    Perform the queued loads
+
+    The Worker thread performs the queued loads one at a time, in the
+    order they were queued, until the service stops.
+
+    @param[in]
+        arg
+            pointer to the loader service
+
+    @retval NULL
+
+============================================================================*/
+static void *Worker( void *arg )
+{
+    Server *pServer = arg;
+    ServerReply reply;
+    Job *pJob;
+
+    pthread_mutex_lock( &pServer->lock );
+
+    while ( pServer->stop == false )
+    {
+        pJob = pServer->pHead;
+        if ( pJob == NULL )
+        {
+            pthread_cond_wait( &pServer->queued, &pServer->lock );
+            continue;
+        }
+
+        /* later identical requests start a new load */
+        pServer->pHead = pJob->pNext;
+        if ( pServer->pHead == NULL )
+        {
+            pServer->pTail = NULL;
+        }
+
+        pJob->state = JOB_RUNNING;
+        pthread_mutex_unlock( &pServer->lock );
+
+        memset( &reply, 0, sizeof( ServerReply ) );
+        reply.result = pServer->fn( pServer->arg, &pJob->request, &reply );
+
+        pthread_mutex_lock( &pServer->lock );
+        pJob->reply = reply;
+        pJob->reply.coalesced = pJob->requests - 1;
+        pJob->state = JOB_DONE;
+        pthread_cond_broadcast( &pServer->done );
+    }
+
+    pthread_mutex_unlock( &pServer->lock );
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  Serve                                                                   */
+/*!
+    Serve a client connection
+
+    The Serve thread reads a load request from a client connection,
+    waits for the load to complete, and sends the reply.  The service
+    is notified when the last connection thread finishes.
+
+    @param[in]
+        arg
+            pointer to the client connection
+
+    @retval NULL
+
+============================================================================*/
+static void *Serve( void *arg )
+{
+    Connection *pConnection = arg;
+    Server *pServer = pConnection->pServer;
+    char line[SERVER_MAX_REQUEST];
+    ServerRequest request;
+    ServerReply reply;
+    int n;
+
+    memset( &reply, 0, sizeof( ServerReply ) );
+
+    reply.result = ReadRequest( pConnection->fd, line, sizeof( line ) );
+    if ( reply.result == EOK )
+    {
+        reply.result = ParseRequest( line, &request );
+    }
+
+    if ( reply.result == EOK )
+    {
+        Submit( pServer, &request, &reply );
+    }
+
+    n = snprintf( line,
+                  sizeof( line ),
+                  "result=%d files=%zu applied=%zu skipped=%zu errors=%zu "
+                  "time_us=%llu coalesced=%zu\n",
+                  reply.result,
+                  reply.files,
+                  reply.applied,
+                  reply.skipped,
+                  reply.errors,
+                  (unsigned long long)reply.elapsedUs,
+                  reply.coalesced );
+
+    if ( write( pConnection->fd, line, n ) != n )
+    {
+        /* the client is no longer waiting for the reply */
+    }
+
+    close( pConnection->fd );
+    free( pConnection );
+
+    pthread_mutex_lock( &pServer->lock );
+    if ( --pServer->connections == 0 )
+    {
+        pthread_cond_broadcast( &pServer->idle );
+    }
+    pthread_mutex_unlock( &pServer->lock );
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  ReadRequest                                                             */
+/*!
+    Read a request line from a client connection
+
+    @param[in]
+        fd
+            connected socket
+
+    @param[out]
+        pBuf
+            pointer to the buffer to store the NUL terminated line
+
+    @param[in]
+        len
+            length of the buffer
+
+    @retval EOK the request line was read
+    @retval E2BIG the request line is too long
+    @retval EPROTO the connection was closed before the end of the line
+    @retval other error as returned by read
+
+============================================================================*/
+static int ReadRequest( int fd, char *pBuf, size_t len )
+{
+    int result = EPROTO;
+    size_t n = 0;
+    ssize_t rc;
+    char *pEnd = NULL;
+
+    while ( ( pEnd == NULL ) && ( n < len - 1 ) )
+    {
+        rc = read( fd, &pBuf[n], len - 1 - n );
+        if ( rc > 0 )
+        {
+            pBuf[n + rc] = '\0';
+            pEnd = strchr( &pBuf[n], '\n' );
+            n += rc;
+        }
+        else if ( ( rc == -1 ) && ( errno == EINTR ) )
+        {
+            continue;
+        }
+        else
+        {
+            result = ( rc == 0 ) ? EPROTO : errno;
+            break;
+        }
+    }
+
+    if ( pEnd != NULL )
+    {
+        *pEnd = '\0';
+        result = EOK;
+    }
+    else if ( n == len - 1 )
+    {
+        result = E2BIG;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ParseRequest                                                            */
+/*!
+    Parse a request line
+
+    The request strings point into the request line.
+
+    @param[in]
+        pLine
+            pointer to the NUL terminated request line, which is modified
+
+    @param[out]
+        pRequest
+            pointer to the request to populate
+
+    @retval EOK the request was parsed
+    @retval EINVAL the request is not valid
+
+============================================================================*/
+static int ParseRequest( char *pLine, ServerRequest *pRequest )
+{
+    int result = EINVAL;
+    char *pToken;
+    char *pSave = NULL;
+
+    memset( pRequest, 0, sizeof( ServerRequest ) );
+
+    pRequest->pFileName = strtok_r( pLine, " \t\r", &pSave );
+    if ( pRequest->pFileName != NULL )
+    {
+        result = EOK;
+    }
+
+    while ( ( result == EOK ) &&
+            ( ( pToken = strtok_r( NULL, " \t\r", &pSave ) ) != NULL ) )
+    {
+        if ( strncmp( pToken, "prefix=", 7 ) == 0 )
+        {
+            pRequest->pPrefix = &pToken[7];
+        }
+        else if ( strcmp( pToken, "dry-run" ) == 0 )
+        {
+            pRequest->dryRun = true;
+        }
+        else
+        {
+            result = EINVAL;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Submit                                                                  */
+/*!
+    Submit a load request and wait for its reply
+
+    The Submit function joins an identical load which is waiting to
+    start, or queues a new load, and waits for the load to complete.
+
+    @param[in]
+        pServer
+            pointer to the loader service
+
+    @param[in]
+        pRequest
+            pointer to the load request
+
+    @param[out]
+        pReply
+            pointer to the reply to populate
+
+============================================================================*/
+static void Submit( Server *pServer,
+                    ServerRequest *pRequest,
+                    ServerReply *pReply )
+{
+    Job *pJob;
+
+    pthread_mutex_lock( &pServer->lock );
+
+    pJob = FindPending( pServer, pRequest );
+    if ( ( pJob == NULL ) && ( pServer->stop == false ) )
+    {
+        pJob = CreateJob( pRequest );
+        if ( pJob != NULL )
+        {
+            if ( pServer->pTail != NULL )
+            {
+                pServer->pTail->pNext = pJob;
+            }
+            else
+            {
+                pServer->pHead = pJob;
+            }
+
+            pServer->pTail = pJob;
+            pthread_cond_signal( &pServer->queued );
+        }
+    }
+
+    if ( pJob != NULL )
+    {
+        pJob->requests++;
+        pJob->waiters++;
+
+        while ( pJob->state != JOB_DONE )
+        {
+            pthread_cond_wait( &pServer->done, &pServer->lock );
+        }
+
+        *pReply = pJob->reply;
+
+        if ( --pJob->waiters == 0 )
+        {
+            FreeJob( pJob );
+        }
+    }
+    else
+    {
+        pReply->result = ( pServer->stop == true ) ? ECANCELED : ENOMEM;
+    }
+
+    pthread_mutex_unlock( &pServer->lock );
+}
+
+/*==========================================================================*/
+/*  FindPending                                                             */
+/*!
+    Find a queued load which is identical to a request
+
+    @param[in]
+        pServer
+            pointer to the loader service
+
+    @param[in]
+        pRequest
+            pointer to the load request
+
+    @retval pointer to the identical queued load
+    @retval NULL if there is no identical queued load
+
+============================================================================*/
+static Job *FindPending( Server *pServer, ServerRequest *pRequest )
+{
+    Job *pJob;
+
+    for ( pJob = pServer->pHead; pJob != NULL; pJob = pJob->pNext )
+    {
+        if ( ( strcmp( pJob->request.pFileName,
+                       pRequest->pFileName ) == 0 ) &&
+             ( pJob->request.dryRun == pRequest->dryRun ) &&
+             ( ( pJob->request.pPrefix == pRequest->pPrefix ) ||
+               ( ( pJob->request.pPrefix != NULL ) &&
+                 ( pRequest->pPrefix != NULL ) &&
+                 ( strcmp( pJob->request.pPrefix,
+                           pRequest->pPrefix ) == 0 ) ) ) )
+        {
+            break;
+        }
+    }
+
+    return pJob;
+}
+
+/*==========================================================================*/
+/*  CreateJob                                                               */
+/*!
+    Create a load from a request
+
+    @param[in]
+        pRequest
+            pointer to the load request, which is copied
+
+    @retval pointer to the new load
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static Job *CreateJob( ServerRequest *pRequest )
+{
+    Job *pJob;
+
+    pJob = calloc( 1, sizeof( Job ) );
+    if ( pJob != NULL )
+    {
+        pJob->request.dryRun = pRequest->dryRun;
+        pJob->request.pFileName = strdup( pRequest->pFileName );
+        pJob->request.pPrefix = ( pRequest->pPrefix != NULL )
+                                    ? strdup( pRequest->pPrefix )
+                                    : NULL;
+
+        if ( ( pJob->request.pFileName == NULL ) ||
+             ( ( pRequest->pPrefix != NULL ) &&
+               ( pJob->request.pPrefix == NULL ) ) )
+        {
+            FreeJob( pJob );
+            pJob = NULL;
+        }
+    }
+
+    return pJob;
+}
+
+/*==========================================================================*/
+/*  FreeJob                                                                 */
+/*!
+    Free a load
+
+    @param[in]
+        pJob
+            pointer to the load to free
+
+============================================================================*/
+static void FreeJob( Job *pJob )
+{
+    free( pJob->request.pFileName );
+    free( pJob->request.pPrefix );
+    free( pJob );
+}
+
+/*==========================================================================*/
+/*  CancelPending                                                           */
+/*!
+    Cancel the loads waiting for the worker thread
+
+    The waiting requests are released with ECANCELED.  The lock must
+    be held by the caller.
+
+    @param[in]
+        pServer
+            pointer to the loader service
+
+============================================================================*/
+static void CancelPending( Server *pServer )
+{
+    Job *pJob;
+
+    while ( pServer->pHead != NULL )
+    {
+        pJob = pServer->pHead;
+        pServer->pHead = pJob->pNext;
+        pJob->reply.result = ECANCELED;
+        pJob->state = JOB_DONE;
+    }
+
+    pServer->pTail = NULL;
+    pthread_cond_broadcast( &pServer->done );
+}
+
+/*==========================================================================*/
+/*  SetTimeout                                                              */
+/*!
+    Limit the time a client connection can stall
+
+    The SetTimeout function sets the receive and send timeouts of a
+    client connection, so that a client which stops sending its
+    request or reading its reply cannot hold its thread forever.
+
+    @param[in]
+        fd
+            connected socket
+
+============================================================================*/
+static void SetTimeout( int fd )
+{
+    struct timeval tv;
+
+    tv.tv_sec = SERVER_TIMEOUT_MS / 1000;
+    tv.tv_usec = ( SERVER_TIMEOUT_MS % 1000 ) * 1000;
+
+    setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+    setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( tv ) );
+}
+
+/*! @}
+ * end of server group */
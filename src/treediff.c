@@ -0,0 +1,382 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup treediff treediff
+ * @brief Configuration tree comparison
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file treediff.c
+
+    Configuration Tree Comparison
+
+    The Configuration Tree Comparison functions compare the final
+    variable values produced by evaluating two configuration trees,
+    and load the seeded variable store the trees are evaluated against.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include "treediff.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! maximum length of a seed file line */
+#define SEED_LINE_LEN   4096
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static Assignment **FinalValues( AssignList *pList, size_t *pCount );
+static int CompareAssignments( const void *p1, const void *p2 );
+static void PrintAssignment( FILE *fp, char type, Assignment *pAssignment );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  TREEDIFF_LoadSeed                                                       */
+/*!
+    Load a seeded variable store
+
+    The TREEDIFF_LoadSeed function loads the variable values which
+    configuration trees are evaluated against.  Each line of the seed
+    file is a name=value assignment.  Blank lines and lines starting
+    with '#' are ignored.
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the seed file, or NULL
+            for an empty variable store
+
+    @retval pointer to the seeded variable store
+    @retval NULL the seed file could not be loaded
+
+============================================================================*/
+VarTable *TREEDIFF_LoadSeed( char *pFileName )
+{
+    VarTable *pSeed;
+    FILE *fp = NULL;
+    char line[SEED_LINE_LEN];
+    char *pValue;
+    int result = EOK;
+
+    pSeed = VARTABLE_Create( 0 );
+    if ( ( pSeed != NULL ) &&
+         ( pFileName != NULL ) )
+    {
+        fp = fopen( pFileName, "r" );
+        result = ( fp != NULL ) ? EOK : errno;
+    }
+
+    while ( ( fp != NULL ) &&
+            ( result == EOK ) &&
+            ( fgets( line, sizeof( line ), fp ) != NULL ) )
+    {
+        line[strcspn( line, "\r\n" )] = '\0';
+
+        pValue = strchr( line, '=' );
+        if ( ( line[0] != '#' ) &&
+             ( pValue != NULL ) )
+        {
+            *pValue++ = '\0';
+            result = VARTABLE_Set( pSeed, line, pValue );
+        }
+    }
+
+    if ( fp != NULL )
+    {
+        fclose( fp );
+    }
+
+    if ( result != EOK )
+    {
+        VARTABLE_Destroy( pSeed );
+        pSeed = NULL;
+    }
+
+    return pSeed;
+}
+
+/*==========================================================================*/
+/*  TREEDIFF_Print                                                          */
+/*!
+    Print the differences between the values of two configuration trees
+
+    The TREEDIFF_Print function compares the final value of each variable
+    assigned by two configuration trees, and prints the variables which
+    were added, removed or changed, sorted by name, with the file and
+    line which produced each final value:
+
+    + name=value (file:line)
+    - name=value (file:line)
+    ~ name=old (file:line) -> new (file:line)
+
+    @param[in]
+        pOld
+            pointer to the assignments of the old tree
+
+    @param[in]
+        pNew
+            pointer to the assignments of the new tree
+
+    @param[in]
+        fp
+            output stream to print the differences to
+
+    @param[out]
+        pCount
+            pointer to a location to store the number of differences
+
+    @retval EOK the differences were printed
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int TREEDIFF_Print( AssignList *pOld,
+                    AssignList *pNew,
+                    FILE *fp,
+                    size_t *pCount )
+{
+    int result = EINVAL;
+    Assignment **ppOld = NULL;
+    Assignment **ppNew = NULL;
+    size_t nold = 0;
+    size_t nnew = 0;
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+    int cmp;
+
+    if ( ( pOld != NULL ) &&
+         ( pNew != NULL ) &&
+         ( fp != NULL ) &&
+         ( pCount != NULL ) )
+    {
+        ppOld = FinalValues( pOld, &nold );
+        ppNew = FinalValues( pNew, &nnew );
+        result = ( ( ppOld != NULL ) && ( ppNew != NULL ) ) ? EOK : ENOMEM;
+    }
+
+    while ( ( result == EOK ) &&
+            ( ( i < nold ) || ( j < nnew ) ) )
+    {
+        if ( i >= nold )
+        {
+            cmp = 1;
+        }
+        else if ( j >= nnew )
+        {
+            cmp = -1;
+        }
+        else
+        {
+            cmp = strcmp( ppOld[i]->pName, ppNew[j]->pName );
+        }
+
+        if ( cmp < 0 )
+        {
+            PrintAssignment( fp, '-', ppOld[i++] );
+            fprintf( fp, "\n" );
+            count++;
+        }
+        else if ( cmp > 0 )
+        {
+            PrintAssignment( fp, '+', ppNew[j++] );
+            fprintf( fp, "\n" );
+            count++;
+        }
+        else
+        {
+            if ( strcmp( ppOld[i]->pValue, ppNew[j]->pValue ) != 0 )
+            {
+                PrintAssignment( fp, '~', ppOld[i] );
+                fprintf( fp,
+                         " -> %s (%s:%d)\n",
+                         ppNew[j]->pValue,
+                         ppNew[j]->pFileName,
+                         ppNew[j]->lineno );
+                count++;
+            }
+
+            i++;
+            j++;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        *pCount = count;
+    }
+
+    free( ppOld );
+    free( ppNew );
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  FinalValues                                                             */
+/*!
+    Get the final assignment of each variable
+
+    @param[in]
+        pList
+            pointer to the assignments of a configuration tree
+
+    @param[out]
+        pCount
+            pointer to a location to store the number of variables
+
+    @retval pointer to an array of the final assignment of each variable,
+            sorted by variable name, to be freed by the caller
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static Assignment **FinalValues( AssignList *pList, size_t *pCount )
+{
+    Assignment **ppAssignments;
+    size_t i;
+    size_t n = 0;
+
+    ppAssignments = malloc( ( pList->count + 1 ) * sizeof( Assignment * ) );
+    if ( ppAssignments != NULL )
+    {
+        for ( i = 0; i < pList->count; i++ )
+        {
+            ppAssignments[i] = &pList->pAssignments[i];
+        }
+
+        /* sort by name, then in assignment order */
+        qsort( ppAssignments,
+               pList->count,
+               sizeof( Assignment * ),
+               CompareAssignments );
+
+        /* keep the last assignment of each variable */
+        for ( i = 0; i < pList->count; i++ )
+        {
+            if ( ( i + 1 == pList->count ) ||
+                 ( strcmp( ppAssignments[i]->pName,
+                           ppAssignments[i + 1]->pName ) != 0 ) )
+            {
+                ppAssignments[n++] = ppAssignments[i];
+            }
+        }
+    }
+
+    *pCount = n;
+
+    return ppAssignments;
+}
+
+/*==========================================================================*/
+/*  CompareAssignments                                                      */
+/*!
+    Compare two assignments by variable name and assignment order
+
+    @param[in]
+        p1
+            pointer to the first assignment pointer
+
+    @param[in]
+        p2
+            pointer to the second assignment pointer
+
+    @retval <0 the first assignment sorts before the second
+    @retval >0 the first assignment sorts after the second
+
+============================================================================*/
+static int CompareAssignments( const void *p1, const void *p2 )
+{
+    Assignment *pA1 = *(Assignment **)p1;
+    Assignment *pA2 = *(Assignment **)p2;
+    int result;
+
+    result = strcmp( pA1->pName, pA2->pName );
+    if ( result == 0 )
+    {
+        /* assignments are stored in the order they were made */
+        result = ( pA1 < pA2 ) ? -1 : 1;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  PrintAssignment                                                         */
+/*!
+    Print an assignment and the file and line which made it
+
+    @param[in]
+        fp
+            output stream to print to
+
+    @param[in]
+        type
+            type of difference: '+', '-' or '~'
+
+    @param[in]
+        pAssignment
+            pointer to the assignment to print
+
+============================================================================*/
+static void PrintAssignment( FILE *fp, char type, Assignment *pAssignment )
+{
+    fprintf( fp,
+             "%c %s=%s (%s:%d)",
+             type,
+             pAssignment->pName,
+             pAssignment->pValue,
+             pAssignment->pFileName,
+             pAssignment->lineno );
+}
+
+/*! @}
+ * end of treediff group */
@@ -0,0 +1,1855 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup varcall varcall
+ * @brief Variable server call layer
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file varcall.c
+
+    Variable Server Call Layer
+
+    The Variable Server Call Layer functions wrap the variable server
+    calls made by loadconfig so that a slow or stalled variable server
+    cannot stall the caller indefinitely.
+
+    Each call can be given a deadline, and the whole run can be given
+    a deadline.  Calls which fail with a transient error or time out
+    are retried after an exponential backoff delay with random jitter.
+    When a deadline is set, calls are made from a worker thread so the
+    caller can stop waiting for them.  A call which has timed out is
+    never re-issued, since the variable server may still complete it;
+    a retry waits for the outstanding call instead.
+
+    In queue mode, writes made while the variable server is unavailable
+    are queued, and parsing continues.  The queued writes are applied
+    in order as soon as the variable server becomes available again,
+    before any template expansion, and at the end of the run.
+
+    The latency of every call is recorded so that tail latency
+    statistics can be reported.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <varserver/varserver.h>
+#include <varserver/vartemplate.h>
+#include "assignlist.h"
+#include "varcall.h"
+#include "varlog.h"
+#include "pacer.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! deadline value which never expires */
+#define NO_DEADLINE         UINT64_MAX
+
+/*! nanoseconds per millisecond */
+#define NS_PER_MS           1000000ULL
+
+/*! nanoseconds per second */
+#define NS_PER_S            1000000000ULL
+
+/*! maximum backoff doubling */
+#define MAX_BACKOFF_SHIFT   10
+
+/*! type of variable server call */
+typedef enum _CallType
+{
+    /*! VAR_SetNameValue */
+    CALL_SET = 0,
+
+    /*! TEMPLATE_StrToFile */
+    CALL_EXPAND,
+
+    /*! number of call types */
+    CALL_NUM_TYPES
+
+} CallType;
+
+/*! state of the request slot */
+typedef enum _RequestState
+{
+    /*! no request is outstanding */
+    REQUEST_IDLE = 0,
+
+    /*! a request is waiting for the worker thread */
+    REQUEST_SUBMITTED,
+
+    /*! the worker thread is executing the request */
+    REQUEST_RUNNING,
+
+    /*! the request has completed and its result is available */
+    REQUEST_DONE
+
+} RequestState;
+
+/*! variable server call request */
+typedef struct _Request
+{
+    /*! type of call */
+    CallType type;
+
+    /*! request identifier */
+    uint64_t id;
+
+    /*! name of the variable to set */
+    char *pName;
+
+    /*! value to set, or template to expand */
+    char *pValue;
+
+    /*! name of the configuration file the request came from */
+    char *pFileName;
+
+    /*! line number the request came from */
+    int lineno;
+
+    /*! file descriptor to write the expanded template to */
+    int fd;
+
+    /*! buffer mapped by fd which is cleared before the expansion */
+    char *pBuf;
+
+    /*! size of the buffer mapped by fd */
+    size_t len;
+
+    /*! report a failure if the caller stopped waiting for the request */
+    bool report;
+
+    /*! result of the call */
+    int result;
+
+} Request;
+
+/*! call latency statistics */
+typedef struct _CallStats
+{
+    /*! latency of each call in microseconds */
+    uint32_t *pSamples;
+
+    /*! number of samples */
+    size_t count;
+
+    /*! number of samples allocated */
+    size_t size;
+
+    /*! number of retries */
+    size_t retries;
+
+    /*! number of attempts which timed out */
+    size_t timeouts;
+
+    /*! number of calls which failed */
+    size_t failures;
+
+} CallStats;
+
+/*! variable server call context */
+struct _VarCall
+{
+    /*! call options */
+    VarCallOptions options;
+
+    /*! label used when reporting errors, or NULL */
+    char *pLabel;
+
+    /*! handle to the variable server, or NULL if not connected */
+    VARSERVER_HANDLE hVarServer;
+
+    /*! deadline for the whole run */
+    uint64_t runDeadline;
+
+    /*! earliest time of the next connection attempt in queue mode */
+    uint64_t nextOpen;
+
+    /*! random number seed for the backoff jitter */
+    unsigned int seed;
+
+    /*! identifier of the most recent request */
+    uint64_t lastId;
+
+    /*! calls are made from a worker thread */
+    bool threaded;
+
+    /*! worker thread */
+    pthread_t thread;
+
+    /*! lock protecting the request slot */
+    pthread_mutex_t lock;
+
+    /*! condition signalled when the request slot changes */
+    pthread_cond_t cond;
+
+    /*! request the worker thread to exit */
+    bool stop;
+
+    /*! state of the request slot */
+    RequestState state;
+
+    /*! request slot shared with the worker thread */
+    Request request;
+
+    /*! writes queued while the variable server is unavailable */
+    AssignList *pQueue;
+
+    /*! index of the next queued write to apply */
+    size_t queueHead;
+
+    /*! total number of writes which were queued */
+    size_t queued;
+
+    /*! number of queued writes which failed */
+    size_t lateFailures;
+
+    /*! latency statistics for each call type */
+    CallStats stats[CALL_NUM_TYPES];
+
+    /*! write pacing controller, or NULL if writes are not paced */
+    Pacer *pPacer;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static void *Worker( void *arg );
+static int Execute( VarCall *pVarCall, Request *pRequest );
+static int Replay( VarCall *pVarCall, Request *pRequest );
+static int Call( VarCall *pVarCall, Request *pRequest );
+static int Attempt( VarCall *pVarCall, Request *pRequest, uint64_t deadline );
+static bool WaitIdle( VarCall *pVarCall, uint64_t deadline );
+static bool WaitSignal( VarCall *pVarCall, uint64_t deadline );
+static void Reap( VarCall *pVarCall );
+static void FreeRequest( Request *pRequest );
+static bool Connect( VarCall *pVarCall, uint64_t deadline );
+static VARSERVER_HANDLE OpenServer( VarCall *pVarCall );
+static int Enqueue( VarCall *pVarCall, Request *pRequest );
+static void DrainQueue( VarCall *pVarCall, uint64_t deadline );
+static void ReportFailure( VarCall *pVarCall, Request *pRequest, int rc );
+static void Confirm( VarCall *pVarCall, Request *pRequest );
+static bool IsTransient( int rc );
+static void Backoff( VarCall *pVarCall, unsigned int attempt );
+static void Pause( VarCall *pVarCall, uint64_t delay );
+static uint64_t CallDeadline( VarCall *pVarCall );
+static uint64_t Now( void );
+static void Record( CallStats *pStats, uint64_t start );
+static int CompareSamples( const void *p1, const void *p2 );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  VARCALL_Create                                                          */
+/*!
+    Create a variable server call context
+
+    The VARCALL_Create function creates a call context with the specified
+    options.  A worker thread is only started if a call or run deadline
+    has been set, otherwise calls are made directly by the caller.
+
+    @param[in]
+        pOptions
+            pointer to the call options
+
+    @param[in]
+        pLabel
+            pointer to a NUL terminated label to add to error reports,
+            or NULL for none
+
+    @retval pointer to the new call context
+    @retval NULL if the call context could not be created
+
+============================================================================*/
+VarCall *VARCALL_Create( VarCallOptions *pOptions, char *pLabel )
+{
+    VarCall *pVarCall = NULL;
+    pthread_condattr_t attr;
+    uint64_t now = Now();
+
+    if ( pOptions != NULL )
+    {
+        pVarCall = calloc( 1, sizeof( VarCall ) );
+    }
+
+    if ( pVarCall != NULL )
+    {
+        pVarCall->options = *pOptions;
+        if ( pVarCall->options.backoffMs == 0 )
+        {
+            pVarCall->options.backoffMs = VARCALL_DEFAULT_BACKOFF_MS;
+        }
+
+        pVarCall->pLabel = ( pLabel != NULL ) ? strdup( pLabel ) : NULL;
+        pVarCall->seed = (unsigned int)( getpid() ^ now );
+        pVarCall->runDeadline =
+            ( pOptions->runTimeoutMs > 0 )
+                ? now + pOptions->runTimeoutMs * NS_PER_MS
+                : NO_DEADLINE;
+
+        if ( ( pOptions->paceTargetUs > 0 ) ||
+             ( pOptions->paceIdle == true ) )
+        {
+            pVarCall->pPacer = PACER_Create( pOptions->paceTargetUs,
+                                             pOptions->paceIdle );
+            if ( pVarCall->pPacer == NULL )
+            {
+                free( pVarCall->pLabel );
+                free( pVarCall );
+                pVarCall = NULL;
+            }
+        }
+    }
+
+    if ( pVarCall != NULL )
+    {
+        pVarCall->threaded = ( pOptions->callTimeoutMs > 0 ) ||
+                             ( pOptions->runTimeoutMs > 0 );
+        if ( pVarCall->threaded == true )
+        {
+            pthread_mutex_init( &pVarCall->lock, NULL );
+            pthread_condattr_init( &attr );
+            pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+            pthread_cond_init( &pVarCall->cond, &attr );
+            pthread_condattr_destroy( &attr );
+
+            if ( pthread_create( &pVarCall->thread,
+                                 NULL,
+                                 Worker,
+                                 pVarCall ) != 0 )
+            {
+                pthread_cond_destroy( &pVarCall->cond );
+                pthread_mutex_destroy( &pVarCall->lock );
+                PACER_Free( pVarCall->pPacer );
+                free( pVarCall->pLabel );
+                free( pVarCall );
+                pVarCall = NULL;
+            }
+        }
+    }
+
+    return pVarCall;
+}
+
+/*==========================================================================*/
+/*  VARCALL_Open                                                            */
+/*!
+    Open the variable server
+
+    The VARCALL_Open function opens a handle to the variable server.
+    If the variable server is not available, for example because it
+    is still starting, the open is retried until the run deadline if
+    one has been set, otherwise up to the configured number of retries.
+
+    In queue mode the caller does not wait for the variable server.
+    Writes are queued until a later connection attempt succeeds.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @retval EOK the variable server was opened, or will be in queue mode
+    @retval EINVAL invalid arguments
+    @retval ENOTCONN the variable server could not be opened
+
+============================================================================*/
+int VARCALL_Open( VarCall *pVarCall )
+{
+    int result = EINVAL;
+    unsigned int attempt = 0;
+
+    if ( pVarCall != NULL )
+    {
+        pVarCall->hVarServer = OpenServer( pVarCall );
+        while ( ( pVarCall->hVarServer == NULL ) &&
+                ( pVarCall->options.queue == false ) &&
+                ( Now() < pVarCall->runDeadline ) &&
+                ( ( pVarCall->runDeadline != NO_DEADLINE ) ||
+                  ( attempt < pVarCall->options.retries ) ) )
+        {
+            Backoff( pVarCall, ++attempt );
+            pVarCall->hVarServer = OpenServer( pVarCall );
+        }
+
+        if ( ( pVarCall->hVarServer != NULL ) ||
+             ( pVarCall->options.queue == true ) )
+        {
+            pVarCall->nextOpen = Now() +
+                                 pVarCall->options.backoffMs * NS_PER_MS;
+            result = EOK;
+        }
+        else
+        {
+            result = ENOTCONN;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARCALL_SetNameValue                                                    */
+/*!
+    Set a variable on the variable server
+
+    The VARCALL_SetNameValue function sets a variable, subject to the
+    call deadline, run deadline and retry options.
+
+    In queue mode, the write is queued if the variable server is not
+    available or earlier writes are still queued, and EINPROGRESS is
+    returned.  Failures of queued writes are reported against the
+    configuration file and line when they are applied, and successful
+    writes are passed to the confirm function of the call options.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pName
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        pValue
+            pointer to the NUL terminated variable value
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the configuration file
+            containing the assignment
+
+    @param[in]
+        lineno
+            line number of the assignment
+
+    @retval EOK the variable was set
+    @retval EINPROGRESS the write was queued
+    @retval EINVAL invalid arguments
+    @retval ETIMEDOUT the call did not complete before its deadline
+    @retval other error as returned by VAR_SetNameValue
+
+============================================================================*/
+int VARCALL_SetNameValue( VarCall *pVarCall,
+                          char *pName,
+                          char *pValue,
+                          char *pFileName,
+                          int lineno )
+{
+    int result = EINVAL;
+    Request request;
+    uint64_t start;
+
+    if ( ( pVarCall != NULL ) &&
+         ( pName != NULL ) &&
+         ( pValue != NULL ) )
+    {
+        memset( &request, 0, sizeof( request ) );
+        request.type = CALL_SET;
+        request.id = ++pVarCall->lastId;
+        request.pName = pName;
+        request.pValue = pValue;
+        request.pFileName = ( pFileName != NULL ) ? pFileName : "";
+        request.lineno = lineno;
+        request.report = pVarCall->options.queue;
+
+        if ( pVarCall->options.queue == false )
+        {
+            result = Call( pVarCall, &request );
+        }
+        else
+        {
+            /* apply any queued writes which can be applied now */
+            DrainQueue( pVarCall, Now() );
+
+            if ( ( pVarCall->pQueue == NULL ) &&
+                 ( Connect( pVarCall, Now() ) == true ) &&
+                 ( WaitIdle( pVarCall, Now() ) == true ) )
+            {
+                start = Now();
+                result = Attempt( pVarCall, &request, CallDeadline( pVarCall ) );
+                Record( &pVarCall->stats[CALL_SET], start );
+
+                if ( result == ETIMEDOUT )
+                {
+                    /* the write is still outstanding and its result
+                     * will be checked when it completes */
+                    pVarCall->stats[CALL_SET].timeouts++;
+                    result = EINPROGRESS;
+                }
+                else if ( IsTransient( result ) == true )
+                {
+                    result = Enqueue( pVarCall, &request );
+                }
+            }
+            else
+            {
+                result = Enqueue( pVarCall, &request );
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARCALL_StrToFile                                                       */
+/*!
+    Expand a template using the variable server
+
+    The VARCALL_StrToFile function clears the output buffer, rewinds
+    the output file descriptor and expands the template into it, subject
+    to the call deadline, run deadline and retry options.  The buffer is
+    cleared by whoever makes the call, so an expansion which completes
+    after its deadline cannot corrupt a later expansion.
+
+    In queue mode, any queued writes are applied first so the expansion
+    sees them, waiting for the variable server if necessary.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pStr
+            pointer to the NUL terminated template to expand
+
+    @param[in]
+        fd
+            file descriptor to write the expanded template to
+
+    @param[in]
+        pBuf
+            pointer to the buffer mapped by fd
+
+    @param[in]
+        len
+            size of the buffer mapped by fd
+
+    @retval EOK the template was expanded
+    @retval EINVAL invalid arguments
+    @retval ENOTCONN the variable server is not available
+    @retval ETIMEDOUT the call did not complete before its deadline
+    @retval other error as returned by TEMPLATE_StrToFile
+
+============================================================================*/
+int VARCALL_StrToFile( VarCall *pVarCall,
+                       char *pStr,
+                       int fd,
+                       char *pBuf,
+                       size_t len )
+{
+    int result = EINVAL;
+    Request request;
+
+    if ( ( pVarCall != NULL ) &&
+         ( pStr != NULL ) &&
+         ( pBuf != NULL ) )
+    {
+        if ( pVarCall->options.queue == true )
+        {
+            DrainQueue( pVarCall, pVarCall->runDeadline );
+        }
+
+        if ( pVarCall->pQueue != NULL )
+        {
+            result = ETIMEDOUT;
+        }
+        else if ( Connect( pVarCall, pVarCall->runDeadline ) == false )
+        {
+            result = ENOTCONN;
+        }
+        else
+        {
+            memset( &request, 0, sizeof( request ) );
+            request.type = CALL_EXPAND;
+            request.id = ++pVarCall->lastId;
+            request.pValue = pStr;
+            request.fd = fd;
+            request.pBuf = pBuf;
+            request.len = len;
+
+            result = Call( pVarCall, &request );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARCALL_Drain                                                           */
+/*!
+    Complete all outstanding writes
+
+    The VARCALL_Drain function applies all queued writes and waits for
+    any outstanding call to complete, up to the run deadline.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @retval EOK all writes were completed successfully
+    @retval EINVAL invalid arguments
+    @retval ETIMEDOUT queued writes could not be applied before the deadline
+    @retval EIO one or more queued writes failed
+
+============================================================================*/
+int VARCALL_Drain( VarCall *pVarCall )
+{
+    int result = EINVAL;
+
+    if ( pVarCall != NULL )
+    {
+        result = EOK;
+
+        DrainQueue( pVarCall, pVarCall->runDeadline );
+
+        if ( ( pVarCall->threaded == true ) &&
+             ( WaitIdle( pVarCall, pVarCall->runDeadline ) == false ) )
+        {
+            result = ETIMEDOUT;
+        }
+
+        if ( pVarCall->pQueue != NULL )
+        {
+            fprintf( stderr,
+                     "%zu queued assignments not applied%s%s%s\n",
+                     pVarCall->pQueue->count - pVarCall->queueHead,
+                     ( pVarCall->pLabel != NULL ) ? " [" : "",
+                     ( pVarCall->pLabel != NULL ) ? pVarCall->pLabel : "",
+                     ( pVarCall->pLabel != NULL ) ? "]" : "" );
+            result = ETIMEDOUT;
+        }
+        else if ( ( result == EOK ) &&
+                  ( pVarCall->lateFailures > 0 ) )
+        {
+            result = EIO;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARCALL_PrintStats                                                      */
+/*!
+    Print the call latency statistics
+
+    The VARCALL_PrintStats function prints the number of calls of each
+    type, their median, 90th and 99th percentile and maximum latency,
+    and the number of retries, timeouts and failures.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+============================================================================*/
+void VARCALL_PrintStats( VarCall *pVarCall, FILE *fp )
+{
+    static const char *names[CALL_NUM_TYPES] = { "set", "expand" };
+    CallStats *pStats;
+    uint32_t *s;
+    size_t n;
+    int i;
+
+    if ( ( pVarCall != NULL ) &&
+         ( fp != NULL ) )
+    {
+        for ( i = 0; i < CALL_NUM_TYPES; i++ )
+        {
+            pStats = &pVarCall->stats[i];
+            s = pStats->pSamples;
+            n = pStats->count;
+
+            if ( n > 0 )
+            {
+                qsort( s, n, sizeof( uint32_t ), CompareSamples );
+                fprintf( fp,
+                         "%-6s calls: %zu p50: %uus p90: %uus p99: %uus "
+                         "max: %uus retries: %zu timeouts: %zu "
+                         "failures: %zu\n",
+                         names[i],
+                         n,
+                         s[( n - 1 ) * 50 / 100],
+                         s[( n - 1 ) * 90 / 100],
+                         s[( n - 1 ) * 99 / 100],
+                         s[n - 1],
+                         pStats->retries,
+                         pStats->timeouts,
+                         pStats->failures );
+            }
+        }
+
+        if ( pVarCall->queued > 0 )
+        {
+            fprintf( fp,
+                     "queued writes: %zu failed: %zu\n",
+                     pVarCall->queued,
+                     pVarCall->lateFailures );
+        }
+
+        PACER_PrintStats( pVarCall->pPacer, fp );
+    }
+}
+
+/*==========================================================================*/
+/*  VARCALL_Percentile                                                      */
+/*!
+    Get a percentile of the call latency
+
+    The VARCALL_Percentile function calculates the specified percentile
+    of the latency of all calls made so far, of every type.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        percentile
+            percentile to calculate, from 0 to 100
+
+    @retval latency percentile in microseconds
+    @retval 0 if no calls have been made
+
+============================================================================*/
+uint32_t VARCALL_Percentile( VarCall *pVarCall, unsigned int percentile )
+{
+    uint32_t result = 0;
+    uint32_t *pSamples;
+    size_t n = 0;
+    int i;
+
+    if ( pVarCall != NULL )
+    {
+        for ( i = 0; i < CALL_NUM_TYPES; i++ )
+        {
+            n += pVarCall->stats[i].count;
+        }
+
+        pSamples = ( n > 0 ) ? malloc( n * sizeof( uint32_t ) ) : NULL;
+        if ( pSamples != NULL )
+        {
+            n = 0;
+            for ( i = 0; i < CALL_NUM_TYPES; i++ )
+            {
+                memcpy( &pSamples[n],
+                        pVarCall->stats[i].pSamples,
+                        pVarCall->stats[i].count * sizeof( uint32_t ) );
+                n += pVarCall->stats[i].count;
+            }
+
+            qsort( pSamples, n, sizeof( uint32_t ), CompareSamples );
+
+            if ( percentile > 100 )
+            {
+                percentile = 100;
+            }
+
+            result = pSamples[( n - 1 ) * percentile / 100];
+            free( pSamples );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARCALL_Close                                                           */
+/*!
+    Close the variable server and release the call context
+
+    The VARCALL_Close function stops the worker thread and closes the
+    variable server handle.  If a call is still outstanding, the worker
+    thread and the handle are left in use and the call context is not
+    released, since the worker thread may still access it.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+============================================================================*/
+void VARCALL_Close( VarCall *pVarCall )
+{
+    bool stuck = false;
+    int i;
+
+    if ( pVarCall != NULL )
+    {
+        if ( pVarCall->threaded == true )
+        {
+            pthread_mutex_lock( &pVarCall->lock );
+            Reap( pVarCall );
+            stuck = ( pVarCall->state != REQUEST_IDLE );
+            pVarCall->stop = true;
+            pthread_cond_broadcast( &pVarCall->cond );
+            pthread_mutex_unlock( &pVarCall->lock );
+
+            if ( stuck == false )
+            {
+                pthread_join( pVarCall->thread, NULL );
+                pthread_cond_destroy( &pVarCall->cond );
+                pthread_mutex_destroy( &pVarCall->lock );
+            }
+        }
+
+        if ( stuck == false )
+        {
+            if ( ( pVarCall->hVarServer != NULL ) &&
+                 ( VARLOG_IsReplay( pVarCall->options.pLog ) == false ) )
+            {
+                VARSERVER_Close( pVarCall->hVarServer );
+            }
+
+            for ( i = 0; i < CALL_NUM_TYPES; i++ )
+            {
+                free( pVarCall->stats[i].pSamples );
+            }
+
+            ASSIGNLIST_Free( pVarCall->pQueue );
+            PACER_Free( pVarCall->pPacer );
+            free( pVarCall->pLabel );
+            free( pVarCall );
+        }
+    }
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  Worker                                                                  */
+/*!
+    Worker thread which makes the variable server calls
+
+    @param[in]
+        arg
+            pointer to the call context
+
+    @retval NULL
+
+============================================================================*/
+static void *Worker( void *arg )
+{
+    VarCall *pVarCall = (VarCall *)arg;
+    Request request;
+    int rc;
+
+    pthread_mutex_lock( &pVarCall->lock );
+
+    while ( pVarCall->stop == false )
+    {
+        if ( pVarCall->state == REQUEST_SUBMITTED )
+        {
+            pVarCall->state = REQUEST_RUNNING;
+            request = pVarCall->request;
+            pthread_mutex_unlock( &pVarCall->lock );
+
+            rc = Execute( pVarCall, &request );
+
+            pthread_mutex_lock( &pVarCall->lock );
+            pVarCall->request.result = rc;
+            pVarCall->state = REQUEST_DONE;
+            pthread_cond_broadcast( &pVarCall->cond );
+        }
+        else
+        {
+            pthread_cond_wait( &pVarCall->cond, &pVarCall->lock );
+        }
+    }
+
+    pthread_mutex_unlock( &pVarCall->lock );
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  Execute                                                                 */
+/*!
+    Make a variable server call
+
+    If a log is being recorded, the call and its result are added to it.
+    If a log is being replayed, the recorded response is returned instead
+    of calling the variable server.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the request to execute
+
+    @retval result of the variable server call
+
+============================================================================*/
+static int Execute( VarCall *pVarCall, Request *pRequest )
+{
+    int result = ENOTSUP;
+    VarLog *pLog = pVarCall->options.pLog;
+    uint64_t start = Now();
+
+    switch( pRequest->type )
+    {
+        case CALL_SET:
+            if ( VARLOG_IsReplay( pLog ) == true )
+            {
+                result = Replay( pVarCall, pRequest );
+            }
+            else
+            {
+                result = VAR_SetNameValue( pVarCall->hVarServer,
+                                           pRequest->pName,
+                                           pRequest->pValue );
+                VARLOG_Add( pLog,
+                            VARLOG_SET,
+                            result,
+                            Now() - start,
+                            pRequest->pName,
+                            pRequest->pValue,
+                            strlen( pRequest->pValue ) );
+            }
+            break;
+
+        case CALL_EXPAND:
+            /* clear the working buffer and reposition
+             * the write point to the start of the buffer */
+            lseek( pRequest->fd, 0, SEEK_SET );
+            memset( pRequest->pBuf, 0, pRequest->len );
+
+            if ( VARLOG_IsReplay( pLog ) == true )
+            {
+                result = Replay( pVarCall, pRequest );
+            }
+            else
+            {
+                result = TEMPLATE_StrToFile( pVarCall->hVarServer,
+                                             pRequest->pValue,
+                                             pRequest->fd );
+                VARLOG_Add( pLog,
+                            VARLOG_EXPAND,
+                            result,
+                            Now() - start,
+                            pRequest->pValue,
+                            pRequest->pBuf,
+                            strnlen( pRequest->pBuf, pRequest->len ) );
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Replay                                                                  */
+/*!
+    Replay a recorded variable server call
+
+    The Replay function returns the recorded result of the call, and
+    writes the recorded expansion of a template to the working buffer.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the request to replay
+
+    @retval recorded result of the variable server call
+    @retval ENOENT the call was not recorded
+    @retval EPROTO the replay has diverged from the recording
+
+============================================================================*/
+static int Replay( VarCall *pVarCall, Request *pRequest )
+{
+    int result;
+    VarLogEntry entry;
+    size_t len;
+
+    if ( pRequest->type == CALL_SET )
+    {
+        result = VARLOG_Next( pVarCall->options.pLog,
+                              VARLOG_SET,
+                              pRequest->pName,
+                              &entry );
+    }
+    else
+    {
+        result = VARLOG_Next( pVarCall->options.pLog,
+                              VARLOG_EXPAND,
+                              pRequest->pValue,
+                              &entry );
+        if ( result == EOK )
+        {
+            /* leave room for the NUL terminator */
+            len = ( entry.len < pRequest->len ) ? entry.len
+                                                : pRequest->len - 1;
+            if ( write( pRequest->fd, entry.pData, len ) != (ssize_t)len )
+            {
+                entry.result = errno;
+            }
+        }
+    }
+
+    return ( result == EOK ) ? entry.result : result;
+}
+
+/*==========================================================================*/
+/*  Call                                                                    */
+/*!
+    Make a variable server call with retries
+
+    The Call function makes a variable server call, retrying it after
+    a backoff delay if it fails with a transient error or times out,
+    up to the configured number of retries and the run deadline.
+    When writes are paced, a write first waits out any gap requested
+    by the pacing controller, and its latency is fed back to it.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the request to make
+
+    @retval result of the variable server call
+    @retval ETIMEDOUT the call did not complete before its deadline
+
+============================================================================*/
+static int Call( VarCall *pVarCall, Request *pRequest )
+{
+    int result = ETIMEDOUT;
+    CallStats *pStats = &pVarCall->stats[pRequest->type];
+    bool paced = ( pRequest->type == CALL_SET ) &&
+                 ( pVarCall->pPacer != NULL );
+    uint64_t start;
+    unsigned int attempt;
+
+    if ( paced == true )
+    {
+        Pause( pVarCall, PACER_Delay( pVarCall->pPacer ) );
+    }
+
+    start = Now();
+
+    for ( attempt = 0; attempt <= pVarCall->options.retries; attempt++ )
+    {
+        if ( attempt > 0 )
+        {
+            pStats->retries++;
+            Backoff( pVarCall, attempt );
+        }
+
+        if ( Now() >= pVarCall->runDeadline )
+        {
+            result = ETIMEDOUT;
+            break;
+        }
+
+        result = Attempt( pVarCall, pRequest, CallDeadline( pVarCall ) );
+        if ( result == ETIMEDOUT )
+        {
+            pStats->timeouts++;
+        }
+
+        if ( IsTransient( result ) == false )
+        {
+            break;
+        }
+    }
+
+    if ( result != EOK )
+    {
+        pStats->failures++;
+    }
+
+    if ( paced == true )
+    {
+        PACER_Record( pVarCall->pPacer, Now() - start );
+    }
+
+    Record( pStats, start );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Attempt                                                                 */
+/*!
+    Make a single attempt at a variable server call
+
+    The Attempt function waits for any outstanding call to complete and
+    then submits the request to the worker thread and waits for its
+    result, up to the specified deadline.  If the request itself is
+    still outstanding from a previous attempt, its result is used
+    instead of submitting it again.
+
+    Without a worker thread the call is made directly.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the request to make
+
+    @param[in]
+        deadline
+            time by which the attempt must complete
+
+    @retval result of the variable server call
+    @retval ETIMEDOUT the call did not complete before its deadline
+
+============================================================================*/
+static int Attempt( VarCall *pVarCall, Request *pRequest, uint64_t deadline )
+{
+    int result = ETIMEDOUT;
+    bool done = false;
+
+    if ( pVarCall->threaded == false )
+    {
+        result = Execute( pVarCall, pRequest );
+    }
+    else
+    {
+        pthread_mutex_lock( &pVarCall->lock );
+
+        /* wait for any outstanding call */
+        while ( ( done == false ) &&
+                ( pVarCall->state != REQUEST_IDLE ) )
+        {
+            if ( pVarCall->state == REQUEST_DONE )
+            {
+                if ( pVarCall->request.id == pRequest->id )
+                {
+                    /* a previous attempt of this request has completed */
+                    result = pVarCall->request.result;
+                    FreeRequest( &pVarCall->request );
+                    pVarCall->state = REQUEST_IDLE;
+                    done = true;
+                }
+                else
+                {
+                    Reap( pVarCall );
+                }
+            }
+            else if ( WaitSignal( pVarCall, deadline ) == false )
+            {
+                done = true;
+            }
+        }
+
+        if ( done == false )
+        {
+            /* submit a copy of the request which the worker thread owns */
+            pVarCall->request = *pRequest;
+            pVarCall->request.pName = ( pRequest->pName != NULL )
+                                        ? strdup( pRequest->pName )
+                                        : NULL;
+            pVarCall->request.pValue = strdup( pRequest->pValue );
+            pVarCall->request.pFileName = ( pRequest->pFileName != NULL )
+                                            ? strdup( pRequest->pFileName )
+                                            : NULL;
+            pVarCall->state = REQUEST_SUBMITTED;
+            pthread_cond_broadcast( &pVarCall->cond );
+
+            while ( ( pVarCall->state != REQUEST_DONE ) &&
+                    ( WaitSignal( pVarCall, deadline ) == true ) );
+
+            if ( pVarCall->state == REQUEST_DONE )
+            {
+                result = pVarCall->request.result;
+                FreeRequest( &pVarCall->request );
+                pVarCall->state = REQUEST_IDLE;
+            }
+        }
+
+        pthread_mutex_unlock( &pVarCall->lock );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  WaitIdle                                                                */
+/*!
+    Wait for any outstanding call to complete
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        deadline
+            time by which the outstanding call must complete
+
+    @retval true no call is outstanding
+    @retval false a call is still outstanding at the deadline
+
+============================================================================*/
+static bool WaitIdle( VarCall *pVarCall, uint64_t deadline )
+{
+    bool result = true;
+
+    if ( pVarCall->threaded == true )
+    {
+        pthread_mutex_lock( &pVarCall->lock );
+
+        Reap( pVarCall );
+        while ( ( pVarCall->state != REQUEST_IDLE ) &&
+                ( WaitSignal( pVarCall, deadline ) == true ) )
+        {
+            Reap( pVarCall );
+        }
+
+        result = ( pVarCall->state == REQUEST_IDLE );
+
+        pthread_mutex_unlock( &pVarCall->lock );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  WaitSignal                                                              */
+/*!
+    Wait for the request slot to change
+
+    The WaitSignal function must be called with the lock held.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        deadline
+            time to stop waiting
+
+    @retval true the deadline has not passed
+    @retval false the deadline has passed
+
+============================================================================*/
+static bool WaitSignal( VarCall *pVarCall, uint64_t deadline )
+{
+    struct timespec ts;
+    bool result = true;
+
+    if ( deadline == NO_DEADLINE )
+    {
+        pthread_cond_wait( &pVarCall->cond, &pVarCall->lock );
+    }
+    else if ( Now() < deadline )
+    {
+        ts.tv_sec = deadline / NS_PER_S;
+        ts.tv_nsec = deadline % NS_PER_S;
+        pthread_cond_timedwait( &pVarCall->cond, &pVarCall->lock, &ts );
+    }
+    else
+    {
+        result = false;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  Reap                                                                    */
+/*!
+    Collect the result of a call which the caller stopped waiting for
+
+    The Reap function must be called with the lock held.  If a completed
+    queued write failed, the failure is reported, otherwise the write
+    is confirmed.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+============================================================================*/
+static void Reap( VarCall *pVarCall )
+{
+    Request *pRequest = &pVarCall->request;
+
+    if ( pVarCall->state == REQUEST_DONE )
+    {
+        if ( ( pRequest->report == true ) &&
+             ( pRequest->result != EOK ) )
+        {
+            ReportFailure( pVarCall, pRequest, pRequest->result );
+            pVarCall->lateFailures++;
+        }
+        else if ( pRequest->report == true )
+        {
+            Confirm( pVarCall, pRequest );
+        }
+
+        FreeRequest( pRequest );
+        pVarCall->state = REQUEST_IDLE;
+    }
+}
+
+/*==========================================================================*/
+/*  FreeRequest                                                             */
+/*!
+    Release the strings owned by a submitted request
+
+    @param[in]
+        pRequest
+            pointer to the request
+
+============================================================================*/
+static void FreeRequest( Request *pRequest )
+{
+    free( pRequest->pName );
+    free( pRequest->pValue );
+    free( pRequest->pFileName );
+
+    pRequest->pName = NULL;
+    pRequest->pValue = NULL;
+    pRequest->pFileName = NULL;
+}
+
+/*==========================================================================*/
+/*  Connect                                                                 */
+/*!
+    Make sure there is a connection to the variable server
+
+    The Connect function attempts to open the variable server if it is
+    not yet open.  Attempts are spaced by the backoff delay, and are
+    repeated until the deadline.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        deadline
+            time to stop trying to connect
+
+    @retval true the variable server is open
+    @retval false the variable server could not be opened
+
+============================================================================*/
+static bool Connect( VarCall *pVarCall, uint64_t deadline )
+{
+    unsigned int attempt = 0;
+    uint64_t now = Now();
+
+    while ( pVarCall->hVarServer == NULL )
+    {
+        if ( now >= pVarCall->nextOpen )
+        {
+            pVarCall->hVarServer = OpenServer( pVarCall );
+            pVarCall->nextOpen = now + pVarCall->options.backoffMs * NS_PER_MS;
+        }
+
+        if ( ( pVarCall->hVarServer == NULL ) &&
+             ( now < deadline ) )
+        {
+            Backoff( pVarCall, ++attempt );
+            now = Now();
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return ( pVarCall->hVarServer != NULL );
+}
+
+/*==========================================================================*/
+/*  OpenServer                                                              */
+/*!
+    Open a handle to the variable server
+
+    When a log is being replayed, the recorded result of the open is
+    returned and no connection is made.  A placeholder handle is returned
+    once there are no more recorded failures to open.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @retval handle to the variable server
+    @retval NULL the variable server could not be opened
+
+============================================================================*/
+static VARSERVER_HANDLE OpenServer( VarCall *pVarCall )
+{
+    VARSERVER_HANDLE hVarServer = NULL;
+    VarLog *pLog = pVarCall->options.pLog;
+    VarLogEntry entry;
+    uint64_t start = Now();
+
+    if ( VARLOG_IsReplay( pLog ) == true )
+    {
+        if ( ( VARLOG_Next( pLog, VARLOG_OPEN, NULL, &entry ) != EOK ) ||
+             ( entry.result == EOK ) )
+        {
+            hVarServer = (VARSERVER_HANDLE)pVarCall;
+        }
+    }
+    else
+    {
+        hVarServer = VARSERVER_Open();
+        VARLOG_Add( pLog,
+                    VARLOG_OPEN,
+                    ( hVarServer != NULL ) ? EOK : ENOTCONN,
+                    Now() - start,
+                    NULL,
+                    NULL,
+                    0 );
+    }
+
+    return hVarServer;
+}
+
+/*==========================================================================*/
+/*  Enqueue                                                                 */
+/*!
+    Queue a write until the variable server is available
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the write request
+
+    @retval EINPROGRESS the write was queued
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int Enqueue( VarCall *pVarCall, Request *pRequest )
+{
+    int result = ENOMEM;
+
+    if ( pVarCall->pQueue == NULL )
+    {
+        pVarCall->pQueue = ASSIGNLIST_Create();
+        pVarCall->queueHead = 0;
+    }
+
+    if ( ( pVarCall->pQueue != NULL ) &&
+         ( ASSIGNLIST_Add( pVarCall->pQueue,
+                           pRequest->pName,
+                           pRequest->pValue,
+                           pRequest->pFileName,
+                           pRequest->lineno ) == EOK ) )
+    {
+        pVarCall->queued++;
+        result = EINPROGRESS;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  DrainQueue                                                              */
+/*!
+    Apply queued writes
+
+    The DrainQueue function applies queued writes in order while the
+    variable server is available, up to the specified deadline.  A write
+    which times out is left outstanding and its result is checked when
+    it completes.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        deadline
+            time to stop waiting for the variable server
+
+============================================================================*/
+static void DrainQueue( VarCall *pVarCall, uint64_t deadline )
+{
+    Assignment *pAssignment;
+    Request request;
+    unsigned int attempt = 0;
+    uint64_t start;
+    uint64_t limit;
+    int rc;
+
+    while ( ( pVarCall->pQueue != NULL ) &&
+            ( pVarCall->queueHead < pVarCall->pQueue->count ) &&
+            ( Connect( pVarCall, deadline ) == true ) &&
+            ( WaitIdle( pVarCall, deadline ) == true ) )
+    {
+        pAssignment = &pVarCall->pQueue->pAssignments[pVarCall->queueHead];
+
+        memset( &request, 0, sizeof( request ) );
+        request.type = CALL_SET;
+        request.id = ++pVarCall->lastId;
+        request.pName = pAssignment->pName;
+        request.pValue = pAssignment->pValue;
+        request.pFileName = pAssignment->pFileName;
+        request.lineno = pAssignment->lineno;
+        request.report = true;
+
+        start = Now();
+        limit = CallDeadline( pVarCall );
+        rc = Attempt( pVarCall, &request, limit );
+        Record( &pVarCall->stats[CALL_SET], start );
+
+        if ( rc == ETIMEDOUT )
+        {
+            /* the write is outstanding, and is checked when it completes */
+            pVarCall->stats[CALL_SET].timeouts++;
+            pVarCall->queueHead++;
+        }
+        else if ( IsTransient( rc ) == true )
+        {
+            if ( Now() >= deadline )
+            {
+                break;
+            }
+
+            pVarCall->stats[CALL_SET].retries++;
+            Backoff( pVarCall, ++attempt );
+        }
+        else
+        {
+            if ( rc != EOK )
+            {
+                ReportFailure( pVarCall, &request, rc );
+                pVarCall->lateFailures++;
+                pVarCall->stats[CALL_SET].failures++;
+            }
+            else
+            {
+                Confirm( pVarCall, &request );
+            }
+
+            attempt = 0;
+            pVarCall->queueHead++;
+        }
+    }
+
+    if ( ( pVarCall->pQueue != NULL ) &&
+         ( pVarCall->queueHead == pVarCall->pQueue->count ) )
+    {
+        ASSIGNLIST_Free( pVarCall->pQueue );
+        pVarCall->pQueue = NULL;
+        pVarCall->queueHead = 0;
+    }
+}
+
+/*==========================================================================*/
+/*  ReportFailure                                                           */
+/*!
+    Report a failed write which was not reported to the caller
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the failed write request
+
+    @param[in]
+        rc
+            result of the write
+
+============================================================================*/
+static void ReportFailure( VarCall *pVarCall, Request *pRequest, int rc )
+{
+    fprintf( stderr,
+             "%s: '%s' in %s on line %d%s%s%s\n",
+             ( rc == ENOENT ) ? "Variable not found"
+                              : "Variable assignment failed",
+             pRequest->pName,
+             pRequest->pFileName,
+             pRequest->lineno,
+             ( pVarCall->pLabel != NULL ) ? " [" : "",
+             ( pVarCall->pLabel != NULL ) ? pVarCall->pLabel : "",
+             ( pVarCall->pLabel != NULL ) ? "]" : "" );
+}
+
+/*==========================================================================*/
+/*  Confirm                                                                 */
+/*!
+    Confirm a deferred write which was applied
+
+    The Confirm function passes a queued write, or a write which
+    completed after the caller stopped waiting for it, to the confirm
+    function of the call options.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        pRequest
+            pointer to the applied write request
+
+============================================================================*/
+static void Confirm( VarCall *pVarCall, Request *pRequest )
+{
+    if ( ( pVarCall->options.confirm != NULL ) &&
+         ( pRequest->type == CALL_SET ) )
+    {
+        pVarCall->options.confirm( pVarCall->options.pConfirmArg,
+                                   pRequest->pName,
+                                   pRequest->pValue );
+    }
+}
+
+/*==========================================================================*/
+/*  IsTransient                                                             */
+/*!
+    Check if a call error is transient
+
+    @param[in]
+        rc
+            result of a variable server call
+
+    @retval true the call may succeed if it is retried
+    @retval false the call should not be retried
+
+============================================================================*/
+static bool IsTransient( int rc )
+{
+    return ( rc == ETIMEDOUT ) ||
+           ( rc == EAGAIN ) ||
+           ( rc == EBUSY ) ||
+           ( rc == EINTR );
+}
+
+/*==========================================================================*/
+/*  Backoff                                                                 */
+/*!
+    Wait before retrying a call
+
+    The Backoff function sleeps for an exponentially increasing delay
+    with random jitter.  The delay for the specified attempt lies
+    between half and all of the base delay doubled once per attempt.
+    The delay never extends beyond the run deadline.
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        attempt
+            number of the retry attempt, starting from 1
+
+============================================================================*/
+static void Backoff( VarCall *pVarCall, unsigned int attempt )
+{
+    unsigned int shift;
+    uint64_t delay;
+
+    shift = ( attempt > MAX_BACKOFF_SHIFT ) ? MAX_BACKOFF_SHIFT : attempt - 1;
+    delay = ( pVarCall->options.backoffMs * NS_PER_MS ) << shift;
+    delay = delay / 2 + (uint64_t)rand_r( &pVarCall->seed ) % ( delay / 2 + 1 );
+
+    Pause( pVarCall, delay );
+}
+
+/*==========================================================================*/
+/*  Pause                                                                   */
+/*!
+    Sleep without passing the run deadline
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @param[in]
+        delay
+            time to sleep in nanoseconds
+
+============================================================================*/
+static void Pause( VarCall *pVarCall, uint64_t delay )
+{
+    struct timespec ts;
+    uint64_t now;
+
+    if ( delay > 0 )
+    {
+        now = Now();
+        if ( ( pVarCall->runDeadline != NO_DEADLINE ) &&
+             ( now + delay > pVarCall->runDeadline ) )
+        {
+            delay = ( pVarCall->runDeadline > now )
+                        ? pVarCall->runDeadline - now
+                        : 0;
+        }
+
+        ts.tv_sec = delay / NS_PER_S;
+        ts.tv_nsec = delay % NS_PER_S;
+        while ( ( nanosleep( &ts, &ts ) == -1 ) && ( errno == EINTR ) );
+    }
+}
+
+/*==========================================================================*/
+/*  CallDeadline                                                            */
+/*!
+    Get the deadline for a call made now
+
+    @param[in]
+        pVarCall
+            pointer to the call context
+
+    @retval the earlier of the call deadline and the run deadline
+
+============================================================================*/
+static uint64_t CallDeadline( VarCall *pVarCall )
+{
+    uint64_t deadline = pVarCall->runDeadline;
+    uint64_t limit;
+
+    if ( pVarCall->options.callTimeoutMs > 0 )
+    {
+        limit = Now() + pVarCall->options.callTimeoutMs * NS_PER_MS;
+        if ( limit < deadline )
+        {
+            deadline = limit;
+        }
+    }
+
+    return deadline;
+}
+
+/*==========================================================================*/
+/*  Now                                                                     */
+/*!
+    Get the current monotonic time
+
+    @retval current monotonic time in nanoseconds
+
+============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return (uint64_t)ts.tv_sec * NS_PER_S + ts.tv_nsec;
+}
+
+/*==========================================================================*/
+/*  Record                                                                  */
+/*!
+    Record the latency of a call
+
+    @param[in]
+        pStats
+            pointer to the statistics for the call type
+
+    @param[in]
+        start
+            time the call started
+
+============================================================================*/
+static void Record( CallStats *pStats, uint64_t start )
+{
+    uint64_t us = ( Now() - start ) / 1000;
+    uint32_t *pSamples;
+    size_t n;
+
+    if ( pStats->count == pStats->size )
+    {
+        n = ( pStats->size == 0 ) ? 256 : pStats->size * 2;
+        pSamples = realloc( pStats->pSamples, n * sizeof( uint32_t ) );
+        if ( pSamples != NULL )
+        {
+            pStats->pSamples = pSamples;
+            pStats->size = n;
+        }
+    }
+
+    if ( pStats->count < pStats->size )
+    {
+        pStats->pSamples[pStats->count++] =
+            ( us > UINT32_MAX ) ? UINT32_MAX : (uint32_t)us;
+    }
+}
+
+/*==========================================================================*/
+/*  CompareSamples                                                          */
+/*!
+    Compare two latency samples for sorting
+
+    @param[in]
+        p1
+            pointer to the first sample
+
+    @param[in]
+        p2
+            pointer to the second sample
+
+    @retval -1, 0 or 1 as the first sample is less than, equal to
+            or greater than the second
+
+============================================================================*/
+static int CompareSamples( const void *p1, const void *p2 )
+{
+    uint32_t s1 = *(const uint32_t *)p1;
+    uint32_t s2 = *(const uint32_t *)p2;
+
+    return ( s1 > s2 ) - ( s1 < s2 );
+}
+
+/*! @}
+ * end of varcall group */
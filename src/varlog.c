@@ -0,0 +1,829 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup varlog varlog
+ * @brief Record and replay of variable server interactions
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file varlog.c
+
+    Variable Server Record and Replay Log
+
+    The Variable Server Record and Replay Log functions capture every
+    interaction between the loader and the variable server, together
+    with the configuration files which were read, in a compact binary
+    log.  The log can be replayed in place of the variable server and
+    the file system so that a load on a unit in the field can be
+    reproduced and benchmarked elsewhere.
+
+    The log starts with a header holding the magic string "LCVL" and
+    the format version, followed by one record per interaction in
+    native byte order:
+
+    type (1 byte), result (4 bytes), latency in microseconds (4 bytes),
+    key length (4 bytes), key, data length (4 bytes), data
+
+    The key and data lengths include a terminating NUL character.
+    The key is the variable name, template, or file name, and the data
+    is the value set, the expanded template, or the file contents.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "varlog.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! log file magic string */
+#define VARLOG_MAGIC        "LCVL"
+
+/*! log file format version */
+#define VARLOG_VERSION      1
+
+/*! size of the fixed part of a record */
+#define VARLOG_RECORD_SIZE  ( 1 + 4 + 4 + 4 )
+
+/*! nanoseconds per microsecond */
+#define NS_PER_US           1000ULL
+
+/*! recorded interaction */
+typedef struct _VarLogRecord
+{
+    /*! type of interaction */
+    VarLogType type;
+
+    /*! recorded result */
+    int result;
+
+    /*! recorded latency in microseconds */
+    uint32_t latencyUs;
+
+    /*! pointer to the NUL terminated key */
+    char *pKey;
+
+    /*! pointer to the NUL terminated data */
+    char *pData;
+
+    /*! length of the data excluding the NUL terminator */
+    size_t len;
+
+} VarLogRecord;
+
+/*! record or replay log */
+struct _VarLog
+{
+    /*! lock serializing access from the caller and call worker threads */
+    pthread_mutex_t lock;
+
+    /*! output stream when recording, or NULL when replaying */
+    FILE *fp;
+
+    /*! a record could not be written */
+    bool failed;
+
+    /*! log file contents when replaying */
+    char *pBuf;
+
+    /*! records when replaying */
+    VarLogRecord *pRecords;
+
+    /*! number of records */
+    size_t count;
+
+    /*! index of the next record of each type to replay */
+    size_t cursor[VARLOG_NUM_TYPES];
+
+    /*! replay at the recorded latency */
+    bool latency;
+
+    /*! the replay has diverged from the recording */
+    bool diverged;
+};
+
+/*! names of the interaction types */
+static const char *typeNames[VARLOG_NUM_TYPES] =
+{
+    "open",
+    "set",
+    "expand",
+    "file"
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static VarLog *NewLog( void );
+static bool WriteField( VarLog *pLog, const void *p, size_t len );
+static bool WriteString( VarLog *pLog, char *pStr, size_t len );
+static char *ReadLogFile( char *pFileName, size_t *pSize );
+static int ParseLog( VarLog *pLog, size_t size );
+static char *ParseString( char *pBuf, size_t size, size_t *pOffset );
+static void Delay( uint32_t latencyUs );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  VARLOG_Create                                                           */
+/*!
+    Create a log to record into
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the log file to create
+
+    @retval pointer to the log
+    @retval NULL the log could not be created
+
+============================================================================*/
+VarLog *VARLOG_Create( char *pFileName )
+{
+    VarLog *pLog = NULL;
+    uint32_t version = VARLOG_VERSION;
+
+    if ( pFileName != NULL )
+    {
+        pLog = NewLog();
+    }
+
+    if ( pLog != NULL )
+    {
+        pLog->fp = fopen( pFileName, "wb" );
+        if ( ( pLog->fp == NULL ) ||
+             ( WriteField( pLog, VARLOG_MAGIC, 4 ) == false ) ||
+             ( WriteField( pLog, &version, sizeof( version ) ) == false ) )
+        {
+            VARLOG_Close( pLog );
+            pLog = NULL;
+        }
+    }
+
+    return pLog;
+}
+
+/*==========================================================================*/
+/*  VARLOG_Load                                                             */
+/*!
+    Load a log to replay
+
+    A log whose last record is incomplete, for example because the
+    recording was interrupted, is replayed up to its last complete record.
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the log file to load
+
+    @param[in]
+        latency
+            true to replay each interaction at its recorded latency,
+            false to replay with no delay
+
+    @retval pointer to the log
+    @retval NULL the log could not be loaded
+
+============================================================================*/
+VarLog *VARLOG_Load( char *pFileName, bool latency )
+{
+    VarLog *pLog = NULL;
+    size_t size = 0;
+
+    if ( pFileName != NULL )
+    {
+        pLog = NewLog();
+    }
+
+    if ( pLog != NULL )
+    {
+        pLog->latency = latency;
+        pLog->pBuf = ReadLogFile( pFileName, &size );
+        if ( ( pLog->pBuf == NULL ) ||
+             ( ParseLog( pLog, size ) != EOK ) )
+        {
+            VARLOG_Close( pLog );
+            pLog = NULL;
+        }
+    }
+
+    return pLog;
+}
+
+/*==========================================================================*/
+/*  VARLOG_IsReplay                                                         */
+/*!
+    Check if a log is being replayed
+
+    @param[in]
+        pLog
+            pointer to the log, or NULL
+
+    @retval true the log is being replayed
+    @retval false the log is being recorded, or there is no log
+
+============================================================================*/
+bool VARLOG_IsReplay( VarLog *pLog )
+{
+    return ( pLog != NULL ) && ( pLog->pBuf != NULL );
+}
+
+/*==========================================================================*/
+/*  VARLOG_Add                                                              */
+/*!
+    Record an interaction
+
+    @param[in]
+        pLog
+            pointer to the log.  If NULL, or if the log is being
+            replayed, nothing is recorded.
+
+    @param[in]
+        type
+            type of interaction
+
+    @param[in]
+        result
+            result of the interaction
+
+    @param[in]
+        latencyNs
+            duration of the interaction in nanoseconds
+
+    @param[in]
+        pKey
+            pointer to the NUL terminated variable name, template or
+            file name, or NULL for none
+
+    @param[in]
+        pData
+            pointer to the value set, expanded template or file contents,
+            or NULL for none
+
+    @param[in]
+        len
+            length of the data
+
+============================================================================*/
+void VARLOG_Add( VarLog *pLog,
+                 VarLogType type,
+                 int result,
+                 uint64_t latencyNs,
+                 char *pKey,
+                 char *pData,
+                 size_t len )
+{
+    uint8_t t = (uint8_t)type;
+    int32_t rc = result;
+    uint64_t us = latencyNs / NS_PER_US;
+    uint32_t latencyUs = ( us > UINT32_MAX ) ? UINT32_MAX : (uint32_t)us;
+
+    if ( ( pLog != NULL ) &&
+         ( pLog->fp != NULL ) )
+    {
+        pthread_mutex_lock( &pLog->lock );
+
+        if ( ( WriteField( pLog, &t, sizeof( t ) ) == false ) ||
+             ( WriteField( pLog, &rc, sizeof( rc ) ) == false ) ||
+             ( WriteField( pLog, &latencyUs, sizeof( latencyUs ) ) == false ) ||
+             ( WriteString( pLog,
+                            pKey,
+                            ( pKey != NULL ) ? strlen( pKey ) : 0 ) == false ) ||
+             ( WriteString( pLog, pData, len ) == false ) )
+        {
+            pLog->failed = true;
+        }
+
+        pthread_mutex_unlock( &pLog->lock );
+    }
+}
+
+/*==========================================================================*/
+/*  VARLOG_Next                                                             */
+/*!
+    Replay the next interaction of the specified type
+
+    The VARLOG_Next function gets the next recorded interaction of the
+    specified type.  The replay has diverged from the recording if the
+    key of the recorded interaction does not match, or there are no
+    more interactions of the type.  The first divergence is reported.
+
+    If the log is replayed at the recorded latency, the function waits
+    for the recorded duration of the interaction before returning.
+
+    @param[in]
+        pLog
+            pointer to the log being replayed
+
+    @param[in]
+        type
+            type of interaction
+
+    @param[in]
+        pKey
+            pointer to the NUL terminated key the interaction must
+            match, or NULL to match any key
+
+    @param[out]
+        pEntry
+            pointer to a location to store the recorded interaction
+
+    @retval EOK the recorded interaction was found
+    @retval EINVAL invalid arguments
+    @retval ENOENT there are no more interactions of the type
+    @retval EPROTO the recorded interaction has a different key
+
+============================================================================*/
+int VARLOG_Next( VarLog *pLog,
+                 VarLogType type,
+                 char *pKey,
+                 VarLogEntry *pEntry )
+{
+    int result = EINVAL;
+    VarLogRecord *pRecord = NULL;
+    size_t i;
+
+    if ( ( VARLOG_IsReplay( pLog ) == true ) &&
+         ( type < VARLOG_NUM_TYPES ) &&
+         ( pEntry != NULL ) )
+    {
+        pthread_mutex_lock( &pLog->lock );
+
+        i = pLog->cursor[type];
+        while ( ( i < pLog->count ) &&
+                ( pLog->pRecords[i].type != type ) )
+        {
+            i++;
+        }
+
+        if ( i >= pLog->count )
+        {
+            result = ENOENT;
+        }
+        else if ( ( pKey != NULL ) &&
+                  ( strcmp( pLog->pRecords[i].pKey, pKey ) != 0 ) )
+        {
+            result = EPROTO;
+        }
+        else
+        {
+            pRecord = &pLog->pRecords[i];
+            pLog->cursor[type] = i + 1;
+
+            pEntry->result = pRecord->result;
+            pEntry->pData = pRecord->pData;
+            pEntry->len = pRecord->len;
+            result = EOK;
+        }
+
+        if ( ( result != EOK ) &&
+             ( type != VARLOG_OPEN ) &&
+             ( pLog->diverged == false ) )
+        {
+            pLog->diverged = true;
+            fprintf( stderr,
+                     "Replay diverged at %s '%s'\n",
+                     typeNames[type],
+                     ( pKey != NULL ) ? pKey : "" );
+        }
+
+        pthread_mutex_unlock( &pLog->lock );
+    }
+
+    if ( ( pRecord != NULL ) &&
+         ( pLog->latency == true ) )
+    {
+        Delay( pRecord->latencyUs );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARLOG_GetFile                                                          */
+/*!
+    Replay a configuration file read
+
+    The VARLOG_GetFile function gets the contents of a configuration
+    file as it was read when the log was recorded.
+
+    @param[in]
+        pLog
+            pointer to the log being replayed
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the configuration file
+
+    @retval pointer to a copy of the file contents, to be freed by the caller
+    @retval NULL the file was not read or did not exist when recording
+
+============================================================================*/
+char *VARLOG_GetFile( VarLog *pLog, char *pFileName )
+{
+    char *pData = NULL;
+    VarLogRecord *pRecord = NULL;
+    size_t i;
+
+    if ( ( VARLOG_IsReplay( pLog ) == true ) &&
+         ( pFileName != NULL ) )
+    {
+        for ( i = 0; ( i < pLog->count ) && ( pRecord == NULL ); i++ )
+        {
+            if ( ( pLog->pRecords[i].type == VARLOG_FILE ) &&
+                 ( strcmp( pLog->pRecords[i].pKey, pFileName ) == 0 ) )
+            {
+                pRecord = &pLog->pRecords[i];
+            }
+        }
+    }
+
+    if ( pRecord != NULL )
+    {
+        if ( pLog->latency == true )
+        {
+            Delay( pRecord->latencyUs );
+        }
+
+        if ( pRecord->result == EOK )
+        {
+            pData = strdup( pRecord->pData );
+        }
+    }
+
+    return pData;
+}
+
+/*==========================================================================*/
+/*  VARLOG_Close                                                            */
+/*!
+    Close a log
+
+    The VARLOG_Close function completes a recording, or releases
+    a replayed log.
+
+    @param[in]
+        pLog
+            pointer to the log to close
+
+    @retval EOK the log was closed
+    @retval EINVAL invalid arguments
+    @retval EIO one or more records could not be written
+
+============================================================================*/
+int VARLOG_Close( VarLog *pLog )
+{
+    int result = EINVAL;
+
+    if ( pLog != NULL )
+    {
+        result = EOK;
+
+        if ( pLog->fp != NULL )
+        {
+            pthread_mutex_lock( &pLog->lock );
+
+            if ( ( fclose( pLog->fp ) != 0 ) ||
+                 ( pLog->failed == true ) )
+            {
+                result = EIO;
+            }
+
+            pLog->fp = NULL;
+            pthread_mutex_unlock( &pLog->lock );
+        }
+
+        pthread_mutex_destroy( &pLog->lock );
+        free( pLog->pRecords );
+        free( pLog->pBuf );
+        free( pLog );
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  NewLog                                                                  */
+/*!
+    Allocate an empty log
+
+    @retval pointer to the log
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static VarLog *NewLog( void )
+{
+    VarLog *pLog;
+
+    pLog = calloc( 1, sizeof( VarLog ) );
+    if ( pLog != NULL )
+    {
+        pthread_mutex_init( &pLog->lock, NULL );
+    }
+
+    return pLog;
+}
+
+/*==========================================================================*/
+/*  WriteField                                                              */
+/*!
+    Write a field of a record
+
+    @param[in]
+        pLog
+            pointer to the log being recorded
+
+    @param[in]
+        p
+            pointer to the field
+
+    @param[in]
+        len
+            length of the field
+
+    @retval true the field was written
+    @retval false the field could not be written
+
+============================================================================*/
+static bool WriteField( VarLog *pLog, const void *p, size_t len )
+{
+    return ( len == 0 ) || ( fwrite( p, len, 1, pLog->fp ) == 1 );
+}
+
+/*==========================================================================*/
+/*  WriteString                                                             */
+/*!
+    Write a length prefixed, NUL terminated string field of a record
+
+    @param[in]
+        pLog
+            pointer to the log being recorded
+
+    @param[in]
+        pStr
+            pointer to the string, or NULL for an empty string
+
+    @param[in]
+        len
+            length of the string excluding any NUL terminator
+
+    @retval true the field was written
+    @retval false the field could not be written
+
+============================================================================*/
+static bool WriteString( VarLog *pLog, char *pStr, size_t len )
+{
+    uint32_t n = ( pStr != NULL ) ? (uint32_t)len + 1 : 1;
+
+    return ( WriteField( pLog, &n, sizeof( n ) ) == true ) &&
+           ( WriteField( pLog, pStr, n - 1 ) == true ) &&
+           ( WriteField( pLog, "", 1 ) == true );
+}
+
+/*==========================================================================*/
+/*  ReadLogFile                                                             */
+/*!
+    Read a log file into memory
+
+    @param[in]
+        pFileName
+            pointer to the NUL terminated name of the log file
+
+    @param[out]
+        pSize
+            pointer to a location to store the size of the log
+
+    @retval pointer to the log file contents
+    @retval NULL the log file could not be read
+
+============================================================================*/
+static char *ReadLogFile( char *pFileName, size_t *pSize )
+{
+    FILE *fp;
+    char *pBuf = NULL;
+    long size;
+
+    fp = fopen( pFileName, "rb" );
+    if ( fp != NULL )
+    {
+        if ( ( fseek( fp, 0, SEEK_END ) == 0 ) &&
+             ( ( size = ftell( fp ) ) > 0 ) &&
+             ( fseek( fp, 0, SEEK_SET ) == 0 ) )
+        {
+            pBuf = malloc( size );
+            if ( ( pBuf != NULL ) &&
+                 ( fread( pBuf, size, 1, fp ) != 1 ) )
+            {
+                free( pBuf );
+                pBuf = NULL;
+            }
+
+            *pSize = size;
+        }
+
+        fclose( fp );
+    }
+
+    return pBuf;
+}
+
+/*==========================================================================*/
+/*  ParseLog                                                                */
+/*!
+    Index the records of a loaded log
+
+    @param[in]
+        pLog
+            pointer to the log whose contents have been loaded
+
+    @param[in]
+        size
+            size of the log contents
+
+    @retval EOK the log was indexed
+    @retval EINVAL the log is not a record and replay log
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int ParseLog( VarLog *pLog, size_t size )
+{
+    int result = EINVAL;
+    char *pBuf = pLog->pBuf;
+    size_t offset = 8;
+    size_t n = 0;
+    size_t start;
+    VarLogRecord record;
+    VarLogRecord *pRecords;
+    uint32_t version;
+    int32_t rc;
+
+    if ( ( size >= offset ) &&
+         ( memcmp( pBuf, VARLOG_MAGIC, 4 ) == 0 ) )
+    {
+        memcpy( &version, &pBuf[4], sizeof( version ) );
+        if ( version == VARLOG_VERSION )
+        {
+            result = EOK;
+        }
+    }
+
+    while ( ( result == EOK ) &&
+            ( offset + VARLOG_RECORD_SIZE <= size ) )
+    {
+        start = offset;
+        record.type = (VarLogType)(uint8_t)pBuf[offset];
+        memcpy( &rc, &pBuf[offset + 1], sizeof( rc ) );
+        memcpy( &record.latencyUs, &pBuf[offset + 5], sizeof( uint32_t ) );
+        record.result = rc;
+        offset += VARLOG_RECORD_SIZE - 4;
+
+        record.pKey = ParseString( pBuf, size, &offset );
+        record.pData = ( record.pKey != NULL )
+                        ? ParseString( pBuf, size, &offset )
+                        : NULL;
+
+        if ( ( record.pData == NULL ) ||
+             ( record.type >= VARLOG_NUM_TYPES ) )
+        {
+            /* ignore an incomplete last record */
+            offset = start;
+            break;
+        }
+
+        record.len = offset - (size_t)( record.pData - pBuf ) - 1;
+
+        if ( pLog->count == n )
+        {
+            n = ( n > 0 ) ? n * 2 : 256;
+            pRecords = realloc( pLog->pRecords, n * sizeof( VarLogRecord ) );
+            if ( pRecords == NULL )
+            {
+                result = ENOMEM;
+                break;
+            }
+
+            pLog->pRecords = pRecords;
+        }
+
+        pLog->pRecords[pLog->count++] = record;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  ParseString                                                             */
+/*!
+    Parse a length prefixed, NUL terminated string field of a record
+
+    @param[in]
+        pBuf
+            pointer to the log contents
+
+    @param[in]
+        size
+            size of the log contents
+
+    @param[in,out]
+        pOffset
+            pointer to the offset of the field, which is advanced past it
+
+    @retval pointer to the NUL terminated string
+    @retval NULL the field is incomplete or invalid
+
+============================================================================*/
+static char *ParseString( char *pBuf, size_t size, size_t *pOffset )
+{
+    char *pStr = NULL;
+    uint32_t n;
+    size_t offset = *pOffset;
+
+    if ( offset + sizeof( n ) <= size )
+    {
+        memcpy( &n, &pBuf[offset], sizeof( n ) );
+        offset += sizeof( n );
+
+        if ( ( n > 0 ) &&
+             ( n <= size - offset ) &&
+             ( pBuf[offset + n - 1] == '\0' ) )
+        {
+            pStr = &pBuf[offset];
+            *pOffset = offset + n;
+        }
+    }
+
+    return pStr;
+}
+
+/*==========================================================================*/
+/*  Delay                                                                   */
+/*!
+    Wait for a recorded latency
+
+    @param[in]
+        latencyUs
+            time to wait in microseconds
+
+============================================================================*/
+static void Delay( uint32_t latencyUs )
+{
+    struct timespec ts;
+
+    ts.tv_sec = latencyUs / 1000000;
+    ts.tv_nsec = ( latencyUs % 1000000 ) * NS_PER_US;
+
+    while ( ( nanosleep( &ts, &ts ) == -1 ) &&
+            ( errno == EINTR ) )
+    {
+    }
+}
+
+/*! @}
+ * end of varlog group */
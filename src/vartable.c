@@ -0,0 +1,599 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*!
+ * @defgroup vartable vartable
+ * @brief In-process variable table
+ * @{
+ */
+
+/*==========================================================================*/
+/*!
+@file vartable.c
+
+    Variable Table
+
+    The Variable Table is a simple chained hash table which maps
+    variable names to string values.  It is used by the loadconfig
+    utility to hold variables which live entirely within the loader
+    process (such as those defined using the @let directive) so that
+    they can be resolved without a round trip to the variable server.
+
+    The table grows automatically as entries are added so lookups
+    remain close to constant time.
+
+*/
+/*==========================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "vartable.h"
+
+/*============================================================================
+        Private definitions
+============================================================================*/
+
+#ifndef EOK
+/*! success response */
+#define EOK 0
+#endif
+
+/*! default number of hash buckets */
+#define DEFAULT_VARTABLE_SIZE   ( 64 )
+
+/*! Variable Table */
+struct _VarTable
+{
+    /*! number of hash buckets */
+    size_t size;
+
+    /*! number of entries in the table */
+    size_t count;
+
+    /*! array of hash buckets */
+    VarEntry **buckets;
+};
+
+/*============================================================================
+        Private function declarations
+============================================================================*/
+
+static uint32_t HashName( char *name, size_t len );
+static int Resize( VarTable *pVarTable, size_t size );
+
+/*============================================================================
+        Public function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  VARTABLE_Create                                                         */
+/*!
+    Create a new variable table
+
+    The VARTABLE_Create function allocates an empty variable table
+    on the heap.  The table must be released using VARTABLE_Destroy.
+
+    @param[in]
+        size
+            initial number of hash buckets, or 0 to use the default size
+
+    @retval pointer to the new variable table
+    @retval NULL if the table could not be created
+
+============================================================================*/
+VarTable *VARTABLE_Create( size_t size )
+{
+    VarTable *pVarTable;
+
+    if ( size == 0 )
+    {
+        size = DEFAULT_VARTABLE_SIZE;
+    }
+
+    pVarTable = calloc( 1, sizeof( VarTable ) );
+    if ( pVarTable != NULL )
+    {
+        pVarTable->buckets = calloc( size, sizeof( VarEntry * ) );
+        if ( pVarTable->buckets != NULL )
+        {
+            pVarTable->size = size;
+        }
+        else
+        {
+            free( pVarTable );
+            pVarTable = NULL;
+        }
+    }
+
+    return pVarTable;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_Destroy                                                        */
+/*!
+    Destroy a variable table
+
+    The VARTABLE_Destroy function releases all of the entries in the
+    variable table, and the table itself.  Any user data associated
+    with the entries is not released.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table to destroy
+
+============================================================================*/
+void VARTABLE_Destroy( VarTable *pVarTable )
+{
+    size_t i;
+    VarEntry *pEntry;
+    VarEntry *pNext;
+
+    if ( pVarTable != NULL )
+    {
+        for ( i = 0; i < pVarTable->size; i++ )
+        {
+            pEntry = pVarTable->buckets[i];
+            while ( pEntry != NULL )
+            {
+                pNext = pEntry->pNext;
+                free( pEntry->name );
+                free( pEntry->value );
+                free( pEntry );
+                pEntry = pNext;
+            }
+        }
+
+        free( pVarTable->buckets );
+        free( pVarTable );
+    }
+}
+
+/*==========================================================================*/
+/*  VARTABLE_Set                                                            */
+/*!
+    Set a variable in the variable table
+
+    The VARTABLE_Set function creates or updates the named variable
+    in the variable table.  Copies are made of both the name and
+    the value.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        name
+            pointer to the NUL terminated variable name
+
+    @param[in]
+        value
+            pointer to the NUL terminated variable value
+
+    @retval EOK the variable was set
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int VARTABLE_Set( VarTable *pVarTable, char *name, char *value )
+{
+    int result = EINVAL;
+    VarEntry *pEntry;
+    char *pValue;
+    uint32_t idx;
+
+    if ( ( pVarTable != NULL ) &&
+         ( name != NULL ) &&
+         ( value != NULL ) )
+    {
+        result = ENOMEM;
+
+        pValue = strdup( value );
+        if ( pValue != NULL )
+        {
+            pEntry = VARTABLE_Find( pVarTable, name );
+            if ( pEntry != NULL )
+            {
+                /* update an existing variable */
+                free( pEntry->value );
+                pEntry->value = pValue;
+                result = EOK;
+            }
+            else
+            {
+                /* keep the load factor below 1 */
+                if ( pVarTable->count >= pVarTable->size )
+                {
+                    Resize( pVarTable, pVarTable->size * 2 );
+                }
+
+                pEntry = calloc( 1, sizeof( VarEntry ) );
+                if ( pEntry != NULL )
+                {
+                    pEntry->name = strdup( name );
+                    if ( pEntry->name != NULL )
+                    {
+                        pEntry->value = pValue;
+
+                        idx = HashName( name, strlen( name ) ) %
+                                pVarTable->size;
+                        pEntry->pNext = pVarTable->buckets[idx];
+                        pVarTable->buckets[idx] = pEntry;
+                        pVarTable->count++;
+
+                        result = EOK;
+                    }
+                    else
+                    {
+                        free( pEntry );
+                        free( pValue );
+                    }
+                }
+                else
+                {
+                    free( pValue );
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_Remove                                                         */
+/*!
+    Remove a variable from the variable table
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        name
+            pointer to the NUL terminated variable name
+
+    @retval EOK the variable was removed
+    @retval ENOENT the variable is not in the table
+    @retval EINVAL invalid arguments
+
+============================================================================*/
+int VARTABLE_Remove( VarTable *pVarTable, char *name )
+{
+    int result = EINVAL;
+    VarEntry **ppEntry;
+    VarEntry *pEntry;
+    uint32_t idx;
+
+    if ( ( pVarTable != NULL ) &&
+         ( name != NULL ) )
+    {
+        result = ENOENT;
+
+        idx = HashName( name, strlen( name ) ) % pVarTable->size;
+        ppEntry = &pVarTable->buckets[idx];
+        while ( ( *ppEntry != NULL ) &&
+                ( strcmp( (*ppEntry)->name, name ) != 0 ) )
+        {
+            ppEntry = &(*ppEntry)->pNext;
+        }
+
+        pEntry = *ppEntry;
+        if ( pEntry != NULL )
+        {
+            *ppEntry = pEntry->pNext;
+            pVarTable->count--;
+            free( pEntry->name );
+            free( pEntry->value );
+            free( pEntry );
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_Get                                                            */
+/*!
+    Get the value of a variable from the variable table
+
+    The VARTABLE_Get function looks up the value of the named variable.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        name
+            pointer to the NUL terminated variable name
+
+    @retval pointer to the variable value
+    @retval NULL if the variable is not in the table
+
+============================================================================*/
+char *VARTABLE_Get( VarTable *pVarTable, char *name )
+{
+    VarEntry *pEntry;
+
+    pEntry = VARTABLE_Find( pVarTable, name );
+
+    return ( pEntry != NULL ) ? pEntry->value : NULL;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_Find                                                           */
+/*!
+    Find a variable table entry
+
+    The VARTABLE_Find function looks up the entry for the named variable.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        name
+            pointer to the NUL terminated variable name
+
+    @retval pointer to the variable table entry
+    @retval NULL if the variable is not in the table
+
+============================================================================*/
+VarEntry *VARTABLE_Find( VarTable *pVarTable, char *name )
+{
+    VarEntry *pEntry = NULL;
+
+    if ( name != NULL )
+    {
+        pEntry = VARTABLE_FindN( pVarTable, name, strlen( name ) );
+    }
+
+    return pEntry;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_FindN                                                          */
+/*!
+    Find a variable table entry using a length delimited name
+
+    The VARTABLE_FindN function looks up the entry for a variable whose
+    name is not NUL terminated, such as a name embedded in a ${}
+    reference within a line of configuration data.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        name
+            pointer to the start of the variable name
+
+    @param[in]
+        len
+            length of the variable name
+
+    @retval pointer to the variable table entry
+    @retval NULL if the variable is not in the table
+
+============================================================================*/
+VarEntry *VARTABLE_FindN( VarTable *pVarTable, char *name, size_t len )
+{
+    VarEntry *pEntry = NULL;
+    uint32_t idx;
+
+    if ( ( pVarTable != NULL ) &&
+         ( name != NULL ) )
+    {
+        idx = HashName( name, len ) % pVarTable->size;
+        pEntry = pVarTable->buckets[idx];
+        while ( pEntry != NULL )
+        {
+            if ( ( strncmp( pEntry->name, name, len ) == 0 ) &&
+                 ( pEntry->name[len] == '\0' ) )
+            {
+                break;
+            }
+
+            pEntry = pEntry->pNext;
+        }
+    }
+
+    return pEntry;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_ForEach                                                        */
+/*!
+    Iterate over the entries in a variable table
+
+    The VARTABLE_ForEach function calls the specified function once for
+    each entry in the variable table.  The entries are visited in no
+    particular order.  The function must not add entries to the table.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        fn
+            function to call for each entry
+
+    @param[in]
+        arg
+            opaque argument passed to the function
+
+    @retval EOK all entries were visited ok
+    @retval EINVAL invalid arguments
+    @retval other last error returned by the function
+
+============================================================================*/
+int VARTABLE_ForEach( VarTable *pVarTable, VarTableFn fn, void *arg )
+{
+    int result = EINVAL;
+    int rc;
+    size_t i;
+    VarEntry *pEntry;
+
+    if ( ( pVarTable != NULL ) &&
+         ( fn != NULL ) )
+    {
+        result = EOK;
+
+        for ( i = 0; i < pVarTable->size; i++ )
+        {
+            for ( pEntry = pVarTable->buckets[i];
+                  pEntry != NULL;
+                  pEntry = pEntry->pNext )
+            {
+                rc = fn( pEntry, arg );
+                if ( rc != EOK )
+                {
+                    result = rc;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  VARTABLE_Count                                                          */
+/*!
+    Get the number of entries in a variable table
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @retval number of entries in the table
+
+============================================================================*/
+size_t VARTABLE_Count( VarTable *pVarTable )
+{
+    return ( pVarTable != NULL ) ? pVarTable->count : 0;
+}
+
+/*============================================================================
+        Private function definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  HashName                                                                */
+/*!
+    Calculate the hash of a variable name
+
+    The HashName function calculates the 32-bit FNV-1a hash of
+    a variable name.
+
+    @param[in]
+        name
+            pointer to the start of the variable name
+
+    @param[in]
+        len
+            length of the variable name
+
+    @retval the hash of the variable name
+
+============================================================================*/
+static uint32_t HashName( char *name, size_t len )
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for ( i = 0; i < len; i++ )
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*==========================================================================*/
+/*  Resize                                                                  */
+/*!
+    Resize the variable table
+
+    The Resize function redistributes the variable table entries
+    across a new array of hash buckets.  If the new bucket array
+    cannot be allocated the table is left unchanged.
+
+    @param[in]
+        pVarTable
+            pointer to the variable table
+
+    @param[in]
+        size
+            new number of hash buckets
+
+    @retval EOK the table was resized
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int Resize( VarTable *pVarTable, size_t size )
+{
+    int result = ENOMEM;
+    VarEntry **buckets;
+    VarEntry *pEntry;
+    VarEntry *pNext;
+    uint32_t idx;
+    size_t i;
+
+    buckets = calloc( size, sizeof( VarEntry * ) );
+    if ( buckets != NULL )
+    {
+        for ( i = 0; i < pVarTable->size; i++ )
+        {
+            pEntry = pVarTable->buckets[i];
+            while ( pEntry != NULL )
+            {
+                pNext = pEntry->pNext;
+                idx = HashName( pEntry->name, strlen( pEntry->name ) ) % size;
+                pEntry->pNext = buckets[idx];
+                buckets[idx] = pEntry;
+                pEntry = pNext;
+            }
+        }
+
+        free( pVarTable->buckets );
+        pVarTable->buckets = buckets;
+        pVarTable->size = size;
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of vartable group */